@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2018 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TDBStore.h"
+#include "SecureStore.h"
+#include <string.h>
+
+extern "C" {
+#include "unity.h"
+#include "unity_fixture.h"
+}
+
+using namespace mbed;
+
+static const bd_size_t heap_bd_size       = 16 * 1024;
+static const bd_size_t heap_bd_erase_size = 4 * 1024;
+// TDBStore's work buffer is one program unit, and has to hold a record header and the reserved area
+static const bd_size_t heap_bd_prog_size  = 64;
+
+// RAM backed flash, able to fail one program call covering a given address, or to lose power
+// there (that and all following programs and erases are silently dropped)
+class HeapBlockDevice : public BlockDevice {
+public:
+    HeapBlockDevice() : _fail_addr(no_addr), _power_cut_addr(no_addr), _powered(true), _max_program_end(0)
+    {
+        memset(_data, 0xFF, sizeof(_data));
+    }
+
+    virtual int init()
+    {
+        return 0;
+    }
+
+    virtual int deinit()
+    {
+        return 0;
+    }
+
+    virtual int read(void *buffer, bd_addr_t addr, bd_size_t size)
+    {
+        memcpy(buffer, _data + addr, size);
+        return 0;
+    }
+
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size)
+    {
+        if ((_fail_addr >= addr) && (_fail_addr < addr + size)) {
+            _fail_addr = no_addr;
+            return BD_ERROR_DEVICE_ERROR;
+        }
+        if ((_power_cut_addr >= addr) && (_power_cut_addr < addr + size)) {
+            _powered = false;
+        }
+        if (!_powered) {
+            return 0;
+        }
+        memcpy(_data + addr, buffer, size);
+        if (addr + size > _max_program_end) {
+            _max_program_end = addr + size;
+        }
+        return 0;
+    }
+
+    virtual int erase(bd_addr_t addr, bd_size_t size)
+    {
+        if (!_powered) {
+            return 0;
+        }
+        memset(_data + addr, 0xFF, size);
+        return 0;
+    }
+
+    virtual bd_size_t get_read_size() const
+    {
+        return 1;
+    }
+
+    virtual bd_size_t get_program_size() const
+    {
+        return heap_bd_prog_size;
+    }
+
+    virtual bd_size_t get_erase_size() const
+    {
+        return heap_bd_erase_size;
+    }
+
+    virtual int get_erase_value() const
+    {
+        return 0xFF;
+    }
+
+    virtual bd_size_t size() const
+    {
+        return heap_bd_size;
+    }
+
+    virtual const char *get_type() const
+    {
+        return "HEAP";
+    }
+
+    void fail_program_at(bd_addr_t addr)
+    {
+        _fail_addr = addr;
+    }
+
+    void cut_power_at(bd_addr_t addr)
+    {
+        _power_cut_addr = addr;
+    }
+
+    void restore_power()
+    {
+        _power_cut_addr = no_addr;
+        _powered = true;
+    }
+
+    bd_addr_t max_program_end() const
+    {
+        return _max_program_end;
+    }
+
+private:
+    static const bd_addr_t no_addr = (bd_addr_t) -1;
+    uint8_t _data[heap_bd_size];
+    bd_addr_t _fail_addr;
+    bd_addr_t _power_cut_addr;
+    bool _powered;
+    bd_addr_t _max_program_end;
+};
+
+static const char *const old_value = "old";
+static const KVStore::batch_item_t batch_items[] = {
+    { "batch0", "value of the first item", 24, 0 },
+    { "batch1", "value of the second item", 25, 0 },
+    { "batch2", "value of the last item", 23, 0 },
+};
+static const size_t batch_count = sizeof(batch_items) / sizeof(batch_items[0]);
+
+static HeapBlockDevice *s_bd;
+static TDBStore *s_tdb;
+
+// Same sequence on every store, so that a dry run tells where the batch's records land
+static int set_old_and_batch(KVStore *kv)
+{
+    int ret = kv->set(batch_items[0].key, old_value, strlen(old_value) + 1, 0);
+    if (ret) {
+        return ret;
+    }
+    return kv->set_batch(batch_items, batch_count);
+}
+
+// Only the first item existed before the batch, holding its old value
+static void check_no_item_set(KVStore *kv)
+{
+    char buf[32];
+    size_t actual_size = 0;
+
+    TEST_ASSERT_EQUAL(MBED_SUCCESS, kv->get(batch_items[0].key, buf, sizeof(buf), &actual_size));
+    TEST_ASSERT_EQUAL_STRING(old_value, buf);
+    for (size_t i = 1; i < batch_count; i++) {
+        TEST_ASSERT_EQUAL(MBED_ERROR_ITEM_NOT_FOUND, kv->get(batch_items[i].key, buf, sizeof(buf), &actual_size));
+    }
+}
+
+static void check_all_items_set(KVStore *kv)
+{
+    char buf[32];
+    size_t actual_size = 0;
+
+    for (size_t i = 0; i < batch_count; i++) {
+        TEST_ASSERT_EQUAL(MBED_SUCCESS, kv->get(batch_items[i].key, buf, sizeof(buf), &actual_size));
+        TEST_ASSERT_EQUAL(batch_items[i].size, actual_size);
+        TEST_ASSERT_EQUAL_MEMORY(batch_items[i].buffer, buf, actual_size);
+    }
+}
+
+static void reinit_tdb()
+{
+    TEST_ASSERT_EQUAL(MBED_SUCCESS, s_tdb->deinit());
+    delete s_tdb;
+    s_tdb = new TDBStore(s_bd);
+    TEST_ASSERT_EQUAL(MBED_SUCCESS, s_tdb->init());
+}
+
+TEST_GROUP(kvstore_batch);
+
+TEST_SETUP(kvstore_batch)
+{
+    s_bd = new HeapBlockDevice;
+    s_tdb = new TDBStore(s_bd);
+    TEST_ASSERT_EQUAL(MBED_SUCCESS, s_tdb->init());
+}
+
+TEST_TEAR_DOWN(kvstore_batch)
+{
+    s_tdb->deinit();
+    delete s_tdb;
+    delete s_bd;
+}
+
+TEST(kvstore_batch, setsAllItems)
+{
+    TEST_ASSERT_EQUAL(MBED_SUCCESS, set_old_and_batch(s_tdb));
+    check_all_items_set(s_tdb);
+
+    reinit_tdb();
+    check_all_items_set(s_tdb);
+}
+
+TEST(kvstore_batch, failedLastItemSetsNone)
+{
+    HeapBlockDevice dry_bd;
+    TDBStore dry_tdb(&dry_bd);
+
+    // The last program unit of the batch belongs to the last item's record
+    TEST_ASSERT_EQUAL(MBED_SUCCESS, dry_tdb.init());
+    TEST_ASSERT_EQUAL(MBED_SUCCESS, set_old_and_batch(&dry_tdb));
+    dry_tdb.deinit();
+
+    s_bd->fail_program_at(dry_bd.max_program_end() - 1);
+    TEST_ASSERT_NOT_EQUAL(MBED_SUCCESS, set_old_and_batch(s_tdb));
+    check_no_item_set(s_tdb);
+
+    reinit_tdb();
+    check_no_item_set(s_tdb);
+}
+
+TEST(kvstore_batch, powerCutInLastItemSetsNone)
+{
+    HeapBlockDevice dry_bd;
+    TDBStore dry_tdb(&dry_bd);
+
+    TEST_ASSERT_EQUAL(MBED_SUCCESS, dry_tdb.init());
+    TEST_ASSERT_EQUAL(MBED_SUCCESS, set_old_and_batch(&dry_tdb));
+    dry_tdb.deinit();
+
+    // Records before the last one reached the media, but carry the batch flag
+    s_bd->cut_power_at(dry_bd.max_program_end() - 1);
+    set_old_and_batch(s_tdb);
+    s_bd->restore_power();
+
+    reinit_tdb();
+    check_no_item_set(s_tdb);
+}
+
+TEST(kvstore_batch, writeProtectedLastItemSetsNone)
+{
+    char buf[32];
+
+    TEST_ASSERT_EQUAL(MBED_SUCCESS, s_tdb->set(batch_items[batch_count - 1].key, old_value, strlen(old_value) + 1,
+                                               KVStore::WRITE_ONCE_FLAG));
+    TEST_ASSERT_EQUAL(MBED_ERROR_WRITE_PROTECTED, set_old_and_batch(s_tdb));
+
+    TEST_ASSERT_EQUAL(MBED_SUCCESS, s_tdb->get(batch_items[0].key, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING(old_value, buf);
+    TEST_ASSERT_EQUAL(MBED_ERROR_ITEM_NOT_FOUND, s_tdb->get(batch_items[1].key, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL(MBED_SUCCESS, s_tdb->get(batch_items[batch_count - 1].key, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING(old_value, buf);
+}
+
+TEST(kvstore_batch, duplicateKeySetsNone)
+{
+    KVStore::batch_item_t items[] = { batch_items[1], batch_items[2], batch_items[1] };
+
+    TEST_ASSERT_EQUAL(MBED_ERROR_INVALID_ARGUMENT, s_tdb->set_batch(items, 3));
+    TEST_ASSERT_EQUAL(MBED_ERROR_ITEM_NOT_FOUND, s_tdb->get_info(batch_items[1].key, 0));
+    TEST_ASSERT_EQUAL(MBED_ERROR_ITEM_NOT_FOUND, s_tdb->get_info(batch_items[2].key, 0));
+}
+
+#if SECURESTORE_ENABLED
+TEST(kvstore_batch, secureStoreFailedLastItemSetsNone)
+{
+    HeapBlockDevice dry_bd;
+    TDBStore dry_tdb(&dry_bd);
+    SecureStore dry_sec(&dry_tdb);
+    SecureStore *sec;
+    KVStore::batch_item_t items[batch_count];
+
+    for (size_t i = 0; i < batch_count; i++) {
+        items[i] = batch_items[i];
+        items[i].create_flags = KVStore::REQUIRE_CONFIDENTIALITY_FLAG;
+    }
+
+    // Encrypted records are as large as on the real store, so the dry run still finds the last one
+    TEST_ASSERT_EQUAL(MBED_SUCCESS, dry_sec.init());
+    TEST_ASSERT_EQUAL(MBED_SUCCESS, dry_sec.set_batch(items, batch_count));
+    dry_sec.deinit();
+    dry_tdb.deinit();
+
+    sec = new SecureStore(s_tdb);
+    TEST_ASSERT_EQUAL(MBED_SUCCESS, sec->init());
+    s_bd->fail_program_at(dry_bd.max_program_end() - 1);
+    TEST_ASSERT_NOT_EQUAL(MBED_SUCCESS, sec->set_batch(items, batch_count));
+    for (size_t i = 0; i < batch_count; i++) {
+        TEST_ASSERT_EQUAL(MBED_ERROR_ITEM_NOT_FOUND, sec->get_info(items[i].key, 0));
+    }
+
+    // Once the media is fine again, the same batch reads back authenticated and decrypted
+    TEST_ASSERT_EQUAL(MBED_SUCCESS, sec->set_batch(items, batch_count));
+    check_all_items_set(sec);
+    sec->deinit();
+    delete sec;
+}
+#endif
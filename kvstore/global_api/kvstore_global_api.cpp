@@ -49,6 +49,49 @@ int kv_set(const char *full_name_key, const void *buffer, size_t size, uint32_t
     return ret;
 }
 
+int kv_set_batch(const kv_batch_item_t *items, size_t count)
+{
+    if (!items || !count) {
+        return MBED_ERROR_INVALID_ARGUMENT;
+    }
+
+    int ret = kv_init_storage_config();
+    if (MBED_SUCCESS != ret) {
+        return ret;
+    }
+
+    KVStore::batch_item_t *inner_items = new KVStore::batch_item_t[count];
+
+    KVMap &kv_map = KVMap::get_instance();
+    KVStore *kv_instance = NULL;
+    for (size_t i = 0; i < count; i++) {
+        KVStore *item_instance = NULL;
+        uint32_t flags_mask = 0;
+        size_t key_index = 0;
+        ret = kv_map.lookup(items[i].full_name_key, &item_instance, &key_index, &flags_mask);
+        if (ret != MBED_SUCCESS) {
+            goto end;
+        }
+        // A batch can't span partitions
+        if (kv_instance && (item_instance != kv_instance)) {
+            ret = MBED_ERROR_INVALID_ARGUMENT;
+            goto end;
+        }
+        kv_instance = item_instance;
+
+        inner_items[i].key = items[i].full_name_key + key_index;
+        inner_items[i].buffer = items[i].buffer;
+        inner_items[i].size = items[i].size;
+        inner_items[i].create_flags = items[i].create_flags & flags_mask;
+    }
+
+    ret = kv_instance->set_batch(inner_items, count);
+
+end:
+    delete[] inner_items;
+    return ret;
+}
+
 int kv_get(const char *full_name_key, void *buffer, size_t buffer_size, size_t *actual_size)
 {
     int ret = kv_init_storage_config();
@@ -49,6 +49,16 @@ typedef struct info {
     uint32_t flags;
 } kv_info_t;
 
+/**
+ * One item of kv_set_batch
+ */
+typedef struct kv_batch_item {
+    const char *full_name_key;
+    const void *buffer;
+    size_t size;
+    uint32_t create_flags;
+} kv_batch_item_t;
+
 /**
  * @brief Set one KVStore item, given key and value.
  *
@@ -61,6 +71,17 @@ typedef struct info {
  */
 int kv_set(const char *full_name_key, const void *buffer, size_t size, uint32_t create_flags);
 
+/**
+ * @brief Set several KVStore items. All keys must belong to the same partition, which commits
+ *        them atomically if its KVStore supports it (TDBStore does).
+ *
+ * @param[in]  items                Items to set.
+ * @param[in]  count                Number of items.
+ *
+ * @returns MBED_SUCCESS on success or an error code from underlying KVStore instances
+ */
+int kv_set_batch(const kv_batch_item_t *items, size_t count);
+
 /**
  * @brief Get one KVStore item by given key.
  *
@@ -59,6 +59,16 @@ public:
         uint32_t flags;
     } info_t;
 
+    /**
+     * Holds one item of a batch set
+     */
+    typedef struct batch_item {
+        const char *key;
+        const void *buffer;
+        size_t size;
+        uint32_t create_flags;
+    } batch_item_t;
+
     virtual ~KVStore() {};
 
     /**
@@ -127,6 +137,25 @@ public:
      */
     virtual int remove(const char *key) = 0;
 
+    /**
+     * @brief Set several KVStore items. Implementations supporting it commit the whole batch
+     *        atomically (either all items are set or none of them). The default implementation
+     *        sets the items one by one.
+     *
+     * @param[in]  items                Items to set.
+     * @param[in]  count                Number of items.
+     *
+     * @returns MBED_SUCCESS on success or an error code on failure
+     */
+    virtual int set_batch(const batch_item_t *items, size_t count)
+    {
+        int ret = 0;
+        for (size_t i = 0; (i < count) && !ret; i++) {
+            ret = set(items[i].key, items[i].buffer, items[i].size, items[i].create_flags);
+        }
+        return ret;
+    }
+
 
     /**
      * @brief Start an incremental KVStore set sequence.
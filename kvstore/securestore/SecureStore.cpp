@@ -73,6 +73,15 @@ typedef struct {
     KVStore::iterator_t underlying_it;
 } key_iterator_handle_t;
 
+// read cache entry (free if key is NULL)
+typedef struct {
+    char *key;
+    uint8_t *data;
+    uint32_t data_size;
+    uint32_t create_flags;
+    uint32_t last_used;
+} read_cache_entry_t;
+
 } // anonymous namespace
 
 
@@ -161,6 +170,20 @@ int cmac_calc_finish(mbedtls_cipher_context_t &auth_ctx, uint8_t *output)
     return os_ret;
 }
 
+#if SECURESTORE_READ_CACHE_MAX_KEYS
+static void read_cache_entry_free(read_cache_entry_t *entry)
+{
+    // Wipe plaintext before releasing it (volatile, so that the compiler can't drop the writes)
+    volatile uint8_t *data = entry->data;
+    for (uint32_t i = 0; i < entry->data_size; i++) {
+        data[i] = 0;
+    }
+    delete[] entry->data;
+    delete[] entry->key;
+    memset(entry, 0, sizeof(read_cache_entry_t));
+}
+#endif
+
 
 
 // Class member functions
@@ -168,6 +191,9 @@ int cmac_calc_finish(mbedtls_cipher_context_t &auth_ctx, uint8_t *output)
 SecureStore::SecureStore(KVStore *underlying_kv, KVStore *rbp_kv) :
     _is_initialized(false), _underlying_kv(underlying_kv), _rbp_kv(rbp_kv), _entropy(0),
     _inc_set_handle(0), _scratch_buf(0)
+#if SECURESTORE_READ_CACHE_MAX_KEYS
+    , _read_cache(0), _read_cache_size(0), _read_cache_tick(0), _read_cache_hits(0), _read_cache_misses(0)
+#endif
 {
 }
 
@@ -198,6 +224,10 @@ int SecureStore::set_start(set_handle_t *handle, const char *key, size_t final_d
 
     pal_osMutexWait(_mutex, PAL_RTOS_WAIT_FOREVER);
 
+#if SECURESTORE_READ_CACHE_MAX_KEYS
+    read_cache_remove(key);
+#endif
+
     ret = _underlying_kv->get(key, &ih->metadata, sizeof(record_metadata_t));
     if (ret == MBED_SUCCESS) {
         // Must not remove RP flag
@@ -494,6 +524,10 @@ int SecureStore::remove(const char *key)
         goto end;
     }
 
+#if SECURESTORE_READ_CACHE_MAX_KEYS
+    read_cache_remove(key);
+#endif
+
     ret = _underlying_kv->remove(key);
     if (ret) {
         goto end;
@@ -513,6 +547,184 @@ end:
     return ret;
 }
 
+int SecureStore::set_batch(const batch_item_t *items, size_t count)
+{
+    int os_ret, ret = MBED_SUCCESS;
+    inc_set_handle_t *ih;
+    batch_item_t *under_items = 0, *rbp_items = 0;
+    uint8_t *records = 0, *cmacs = 0, *record, *data, *cmac;
+    size_t i, j, total_size = 0, rbp_count = 0, aes_offs;
+    uint32_t create_flags;
+    info_t info;
+
+    if (!_is_initialized) {
+        return MBED_ERROR_NOT_READY;
+    }
+
+    if (!items && count) {
+        return MBED_ERROR_INVALID_ARGUMENT;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (!is_valid_key(items[i].key)) {
+            return MBED_ERROR_INVALID_ARGUMENT;
+        }
+        if (!items[i].buffer && items[i].size) {
+            return MBED_ERROR_INVALID_ARGUMENT;
+        }
+        for (j = 0; j < i; j++) {
+            if (!strcmp(items[i].key, items[j].key)) {
+                return MBED_ERROR_INVALID_ARGUMENT;
+            }
+        }
+        total_size += sizeof(record_metadata_t) + items[i].size + cmac_size;
+    }
+
+    if (!count) {
+        return MBED_SUCCESS;
+    }
+
+    // Unlike set, which goes through the scratch buffer chunk by chunk, the underlying batch needs
+    // all records ready at once
+    records = new uint8_t[total_size];
+    cmacs = new uint8_t[count * cmac_size];
+    under_items = new batch_item_t[count];
+    rbp_items = new batch_item_t[count];
+
+    // Contexts of the incremental set handle are free while we hold the mutex
+    ih = reinterpret_cast<inc_set_handle_t *>(_inc_set_handle);
+
+    pal_osMutexWait(_mutex, PAL_RTOS_WAIT_FOREVER);
+
+    record = records;
+    for (i = 0; i < count; i++) {
+        create_flags = items[i].create_flags;
+        data = record + sizeof(record_metadata_t);
+        cmac = cmacs + i * cmac_size;
+
+#if SECURESTORE_READ_CACHE_MAX_KEYS
+        read_cache_remove(items[i].key);
+#endif
+
+        // Same checks as set_start
+        ret = _underlying_kv->get(items[i].key, &ih->metadata, sizeof(record_metadata_t));
+        if (ret == MBED_SUCCESS) {
+            // Must not remove RP flag
+            if (!(create_flags & REQUIRE_REPLAY_PROTECTION_FLAG) && (ih->metadata.create_flags & REQUIRE_REPLAY_PROTECTION_FLAG)) {
+                ret = MBED_ERROR_INVALID_ARGUMENT;
+                goto end;
+            }
+            if (ih->metadata.create_flags & WRITE_ONCE_FLAG) {
+                ret = MBED_ERROR_WRITE_PROTECTED;
+                goto end;
+            }
+        } else if (ret != MBED_ERROR_ITEM_NOT_FOUND) {
+            ret = MBED_ERROR_READ_FAILED;
+            goto end;
+        } else if (_rbp_kv) {
+            // A written once key removed from the underlying store is still protected by the RBP store
+            ret = _rbp_kv->get_info(items[i].key, &info);
+            if ((ret == MBED_SUCCESS) && (info.flags & WRITE_ONCE_FLAG)) {
+                ret = MBED_ERROR_WRITE_PROTECTED;
+                goto end;
+            } else if ((ret != MBED_SUCCESS) && (ret != MBED_ERROR_ITEM_NOT_FOUND)) {
+                goto end;
+            }
+        }
+
+        ih->metadata.create_flags = create_flags;
+        ih->metadata.data_size = items[i].size;
+        ih->metadata.metadata_size = sizeof(record_metadata_t);
+        ih->metadata.revision = securestore_revision;
+
+        if (create_flags & REQUIRE_CONFIDENTIALITY_FLAG) {
+            os_ret = mbedtls_entropy_func(_entropy, ih->metadata.iv, iv_size);
+            if (os_ret) {
+                ret = MBED_ERROR_FAILED_OPERATION;
+                goto end;
+            }
+            os_ret = encrypt_decrypt_start(ih->enc_ctx, ih->metadata.iv, items[i].key, ih->ctr_buf, _scratch_buf,
+                                           scratch_buf_size);
+            if (os_ret) {
+                ret = MBED_ERROR_FAILED_OPERATION;
+                goto end;
+            }
+            aes_offs = 0;
+            os_ret = encrypt_decrypt_data(ih->enc_ctx, static_cast<const uint8_t *>(items[i].buffer), data,
+                                          items[i].size, ih->ctr_buf, aes_offs);
+            mbedtls_aes_free(&ih->enc_ctx);
+            if (os_ret) {
+                ret = MBED_ERROR_FAILED_OPERATION;
+                goto end;
+            }
+        } else {
+            memset(ih->metadata.iv, 0, iv_size);
+            if (items[i].size) {
+                memcpy(data, items[i].buffer, items[i].size);
+            }
+        }
+
+        os_ret = cmac_calc_start(ih->auth_ctx, items[i].key, _scratch_buf, scratch_buf_size);
+        if (os_ret) {
+            ret = MBED_ERROR_FAILED_OPERATION;
+            goto end;
+        }
+        os_ret = cmac_calc_data(ih->auth_ctx, items[i].key, strlen(items[i].key));
+        if (!os_ret) {
+            os_ret = cmac_calc_data(ih->auth_ctx, &ih->metadata, sizeof(record_metadata_t));
+        }
+        if (!os_ret) {
+            os_ret = cmac_calc_data(ih->auth_ctx, data, items[i].size);
+        }
+        if (!os_ret) {
+            os_ret = cmac_calc_finish(ih->auth_ctx, cmac);
+        }
+        mbedtls_cipher_free(&ih->auth_ctx);
+        if (os_ret) {
+            ret = MBED_ERROR_FAILED_OPERATION;
+            goto end;
+        }
+
+        // Record layout is the same as the one written by set: metadata, data, CMAC
+        memcpy(record, &ih->metadata, sizeof(record_metadata_t));
+        memcpy(data + items[i].size, cmac, cmac_size);
+
+        // Should strip security flags from underlying storage
+        under_items[i].key = items[i].key;
+        under_items[i].buffer = record;
+        under_items[i].size = sizeof(record_metadata_t) + items[i].size + cmac_size;
+        under_items[i].create_flags = create_flags & ~security_flags;
+        record += under_items[i].size;
+
+        if (_rbp_kv && (create_flags & (REQUIRE_REPLAY_PROTECTION_FLAG | WRITE_ONCE_FLAG))) {
+            rbp_items[rbp_count].key = items[i].key;
+            rbp_items[rbp_count].buffer = cmac;
+            rbp_items[rbp_count].size = cmac_size;
+            rbp_items[rbp_count].create_flags = create_flags & WRITE_ONCE_FLAG;
+            rbp_count++;
+        }
+    }
+
+    ret = _underlying_kv->set_batch(under_items, count);
+    if (ret) {
+        goto end;
+    }
+
+    // As in set_finalize, RBP store is only updated once the records are in the underlying store
+    if (rbp_count) {
+        ret = _rbp_kv->set_batch(rbp_items, rbp_count);
+    }
+
+end:
+    ih->metadata.metadata_size = 0;
+    pal_osMutexRelease(_mutex);
+    delete[] rbp_items;
+    delete[] under_items;
+    delete[] cmacs;
+    delete[] records;
+    return ret;
+}
+
 int SecureStore::do_get(const char *key, void *buffer, size_t buffer_size, size_t *actual_size,
                         size_t offset, info_t *info)
 {
@@ -533,6 +745,26 @@ int SecureStore::do_get(const char *key, void *buffer, size_t buffer_size, size_
         return MBED_ERROR_INVALID_ARGUMENT;
     }
 
+#if SECURESTORE_READ_CACHE_MAX_KEYS
+    read_cache_entry_t *entry = static_cast<read_cache_entry_t *>(read_cache_find(key));
+    if (entry && (offset <= entry->data_size)) {
+        _read_cache_hits++;
+        actual_data_size = std::min((uint32_t) buffer_size, entry->data_size - (uint32_t) offset);
+        if (actual_data_size) {
+            memcpy(buffer, entry->data + offset, actual_data_size);
+        }
+        if (actual_size) {
+            *actual_size = actual_data_size;
+        }
+        if (info) {
+            info->flags = entry->create_flags;
+            info->size = entry->data_size;
+        }
+        return MBED_SUCCESS;
+    }
+    _read_cache_misses++;
+#endif
+
     // Use member variable _inc_set_handle as no set operation is used now,
     // and it saves us the need to define all members on stack
     inc_set_handle_t *ih = static_cast<inc_set_handle_t *>(_inc_set_handle);
@@ -695,6 +927,13 @@ int SecureStore::do_get(const char *key, void *buffer, size_t buffer_size, size_
         info->size = ih->metadata.data_size;
     }
 
+#if SECURESTORE_READ_CACHE_MAX_KEYS
+    // Value is authenticated - cache it if the user buffer got all of it
+    if (!offset && (actual_data_size == ih->metadata.data_size)) {
+        read_cache_add(key, buffer, actual_data_size, ih->metadata.create_flags);
+    }
+#endif
+
 end:
     ih->metadata.metadata_size = 0;
 
@@ -754,6 +993,11 @@ int SecureStore::init()
 
     _scratch_buf = new uint8_t[scratch_buf_size];
     _inc_set_handle = new inc_set_handle_t;
+#if SECURESTORE_READ_CACHE_MAX_KEYS
+    _read_cache = new read_cache_entry_t[SECURESTORE_READ_CACHE_MAX_KEYS];
+    memset(_read_cache, 0, sizeof(read_cache_entry_t) * SECURESTORE_READ_CACHE_MAX_KEYS);
+    _read_cache_size = 0;
+#endif
 
     ret = _underlying_kv->init();
     if (ret) {
@@ -782,6 +1026,11 @@ int SecureStore::deinit()
         delete static_cast<mbedtls_entropy_context *>(_entropy);
         delete static_cast<inc_set_handle_t *>(_inc_set_handle);
         delete _scratch_buf;
+#if SECURESTORE_READ_CACHE_MAX_KEYS
+        read_cache_remove(0);
+        delete[] static_cast<read_cache_entry_t *>(_read_cache);
+        _read_cache = 0;
+#endif
         // TODO: Deinit member KVs?
     }
 
@@ -804,6 +1053,9 @@ int SecureStore::reset()
     }
 
     pal_osMutexWait(_mutex, PAL_RTOS_WAIT_FOREVER);
+#if SECURESTORE_READ_CACHE_MAX_KEYS
+    read_cache_remove(0);
+#endif
     ret = _underlying_kv->reset();
     if (ret) {
         goto end;
@@ -870,4 +1122,83 @@ int SecureStore::iterator_close(iterator_t it)
     return ret;
 }
 
+void SecureStore::get_read_cache_stats(uint32_t &hits, uint32_t &misses)
+{
+#if SECURESTORE_READ_CACHE_MAX_KEYS
+    pal_osMutexWait(_mutex, PAL_RTOS_WAIT_FOREVER);
+    hits = _read_cache_hits;
+    misses = _read_cache_misses;
+    pal_osMutexRelease(_mutex);
+#else
+    hits = 0;
+    misses = 0;
+#endif
+}
+
+#if SECURESTORE_READ_CACHE_MAX_KEYS
+void *SecureStore::read_cache_find(const char *key)
+{
+    read_cache_entry_t *cache = static_cast<read_cache_entry_t *>(_read_cache);
+
+    for (int i = 0; i < SECURESTORE_READ_CACHE_MAX_KEYS; i++) {
+        if (cache[i].key && !strcmp(cache[i].key, key)) {
+            cache[i].last_used = ++_read_cache_tick;
+            return &cache[i];
+        }
+    }
+    return 0;
+}
+
+void SecureStore::read_cache_add(const char *key, const void *data, uint32_t data_size, uint32_t create_flags)
+{
+    read_cache_entry_t *cache = static_cast<read_cache_entry_t *>(_read_cache);
+    read_cache_entry_t *entry;
+
+    if (data_size > SECURESTORE_READ_CACHE_MAX_SIZE) {
+        return;
+    }
+
+    // Evict least recently used entries until there's both a free entry and enough room
+    for (;;) {
+        read_cache_entry_t *lru = 0;
+        entry = 0;
+        for (int i = 0; i < SECURESTORE_READ_CACHE_MAX_KEYS; i++) {
+            if (!cache[i].key) {
+                entry = &cache[i];
+            } else if (!lru || (int32_t)(cache[i].last_used - lru->last_used) < 0) {
+                lru = &cache[i];
+            }
+        }
+        if (entry && (_read_cache_size + data_size <= SECURESTORE_READ_CACHE_MAX_SIZE)) {
+            break;
+        }
+        _read_cache_size -= lru->data_size;
+        read_cache_entry_free(lru);
+    }
+
+    entry->key = new char[strlen(key) + 1];
+    strcpy(entry->key, key);
+    entry->data = new uint8_t[data_size ? data_size : 1];
+    if (data_size) {
+        memcpy(entry->data, data, data_size);
+    }
+    entry->data_size = data_size;
+    entry->create_flags = create_flags;
+    entry->last_used = ++_read_cache_tick;
+    _read_cache_size += data_size;
+}
+
+void SecureStore::read_cache_remove(const char *key)
+{
+    read_cache_entry_t *cache = static_cast<read_cache_entry_t *>(_read_cache);
+
+    for (int i = 0; i < SECURESTORE_READ_CACHE_MAX_KEYS; i++) {
+        if (cache[i].key && (!key || !strcmp(cache[i].key, key))) {
+            _read_cache_size -= cache[i].data_size;
+            read_cache_entry_free(&cache[i]);
+        }
+    }
+}
+#endif
+
 #endif
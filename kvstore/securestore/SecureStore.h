@@ -33,6 +33,16 @@
 #define SECURESTORE_ENABLED 0
 #endif
 
+// Optional LRU cache of authenticated, decrypted values, saving the CMAC calculation and decryption
+// on repeated reads of the same keys. Bounded by number of keys and total value size (0 keys disables it).
+#ifndef SECURESTORE_READ_CACHE_MAX_KEYS
+#define SECURESTORE_READ_CACHE_MAX_KEYS 0
+#endif
+
+#ifndef SECURESTORE_READ_CACHE_MAX_SIZE
+#define SECURESTORE_READ_CACHE_MAX_SIZE 2048
+#endif
+
 #if SECURESTORE_ENABLED || defined(DOXYGEN_ONLY)
 
 #include <stdint.h>
@@ -173,6 +183,27 @@ public:
      */
     virtual int remove(const char *key);
 
+    /**
+     * @brief Set several KVStore items. Each item is encrypted and authenticated as in set, then all
+     *        records are handed to the underlying KVStore's set_batch in one go, so with an atomic
+     *        underlying store (TDBStore) either all items are set or none of them.
+     *        Rollback protection CMACs are stored in the RBP store after the records are committed.
+     *        Unlike set, the whole batch is prepared in a heap buffer (sum of item sizes plus overhead).
+     *
+     * @param[in]  items                Items to set (key, value, size and create flags, as in set).
+     * @param[in]  count                Number of items.
+     *
+     * @returns MBED_SUCCESS                        Success.
+     *          MBED_ERROR_NOT_READY                Not initialized.
+     *          MBED_ERROR_READ_FAILED              Unable to read from media.
+     *          MBED_ERROR_INVALID_ARGUMENT         Invalid argument given in function arguments
+     *                                              (including a key appearing twice in the batch).
+     *          MBED_ERROR_WRITE_PROTECTED          Already stored with "write once" flag.
+     *          MBED_ERROR_FAILED_OPERATION         Internal error.
+     *          or any other error from underlying KVStore instances.
+     */
+    virtual int set_batch(const batch_item_t *items, size_t count);
+
 
     /**
      * @brief Start an incremental KVStore set sequence. This operation is blocking other operations.
@@ -267,6 +298,16 @@ public:
      */
     virtual int iterator_close(iterator_t it);
 
+    /**
+     * @brief Get read cache statistics (both are 0 if the cache is disabled).
+     *
+     * @param[out] hits                 Number of reads served from the cache.
+     * @param[out] misses               Number of reads that had to authenticate (and decrypt) the record.
+     *
+     * @returns none
+     */
+    void get_read_cache_stats(uint32_t &hits, uint32_t &misses);
+
 #if !defined(DOXYGEN_ONLY)
 private:
 
@@ -276,6 +317,13 @@ private:
     void *_entropy;
     void *_inc_set_handle;
     uint8_t *_scratch_buf;
+#if SECURESTORE_READ_CACHE_MAX_KEYS
+    void *_read_cache;
+    uint32_t _read_cache_size;
+    uint32_t _read_cache_tick;
+    uint32_t _read_cache_hits;
+    uint32_t _read_cache_misses;
+#endif
 
     /**
      * @brief Actual get function, serving get and get_info APIs.
@@ -291,6 +339,38 @@ private:
      */
     int do_get(const char *key, void *buffer, size_t buffer_size, size_t *actual_size = NULL,
                size_t offset = 0, info_t *info = 0);
+
+#if SECURESTORE_READ_CACHE_MAX_KEYS
+    /**
+     * @brief Find a key in read cache, marking it as most recently used.
+     *
+     * @param[in]  key                  Key.
+     *
+     * @returns cache entry, or NULL if not cached.
+     */
+    void *read_cache_find(const char *key);
+
+    /**
+     * @brief Add an authenticated value to read cache, evicting least recently used entries as needed.
+     *
+     * @param[in]  key                  Key.
+     * @param[in]  data                 Decrypted value.
+     * @param[in]  data_size            Value size.
+     * @param[in]  create_flags         Key flags.
+     *
+     * @returns none
+     */
+    void read_cache_add(const char *key, const void *data, uint32_t data_size, uint32_t create_flags);
+
+    /**
+     * @brief Remove a key from read cache (all keys if key is NULL), wiping the cached values.
+     *
+     * @param[in]  key                  Key.
+     *
+     * @returns none
+     */
+    void read_cache_remove(const char *key);
+#endif
 #endif
 };
 /** @}*/
@@ -22,13 +22,18 @@
 #include <string.h>
 #include <stdio.h>
 #include <cassert>
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
 
 using namespace mbed;
 
 // --------------------------------------------------------- Definitions ----------------------------------------------------------
 
 static const uint32_t delete_flag = (1UL << 31);
-static const uint32_t internal_flags = delete_flag;
+// Set on all records of a batch but the last one
+static const uint32_t batch_flag = (1UL << 30);
+static const uint32_t internal_flags = delete_flag | batch_flag;
 // Only write once flag is supported, other two are kept in storage but ignored
 static const uint32_t supported_flags = KVStore::WRITE_ONCE_FLAG | KVStore::REQUIRE_CONFIDENTIALITY_FLAG | KVStore::REQUIRE_REPLAY_PROTECTION_FLAG;
 
@@ -47,6 +52,7 @@ typedef struct {
 
 typedef struct {
     uint32_t  hash;
+    uint32_t  gc_offset;    // Offset of the record copy in standby area during incremental GC (0 if not copied yet)
     bd_size_t bd_offset;
 } ram_table_entry_t;
 
@@ -106,6 +112,79 @@ static inline uint32_t align_up(uint32_t val, uint32_t size)
 }
 
 
+// Incremental garbage collection. An idle hook may call garbage_collection_step() at any time. In addition,
+// when TDBSTORE_INCREMENTAL_GC_RECORDS_PER_SET is nonzero, every set() migrates up to that many records once
+// the active area is more than TDBSTORE_INCREMENTAL_GC_START_PERCENT full, so that a set() rarely needs to
+// run a full collection. On Mbed OS both are set through mbed-cloud-client.tdbstore-incremental-gc-* config.
+#ifndef TDBSTORE_INCREMENTAL_GC_RECORDS_PER_SET
+#define TDBSTORE_INCREMENTAL_GC_RECORDS_PER_SET 0
+#endif
+
+#ifndef TDBSTORE_INCREMENTAL_GC_START_PERCENT
+#define TDBSTORE_INCREMENTAL_GC_START_PERCENT 75
+#endif
+
+// CRC engine. All variants compute the same reflected CRC-32 (polynomial 0xEDB88320, no final xor),
+// so records written by one build stay readable by another:
+//  - ARMv8 CRC32 instructions, when the compiler targets them
+//  - Slicing-by-8 tables (8KB of constant data), when TDBSTORE_CRC_SLICING_BY_8 is set (default)
+//  - Nibble table (64 bytes), otherwise
+#ifndef TDBSTORE_CRC_SLICING_BY_8
+#define TDBSTORE_CRC_SLICING_BY_8 1
+#endif
+
+#if defined(__ARM_FEATURE_CRC32)
+
+static uint32_t calc_crc(uint32_t init_crc, uint32_t size, const void *buffer)
+{
+    uint32_t crc = init_crc;
+    const uint8_t *data = (const uint8_t*)buffer;
+
+    while (size && ((uintptr_t)data & 3)) {
+        crc = __crc32b(crc, *data++);
+        size--;
+    }
+    while (size >= 4) {
+        uint32_t word;
+        memcpy(&word, data, sizeof(word));
+        crc = __crc32w(crc, word);
+        data += 4;
+        size -= 4;
+    }
+    while (size--) {
+        crc = __crc32b(crc, *data++);
+    }
+
+    return crc;
+}
+
+#elif TDBSTORE_CRC_SLICING_BY_8
+#include "TDBStoreCrcTable.h"
+
+static uint32_t calc_crc(uint32_t init_crc, uint32_t size, const void *buffer)
+{
+    uint32_t crc = init_crc;
+    const uint8_t *data = (const uint8_t*)buffer;
+
+    // Byte loads keep this independent of alignment and endianness
+    while (size >= 8) {
+        uint32_t lo = crc ^ (data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24));
+        crc = crc_table[7][lo & 0xff] ^ crc_table[6][(lo >> 8) & 0xff] ^
+              crc_table[5][(lo >> 16) & 0xff] ^ crc_table[4][lo >> 24] ^
+              crc_table[3][data[4]] ^ crc_table[2][data[5]] ^
+              crc_table[1][data[6]] ^ crc_table[0][data[7]];
+        data += 8;
+        size -= 8;
+    }
+    while (size--) {
+        crc = (crc >> 8) ^ crc_table[0][(crc ^ *data++) & 0xff];
+    }
+
+    return crc;
+}
+
+#else
+
 static uint32_t calc_crc(uint32_t init_crc, uint32_t size, const void *buffer)
 {
     uint32_t crc = init_crc;
@@ -122,19 +201,18 @@ static uint32_t calc_crc(uint32_t init_crc, uint32_t size, const void *buffer)
         crc = (crc >> 4) ^ rtable[(crc ^ (data[i] >> 4)) & 0xf];
     }
 
-    // These combined do nothing?
-    crc = crc & 0xFFFFFFFF;
-    crc = (crc ^ 0x0) & 0xFFFFFFFF;
-
     return crc;
 }
 
+#endif
+
 // Class member functions
 
 TDBStore::TDBStore(BlockDevice *bd) : _ram_table(0), _max_keys(0),
     _num_keys(0), _bd(bd), _buff_bd(0),  _free_space_offset(0), _master_record_offset(0),
     _master_record_size(0), _is_initialized(false), _active_area(0), _active_area_version(0), _size(0),
-    _area_params{}, _prog_size(0), _work_buf(0), _key_buf(0), _variant_bd_erase_unit_size(false), _inc_set_handle(0)
+    _area_params{}, _prog_size(0), _work_buf(0), _key_buf(0), _variant_bd_erase_unit_size(false), _inc_set_handle(0),
+    _gc_in_progress(false), _gc_ram_table_ind(0), _gc_to_offset(0)
 {
     for (int i = 0; i < _num_areas; i++) {
         _area_params[i] = { 0 };
@@ -255,7 +333,7 @@ int TDBStore::read_record(uint8_t area, uint32_t offset, char *key,
         return MBED_ERROR_INVALID_DATA_DETECTED;
     }
 
-    if (offset + total_size >= _size) {
+    if (offset + total_size > _size) {
         return MBED_ERROR_INVALID_DATA_DETECTED;
     }
 
@@ -375,12 +453,22 @@ int TDBStore::find_record(uint8_t area, const char *key, uint32_t &offset,
 
     hash = calc_crc(initial_crc, strlen(key), key);
 
-    for (ram_table_ind = 0; ram_table_ind < _num_keys; ram_table_ind++) {
+    // RAM table is sorted by descending hash. Find the first entry whose hash is not above ours;
+    // this is also the place where a new key with this hash is to be inserted.
+    uint32_t low = 0, high = _num_keys;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (ram_table[mid].hash > hash) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    // Several keys may share the same hash, so check the key of each candidate
+    for (ram_table_ind = low; ram_table_ind < _num_keys; ram_table_ind++) {
         entry = &ram_table[ram_table_ind];
         offset = entry->bd_offset;
-        if (hash < entry->hash)  {
-            continue;
-        }
         if (hash > entry->hash)  {
             return MBED_ERROR_ITEM_NOT_FOUND;
         }
@@ -415,7 +503,8 @@ int TDBStore::set_start(set_handle_t *handle, const char *key, size_t final_data
         return MBED_ERROR_INVALID_ARGUMENT;
     }
 
-    if (create_flags & ~(supported_flags | internal_flags)) {
+    // Batch flag is only set by set_batch, never through the incremental set API
+    if (create_flags & ~(supported_flags | delete_flag)) {
         return MBED_ERROR_INVALID_ARGUMENT;
     }
 
@@ -579,8 +668,6 @@ int TDBStore::set_finalize(set_handle_t handle)
 {
     int os_ret, ret = MBED_SUCCESS;
     inc_set_handle_t *ih;
-    ram_table_entry_t *ram_table = (ram_table_entry_t *) _ram_table;
-    ram_table_entry_t *entry;
     bool need_gc = false;
     uint32_t actual_data_size, hash, flags, next_offset;
 
@@ -632,27 +719,7 @@ int TDBStore::set_finalize(set_handle_t handle)
         goto end;
     }
 
-    // Update RAM table
-    if (ih->header.flags & delete_flag) {
-        _num_keys--;
-        if (ih->ram_table_ind < _num_keys) {
-            memmove(&ram_table[ih->ram_table_ind], &ram_table[ih->ram_table_ind + 1],
-                    sizeof(ram_table_entry_t) * (_num_keys - ih->ram_table_ind));
-        }
-        update_all_iterators(false, ih->ram_table_ind);
-    } else {
-        if (ih->new_key) {
-            if (ih->ram_table_ind < _num_keys) {
-                memmove(&ram_table[ih->ram_table_ind + 1], &ram_table[ih->ram_table_ind],
-                        sizeof(ram_table_entry_t) * (_num_keys - ih->ram_table_ind));
-            }
-            _num_keys++;
-            update_all_iterators(true, ih->ram_table_ind);
-        }
-        entry = &ram_table[ih->ram_table_ind];
-        entry->hash = ih->hash;
-        entry->bd_offset = ih->bd_base_offset;
-    }
+    update_ram_table(ih->ram_table_ind, ih->new_key, ih->header.flags & delete_flag, ih->hash, ih->bd_base_offset);
 
     _free_space_offset = align_up(ih->bd_curr_offset, _prog_size);
 
@@ -675,11 +742,67 @@ end:
         if (need_gc) {
             garbage_collection();
         }
+#if TDBSTORE_INCREMENTAL_GC_RECORDS_PER_SET
+        else if (ret == MBED_SUCCESS) {
+            // Record is already committed, a failing step only means a full GC will be needed later
+            do_garbage_collection_step(TDBSTORE_INCREMENTAL_GC_RECORDS_PER_SET);
+        }
+#endif
         pal_osMutexRelease(_mutex);
     }
     return ret;
 }
 
+void TDBStore::update_ram_table(uint32_t ram_table_ind, bool new_key, bool deleted, uint32_t hash,
+                                uint32_t bd_offset)
+{
+    ram_table_entry_t *ram_table;
+    ram_table_entry_t *entry;
+    uint32_t gc_next_offset;
+
+    if (deleted) {
+        ram_table = (ram_table_entry_t *) _ram_table;
+        _num_keys--;
+        if (ram_table_ind < _num_keys) {
+            memmove(&ram_table[ram_table_ind], &ram_table[ram_table_ind + 1],
+                    sizeof(ram_table_entry_t) * (_num_keys - ram_table_ind));
+        }
+        update_all_iterators(false, ram_table_ind);
+        if (_gc_in_progress) {
+            // Standby area may already hold a copy of this key, so carry the deletion over as well
+            if (copy_record(_active_area, bd_offset, _gc_to_offset, gc_next_offset) == MBED_SUCCESS) {
+                _gc_to_offset = gc_next_offset;
+            } else {
+                _gc_in_progress = false;
+            }
+            _gc_ram_table_ind = std::min(_gc_ram_table_ind, ram_table_ind);
+        }
+        return;
+    }
+
+    if (new_key) {
+        if (_num_keys >= _max_keys) {
+            increment_max_keys();
+        }
+        ram_table = (ram_table_entry_t *) _ram_table;
+        if (ram_table_ind < _num_keys) {
+            memmove(&ram_table[ram_table_ind + 1], &ram_table[ram_table_ind],
+                    sizeof(ram_table_entry_t) * (_num_keys - ram_table_ind));
+        }
+        _num_keys++;
+        update_all_iterators(true, ram_table_ind);
+    }
+    ram_table = (ram_table_entry_t *) _ram_table;
+    entry = &ram_table[ram_table_ind];
+    entry->hash = hash;
+    entry->gc_offset = 0;
+    entry->bd_offset = bd_offset;
+    // Record (re)written in active area - needs to be migrated (again) by an ongoing GC
+    if (_gc_in_progress) {
+        _gc_ram_table_ind = std::min(_gc_ram_table_ind, ram_table_ind);
+    }
+}
+
 int TDBStore::set(const char *key, const void *buffer, size_t size, uint32_t create_flags)
 {
     int ret;
@@ -709,6 +832,165 @@ int TDBStore::remove(const char *key)
     return set(key, 0, 0, delete_flag);
 }
 
+int TDBStore::set_batch(const batch_item_t *items, size_t count)
+{
+    int os_ret, ret = MBED_SUCCESS;
+    record_header_t header;
+    uint32_t total_size = 0, offset, data_offset, record_offset;
+    uint32_t actual_data_size, hash, flags, next_offset, ram_table_ind;
+    bool need_gc = false;
+    size_t i;
+
+    if (!items && count) {
+        return MBED_ERROR_INVALID_ARGUMENT;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (!is_valid_key(items[i].key) || !strcmp(items[i].key, master_rec_key)) {
+            return MBED_ERROR_INVALID_ARGUMENT;
+        }
+        if (items[i].create_flags & ~supported_flags) {
+            return MBED_ERROR_INVALID_ARGUMENT;
+        }
+        if (!items[i].buffer && items[i].size) {
+            return MBED_ERROR_INVALID_ARGUMENT;
+        }
+        // A key may appear only once, as all items of a batch share one RAM table update
+        for (size_t j = 0; j < i; j++) {
+            if (!strcmp(items[i].key, items[j].key)) {
+                return MBED_ERROR_INVALID_ARGUMENT;
+            }
+        }
+        total_size += record_size(items[i].key, items[i].size);
+    }
+
+    if (!count) {
+        return MBED_SUCCESS;
+    }
+
+    pal_osMutexWait(_mutex, PAL_RTOS_WAIT_FOREVER);
+
+    // The whole batch goes to one contiguous run of records, so make room for all of it
+    if (_free_space_offset + total_size > _size) {
+        ret = garbage_collection();
+        if (ret) {
+            goto end;
+        }
+    }
+
+    if (_free_space_offset + total_size > _size) {
+        ret = MBED_ERROR_MEDIA_FULL;
+        goto end;
+    }
+
+    // Check all keys before writing anything, so that a write protected key fails the entire batch
+    for (i = 0; i < count; i++) {
+        ret = find_record(_active_area, items[i].key, offset, ram_table_ind, hash);
+        if (ret == MBED_SUCCESS) {
+            ret = read_area(_active_area, offset, sizeof(header), &header);
+            if (ret) {
+                goto end;
+            }
+            if (header.flags & WRITE_ONCE_FLAG) {
+                ret = MBED_ERROR_WRITE_PROTECTED;
+                goto end;
+            }
+        } else if (ret != MBED_ERROR_ITEM_NOT_FOUND) {
+            goto end;
+        }
+    }
+
+    ret = check_erase_before_write(_active_area, _free_space_offset, total_size);
+    if (ret) {
+        goto end;
+    }
+
+    // Write the records, all but the last one carrying the batch flag. Until the last one
+    // is written, init will ignore the ones before it.
+    record_offset = _free_space_offset;
+    for (i = 0; i < count; i++) {
+        header.magic = tdbstore_magic;
+        header.header_size = sizeof(record_header_t);
+        header.revision = tdbstore_revision;
+        header.flags = items[i].create_flags | ((i < count - 1) ? batch_flag : 0);
+        header.key_size = strlen(items[i].key);
+        header.reserved = 0;
+        header.data_size = items[i].size;
+        header.crc = calc_crc(initial_crc, sizeof(record_header_t) - sizeof(header.crc), &header);
+        header.crc = calc_crc(header.crc, header.key_size, items[i].key);
+        header.crc = calc_crc(header.crc, header.data_size, items[i].buffer);
+
+        data_offset = record_offset + align_up(sizeof(record_header_t), _prog_size);
+        ret = write_area(_active_area, data_offset, header.key_size, items[i].key);
+        if (!ret) {
+            ret = write_area(_active_area, data_offset + header.key_size, header.data_size, items[i].buffer);
+        }
+        if (!ret) {
+            ret = write_area(_active_area, record_offset, sizeof(record_header_t), &header);
+        }
+        if (ret) {
+            need_gc = true;
+            goto end;
+        }
+        record_offset += record_size(items[i].key, items[i].size);
+    }
+
+    // One flush for the whole batch
+    os_ret = _buff_bd->sync();
+    if (os_ret) {
+        ret = MBED_ERROR_WRITE_FAILED;
+        need_gc = true;
+        goto end;
+    }
+
+    // Writes may fail without returning a failure (especially in flash components). Reread the records
+    // to ensure write success (this won't read the data anywhere - just use the CRC calculation).
+    offset = _free_space_offset;
+    for (i = 0; i < count; i++) {
+        ret = read_record(_active_area, offset, 0, 0, (uint32_t) -1,
+                          actual_data_size, 0, false, false, false, false,
+                          hash, flags, next_offset);
+        if (ret) {
+            need_gc = true;
+            goto end;
+        }
+        offset = next_offset;
+    }
+
+    // Batch is committed, update RAM table
+    record_offset = _free_space_offset;
+    for (i = 0; i < count; i++) {
+        ret = find_record(_active_area, items[i].key, offset, ram_table_ind, hash);
+        if ((ret != MBED_SUCCESS) && (ret != MBED_ERROR_ITEM_NOT_FOUND)) {
+            goto end;
+        }
+        update_ram_table(ram_table_ind, ret == MBED_ERROR_ITEM_NOT_FOUND, false, hash, record_offset);
+        record_offset += record_size(items[i].key, items[i].size);
+    }
+    ret = MBED_SUCCESS;
+
+    _free_space_offset = record_offset;
+
+    // Safety check (see set_finalize)
+    os_ret = read_record(_active_area, _free_space_offset, 0, 0, 0, actual_data_size, 0,
+                         false, false, false, false, hash, flags, next_offset);
+    if (os_ret == MBED_SUCCESS) {
+        check_erase_before_write(_active_area, _free_space_offset, sizeof(record_header_t));
+    }
+
+end:
+    if (need_gc) {
+        garbage_collection();
+    }
+#if TDBSTORE_INCREMENTAL_GC_RECORDS_PER_SET
+    else if (ret == MBED_SUCCESS) {
+        do_garbage_collection_step(TDBSTORE_INCREMENTAL_GC_RECORDS_PER_SET);
+    }
+#endif
+    pal_osMutexRelease(_mutex);
+    return ret;
+}
+
 int TDBStore::get(const char *key, void *buffer, size_t buffer_size, size_t *actual_size, size_t offset)
 {
     int ret;
@@ -770,7 +1052,7 @@ int TDBStore::get_info(const char *key, info_t *info)
     }
 
     if (info) {
-        info->flags = flags;
+        info->flags = flags & ~internal_flags;
         info->size = actual_data_size;
     }
 
@@ -806,8 +1088,34 @@ int TDBStore::copy_record(uint8_t from_area, uint32_t from_offset, uint32_t to_o
     }
 
     total_size = align_up(sizeof(record_header_t), _prog_size) +
-                 align_up(header->key_size + header->data_size, _prog_size);;
-
+                 align_up(header->key_size + header->data_size, _prog_size);
+
+    if (to_offset + total_size > _size) {
+        return MBED_ERROR_MEDIA_FULL;
+    }
+
+    if (header->flags & batch_flag) {
+        // The copy stands on its own, outside of its batch. Drop the flag and recalculate the CRC.
+        record_header_t copy_header;
+        memcpy(&copy_header, header, sizeof(record_header_t));
+        copy_header.flags &= ~batch_flag;
+        uint32_t crc = calc_crc(initial_crc, sizeof(record_header_t) - sizeof(crc), &copy_header);
+        uint32_t offset = from_offset + align_up(sizeof(record_header_t), _prog_size);
+        uint32_t size = copy_header.key_size + copy_header.data_size;
+        while (size) {
+            chunk_size = std::min(size, _prog_size);
+            ret = read_area(from_area, offset, chunk_size, _work_buf);
+            if (ret) {
+                return ret;
+            }
+            crc = calc_crc(crc, chunk_size, _work_buf);
+            offset += chunk_size;
+            size -= chunk_size;
+        }
+        copy_header.crc = crc;
+        memset(_work_buf, 0, _prog_size);
+        memcpy(header, &copy_header, sizeof(record_header_t));
+    }
 
     ret = check_erase_before_write(1 - from_area, to_offset, total_size);
     if (ret) {
@@ -846,18 +1154,94 @@ int TDBStore::copy_record(uint8_t from_area, uint32_t from_offset, uint32_t to_o
 }
 
 int TDBStore::garbage_collection()
+{
+    int ret;
+
+    // Complete an ongoing incremental GC if there is one. If records rewritten while it was in progress
+    // exhausted the standby area, start over - a fresh pass always fits.
+    if (_gc_in_progress) {
+        ret = gc_migrate((size_t) -1);
+        if (ret == MBED_SUCCESS) {
+            return gc_finish();
+        }
+        if (ret != MBED_ERROR_MEDIA_FULL) {
+            return ret;
+        }
+    }
+
+    ret = gc_begin();
+    if (ret) {
+        return ret;
+    }
+
+    ret = gc_migrate((size_t) -1);
+    if (ret) {
+        _gc_in_progress = false;
+        return ret;
+    }
+
+    return gc_finish();
+}
+
+int TDBStore::gc_begin()
 {
     ram_table_entry_t *ram_table = (ram_table_entry_t *) _ram_table;
-    uint32_t to_offset, to_next_offset;
-    uint32_t chunk_size, reserved_size;
     int ret;
-    size_t ind;
 
-    ret = check_erase_before_write(1 - _active_area, 0, _master_record_offset + _master_record_size);
+    // A pass abandoned earlier (_gc_to_offset is only cleared on completion) may have left copies
+    // anywhere up to where it stopped, so erase all of that, not only the master record area.
+    ret = check_erase_before_write(1 - _active_area, 0,
+                                   std::max(_gc_to_offset, _master_record_offset + _master_record_size));
     if (ret) {
         return ret;
     }
 
+    for (size_t ind = 0; ind < _num_keys; ind++) {
+        ram_table[ind].gc_offset = 0;
+    }
+
+    _gc_ram_table_ind = 0;
+    _gc_to_offset = _master_record_offset + _master_record_size;
+    _gc_in_progress = true;
+
+    return MBED_SUCCESS;
+}
+
+int TDBStore::gc_migrate(size_t max_records)
+{
+    ram_table_entry_t *ram_table = (ram_table_entry_t *) _ram_table;
+    uint32_t to_next_offset;
+    int ret;
+
+    // Go over ram table and copy entries not copied yet to opposite area. Entries before
+    // _gc_ram_table_ind are all copied (set_finalize moves it back when rewriting a record).
+    while ((_gc_ram_table_ind < _num_keys) && max_records) {
+        ram_table_entry_t *entry = &ram_table[_gc_ram_table_ind];
+        if (!entry->gc_offset) {
+            ret = copy_record(_active_area, entry->bd_offset, _gc_to_offset, to_next_offset);
+            if (ret) {
+                return ret;
+            }
+            entry->gc_offset = _gc_to_offset;
+            _gc_to_offset = to_next_offset;
+            max_records--;
+        }
+        _gc_ram_table_ind++;
+    }
+
+    return MBED_SUCCESS;
+}
+
+int TDBStore::gc_finish()
+{
+    ram_table_entry_t *ram_table = (ram_table_entry_t *) _ram_table;
+    uint32_t to_offset;
+    uint32_t chunk_size, reserved_size;
+    int ret;
+    size_t ind;
+
+    _gc_in_progress = false;
+
     ret = do_reserved_data_get(0, RESERVED_AREA_SIZE);
 
     if (!ret) {
@@ -880,25 +1264,23 @@ int TDBStore::garbage_collection()
         }
     }
 
-    to_offset = _master_record_offset + _master_record_size;
-
-    // Initialize in case table is empty
-    to_next_offset = to_offset;
-
-    // Go over ram table and copy all entries to opposite area
-    for (ind = 0; ind < _num_keys; ind++) {
-        uint32_t from_offset = ram_table[ind].bd_offset;
-        ret = copy_record(_active_area, from_offset, to_offset, to_next_offset);
+    // If the last copy ended exactly on an erase unit boundary, the next unit was never erased.
+    // Erase it now, so that init won't take its old contents for a corrupt record.
+    if (_gc_to_offset < _size) {
+        ret = check_erase_before_write(1 - _active_area, _gc_to_offset, sizeof(record_header_t));
         if (ret) {
             return ret;
         }
-        // Update RAM table
-        ram_table[ind].bd_offset = to_offset;
-        to_offset = to_next_offset;
     }
 
-    to_offset = to_next_offset;
-    _free_space_offset = to_next_offset;
+    // Update RAM table
+    for (ind = 0; ind < _num_keys; ind++) {
+        ram_table[ind].bd_offset = ram_table[ind].gc_offset;
+        ram_table[ind].gc_offset = 0;
+    }
+
+    _free_space_offset = _gc_to_offset;
+    _gc_to_offset = 0;
 
     // Now we can switch to the new active area
     _active_area = 1 - _active_area;
@@ -919,16 +1301,67 @@ int TDBStore::garbage_collection()
     return MBED_SUCCESS;
 }
 
+int TDBStore::do_garbage_collection_step(size_t max_records)
+{
+    int ret;
+
+    if (!_gc_in_progress) {
+        if (_free_space_offset <= (uint64_t) _size * TDBSTORE_INCREMENTAL_GC_START_PERCENT / 100) {
+            return MBED_SUCCESS;
+        }
+        ret = gc_begin();
+        if (ret) {
+            return ret;
+        }
+    }
+
+    ret = gc_migrate(max_records);
+    if (ret == MBED_ERROR_MEDIA_FULL) {
+        // Too many records were rewritten while migrating - start over on next step
+        _gc_in_progress = false;
+        return MBED_SUCCESS;
+    }
+    if (ret) {
+        _gc_in_progress = false;
+        return ret;
+    }
+
+    if (_gc_ram_table_ind >= _num_keys) {
+        return gc_finish();
+    }
+
+    return MBED_SUCCESS;
+}
+
+int TDBStore::garbage_collection_step(size_t max_records, bool *in_progress)
+{
+    int ret;
+
+    if (!_is_initialized) {
+        return MBED_ERROR_NOT_READY;
+    }
+
+    pal_osMutexWait(_mutex, PAL_RTOS_WAIT_FOREVER);
+
+    ret = do_garbage_collection_step(max_records);
+    if (in_progress) {
+        *in_progress = _gc_in_progress;
+    }
+
+    pal_osMutexRelease(_mutex);
+    return ret;
+}
+
 
 int TDBStore::build_ram_table()
 {
-    ram_table_entry_t *ram_table = (ram_table_entry_t *) _ram_table;
     uint32_t offset, next_offset = 0, dummy;
     int ret = MBED_SUCCESS;
     uint32_t hash;
     uint32_t flags;
     uint32_t actual_data_size;
     uint32_t ram_table_ind;
+    uint32_t batch_offset = 0, batch_end = 0;
 
     _num_keys = 0;
     offset = _master_record_offset;
@@ -941,6 +1374,24 @@ int TDBStore::build_ram_table()
             goto end;
         }
 
+        // Records of a batch (all but the last one carry the batch flag) only take effect once
+        // its last record is found. Then go back and replay the whole batch.
+        if (offset >= batch_end) {
+            if (flags & batch_flag) {
+                if (!batch_offset) {
+                    batch_offset = offset;
+                }
+                offset = next_offset;
+                continue;
+            }
+            if (batch_offset) {
+                batch_end = next_offset;
+                offset = batch_offset;
+                batch_offset = 0;
+                continue;
+            }
+        }
+
         ret = find_record(_active_area, _key_buf, dummy, ram_table_ind, hash);
 
         if ((ret != MBED_SUCCESS) && (ret != MBED_ERROR_ITEM_NOT_FOUND)) {
@@ -950,36 +1401,23 @@ int TDBStore::build_ram_table()
         uint32_t save_offset = offset;
         offset = next_offset;
 
-        if (ret == MBED_ERROR_ITEM_NOT_FOUND) {
-            // Key doesn't exist, need to add it to RAM table
+        if ((ret == MBED_ERROR_ITEM_NOT_FOUND) && (flags & delete_flag)) {
+            // Deleting a key that doesn't exist
             ret = MBED_SUCCESS;
-
-            if (flags & delete_flag) {
-                continue;
-            }
-            if (_num_keys >= _max_keys) {
-                // In order to avoid numerous reallocations of ram table,
-                // Add a chunk of entries now
-                increment_max_keys(reinterpret_cast<void **>(&ram_table));
-            }
-            memmove(&ram_table[ram_table_ind + 1], &ram_table[ram_table_ind],
-                    sizeof(ram_table_entry_t) * (_num_keys - ram_table_ind));
-
-            _num_keys++;
-        } else if (flags & delete_flag) {
-            _num_keys--;
-            memmove(&ram_table[ram_table_ind], &ram_table[ram_table_ind + 1],
-                    sizeof(ram_table_entry_t) * (_num_keys - ram_table_ind));
-
             continue;
         }
 
-        // update record parameters
-        ram_table[ram_table_ind].hash = hash;
-        ram_table[ram_table_ind].bd_offset = save_offset;
+        update_ram_table(ram_table_ind, ret == MBED_ERROR_ITEM_NOT_FOUND, flags & delete_flag, hash, save_offset);
+        ret = MBED_SUCCESS;
     }
 
 end:
+    if (batch_offset) {
+        // A batch was interrupted before its last record was written. Treat it as corrupt data,
+        // so init collects garbage (dropping it) instead of appending records after it.
+        next_offset = batch_offset;
+        ret = MBED_ERROR_INVALID_DATA_DETECTED;
+    }
     _free_space_offset = next_offset;
     return ret;
 }
@@ -1030,6 +1468,8 @@ int TDBStore::init()
     memset(ram_table, 0, sizeof(ram_table_entry_t) * _max_keys);
     _ram_table = ram_table;
     _num_keys = 0;
+    _gc_in_progress = false;
+    _gc_to_offset = 0;
 
     _size = (size_t) -1;
 
@@ -1143,7 +1583,7 @@ int TDBStore::init()
         ret = garbage_collection();
         assert(ret == 0);
         os_ret = _buff_bd->sync();
-        assert(os_ret);
+        assert(!os_ret);
     }
 
 end:
@@ -1211,6 +1651,8 @@ int TDBStore::reset()
 
     _active_area = 0;
     _num_keys = 0;
+    _gc_in_progress = false;
+    _gc_to_offset = 0;
     _free_space_offset = _master_record_offset;
     _active_area_version = 1;
     memset(_ram_table, 0, sizeof(ram_table_entry_t) * _max_keys);
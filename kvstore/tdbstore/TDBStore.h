@@ -153,6 +153,25 @@ public:
      */
     virtual int remove(const char *key);
 
+    /**
+     * @brief Set several TDBStore items atomically. All records are written in one go and flushed
+     *        once; they only take effect (in RAM and on the next init) if the whole batch made it
+     *        to the media.
+     *
+     * @param[in]  items                Items to set.
+     * @param[in]  count                Number of items.
+     *
+     * @returns MBED_SUCCESS                        Success.
+     *          MBED_ERROR_NOT_READY                Not initialized.
+     *          MBED_ERROR_READ_FAILED              Unable to read from media.
+     *          MBED_ERROR_WRITE_FAILED             Unable to write to media.
+     *          MBED_ERROR_INVALID_ARGUMENT         Invalid argument given in function arguments
+     *                                              (including a key appearing twice in the batch).
+     *          MBED_ERROR_MEDIA_FULL               Not enough room on media.
+     *          MBED_ERROR_WRITE_PROTECTED          Already stored with "write once" flag.
+     */
+    virtual int set_batch(const batch_item_t *items, size_t count);
+
 
     /**
      * @brief Start an incremental TDBStore set sequence. This operation is blocking other operations.
@@ -279,6 +298,24 @@ public:
     virtual int reserved_data_get(void *reserved_data, size_t reserved_data_buf_size,
                                   size_t *actual_data_size = 0);
 
+    /**
+     * @brief Perform a bounded part of garbage collection, e.g. from an idle hook.
+     *        If no collection is in progress, one is started only once the active area
+     *        is more than TDBSTORE_INCREMENTAL_GC_START_PERCENT full. Records are migrated
+     *        to the standby area, which becomes active (via a new master record) after the
+     *        last one has been copied. Until then, the active area is left untouched, so
+     *        a power failure simply discards the partial copy.
+     *
+     * @param[in]  max_records          Maximum number of records to migrate in this call.
+     * @param[out] in_progress          Whether collection still has work left (optional).
+     *
+     * @returns MBED_SUCCESS                        Success.
+     *          MBED_ERROR_NOT_READY                Not initialized.
+     *          MBED_ERROR_READ_FAILED              Unable to read from media.
+     *          MBED_ERROR_WRITE_FAILED             Unable to write to media.
+     */
+    int garbage_collection_step(size_t max_records, bool *in_progress = 0);
+
 #if !defined(DOXYGEN_ONLY)
 private:
 
@@ -310,6 +347,9 @@ private:
     char *_key_buf;
     bool _variant_bd_erase_unit_size;
     void *_inc_set_handle;
+    bool _gc_in_progress;
+    uint32_t _gc_ram_table_ind;
+    uint32_t _gc_to_offset;
     void *_iterator_table[_max_open_iterators];
 
     /**
@@ -417,6 +457,41 @@ private:
      */
     int garbage_collection();
 
+    /**
+     * @brief Start an incremental garbage collection (erase standby area start, mark all records
+     *        as not migrated).
+     *
+     * @returns 0 for success, nonzero for failure.
+     */
+    int gc_begin();
+
+    /**
+     * @brief Migrate records not yet copied to the standby area.
+     *
+     * @param[in]  max_records            Maximum number of records to copy.
+     *
+     * @returns 0 for success, MBED_ERROR_MEDIA_FULL if standby area ran out of space,
+     *          other nonzero for failure.
+     */
+    int gc_migrate(size_t max_records);
+
+    /**
+     * @brief Complete an incremental garbage collection once all records are migrated
+     *        (copy reserved data, switch areas and write the new master record).
+     *
+     * @returns 0 for success, nonzero for failure.
+     */
+    int gc_finish();
+
+    /**
+     * @brief Actual logic of garbage_collection_step (unprotected by mutex).
+     *
+     * @param[in]  max_records            Maximum number of records to migrate.
+     *
+     * @returns 0 for success, nonzero for failure.
+     */
+    int do_garbage_collection_step(size_t max_records);
+
     /**
      * @brief Return record size given key and data size.
      *
@@ -475,6 +550,19 @@ private:
      */
     int build_ram_table();
 
+    /**
+     * @brief Update RAM table after a record was committed.
+     *
+     * @param[in]  ram_table_ind          RAM table index (target one if key is new).
+     * @param[in]  new_key                Key doesn't exist in RAM table yet.
+     * @param[in]  deleted                Record deletes the key.
+     * @param[in]  hash                   Key hash.
+     * @param[in]  bd_offset              Record offset in active area.
+     *
+     * @returns none
+     */
+    void update_ram_table(uint32_t ram_table_ind, bool new_key, bool deleted, uint32_t hash, uint32_t bd_offset);
+
     /**
      * @brief Increment maximum number of keys and reallocate RAM table accordingly.
      *
@@ -67,6 +67,22 @@
     #define PAL_NET_TEST_MAX_ASYNC_SOCKETS 	5
 #endif
 
+#ifndef PAL_NET_SEND_BATCH_SUPPORT
+    // pal_sendToBatch() is implemented with sendmmsg()
+    #define PAL_NET_SEND_BATCH_SUPPORT true
+#endif
+
+#ifndef PAL_NET_RECV_BATCH_SUPPORT
+    // pal_receiveFromBatch() is implemented with recvmmsg()
+    #define PAL_NET_RECV_BATCH_SUPPORT true
+#endif
+
+#ifndef PAL_NET_LINUX_USE_EPOLL
+    // Use an edge-triggered epoll() backend for the asynchronous socket manager instead of
+    // O_ASYNC/SIGIO + ppoll(). Leaves SIGIO and SIGUSR1 free for the application.
+    #define PAL_NET_LINUX_USE_EPOLL 0
+#endif
+
 // 16KB does not seem to be enough, some tests are failing with it
 #ifndef PAL_NET_TEST_ASYNC_SOCKET_MANAGER_THREAD_STACK_SIZE
     #define PAL_NET_TEST_ASYNC_SOCKET_MANAGER_THREAD_STACK_SIZE (1024 * 24)
@@ -162,6 +178,12 @@
     #define PAL_TIMER_SIGNAL (SIGRTMIN+0)
 #endif
 
+#ifndef PAL_RTOS_LINUX_TIMER_WHEEL
+    // Run the PAL timers on a user-space timer wheel serviced by a single thread sleeping on a timerfd,
+    // instead of one POSIX timer and PAL_TIMER_SIGNAL delivery per PAL timer.
+    #define PAL_RTOS_LINUX_TIMER_WHEEL 0
+#endif
+
 #ifndef PAL_USE_HW_ROT
     #define PAL_USE_HW_ROT 0
 #endif
@@ -320,6 +320,46 @@ palStatus_t pal_receiveFrom(palSocket_t socket, void* buffer, size_t length, pal
 }
 
 
+palStatus_t pal_receiveFromBatch(palSocket_t socket, palSocketRecvBatchItem_t* items, uint32_t count, uint32_t* itemsReceived)
+{
+
+    PAL_VALIDATE_ARGUMENTS(((NULL == items) && (count > 0)) || (NULL == itemsReceived));
+
+    palStatus_t result = PAL_SUCCESS;
+    *itemsReceived = 0;
+
+    if (count == 0) {
+        return result;
+    }
+
+#if PAL_NET_RECV_BATCH_SUPPORT
+    result = pal_plat_receiveFromBatch(socket, items, count, itemsReceived);
+#else
+    bool isNonBlocking = false;
+    pal_plat_isNonBlocking(socket, &isNonBlocking);
+
+    while (*itemsReceived < count) {
+        palSocketRecvBatchItem_t *item = &items[*itemsReceived];
+        result = pal_plat_receiveFrom(socket, item->buffer, item->length, item->from, &item->fromLength, &item->bytesReceived);
+        if (result != PAL_SUCCESS) {
+            break;
+        }
+        (*itemsReceived)++;
+        // on a blocking socket the next receive could wait for data, so only one datagram is read
+        if (!isNonBlocking) {
+            break;
+        }
+    }
+
+    // the datagrams already received make this a success, the error is seen again on the next call
+    if (*itemsReceived > 0) {
+        result = PAL_SUCCESS;
+    }
+#endif
+    return result;
+}
+
+
 palStatus_t pal_sendTo(palSocket_t socket, const void* buffer, size_t length, const palSocketAddress_t* to, palSocketLength_t toLength, size_t* bytesSent)
 {
 
@@ -330,6 +370,38 @@ palStatus_t pal_sendTo(palSocket_t socket, const void* buffer, size_t length, co
     return result; // TODO(nirson01) ADD debug print for error propagation(once debug print infrastructure is finalized)
 }
 
+palStatus_t pal_sendToBatch(palSocket_t socket, const palSocketSendBatchItem_t* items, uint32_t count, const palSocketAddress_t* to, palSocketLength_t toLength, uint32_t* itemsSent)
+{
+
+    PAL_VALIDATE_ARGUMENTS(((NULL == items) && (count > 0)) || (NULL == itemsSent) || (NULL == to));
+
+    palStatus_t result = PAL_SUCCESS;
+    *itemsSent = 0;
+
+    if (count == 0) {
+        return result;
+    }
+
+#if PAL_NET_SEND_BATCH_SUPPORT
+    result = pal_plat_sendToBatch(socket, items, count, to, toLength, itemsSent);
+#else
+    while (*itemsSent < count) {
+        size_t bytesSent = 0;
+        result = pal_plat_sendTo(socket, items[*itemsSent].buffer, items[*itemsSent].length, to, toLength, &bytesSent);
+        if (result != PAL_SUCCESS) {
+            break;
+        }
+        (*itemsSent)++;
+    }
+
+    // a partially sent batch is a success, the caller retries the rest
+    if (*itemsSent > 0) {
+        result = PAL_SUCCESS;
+    }
+#endif
+    return result;
+}
+
 
 palStatus_t pal_close(palSocket_t* socket)
 {
@@ -143,6 +143,14 @@
     #define PAL_NET_SERVER_SOCKET_API                 true //!< Add PAL support for server socket.
 #endif
 
+#ifndef PAL_NET_SEND_BATCH_SUPPORT
+    #define PAL_NET_SEND_BATCH_SUPPORT                false //!< The platform implements pal_plat_sendToBatch(), otherwise pal_sendToBatch() calls pal_plat_sendTo() for each datagram.
+#endif
+
+#ifndef PAL_NET_RECV_BATCH_SUPPORT
+    #define PAL_NET_RECV_BATCH_SUPPORT                false //!< The platform implements pal_plat_receiveFromBatch(), otherwise pal_receiveFromBatch() calls pal_plat_receiveFrom() for each datagram.
+#endif
+
 #ifndef PAL_SUPPORT_IP_V4
     #define PAL_SUPPORT_IP_V4                 1 //!< support IPV4 as default
 #endif
@@ -114,6 +114,21 @@ typedef uint8_t palIpV6Addr_t[PAL_IPV6_ADDRESS_SIZE];
 
 typedef void(*connectionStatusCallback)(palNetworkStatus_t status, void *client_arg);
 
+/*! \brief One datagram of a `pal_sendToBatch()` call. */
+typedef struct palSocketSendBatchItem {
+    const void *buffer;
+    size_t length;
+} palSocketSendBatchItem_t;
+
+/*! \brief One datagram of a `pal_receiveFromBatch()` call. */
+typedef struct palSocketRecvBatchItem {
+    void *buffer;           //!< The buffer for the payload data.
+    size_t length;          //!< The length of `buffer`.
+    size_t bytesReceived;   //!< The amount of payload data received in `buffer`, set by `pal_receiveFromBatch()`.
+    palSocketAddress_t *from;       //!< Optional, set to the address that sent the datagram. NULL if not needed.
+    palSocketLength_t fromLength;   //!< The length of the `from` address, set by `pal_receiveFromBatch()`. 0 if it could not be read.
+} palSocketRecvBatchItem_t;
+
 /*! \brief Register a network interface for use with PAL sockets.
  *
  * Must be called before other socket functions. Most APIs will not work before an interface is added.
@@ -230,6 +245,20 @@ palStatus_t pal_bind(palSocket_t socket, palSocketAddress_t *myAddress, palSocke
  */
 palStatus_t pal_receiveFrom(palSocket_t socket, void *buffer, size_t length, palSocketAddress_t *from, palSocketLength_t *fromLength, size_t *bytesReceived);
 
+/*! \brief Receive several queued datagrams from a specific socket.
+ *
+ * Datagrams are received in order, one per item, until `count` items are filled or no more data is available.
+ * Where the platform supports it (`PAL_NET_RECV_BATCH_SUPPORT`), the whole batch is read from the network stack at once.
+ * The address that sent each datagram is returned in the `from` of its item, unless `from` is NULL.
+ * A blocking socket waits for the first datagram like `pal_receiveFrom()`, but not for the rest of the batch.
+ * @param[in] socket The socket to receive from. The socket passed to this function should be of type `PAL_SOCK_DGRAM`.
+ * @param[in,out] items The buffers for the datagrams. `bytesReceived` is set for each item that was filled.
+ * @param[in] count The number of items in `items`.
+ * @param[out] itemsReceived The number of datagrams received, counted from the start of `items`.
+ * \return PAL_SUCCESS (0) if at least one datagram was received or `count` is zero, otherwise the error of the first receive, such as `PAL_ERR_SOCKET_WOULD_BLOCK`.
+ */
+palStatus_t pal_receiveFromBatch(palSocket_t socket, palSocketRecvBatchItem_t *items, uint32_t count, uint32_t *itemsReceived);
+
 /*! \brief Send a payload to an address using a specific socket.
  * @param[in] socket The socket to use for sending the payload. The socket passed to this function should usually be of type `PAL_SOCK_DGRAM`, though your specific implementation may support other types as well.
  * @param[in] buffer The buffer for the payload data.
@@ -241,6 +270,20 @@ palStatus_t pal_receiveFrom(palSocket_t socket, void *buffer, size_t length, pal
  */
 palStatus_t pal_sendTo(palSocket_t socket, const void *buffer, size_t length, const palSocketAddress_t *to, palSocketLength_t toLength, size_t *bytesSent);
 
+/*! \brief Send several datagrams to the same address using a specific socket.
+ *
+ * The datagrams are sent in order, and sending stops at the first one that fails.
+ * Where the platform supports it (`PAL_NET_SEND_BATCH_SUPPORT`), the whole batch is handed to the network stack at once.
+ * @param[in] socket The socket to use for sending the payloads. The socket passed to this function should be of type `PAL_SOCK_DGRAM`.
+ * @param[in] items The datagrams to send.
+ * @param[in] count The number of datagrams in `items`.
+ * @param[in] to The address to which the datagrams should be sent.
+ * @param[in] toLength The length of the `to` address.
+ * @param[out] itemsSent The number of datagrams sent, counted from the start of `items`.
+ * \return PAL_SUCCESS (0) if at least one datagram was sent or `count` is zero, otherwise the error of the first datagram.
+ */
+palStatus_t pal_sendToBatch(palSocket_t socket, const palSocketSendBatchItem_t *items, uint32_t count, const palSocketAddress_t *to, palSocketLength_t toLength, uint32_t *itemsSent);
+
 /*! \brief Close a network socket.
  * @param[in,out] socket The socket to be closed.
  * \return PAL_SUCCESS (0) in case of success, or a specific negative error code in case of failure.
@@ -33,6 +33,8 @@ extern "C" {
  * PAL network socket configuration options:
  * - define PAL_NET_TCP_AND_TLS_SUPPORT if TCP is supported by the platform and is required.
  * - define PAL_NET_DNS_SUPPORT if DNS name resolution is supported.
+ * - define PAL_NET_SEND_BATCH_SUPPORT if the platform implements pal_plat_sendToBatch().
+ * - define PAL_NET_RECV_BATCH_SUPPORT if the platform implements pal_plat_receiveFromBatch().
  */
 
 /*! \brief Initialize sockets.
@@ -126,6 +128,31 @@ palStatus_t pal_plat_receiveFrom(palSocket_t socket, void* buffer, size_t length
  */
 palStatus_t pal_plat_sendTo(palSocket_t socket, const void* buffer, size_t length, const palSocketAddress_t* to, palSocketLength_t toLength, size_t* bytesSent);
 
+#if PAL_NET_SEND_BATCH_SUPPORT
+/*! \brief Send several datagrams to an address using a specific socket.
+ * @param[in] socket The socket to use for sending the payloads. The socket passed to this function should be of type `PAL_SOCK_DGRAM`.
+ * @param[in] items The datagrams to send, in order.
+ * @param[in] count The number of datagrams in `items`, at least one.
+ * @param[in] to The address to which the datagrams should be sent.
+ * @param[in] toLength The length of the `to` address.
+ * @param[out] itemsSent The number of datagrams sent, counted from the start of `items`.
+ * \return PAL_SUCCESS (0) if at least one datagram was sent. The error of the first datagram otherwise.
+ */
+palStatus_t pal_plat_sendToBatch(palSocket_t socket, const palSocketSendBatchItem_t* items, uint32_t count, const palSocketAddress_t* to, palSocketLength_t toLength, uint32_t* itemsSent);
+#endif
+
+#if PAL_NET_RECV_BATCH_SUPPORT
+/*! \brief Receive several queued datagrams from a specific socket.
+ * A blocking socket waits for the first datagram only, the rest of the batch is read without waiting.
+ * @param[in] socket The socket to receive from. The socket passed to this function should be of type `PAL_SOCK_DGRAM`.
+ * @param[in,out] items The buffers for the datagrams, `bytesReceived` is set for each item filled.
+ * @param[in] count The number of items in `items`, at least one.
+ * @param[out] itemsReceived The number of datagrams received, counted from the start of `items`.
+ * \return PAL_SUCCESS (0) if at least one datagram was received. The error of the first receive otherwise.
+ */
+palStatus_t pal_plat_receiveFromBatch(palSocket_t socket, palSocketRecvBatchItem_t* items, uint32_t count, uint32_t* itemsReceived);
+#endif
+
 /*! \brief Close a network socket.
  * \note The function recieves `palSocket_t*` and not `palSocket_t` so that it can zero the socket to avoid re-use.
  * @param[in,out] socket Pointer to the socket to release and zero.
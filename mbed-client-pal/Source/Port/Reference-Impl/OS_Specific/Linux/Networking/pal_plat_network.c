@@ -40,6 +40,11 @@
 #include <time.h>
 #include <assert.h>
 
+#if PAL_NET_LINUX_USE_EPOLL
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
 #define TRACE_GROUP "PAL"
 
 #ifdef PAL_NET_TCP_AND_TLS_SUPPORT
@@ -127,6 +132,9 @@ static pthread_t s_pollThread = NULLPTR;
 static palMutexID_t s_mutexSocketCallbacks = 0;
 static palMutexID_t s_mutexSocketEventFilter = 0;
 static palSemaphoreID_t s_socketCallbackSemaphore = 0;
+
+#if !PAL_NET_LINUX_USE_EPOLL
+
 static palSemaphoreID_t s_socketCallbackSignalSemaphore = 0;
 
 // These must be updated only when protected by s_mutexSocketCallbacks
@@ -355,6 +363,177 @@ PAL_PRIVATE void asyncSocketManager(void const* arg)
     }  // while
 }
 
+#else // PAL_NET_LINUX_USE_EPOLL
+
+// epoll user data of the wakeup eventfd. Sockets use their s_asyncSockets index in the low 32 bits
+// and the generation of the entry in the high 32 bits.
+#define PAL_ASYNC_SOCKET_WAKEUP_INDEX UINT32_MAX
+
+typedef struct palAsyncSocket {
+    int fd;                             // PAL_LINUX_INVALID_SOCKET when the entry is free
+    uint32_t generation;                // Bumped on every registration, so events for a closed socket can be dropped
+    palAsyncSocketCallback_t callback;
+    void* callbackArg;
+} palAsyncSocket_t;
+
+// These must be updated only when protected by s_mutexSocketCallbacks
+static palAsyncSocket_t s_asyncSockets[PAL_NET_TEST_MAX_ASYNC_SOCKETS];
+static int s_epollFD = PAL_LINUX_INVALID_SOCKET;
+static int s_wakeupFD = PAL_LINUX_INVALID_SOCKET;
+static volatile bool s_socketThreadTerminateRequested = false;
+static volatile bool s_socketThreadTerminateSignaled = false;
+
+// Sockets are registered edge-triggered, so a socket that stays writable does not keep
+// reporting POLLOUT and no per-socket event filter is needed.
+PAL_PRIVATE void clearSocketFilter(int socketFD)
+{
+    PAL_UNUSED_ARG(socketFD);
+}
+
+PAL_PRIVATE palStatus_t asyncSocketManagerCreate(void)
+{
+    struct epoll_event event = {0};
+    int i;
+
+    for (i = 0; i < PAL_NET_TEST_MAX_ASYNC_SOCKETS; i++)
+    {
+        s_asyncSockets[i].fd = PAL_LINUX_INVALID_SOCKET;
+        s_asyncSockets[i].callback = NULL;
+        s_asyncSockets[i].callbackArg = NULL;
+    }
+
+    s_epollFD = epoll_create1(EPOLL_CLOEXEC);
+    if (s_epollFD == -1)
+    {
+        PAL_LOG_ERR("epoll_create1 failed %d", errno);
+        return PAL_ERR_SOCKET_GENERIC;
+    }
+
+    // Used to wake up the thread for termination. Socket registration changes don't need it,
+    // epoll_ctl() takes effect on an ongoing epoll_wait().
+    s_wakeupFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    event.events = EPOLLIN;
+    event.data.u64 = PAL_ASYNC_SOCKET_WAKEUP_INDEX;
+    if ((s_wakeupFD == -1) || (epoll_ctl(s_epollFD, EPOLL_CTL_ADD, s_wakeupFD, &event) == -1))
+    {
+        PAL_LOG_ERR("eventfd setup failed %d", errno);
+        if (s_wakeupFD != -1)
+        {
+            close(s_wakeupFD);
+            s_wakeupFD = PAL_LINUX_INVALID_SOCKET;
+        }
+        close(s_epollFD);
+        s_epollFD = PAL_LINUX_INVALID_SOCKET;
+        return PAL_ERR_SOCKET_GENERIC;
+    }
+
+    s_socketThreadTerminateRequested = false;
+    return PAL_SUCCESS;
+}
+
+PAL_PRIVATE void asyncSocketManagerDestroy(void)
+{
+    close(s_wakeupFD);
+    s_wakeupFD = PAL_LINUX_INVALID_SOCKET;
+    close(s_epollFD);
+    s_epollFD = PAL_LINUX_INVALID_SOCKET;
+}
+
+PAL_PRIVATE void asyncSocketManagerWakeup(void)
+{
+    uint64_t value = 1;
+    // Can fail only if the counter would overflow, and then the thread is due to wake up anyway
+    if (write(s_wakeupFD, &value, sizeof(value)) != sizeof(value))
+    {
+        PAL_LOG_DBG("async socket manager wakeup write failed %d", errno);
+    }
+}
+
+// Thread function.
+PAL_PRIVATE void asyncSocketManager(void const* arg)
+{
+    PAL_UNUSED_ARG(arg); // unused
+    struct epoll_event events[PAL_NET_TEST_MAX_ASYNC_SOCKETS + 1];
+    palAsyncSocketCallback_t callback;
+    void* callbackArg = NULL;
+    palStatus_t result;
+    int count;
+    int i;
+
+    s_pollThread = pthread_self();
+    // Tell the calling thread that we have finished initialization
+    result = pal_osSemaphoreRelease(s_socketCallbackSemaphore);
+    if (result != PAL_SUCCESS)
+    {
+        PAL_LOG_ERR("Error in async socket manager on semaphore release");
+    }
+
+    while (!s_socketThreadTerminateRequested)
+    {
+        count = epoll_wait(s_epollFD, events, PAL_NET_TEST_MAX_ASYNC_SOCKETS + 1, -1);
+        if (count == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            PAL_LOG_ERR("Error in async socket manager %d", errno);
+            break;
+        }
+
+        for (i = 0; i < count; i++)
+        {
+            uint32_t index = (uint32_t)events[i].data.u64;
+            uint32_t generation = (uint32_t)(events[i].data.u64 >> 32);
+
+            if (index == PAL_ASYNC_SOCKET_WAKEUP_INDEX)
+            {
+                uint64_t value;
+                if (read(s_wakeupFD, &value, sizeof(value)) != sizeof(value))
+                {
+                    PAL_LOG_DBG("async socket manager wakeup read failed %d", errno);
+                }
+                continue;
+            }
+
+            // Linux reports this event combination once for sockets which are not connected yet,
+            // it is not a real event (same filtering as in the ppoll() based manager).
+            if (events[i].events == (EPOLLOUT | EPOLLHUP))
+            {
+                continue;
+            }
+
+            callback = NULL;
+            result = pal_osMutexWait(s_mutexSocketCallbacks, PAL_RTOS_WAIT_FOREVER);
+            if (PAL_SUCCESS != result)
+            {
+                PAL_LOG_ERR("Error in async socket manager on mutex wait");
+                continue;
+            }
+            // Socket may have been closed after the event was queued
+            if ((s_asyncSockets[index].fd != PAL_LINUX_INVALID_SOCKET) && (s_asyncSockets[index].generation == generation))
+            {
+                callback = s_asyncSockets[index].callback;
+                callbackArg = s_asyncSockets[index].callbackArg;
+            }
+            result = pal_osMutexRelease(s_mutexSocketCallbacks);
+            if (PAL_SUCCESS != result)
+            {
+                PAL_LOG_ERR("Error in async socket manager on mutex release");
+            }
+
+            if (callback)
+            {
+                callback(callbackArg);
+            }
+        }
+    }
+
+    s_socketThreadTerminateSignaled = true; // mark that the thread has receieved the termination request
+}
+
+#endif // PAL_NET_LINUX_USE_EPOLL
+
 
 PAL_PRIVATE palStatus_t pal_plat_SockAddrToSocketAddress(const palSocketAddress_t* palAddr, struct sockaddr* output)
 {
@@ -477,7 +656,11 @@ palStatus_t pal_plat_socketsInit(void* context)
         return result;
     }
 
+#if PAL_NET_LINUX_USE_EPOLL
+    result = asyncSocketManagerCreate();
+#else
     result = pal_osSemaphoreCreate(0, &s_socketCallbackSignalSemaphore);
+#endif
     if (result != PAL_SUCCESS)
     {
         // todo: clean up the mess created so far
@@ -591,6 +774,10 @@ palStatus_t pal_plat_socketsTerminate(void* context)
         firstError = result;
     }
 
+#if PAL_NET_LINUX_USE_EPOLL
+    s_socketThreadTerminateRequested = true;
+    asyncSocketManagerWakeup();
+#else
     s_nfds = PAL_SOCKETS_TERMINATE;
     result = pal_osSemaphoreRelease(s_socketCallbackSignalSemaphore);
     if ((PAL_SUCCESS != result) && (PAL_SUCCESS == firstError))
@@ -603,6 +790,7 @@ palStatus_t pal_plat_socketsTerminate(void* context)
     {
         pthread_kill(s_pollThread, SIGUSR1);
     }
+#endif
 
     result = pal_osMutexRelease(s_mutexSocketCallbacks);
     if ((PAL_SUCCESS != result) && (PAL_SUCCESS == firstError))
@@ -616,12 +804,16 @@ palStatus_t pal_plat_socketsTerminate(void* context)
         pal_osDelay(10);
     }
 
+#if PAL_NET_LINUX_USE_EPOLL
+    asyncSocketManagerDestroy();
+#else
     result = pal_osSemaphoreDelete(&s_socketCallbackSignalSemaphore);
     if ((PAL_SUCCESS != result) && (PAL_SUCCESS == firstError))
     {
         // TODO print error using logging mechanism when available.
         firstError = result;
     }
+#endif
 
     result = pal_osMutexDelete(&s_mutexSocketEventFilter);
     if ((PAL_SUCCESS != result) && (PAL_SUCCESS == firstError))
@@ -850,11 +1042,151 @@ palStatus_t pal_plat_sendTo(palSocket_t socket, const void* buffer, size_t lengt
     return result;
 }
 
+#if PAL_NET_SEND_BATCH_SUPPORT
+// Number of datagrams passed to one sendmmsg() call
+#define PAL_NET_LINUX_SEND_BATCH_MAX 32
+
+palStatus_t pal_plat_sendToBatch(palSocket_t socket, const palSocketSendBatchItem_t* items, uint32_t count, const palSocketAddress_t* to, palSocketLength_t toLength, uint32_t* itemsSent)
+{
+    palStatus_t result = PAL_SUCCESS;
+    struct mmsghdr msgs[PAL_NET_LINUX_SEND_BATCH_MAX];
+    struct iovec iovecs[PAL_NET_LINUX_SEND_BATCH_MAX];
+    uint32_t sent = 0;
+
+    clearSocketFilter((intptr_t)socket);
+
+    while (sent < count)
+    {
+        unsigned int chunk = count - sent;
+        unsigned int i;
+        int res;
+
+        if (chunk > PAL_NET_LINUX_SEND_BATCH_MAX)
+        {
+            chunk = PAL_NET_LINUX_SEND_BATCH_MAX;
+        }
+
+        memset(msgs, 0, sizeof(struct mmsghdr) * chunk);
+
+        for (i = 0; i < chunk; i++)
+        {
+            iovecs[i].iov_base = (void*)items[sent + i].buffer;
+            iovecs[i].iov_len = items[sent + i].length;
+            msgs[i].msg_hdr.msg_name = (void*)to;
+            msgs[i].msg_hdr.msg_namelen = toLength;
+            msgs[i].msg_hdr.msg_iov = &iovecs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        res = sendmmsg((intptr_t)socket, msgs, chunk, 0);
+        if (res == -1)
+        {
+            // the datagrams already sent make this a success, the error will be seen on the next call
+            if (sent == 0)
+            {
+                result = translateErrorToPALError(errno);
+            }
+            break;
+        }
+
+        sent += res;
+
+        if ((unsigned int)res < chunk)
+        {
+            break;
+        }
+    }
+
+    *itemsSent = sent;
+
+    return result;
+}
+#endif // PAL_NET_SEND_BATCH_SUPPORT
+
+#if PAL_NET_RECV_BATCH_SUPPORT
+// Number of datagrams read by one recvmmsg() call
+#define PAL_NET_LINUX_RECV_BATCH_MAX 32
+
+palStatus_t pal_plat_receiveFromBatch(palSocket_t socket, palSocketRecvBatchItem_t* items, uint32_t count, uint32_t* itemsReceived)
+{
+    palStatus_t result = PAL_SUCCESS;
+    struct mmsghdr msgs[PAL_NET_LINUX_RECV_BATCH_MAX];
+    struct iovec iovecs[PAL_NET_LINUX_RECV_BATCH_MAX];
+    struct sockaddr_storage internalAddrs[PAL_NET_LINUX_RECV_BATCH_MAX];
+    uint32_t received = 0;
+
+    clearSocketFilter((intptr_t)socket);
+
+    while (received < count)
+    {
+        unsigned int chunk = count - received;
+        unsigned int i;
+        int res;
+
+        if (chunk > PAL_NET_LINUX_RECV_BATCH_MAX)
+        {
+            chunk = PAL_NET_LINUX_RECV_BATCH_MAX;
+        }
+
+        memset(msgs, 0, sizeof(struct mmsghdr) * chunk);
+
+        for (i = 0; i < chunk; i++)
+        {
+            iovecs[i].iov_base = items[received + i].buffer;
+            iovecs[i].iov_len = items[received + i].length;
+            msgs[i].msg_hdr.msg_iov = &iovecs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            if (NULL != items[received + i].from)
+            {
+                msgs[i].msg_hdr.msg_name = &internalAddrs[i];
+                msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+            }
+        }
+
+        // A blocking socket waits for the first datagram only, what is queued after it is read without waiting.
+        // A non-blocking socket never waits, as O_NONBLOCK applies to every datagram.
+        res = recvmmsg((intptr_t)socket, msgs, chunk, (received == 0) ? MSG_WAITFORONE : MSG_DONTWAIT, NULL);
+        if (res == -1)
+        {
+            // the datagrams already received make this a success, the error will be seen on the next call
+            if (received == 0)
+            {
+                result = translateErrorToPALError(errno);
+            }
+            break;
+        }
+
+        for (i = 0; i < (unsigned int)res; i++)
+        {
+            palSocketRecvBatchItem_t* item = &items[received + i];
+            item->bytesReceived = msgs[i].msg_len;
+            // the datagram is already consumed, so an address that can't be converted is left with length 0
+            if ((NULL != item->from) &&
+                (PAL_SUCCESS != pal_plat_socketAddressToPalSockAddr((struct sockaddr *)&internalAddrs[i], item->from, &item->fromLength)))
+            {
+                item->fromLength = 0;
+            }
+        }
+
+        received += res;
+
+        if ((unsigned int)res < chunk)
+        {
+            break;
+        }
+    }
+
+    *itemsReceived = received;
+
+    return result;
+}
+#endif // PAL_NET_RECV_BATCH_SUPPORT
+
 palStatus_t pal_plat_close(palSocket_t* socket)
 {
     palStatus_t result = PAL_SUCCESS;
     int res;
-    unsigned int i,j;
+    unsigned int i;
 
     if  (*socket == (void *)PAL_LINUX_INVALID_SOCKET) // socket already closed - return success.
     {
@@ -870,11 +1202,26 @@ palStatus_t pal_plat_close(palSocket_t* socket)
         return result;
     }
 
+#if PAL_NET_LINUX_USE_EPOLL
+    for (i = 0; i < PAL_NET_TEST_MAX_ASYNC_SOCKETS; i++)
+    {
+        if (s_asyncSockets[i].fd == (intptr_t)*socket)
+        {
+            // close() drops the socket from the epoll set only once all its duplicates are closed
+            epoll_ctl(s_epollFD, EPOLL_CTL_DEL, s_asyncSockets[i].fd, NULL);
+            s_asyncSockets[i].fd = PAL_LINUX_INVALID_SOCKET;
+            s_asyncSockets[i].callback = NULL;
+            s_asyncSockets[i].callbackArg = NULL;
+            break;
+        }
+    }
+#else
     for(i= 0 ; i < s_nfds; i++)
     {
         // check if we have we found the socket being closed
         if (s_fds[i].fd == (intptr_t)*socket)
         {
+            unsigned int j;
             // Remove from async socket list
             // Close the gap in the socket data structures.
             for(j = i; j < s_nfds - 1; j++)
@@ -894,6 +1241,7 @@ palStatus_t pal_plat_close(palSocket_t* socket)
             break;
         }
     }
+#endif
     result = pal_osMutexRelease(s_mutexSocketCallbacks);
     if (result != PAL_SUCCESS)
     {
@@ -979,6 +1327,62 @@ palStatus_t pal_plat_getNetInterfaceInfo(uint32_t interfaceNum, palNetInterfaceI
     return result;
 }
 
+#if PAL_NET_LINUX_USE_EPOLL
+
+PAL_PRIVATE palStatus_t registerAsyncSocketParams(palSocket_t socket, palAsyncSocketCallback_t callback, void* callbackArgument)
+{
+    palStatus_t result;
+    palStatus_t releaseResult;
+    struct epoll_event event = {0};
+    int i;
+
+    // Critical section to update globals
+    result = pal_osMutexWait(s_mutexSocketCallbacks, PAL_RTOS_WAIT_FOREVER);
+    if (result != PAL_SUCCESS)
+    {
+        return result;
+    }
+
+    for (i = 0; i < PAL_NET_TEST_MAX_ASYNC_SOCKETS; i++)
+    {
+        if (s_asyncSockets[i].fd == PAL_LINUX_INVALID_SOCKET)
+        {
+            break;
+        }
+    }
+
+    if (i == PAL_NET_TEST_MAX_ASYNC_SOCKETS)
+    {
+        PAL_LOG_ERR("registerAsyncSocketParams: too many async sockets");
+        result = PAL_ERR_SOCKET_ALLOCATION_FAILED;
+    }
+    else
+    {
+        s_asyncSockets[i].generation++;
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET; // EPOLLERR and EPOLLHUP are always reported
+        event.data.u64 = ((uint64_t)s_asyncSockets[i].generation << 32) | (uint32_t)i;
+        if (epoll_ctl(s_epollFD, EPOLL_CTL_ADD, (intptr_t)socket, &event) == -1)
+        {
+            result = translateErrorToPALError(errno);
+        }
+        else
+        {
+            s_asyncSockets[i].fd = (intptr_t)socket;
+            s_asyncSockets[i].callback = callback;
+            s_asyncSockets[i].callbackArg = callbackArgument;
+        }
+    }
+
+    releaseResult = pal_osMutexRelease(s_mutexSocketCallbacks);
+    if (PAL_SUCCESS == result)
+    {
+        result = releaseResult;
+    }
+    return result;
+}
+
+#else // PAL_NET_LINUX_USE_EPOLL
+
 PAL_PRIVATE palStatus_t registerAsyncSocketParams(palSocket_t socket, palAsyncSocketCallback_t callback, void* callbackArgument)
 {
     palStatus_t result;
@@ -1012,6 +1416,8 @@ PAL_PRIVATE palStatus_t registerAsyncSocketParams(palSocket_t socket, palAsyncSo
     return result;
 }
 
+#endif // PAL_NET_LINUX_USE_EPOLL
+
 #if PAL_NET_TCP_AND_TLS_SUPPORT // functionality below supported only in case TCP is supported.
 
 #if PAL_NET_SERVER_SOCKET_API
@@ -1134,10 +1540,11 @@ palStatus_t pal_plat_send(palSocket_t socket, const void *buf, size_t len, size_
 
 palStatus_t pal_plat_asynchronousSocket(palSocketDomain_t domain, palSocketType_t type, bool nonBlockingSocket, uint32_t interfaceNum, palAsyncSocketCallback_t callback, void* callbackArgument, palSocket_t* socket)
 {
+    palStatus_t result = create_socket(domain,  type,  nonBlockingSocket,  interfaceNum, socket);
 
+#if !PAL_NET_LINUX_USE_EPOLL
     int err;
     int flags;
-    palStatus_t result = create_socket(domain,  type,  nonBlockingSocket,  interfaceNum, socket);
 
     // initialize the socket to be ASYNC so we get SIGIO's for it
     // XXX: this needs to be conditionalized as the blocking IO might have some use also.
@@ -1155,6 +1562,7 @@ palStatus_t pal_plat_asynchronousSocket(palSocketDomain_t domain, palSocketType_
     {
         result = translateErrorToPALError(errno);
     }
+#endif
 
     if (result == PAL_SUCCESS)
     {
@@ -35,6 +35,10 @@
 #include "pal.h"
 #include "pal_plat_rtos.h"
 
+#if PAL_RTOS_LINUX_TIMER_WHEEL
+#include <sys/timerfd.h>
+#endif
+
 #define TRACE_GROUP "PAL"
 
  /*
@@ -62,6 +66,26 @@ typedef struct palThreadData
     void* userFunctionArgument;
 } palThreadData_t;
 
+#if PAL_RTOS_LINUX_TIMER_WHEEL
+
+/*
+ * Internal struct to handle timers. The timer is queued either on one of the timer wheel slots
+ * or on the expired list, or on neither when pprev is NULL.
+ */
+struct palTimerInfo
+{
+    struct palTimerInfo *next;
+    struct palTimerInfo **pprev;
+    struct palTimerInfo **list;
+    uint64_t expires;
+    uint32_t period;
+    palTimerFuncPtr function;
+    void *funcArgs;
+    palTimerType_t timerType;
+};
+
+#else
+
 /*
  * Internal struct to handle timers.
  */
@@ -74,6 +98,8 @@ struct palTimerInfo
     palTimerType_t timerType;
 };
 
+#endif
+
 // Mutex to prevent simultaneus modification of the linked list of the timers in g_timerList.
 PAL_PRIVATE palMutexID_t g_timerListMutex = 0;
 
@@ -82,12 +108,14 @@ PAL_PRIVATE palMutexID_t g_timerListMutex = 0;
 #endif
 
 
+#if !PAL_RTOS_LINUX_TIMER_WHEEL
 // A singly linked list of the timers, access may be done only if holding the g_timerListMutex.
 // The list is needed as the timers use async signals and when the signal is finally delivered, the
 // palTimerInfo timer struct may be already deleted. The signals themselves carry pointer to timer,
 // so whenever a signal is received, the thread will look if the palTimerInfo is still on the list,
 // and if it is, uses the struct to find the callback pointer and arguments.
 PAL_PRIVATE volatile struct palTimerInfo *g_timerList = NULL;
+#endif
 
 extern palStatus_t pal_plat_getRandomBufferFromHW(uint8_t *randomBuf, size_t bufSizeBytes, size_t* actualRandomSizeBytes);
 
@@ -138,6 +166,7 @@ palStatus_t pal_plat_RTOSInitialize(void* opaqueContext)
 
     status = pal_osMutexCreate(&g_timerListMutex);
 
+#if !PAL_RTOS_LINUX_TIMER_WHEEL
     if (status == PAL_SUCCESS) {
 
         sigset_t blocked;
@@ -155,6 +184,7 @@ palStatus_t pal_plat_RTOSInitialize(void* opaqueContext)
             status = PAL_ERR_SYSCALL_FAILED;
         }
     }
+#endif
 
     if (status == PAL_SUCCESS) {
 
@@ -378,6 +408,539 @@ typedef struct palTimerThreadContext
 static palThreadID_t s_palHighResTimerThreadID = NULLPTR;
 static palTimerThreadContext_t s_palTimerThreadContext = {0};
 
+#if PAL_RTOS_LINUX_TIMER_WHEEL
+
+/*
+ * Timers are kept in a hierarchical timer wheel of PAL_TIMER_WHEEL_LEVELS levels with 64 slots each.
+ * A level 0 slot is one millisecond wide and each upper level slot spans a whole lower level, so the
+ * wheel covers 2^24 ms (~4.6 hours). Timers further away are parked on the top level and cascaded
+ * again until they come into range. Starting and stopping a timer is a list insert/unlink under
+ * g_timerListMutex, the timer thread sleeps on a timerfd which is only re-armed when a new timer
+ * expires before the currently armed deadline.
+ */
+#define PAL_TIMER_WHEEL_BITS 6
+#define PAL_TIMER_WHEEL_SIZE (1 << PAL_TIMER_WHEEL_BITS)
+#define PAL_TIMER_WHEEL_MASK (PAL_TIMER_WHEEL_SIZE - 1)
+#define PAL_TIMER_WHEEL_LEVELS 4
+#define PAL_TIMER_WHEEL_MAX_DELTA ((1ULL << (PAL_TIMER_WHEEL_BITS * PAL_TIMER_WHEEL_LEVELS)) - 1)
+#define PAL_TIMER_WHEEL_NEVER UINT64_MAX
+
+typedef struct palTimerWheel
+{
+    struct palTimerInfo *slots[PAL_TIMER_WHEEL_LEVELS][PAL_TIMER_WHEEL_SIZE];
+
+    // bit N of occupied[level] is set when slots[level][N] is not empty
+    uint64_t occupied[PAL_TIMER_WHEEL_LEVELS];
+
+    // timers which are due, but whose callback has not been called yet, in expiry order
+    struct palTimerInfo *expired;
+    struct palTimerInfo **expiredTail;
+
+    // the next millisecond tick to be processed
+    uint64_t current;
+
+    // the deadline the timerfd is armed for, PAL_TIMER_WHEEL_NEVER if disarmed
+    uint64_t armed;
+
+    int timerFD;
+
+} palTimerWheel_t;
+
+// All the fields are accessed only while holding the g_timerListMutex.
+PAL_PRIVATE palTimerWheel_t s_timerWheel = {.timerFD = -1};
+
+/*
+ * Current CLOCK_MONOTONIC time in milliseconds, rounded up if roundUp is set. Starting timers
+ * round up so that a timer never fires before the requested time has passed.
+ */
+PAL_PRIVATE uint64_t timerWheelNow(bool roundUp)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    uint64_t now = ((uint64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+
+    if (roundUp && (ts.tv_nsec % 1000000)) {
+        now++;
+    }
+    return now;
+}
+
+PAL_PRIVATE void timerWheelLink(struct palTimerInfo **list, struct palTimerInfo *timer)
+{
+    timer->next = *list;
+    if (timer->next) {
+        timer->next->pprev = &timer->next;
+    }
+    timer->pprev = list;
+    timer->list = list;
+    *list = timer;
+}
+
+PAL_PRIVATE void timerWheelUnlink(struct palTimerInfo *timer)
+{
+    *timer->pprev = timer->next;
+
+    if (timer->next) {
+        timer->next->pprev = timer->pprev;
+    } else if (timer->list == &s_timerWheel.expired) {
+        s_timerWheel.expiredTail = timer->pprev;
+    }
+
+    if ((timer->list != &s_timerWheel.expired) && (*timer->list == NULL)) {
+        // the slot became empty, clear its bit
+        size_t index = timer->list - &s_timerWheel.slots[0][0];
+        s_timerWheel.occupied[index / PAL_TIMER_WHEEL_SIZE] &= ~(1ULL << (index % PAL_TIMER_WHEEL_SIZE));
+    }
+
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->list = NULL;
+}
+
+PAL_PRIVATE void timerWheelInsert(struct palTimerInfo *timer)
+{
+    uint64_t expires = timer->expires;
+    uint64_t delta;
+    int level = 0;
+
+    // a timer which is already due is run on the next processed tick
+    if (expires < s_timerWheel.current) {
+        expires = s_timerWheel.current;
+    }
+
+    delta = expires - s_timerWheel.current;
+
+    if (delta > PAL_TIMER_WHEEL_MAX_DELTA) {
+        // out of range, park it on the top level, it will be re-inserted when the slot cascades
+        expires = s_timerWheel.current + PAL_TIMER_WHEEL_MAX_DELTA;
+        delta = PAL_TIMER_WHEEL_MAX_DELTA;
+    }
+
+    while (delta >= PAL_TIMER_WHEEL_SIZE) {
+        delta >>= PAL_TIMER_WHEEL_BITS;
+        level++;
+    }
+
+    int slot = (expires >> (level * PAL_TIMER_WHEEL_BITS)) & PAL_TIMER_WHEEL_MASK;
+
+    timerWheelLink(&s_timerWheel.slots[level][slot], timer);
+    s_timerWheel.occupied[level] |= (1ULL << slot);
+}
+
+/*
+ * Return the first tick at which the wheel has something to do, ie. either a level 0 slot
+ * expires or an upper level slot cascades. This is never later than the earliest timer expiry.
+ */
+PAL_PRIVATE uint64_t timerWheelNextEvent(void)
+{
+    uint64_t next = PAL_TIMER_WHEEL_NEVER;
+
+    for (int level = 0; level < PAL_TIMER_WHEEL_LEVELS; level++) {
+
+        uint64_t occupied = s_timerWheel.occupied[level];
+
+        if (occupied == 0) {
+            continue;
+        }
+
+        int shift = level * PAL_TIMER_WHEEL_BITS;
+        uint64_t block = s_timerWheel.current >> shift;
+        unsigned int skip = 0;
+
+        // Upper level slot of the current block has already been cascaded, unless the wheel is
+        // exactly at the block boundary.
+        if (level && (s_timerWheel.current & ((1ULL << shift) - 1))) {
+            skip = 1;
+        }
+
+        unsigned int start = (block + skip) & PAL_TIMER_WHEEL_MASK;
+
+        // rotate so that bit 0 is the slot at "start"
+        if (start) {
+            occupied = (occupied >> start) | (occupied << (PAL_TIMER_WHEEL_SIZE - start));
+        }
+
+        uint64_t event = (block + skip + __builtin_ctzll(occupied)) << shift;
+
+        if (event < next) {
+            next = event;
+        }
+    }
+
+    return next;
+}
+
+PAL_PRIVATE void timerWheelCascade(int level, int slot)
+{
+    struct palTimerInfo *timer = s_timerWheel.slots[level][slot];
+
+    s_timerWheel.slots[level][slot] = NULL;
+    s_timerWheel.occupied[level] &= ~(1ULL << slot);
+
+    while (timer) {
+        struct palTimerInfo *next = timer->next;
+        timerWheelInsert(timer);
+        timer = next;
+    }
+}
+
+/*
+ * Process the wheel up to and including the tick "now", moving the due timers to the expired list.
+ * Ticks with nothing to do are skipped over.
+ */
+PAL_PRIVATE void timerWheelAdvance(uint64_t now)
+{
+    while (s_timerWheel.current <= now) {
+
+        uint64_t next = timerWheelNextEvent();
+
+        if (next > now) {
+            s_timerWheel.current = now + 1;
+            break;
+        }
+
+        s_timerWheel.current = next;
+
+        // at a block boundary, cascade the upper level slots down
+        for (int level = 1; level < PAL_TIMER_WHEEL_LEVELS; level++) {
+            int shift = level * PAL_TIMER_WHEEL_BITS;
+
+            if (s_timerWheel.current & ((1ULL << shift) - 1)) {
+                break;
+            }
+            timerWheelCascade(level, (s_timerWheel.current >> shift) & PAL_TIMER_WHEEL_MASK);
+        }
+
+        int slot = s_timerWheel.current & PAL_TIMER_WHEEL_MASK;
+        struct palTimerInfo *timer = s_timerWheel.slots[0][slot];
+
+        s_timerWheel.slots[0][slot] = NULL;
+        s_timerWheel.occupied[0] &= ~(1ULL << slot);
+
+        while (timer) {
+            struct palTimerInfo *next = timer->next;
+
+            // append to the tail of the expired list
+            timer->next = NULL;
+            timer->pprev = s_timerWheel.expiredTail;
+            timer->list = &s_timerWheel.expired;
+            *s_timerWheel.expiredTail = timer;
+            s_timerWheel.expiredTail = &timer->next;
+
+            timer = next;
+        }
+
+        s_timerWheel.current++;
+    }
+}
+
+/*
+ * Arm the timerfd to wake up the timer thread at the given deadline.
+ */
+PAL_PRIVATE void timerWheelArm(uint64_t deadline)
+{
+    struct itimerspec its;
+
+    if (deadline == s_timerWheel.armed) {
+        return;
+    }
+
+    memset(&its, 0, sizeof(its));
+
+    if (deadline != PAL_TIMER_WHEEL_NEVER) {
+        its.it_value.tv_sec = deadline / 1000;
+        its.it_value.tv_nsec = PAL_MILLI_TO_NANO(deadline % 1000);
+
+        // a zero it_value would disarm the timer, whereas a past deadline fires immediately
+        if ((its.it_value.tv_sec == 0) && (its.it_value.tv_nsec == 0)) {
+            its.it_value.tv_nsec = 1;
+        }
+    }
+
+    if (timerfd_settime(s_timerWheel.timerFD, TFD_TIMER_ABSTIME, &its, NULL) == -1) {
+        PAL_LOG_ERR("palTimerThread: timerfd_settime failed with %d\n", errno);
+    } else {
+        s_timerWheel.armed = deadline;
+    }
+}
+
+/*
+* Thread for running the timer wheel and calling the callbacks of the expired timers
+*/
+
+PAL_PRIVATE void palTimerThread(void const *args)
+{
+    palTimerThreadContext_t* context = (palTimerThreadContext_t*)args;
+
+    // signal the caller that thread has started
+    if (pal_osSemaphoreRelease(context->startStopSemaphore) != PAL_SUCCESS) {
+        PAL_LOG_ERR("pal_osSemaphoreRelease(context->startStopSemaphore) failed!");
+    }
+
+    pal_osMutexWait(g_timerListMutex, PAL_RTOS_WAIT_FOREVER);
+
+    // loop until signaled with threadStopRequested
+    while (!context->threadStopRequested) {
+
+        uint64_t now = timerWheelNow(false);
+
+        timerWheelAdvance(now);
+
+        struct palTimerInfo *timer = s_timerWheel.expired;
+
+        if (timer) {
+
+            // Backup the callback as the timer may get deleted as soon as the mutex is released.
+            palTimerFuncPtr function = timer->function;
+            void *funcArgs = timer->funcArgs;
+
+            timerWheelUnlink(timer);
+
+            if (timer->period) {
+                // skip over the missed periods instead of trying to catch up with them
+                timer->expires += timer->period;
+                if (timer->expires <= now) {
+                    timer->expires = now + timer->period;
+                }
+                timerWheelInsert(timer);
+            }
+
+            // Release the list mutex before callback to avoid callback deadlocking other threads
+            // if they try to create a timer.
+            (void)pal_osMutexRelease(g_timerListMutex);
+
+            function(funcArgs);
+
+            pal_osMutexWait(g_timerListMutex, PAL_RTOS_WAIT_FOREVER);
+
+        } else {
+
+            uint64_t expirations;
+
+            timerWheelArm(timerWheelNextEvent());
+
+            (void)pal_osMutexRelease(g_timerListMutex);
+
+            // Wait for the deadline, or for an earlier one set by pal_plat_osTimerStart().
+            // EINTR is harmless here, the loop just re-evaluates the wheel.
+            if ((read(s_timerWheel.timerFD, &expirations, sizeof(expirations)) == -1) && (errno != EINTR)) {
+                PAL_LOG_ERR("palTimerThread: read failed with %d\n", errno);
+            }
+
+            pal_osMutexWait(g_timerListMutex, PAL_RTOS_WAIT_FOREVER);
+
+            // the timerfd is disarmed once it has expired
+            s_timerWheel.armed = PAL_TIMER_WHEEL_NEVER;
+        }
+    }
+
+    (void)pal_osMutexRelease(g_timerListMutex);
+
+    // signal the caller that thread is now stopping and it can continue the pal_destroy()
+    (void)pal_osSemaphoreRelease(context->startStopSemaphore);
+}
+
+PAL_PRIVATE palStatus_t startTimerThread()
+{
+    palStatus_t status;
+
+    // The wheel itself is kept over pal_destroy()/pal_init(), like the POSIX timers are,
+    // only the timerfd and the thread are recreated.
+    s_timerWheel.timerFD = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+
+    if (s_timerWheel.timerFD == -1) {
+        PAL_LOG_ERR("timerfd_create failed with %d\n", errno);
+        return PAL_ERR_SYSCALL_FAILED;
+    }
+
+    s_timerWheel.armed = PAL_TIMER_WHEEL_NEVER;
+
+    if (s_timerWheel.expiredTail == NULL) {
+        s_timerWheel.expiredTail = &s_timerWheel.expired;
+        s_timerWheel.current = timerWheelNow(false);
+    }
+
+    status = pal_osSemaphoreCreate(0, &s_palTimerThreadContext.startStopSemaphore);
+
+    if (status == PAL_SUCCESS) {
+
+        s_palTimerThreadContext.threadStopRequested = false;
+
+        status = pal_osThreadCreateWithAlloc(palTimerThread, &s_palTimerThreadContext, PAL_osPriorityReservedHighResTimer,
+                                                PAL_RTOS_HIGH_RES_TIMER_THREAD_STACK_SIZE, NULL, &s_palHighResTimerThreadID);
+
+        if (status == PAL_SUCCESS) {
+
+            // the timer thread will signal on semaphore when it has started
+            pal_osSemaphoreWait(s_palTimerThreadContext.startStopSemaphore, PAL_RTOS_WAIT_FOREVER, NULL);
+
+        } else {
+            // cleanup the semaphore
+            pal_osSemaphoreDelete(&s_palTimerThreadContext.startStopSemaphore);
+        }
+    }
+
+    if (status != PAL_SUCCESS) {
+        close(s_timerWheel.timerFD);
+        s_timerWheel.timerFD = -1;
+    }
+
+    return status;
+}
+
+PAL_PRIVATE palStatus_t stopTimerThread()
+{
+    palStatus_t status;
+
+    status = pal_osMutexWait(g_timerListMutex, PAL_RTOS_WAIT_FOREVER);
+
+    if (status == PAL_SUCCESS) {
+
+        // set the flag to end the thread and wake it up right away
+        s_palTimerThreadContext.threadStopRequested = true;
+
+        timerWheelArm(0);
+
+        (void)pal_osMutexRelease(g_timerListMutex);
+
+        // wait for for acknowledgement that timer thread is going down
+        pal_osSemaphoreWait(s_palTimerThreadContext.startStopSemaphore, PAL_RTOS_WAIT_FOREVER, NULL);
+
+        pal_osSemaphoreDelete(&s_palTimerThreadContext.startStopSemaphore);
+
+        // and clean up the thread
+        status = pal_osThreadTerminate(&s_palHighResTimerThreadID);
+
+        close(s_timerWheel.timerFD);
+        s_timerWheel.timerFD = -1;
+    }
+    return status;
+}
+
+/*! Create a timer.
+ *
+ * @param[in] function A function pointer to the timer callback function.
+ * @param[in] funcArgument An argument for the timer callback function.
+ * @param[in] timerType The timer type to be created, periodic or oneShot.
+ * @param[out] timerID The ID of the created timer, zero value indicates an error.
+ *
+ * \return PAL_SUCCESS when the timer was created successfully. A specific error in case of failure.
+ */
+palStatus_t pal_plat_osTimerCreate(palTimerFuncPtr function, void* funcArgument,
+        palTimerType_t timerType, palTimerID_t* timerID)
+{
+    if ((NULL == timerID) || (NULL == (void*) function))
+    {
+        return PAL_ERR_INVALID_ARGUMENT;
+    }
+
+    struct palTimerInfo* timerInfo = (struct palTimerInfo*) calloc(1, sizeof(struct palTimerInfo));
+    if (NULL == timerInfo)
+    {
+        return PAL_ERR_NO_MEMORY;
+    }
+
+    timerInfo->function = function;
+    timerInfo->funcArgs = funcArgument;
+    timerInfo->timerType = timerType;
+
+    *timerID = (palTimerID_t) timerInfo;
+
+    return PAL_SUCCESS;
+}
+
+/*! Start or restart a timer.
+ *
+ * @param[in] timerID The handle for the timer to start.
+ * @param[in] millisec The time in milliseconds to set the timer to.
+ *
+ * \return The status in the form of palStatus_t; PAL_SUCCESS(0) in case of success, a negative value indicating a specific error code in case of failure.
+ */
+palStatus_t pal_plat_osTimerStart(palTimerID_t timerID, uint32_t millisec)
+{
+    if (NULL == (struct palTimerInfo *) timerID)
+    {
+        return PAL_ERR_INVALID_ARGUMENT;
+    }
+
+    struct palTimerInfo* timerInfo = (struct palTimerInfo *) timerID;
+    uint64_t now = timerWheelNow(true);
+
+    pal_osMutexWait(g_timerListMutex, PAL_RTOS_WAIT_FOREVER);
+
+    if (timerInfo->pprev)
+    {
+        timerWheelUnlink(timerInfo);
+    }
+
+    timerInfo->expires = now + millisec;
+    timerInfo->period = (palOsTimerPeriodic == timerInfo->timerType) ? millisec : 0;
+
+    timerWheelInsert(timerInfo);
+
+    // wake up the timer thread only if this timer is due before anything else
+    if (timerInfo->expires < s_timerWheel.armed)
+    {
+        timerWheelArm(timerInfo->expires);
+    }
+
+    (void)pal_osMutexRelease(g_timerListMutex);
+
+    return PAL_SUCCESS;
+}
+
+/*! Stop a timer.
+ *
+ * @param[in] timerID The handle for the timer to stop.
+ *
+ * \return The status in the form of palStatus_t; PAL_SUCCESS(0) in case of success, a negative value indicating a specific error code in case of failure.
+ */
+palStatus_t pal_plat_osTimerStop(palTimerID_t timerID)
+{
+    if (NULL == (struct palTimerInfo *) timerID)
+    {
+        return PAL_ERR_INVALID_ARGUMENT;
+    }
+
+    struct palTimerInfo* timerInfo = (struct palTimerInfo *) timerID;
+
+    pal_osMutexWait(g_timerListMutex, PAL_RTOS_WAIT_FOREVER);
+
+    // The timerfd is left armed, a spurious wakeup of the timer thread is cheaper than a syscall.
+    if (timerInfo->pprev)
+    {
+        timerWheelUnlink(timerInfo);
+    }
+
+    (void)pal_osMutexRelease(g_timerListMutex);
+
+    return PAL_SUCCESS;
+}
+
+/*! Delete the timer object
+ *
+ * @param[inout] timerID The handle for the timer to delete. In success, *timerID = NULL.
+ *
+ * \return PAL_SUCCESS when the timer was deleted successfully, PAL_ERR_RTOS_PARAMETER when the timerID is incorrect.
+ */
+palStatus_t pal_plat_osTimerDelete(palTimerID_t* timerID)
+{
+    if ((NULL == timerID) || ((struct palTimerInfo *)*timerID == NULL)) {
+        return PAL_ERR_INVALID_ARGUMENT;
+    }
+
+    palStatus_t status = pal_plat_osTimerStop(*timerID);
+
+    free((struct palTimerInfo *) *timerID);
+    *timerID = (palTimerID_t) NULL;
+
+    return status;
+}
+
+#else // PAL_RTOS_LINUX_TIMER_WHEEL
+
 /*
 * Thread for handling the signals from all timers by calling the attached callback
 */
@@ -764,6 +1327,8 @@ palStatus_t pal_plat_osTimerDelete(palTimerID_t* timerID)
     return status;
 }
 
+#endif // PAL_RTOS_LINUX_TIMER_WHEEL
+
 /*! Create and initialize a mutex object.
  *
  * @param[out] mutexID The created mutex ID handle, zero value indicates an error.
@@ -1302,6 +1302,420 @@ TEST(pal_socket, socketUDPBufferedLarge)
     socketUDPBuffered(PAL_NET_TEST_BUFFERED_BUF_SIZE_LARGE);
 }
 
+#define PAL_NET_TEST_LOOPBACK_UDP_PORT 2607
+#define PAL_NET_TEST_LOOPBACK_SENDERS 2
+#define PAL_NET_TEST_LOOPBACK_DATAGRAMS 40
+#define PAL_NET_TEST_LOOPBACK_DATAGRAM_SIZE 32
+#define PAL_NET_TEST_LOOPBACK_RECV_BATCH 8
+#define PAL_NET_TEST_LOOPBACK_OVERSIZED (64 * 1024)
+#define PAL_NET_TEST_LOOPBACK_SETTLE_MS 200
+#define PAL_NET_TEST_LOOPBACK_REOPENED (1 + PAL_NET_TEST_LOOPBACK_SENDERS)
+
+// g_testSockets[0] receives on PAL_NET_TEST_LOOPBACK_UDP_PORT, g_testSockets[1] and [2] send from the ports after it.
+// Events of a receiving socket opened again after g_testSockets[0] is closed are counted separately.
+PAL_PRIVATE palSemaphoreID_t s_loopbackSemaphore = NULLPTR;
+PAL_PRIVATE int32_t s_loopbackEvents[PAL_NET_TEST_LOOPBACK_REOPENED + 1];
+PAL_PRIVATE palSocketAddress_t s_loopbackAddress[1 + PAL_NET_TEST_LOOPBACK_SENDERS];
+PAL_PRIVATE palSocketLength_t s_loopbackAddressLength;
+
+PAL_PRIVATE void loopbackSocketCallback(void *arg)
+{
+    (void)pal_osAtomicIncrement((int32_t *)arg, 1);
+    (void)pal_osSemaphoreRelease(s_loopbackSemaphore);
+}
+
+PAL_PRIVATE int32_t loopbackEvents(int socketIndex)
+{
+    return pal_osAtomicIncrement(&s_loopbackEvents[socketIndex], 0);
+}
+
+// Wait until the socket gets an event after the `events` it had, the other sockets may wake the wait as well
+PAL_PRIVATE void loopbackWaitEvent(int socketIndex, int32_t events)
+{
+    palStatus_t result;
+
+    while (loopbackEvents(socketIndex) == events)
+    {
+        result = pal_osSemaphoreWait(s_loopbackSemaphore, TEST_SEMAPHORE_WAIT, NULL);
+        TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+    }
+}
+
+// Datagram `index` of a sender carries the sender and the index, so that the receiver can tell them apart
+PAL_PRIVATE void loopbackFillDatagram(uint8_t *buffer, int sender, int index)
+{
+    memset(buffer, (uint8_t)(sender * PAL_NET_TEST_LOOPBACK_DATAGRAMS + index), PAL_NET_TEST_LOOPBACK_DATAGRAM_SIZE);
+    buffer[0] = (uint8_t)sender;
+    buffer[1] = (uint8_t)index;
+}
+
+// Bind the receiving socket and the sending sockets to consecutive ports of the interface address.
+// Returns false if the interface address is not supported by the current configuration and the test should end.
+PAL_PRIVATE bool loopbackSetUp(void)
+{
+    palStatus_t result;
+    palNetInterfaceInfo_t interfaceInfo;
+    int i;
+
+    memset(&interfaceInfo, 0, sizeof(interfaceInfo));
+    result = pal_getNetInterfaceInfo(PAL_NET_TEST_LOCAL_LOOPBACK_IF_INDEX, &interfaceInfo);
+    if ((PAL_ERR_SOCKET_DNS_ERROR == result) || (PAL_ERR_SOCKET_INVALID_ADDRESS_FAMILY == result))
+    {
+        PAL_LOG_ERR("error: address lookup returned an address not supported by current configuration cant continue test ( IPv6 add for IPv4 only configuration or IPv4 for IPv6 only configuration)");
+        return false;
+    }
+    TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+
+    result = pal_osSemaphoreCreate(0, &s_loopbackSemaphore);
+    TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+
+    s_loopbackAddressLength = interfaceInfo.addressSize;
+    s_loopbackEvents[PAL_NET_TEST_LOOPBACK_REOPENED] = 0;
+    for (i = 0; i <= PAL_NET_TEST_LOOPBACK_SENDERS; i++)
+    {
+        s_loopbackEvents[i] = 0;
+        s_loopbackAddress[i] = interfaceInfo.address;
+        result = pal_setSockAddrPort(&s_loopbackAddress[i], PAL_NET_TEST_LOOPBACK_UDP_PORT + i);
+        TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+
+        result = pal_asynchronousSocketWithArgument(PAL_AF_INET, PAL_SOCK_DGRAM, true, 0, loopbackSocketCallback, &s_loopbackEvents[i], &g_testSockets[i]);
+        TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+
+        result = pal_bind(g_testSockets[i], &s_loopbackAddress[i], s_loopbackAddressLength);
+        TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+    }
+
+    return true;
+}
+
+PAL_PRIVATE void loopbackTearDown(void)
+{
+    palStatus_t result;
+    int i;
+
+    for (i = 0; i <= PAL_NET_TEST_LOOPBACK_SENDERS; i++)
+    {
+        if (g_testSockets[i] != 0)
+        {
+            result = pal_close(&g_testSockets[i]);
+            TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+        }
+    }
+    result = pal_osSemaphoreDelete(&s_loopbackSemaphore);
+    TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+}
+
+// Receive one datagram with pal_receiveFrom, waiting for socket callbacks while there is nothing to read.
+// Checks that it is one of the datagrams sent by loopbackFillDatagram() and that it was not received before.
+PAL_PRIVATE void loopbackReceiveOnce(bool received[][PAL_NET_TEST_LOOPBACK_DATAGRAMS])
+{
+    palStatus_t result;
+    uint8_t buffer[PAL_NET_TEST_LOOPBACK_DATAGRAM_SIZE + 1];
+    uint8_t expected[PAL_NET_TEST_LOOPBACK_DATAGRAM_SIZE];
+    size_t read = 0;
+
+    result = pal_receiveFrom(g_testSockets[0], buffer, sizeof(buffer), NULL, NULL, &read);
+    while (PAL_ERR_SOCKET_WOULD_BLOCK == result)
+    {
+        result = pal_osSemaphoreWait(s_loopbackSemaphore, TEST_SEMAPHORE_WAIT, NULL);
+        TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+        result = pal_receiveFrom(g_testSockets[0], buffer, sizeof(buffer), NULL, NULL, &read);
+    }
+    TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+    TEST_ASSERT_EQUAL(PAL_NET_TEST_LOOPBACK_DATAGRAM_SIZE, read);
+    TEST_ASSERT((buffer[0] >= 1) && (buffer[0] <= PAL_NET_TEST_LOOPBACK_SENDERS));
+    TEST_ASSERT(buffer[1] < PAL_NET_TEST_LOOPBACK_DATAGRAMS);
+    loopbackFillDatagram(expected, buffer[0], buffer[1]);
+    TEST_ASSERT_EQUAL_MEMORY(expected, buffer, PAL_NET_TEST_LOOPBACK_DATAGRAM_SIZE);
+    TEST_ASSERT_FALSE(received[buffer[0] - 1][buffer[1]]);
+    received[buffer[0] - 1][buffer[1]] = true;
+}
+
+// Nothing more is queued on the receiving socket
+PAL_PRIVATE void loopbackAssertEmpty(void)
+{
+    palStatus_t result;
+    uint8_t buffer[PAL_NET_TEST_LOOPBACK_DATAGRAM_SIZE];
+    size_t read = 0;
+
+    result = pal_receiveFrom(g_testSockets[0], buffer, sizeof(buffer), NULL, NULL, &read);
+    TEST_ASSERT_EQUAL_HEX(PAL_ERR_SOCKET_WOULD_BLOCK, result);
+}
+
+/*! \brief /b asyncUDPLoopback checks the asynchronous socket events with UDP over the device loopback.
+*
+* \note Events must wake the receiver for every datagram, and stop once the socket is closed,
+* whichever socket manager implementation is used (for example PAL_NET_LINUX_USE_EPOLL on Linux).
+*
+** \test
+* | # |    Step                        |   Expected  |
+* |---|--------------------------------|-------------|
+* | 1 | Get the interface address, create the callback semaphore and bind the receiving and sending sockets. | PAL_SUCCESS |
+* | 2 | Send numbered datagrams from both senders one at a time, and read each after the receiver's socket event. | PAL_SUCCESS |
+* | 3 | Check that every datagram was received exactly once and nothing else is queued.            | PAL_SUCCESS |
+* | 4 | Close the receiving socket, open a new one on its port and send to it, reading each datagram after its event. | PAL_SUCCESS |
+* | 5 | Check that the closed socket got no more events.                                           | PAL_SUCCESS |
+* | 6 | Close the sockets and delete the semaphore.                                                | PAL_SUCCESS |
+*/
+TEST(pal_socket, asyncUDPLoopback)
+{
+    palStatus_t result = PAL_SUCCESS;
+    bool received[PAL_NET_TEST_LOOPBACK_SENDERS][PAL_NET_TEST_LOOPBACK_DATAGRAMS];
+    uint8_t buffer[PAL_NET_TEST_LOOPBACK_DATAGRAM_SIZE];
+    size_t sent = 0;
+    int32_t events, eventsAfterClose;
+    int i, sender;
+
+    /*#1*/
+    if (!loopbackSetUp())
+    {
+        return;
+    }
+    memset(received, 0, sizeof(received));
+
+    /*#2*/
+    // one datagram in flight, and each one is read only after the event it caused on the receiver
+    for (i = 0; i < PAL_NET_TEST_LOOPBACK_DATAGRAMS; i++)
+    {
+        for (sender = 1; sender <= PAL_NET_TEST_LOOPBACK_SENDERS; sender++)
+        {
+            events = loopbackEvents(0);
+            loopbackFillDatagram(buffer, sender, i);
+            result = pal_sendTo(g_testSockets[sender], buffer, sizeof(buffer), &s_loopbackAddress[0], s_loopbackAddressLength, &sent);
+            TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+            TEST_ASSERT_EQUAL(sizeof(buffer), sent);
+            loopbackWaitEvent(0, events);
+            loopbackReceiveOnce(received);
+        }
+    }
+
+    /*#3*/
+    for (sender = 0; sender < PAL_NET_TEST_LOOPBACK_SENDERS; sender++)
+    {
+        for (i = 0; i < PAL_NET_TEST_LOOPBACK_DATAGRAMS; i++)
+        {
+            TEST_ASSERT_TRUE(received[sender][i]);
+        }
+    }
+    loopbackAssertEmpty();
+
+    /*#4*/
+    result = pal_close(&g_testSockets[0]);
+    TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+    // an event taken by the socket manager just before the close may still be delivered
+    pal_osDelay(PAL_NET_TEST_LOOPBACK_SETTLE_MS);
+    eventsAfterClose = loopbackEvents(0);
+
+    // the new socket is likely to get the descriptor and the socket manager slot of the closed one
+    result = pal_asynchronousSocketWithArgument(PAL_AF_INET, PAL_SOCK_DGRAM, true, 0, loopbackSocketCallback, &s_loopbackEvents[PAL_NET_TEST_LOOPBACK_REOPENED], &g_testSockets[0]);
+    TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+    result = pal_bind(g_testSockets[0], &s_loopbackAddress[0], s_loopbackAddressLength);
+    TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+
+    memset(received, 0, sizeof(received));
+    for (i = 0; i < PAL_NET_TEST_LOOPBACK_DATAGRAMS; i++)
+    {
+        events = loopbackEvents(PAL_NET_TEST_LOOPBACK_REOPENED);
+        loopbackFillDatagram(buffer, 1, i);
+        result = pal_sendTo(g_testSockets[1], buffer, sizeof(buffer), &s_loopbackAddress[0], s_loopbackAddressLength, &sent);
+        TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+        loopbackWaitEvent(PAL_NET_TEST_LOOPBACK_REOPENED, events);
+        loopbackReceiveOnce(received);
+    }
+    pal_osDelay(PAL_NET_TEST_LOOPBACK_SETTLE_MS);
+
+    /*#5*/
+    TEST_ASSERT_EQUAL(eventsAfterClose, loopbackEvents(0));
+
+    /*#6*/
+    loopbackTearDown();
+}
+
+/*! \brief /b asyncUDPLoopbackBatch checks that a partly sent `pal_sendToBatch` batch can be resumed,
+* with UDP over the device loopback.
+*
+** \test
+* | # |    Step                        |   Expected  |
+* |---|--------------------------------|-------------|
+* | 1 | Get the interface address, create the callback semaphore and bind the receiving and sending sockets. | PAL_SUCCESS |
+* | 2 | Send a batch with an oversized datagram in the middle, only the datagrams before it are sent. | PAL_SUCCESS |
+* | 3 | Resume the batch from the oversized datagram, which fails without sending anything.        | Error |
+* | 4 | Resume the batch after the oversized datagram, the rest is sent.                           | PAL_SUCCESS |
+* | 5 | Check that every datagram but the oversized one was received exactly once and nothing else is queued. | PAL_SUCCESS |
+* | 6 | Close the sockets and delete the semaphore.                                                | PAL_SUCCESS |
+*/
+TEST(pal_socket, asyncUDPLoopbackBatch)
+{
+    palStatus_t result = PAL_SUCCESS;
+    bool received[PAL_NET_TEST_LOOPBACK_SENDERS][PAL_NET_TEST_LOOPBACK_DATAGRAMS];
+    uint8_t buffers[PAL_NET_TEST_LOOPBACK_DATAGRAMS][PAL_NET_TEST_LOOPBACK_DATAGRAM_SIZE];
+    palSocketSendBatchItem_t items[PAL_NET_TEST_LOOPBACK_DATAGRAMS];
+    const int oversized = PAL_NET_TEST_LOOPBACK_DATAGRAMS / 2;
+    uint32_t itemsSent = 0;
+    int i;
+
+    for (i = 0; i < PAL_NET_TEST_LOOPBACK_DATAGRAMS; i++)
+    {
+        loopbackFillDatagram(buffers[i], 1, i);
+        items[i].buffer = buffers[i];
+        items[i].length = PAL_NET_TEST_LOOPBACK_DATAGRAM_SIZE;
+    }
+    // larger than any UDP datagram, so the network stack refuses it
+    g_testSendBuffer = (uint8_t*)malloc(PAL_NET_TEST_LOOPBACK_OVERSIZED);
+    TEST_ASSERT_NOT_NULL(g_testSendBuffer);
+    memset(g_testSendBuffer, 0, PAL_NET_TEST_LOOPBACK_OVERSIZED);
+    items[oversized].buffer = g_testSendBuffer;
+    items[oversized].length = PAL_NET_TEST_LOOPBACK_OVERSIZED;
+    memset(received, 0, sizeof(received));
+
+    /*#1*/
+    if (!loopbackSetUp())
+    {
+        goto end;
+    }
+
+    /*#2*/
+    result = pal_sendToBatch(g_testSockets[1], items, PAL_NET_TEST_LOOPBACK_DATAGRAMS, &s_loopbackAddress[0], s_loopbackAddressLength, &itemsSent);
+    TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+    TEST_ASSERT_EQUAL(oversized, itemsSent);
+
+    /*#3*/
+    result = pal_sendToBatch(g_testSockets[1], &items[oversized], PAL_NET_TEST_LOOPBACK_DATAGRAMS - oversized, &s_loopbackAddress[0], s_loopbackAddressLength, &itemsSent);
+    TEST_ASSERT_NOT_EQUAL(PAL_SUCCESS, result);
+    TEST_ASSERT_EQUAL(0, itemsSent);
+
+    /*#4*/
+    result = pal_sendToBatch(g_testSockets[1], &items[oversized + 1], PAL_NET_TEST_LOOPBACK_DATAGRAMS - oversized - 1, &s_loopbackAddress[0], s_loopbackAddressLength, &itemsSent);
+    TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+    TEST_ASSERT_EQUAL(PAL_NET_TEST_LOOPBACK_DATAGRAMS - oversized - 1, itemsSent);
+
+    /*#5*/
+    for (i = 0; i < PAL_NET_TEST_LOOPBACK_DATAGRAMS - 1; i++)
+    {
+        loopbackReceiveOnce(received);
+    }
+    for (i = 0; i < PAL_NET_TEST_LOOPBACK_DATAGRAMS; i++)
+    {
+        TEST_ASSERT_EQUAL(i != oversized, received[0][i]);
+    }
+    loopbackAssertEmpty();
+
+    /*#6*/
+    loopbackTearDown();
+
+end:
+    free(g_testSendBuffer);
+    g_testSendBuffer = NULLPTR;
+}
+
+/*! \brief /b asyncUDPLoopbackRecvBatch checks the datagrams and the source addresses returned by
+* `pal_receiveFromBatch` with UDP over the device loopback.
+*
+** \test
+* | # |    Step                        |   Expected  |
+* |---|--------------------------------|-------------|
+* | 1 | Get the interface address, create the callback semaphore and bind the receiving and sending sockets. | PAL_SUCCESS |
+* | 2 | Send numbered datagrams from both senders, interleaved.                                    | PAL_SUCCESS |
+* | 3 | Receive them in batches, waiting for socket events while there is nothing to read.         | PAL_SUCCESS |
+* | 4 | Check the size, the contents and the source address of each datagram, and that it was not received before. | PAL_SUCCESS |
+* | 5 | Check that every datagram was received and nothing else is queued.                         | PAL_SUCCESS |
+* | 6 | Close the sockets and delete the semaphore.                                                | PAL_SUCCESS |
+*/
+TEST(pal_socket, asyncUDPLoopbackRecvBatch)
+{
+    palStatus_t result = PAL_SUCCESS;
+    bool received[PAL_NET_TEST_LOOPBACK_SENDERS][PAL_NET_TEST_LOOPBACK_DATAGRAMS];
+    uint8_t buffer[PAL_NET_TEST_LOOPBACK_DATAGRAM_SIZE];
+    uint8_t recvBuffers[PAL_NET_TEST_LOOPBACK_RECV_BATCH][PAL_NET_TEST_LOOPBACK_DATAGRAM_SIZE + 1];
+    palSocketAddress_t fromAddresses[PAL_NET_TEST_LOOPBACK_RECV_BATCH];
+    palSocketRecvBatchItem_t items[PAL_NET_TEST_LOOPBACK_RECV_BATCH];
+    palIpV4Addr_t expectedIp, fromIp;
+    uint16_t fromPort;
+    uint32_t itemsReceived = 0;
+    uint32_t total = 0;
+    size_t sent = 0;
+    int i, sender;
+
+    /*#1*/
+    if (!loopbackSetUp())
+    {
+        return;
+    }
+    memset(received, 0, sizeof(received));
+    result = pal_getSockAddrIPV4Addr(&s_loopbackAddress[0], expectedIp);
+    TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+
+    /*#2*/
+    for (i = 0; i < PAL_NET_TEST_LOOPBACK_DATAGRAMS; i++)
+    {
+        for (sender = 1; sender <= PAL_NET_TEST_LOOPBACK_SENDERS; sender++)
+        {
+            loopbackFillDatagram(buffer, sender, i);
+            result = pal_sendTo(g_testSockets[sender], buffer, sizeof(buffer), &s_loopbackAddress[0], s_loopbackAddressLength, &sent);
+            TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+        }
+    }
+
+    /*#3*/
+    while (total < PAL_NET_TEST_LOOPBACK_SENDERS * PAL_NET_TEST_LOOPBACK_DATAGRAMS)
+    {
+        for (i = 0; i < PAL_NET_TEST_LOOPBACK_RECV_BATCH; i++)
+        {
+            memset(recvBuffers[i], 0, sizeof(recvBuffers[i]));
+            memset(&fromAddresses[i], 0, sizeof(fromAddresses[i]));
+            items[i].buffer = recvBuffers[i];
+            items[i].length = sizeof(recvBuffers[i]);
+            items[i].bytesReceived = 0;
+            items[i].from = &fromAddresses[i];
+            items[i].fromLength = 0;
+        }
+        result = pal_receiveFromBatch(g_testSockets[0], items, PAL_NET_TEST_LOOPBACK_RECV_BATCH, &itemsReceived);
+        if (PAL_ERR_SOCKET_WOULD_BLOCK == result)
+        {
+            result = pal_osSemaphoreWait(s_loopbackSemaphore, TEST_SEMAPHORE_WAIT, NULL);
+            TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+            continue;
+        }
+        TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+        TEST_ASSERT((itemsReceived > 0) && (itemsReceived <= PAL_NET_TEST_LOOPBACK_RECV_BATCH));
+
+        /*#4*/
+        for (i = 0; i < (int)itemsReceived; i++)
+        {
+            uint8_t *data = recvBuffers[i];
+            TEST_ASSERT_EQUAL(PAL_NET_TEST_LOOPBACK_DATAGRAM_SIZE, items[i].bytesReceived);
+            TEST_ASSERT((data[0] >= 1) && (data[0] <= PAL_NET_TEST_LOOPBACK_SENDERS));
+            TEST_ASSERT(data[1] < PAL_NET_TEST_LOOPBACK_DATAGRAMS);
+            loopbackFillDatagram(buffer, data[0], data[1]);
+            TEST_ASSERT_EQUAL_MEMORY(buffer, data, PAL_NET_TEST_LOOPBACK_DATAGRAM_SIZE);
+            TEST_ASSERT_FALSE(received[data[0] - 1][data[1]]);
+            received[data[0] - 1][data[1]] = true;
+
+            // the datagram came from the socket whose number it carries
+            TEST_ASSERT(items[i].fromLength > 0);
+            result = pal_getSockAddrPort(&fromAddresses[i], &fromPort);
+            TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+            TEST_ASSERT_EQUAL(PAL_NET_TEST_LOOPBACK_UDP_PORT + data[0], fromPort);
+            result = pal_getSockAddrIPV4Addr(&fromAddresses[i], fromIp);
+            TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, result);
+            TEST_ASSERT_EQUAL_MEMORY(expectedIp, fromIp, PAL_IPV4_ADDRESS_SIZE);
+        }
+        total += itemsReceived;
+    }
+
+    /*#5*/
+    for (sender = 0; sender < PAL_NET_TEST_LOOPBACK_SENDERS; sender++)
+    {
+        for (i = 0; i < PAL_NET_TEST_LOOPBACK_DATAGRAMS; i++)
+        {
+            TEST_ASSERT_TRUE(received[sender][i]);
+        }
+    }
+    loopbackAssertEmpty();
+
+    /*#6*/
+    loopbackTearDown();
+}
 
 /*! \brief Test TCP socket read in chunks
 *
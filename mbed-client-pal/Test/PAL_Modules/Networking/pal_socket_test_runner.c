@@ -34,6 +34,9 @@ TEST_GROUP_RUNNER(pal_socket)
     RUN_TEST_CASE(pal_socket, socketTCPBufferedLarge);
     RUN_TEST_CASE(pal_socket, socketUDPBufferedSmall);
     RUN_TEST_CASE(pal_socket, socketUDPBufferedLarge);
+    RUN_TEST_CASE(pal_socket, asyncUDPLoopback);
+    RUN_TEST_CASE(pal_socket, asyncUDPLoopbackBatch);
+    RUN_TEST_CASE(pal_socket, asyncUDPLoopbackRecvBatch);
     RUN_TEST_CASE(pal_socket, getAddressInfoAsync);
     RUN_TEST_CASE(pal_socket, socketApiInputParamValidation);
     RUN_TEST_CASE(pal_socket, keepaliveOn);
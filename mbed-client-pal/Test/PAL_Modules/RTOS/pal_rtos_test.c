@@ -54,6 +54,9 @@ palRecursiveMutexParam_t* recursiveMutexData = NULL;
 
 #define PAL_DELAY_RUN_LOOPS 10
 
+#define PAL_TEST_TIMER_BENCH_TIMERS 16
+#define PAL_TEST_TIMER_BENCH_CYCLES 10000
+
 //Forward declarations
 void palRunThreads(void);
 
@@ -938,6 +941,89 @@ TEST(pal_rtos, TimerNegativeUnityTest)
     TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, status);
 }
 
+/*! \brief Measure the cost of timer start/stop and of timer expiry.
+ *
+* | # |    Step                                                                                          |   Expected                     |
+* |---|--------------------------------------------------------------------------------------------------|--------------------------------|
+* | 1 | Create one-shot timers, which call `palTimerFunc9` when triggered, using `pal_osTimerCreate`.    | PAL_SUCCESS                    |
+* | 2 | Start and stop the timers in a loop before they expire.                                          | PAL_SUCCESS                    |
+* | 3 | Start the timers with a short timeout in rounds and wait for all of them to fire.                | PAL_SUCCESS                    |
+* | 4 | Check that all the started timers did fire and that the stopped ones did not.                    | PAL_SUCCESS                    |
+* | 5 | Delete the timers.                                                                               | PAL_SUCCESS                    |
+*/
+TEST(pal_rtos, TimerStartStopFireBenchmark)
+{
+    palStatus_t status = PAL_SUCCESS;
+    palTimerID_t timerIDs[PAL_TEST_TIMER_BENCH_TIMERS] = {NULLPTR};
+    palSemaphoreID_t semaphoreID = NULLPTR;
+    uint64_t startTick;
+    uint64_t startStopMs;
+    uint64_t fireMs;
+    int i;
+
+    g_timerArgs.ticksInFunc1 = 0;
+
+    status = pal_osSemaphoreCreate(0, &semaphoreID);
+    TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, status);
+
+    /*#1*/
+    for (i = 0; i < PAL_TEST_TIMER_BENCH_TIMERS; i++)
+    {
+        status = pal_osTimerCreate(palTimerFunc9, &semaphoreID, palOsTimerOnce, &timerIDs[i]);
+        TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, status);
+    }
+
+    /*#2*/
+    startTick = pal_osKernelSysTick();
+    for (i = 0; i < PAL_TEST_TIMER_BENCH_CYCLES; i++)
+    {
+        status = pal_osTimerStart(timerIDs[i % PAL_TEST_TIMER_BENCH_TIMERS], PAL_TEST_TIME_SECOND);
+        TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, status);
+        status = pal_osTimerStop(timerIDs[i % PAL_TEST_TIMER_BENCH_TIMERS]);
+        TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, status);
+    }
+    startStopMs = pal_osKernelSysMilliSecTick(pal_osKernelSysTick() - startTick);
+
+    /*#3*/
+    startTick = pal_osKernelSysTick();
+    for (i = 0; i < PAL_TEST_TIMER_BENCH_CYCLES; i++)
+    {
+        status = pal_osTimerStart(timerIDs[i % PAL_TEST_TIMER_BENCH_TIMERS], 1 + (i % 3));
+        TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, status);
+
+        if ((i % PAL_TEST_TIMER_BENCH_TIMERS) == (PAL_TEST_TIMER_BENCH_TIMERS - 1))
+        {
+            int j;
+            for (j = 0; j < PAL_TEST_TIMER_BENCH_TIMERS; j++)
+            {
+                status = pal_osSemaphoreWait(semaphoreID, PAL_TEST_TIME_SECOND, NULL);
+                TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, status);
+            }
+        }
+    }
+    fireMs = pal_osKernelSysMilliSecTick(pal_osKernelSysTick() - startTick);
+
+    PAL_PRINTF("%d timer start/stop cycles took %" PRIu32 " ms, %d timer start/fire cycles took %" PRIu32 " ms\n",
+               PAL_TEST_TIMER_BENCH_CYCLES, (uint32_t)startStopMs, PAL_TEST_TIMER_BENCH_CYCLES, (uint32_t)fireMs);
+
+    /*#4*/
+    TEST_ASSERT_EQUAL_INT(PAL_TEST_TIMER_BENCH_CYCLES, g_timerArgs.ticksInFunc1);
+
+    // very loose sanity limits, both should stay well below a millisecond per cycle on average
+    TEST_ASSERT_TRUE(startStopMs < PAL_TEST_TIMER_BENCH_CYCLES);
+    TEST_ASSERT_TRUE(fireMs < PAL_TEST_TIMER_BENCH_CYCLES);
+
+    /*#5*/
+    for (i = 0; i < PAL_TEST_TIMER_BENCH_TIMERS; i++)
+    {
+        status = pal_osTimerDelete(&timerIDs[i]);
+        TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, status);
+    }
+
+    status = pal_osSemaphoreDelete(&semaphoreID);
+    TEST_ASSERT_EQUAL_HEX(PAL_SUCCESS, status);
+}
+
 /*! \brief Creates mutexes and semaphores and uses them to communicate between
 * the different threads it creates (as defined in `pal_rtos_test_utils.c`).
 * In this test, we check that thread communication is working as expected between the threads and in the designed order.
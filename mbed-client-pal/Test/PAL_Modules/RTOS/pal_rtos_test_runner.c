@@ -40,6 +40,7 @@ TEST_GROUP_RUNNER(pal_rtos)
     RUN_TEST_CASE(pal_rtos, HighResTimerUnityTest);
     RUN_TEST_CASE(pal_rtos, TimerSleepUnityTest);
     RUN_TEST_CASE(pal_rtos, TimerNegativeUnityTest);
+    RUN_TEST_CASE(pal_rtos, TimerStartStopFireBenchmark);
     RUN_TEST_CASE(pal_rtos, AtomicIncrementUnityTest);
     RUN_TEST_CASE(pal_rtos, PrimitivesUnityTest1);
     RUN_TEST_CASE(pal_rtos, PrimitivesUnityTest2);
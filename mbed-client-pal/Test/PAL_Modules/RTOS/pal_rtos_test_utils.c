@@ -295,6 +295,14 @@ void palTimerFunc8(void const *argument)
     g_timerArgs.ticksInFunc1++;
 }
 
+void palTimerFunc9(void const *argument)
+{
+    palSemaphoreID_t *semaphoreID = (palSemaphoreID_t*)argument;
+
+    g_timerArgs.ticksInFunc1++;
+    pal_osSemaphoreRelease(*semaphoreID);
+}
+
 void palThreadFuncWaitForEverTest(void const *argument)
 {
     pal_osDelay(PAL_TIME_TO_WAIT_MS/2);
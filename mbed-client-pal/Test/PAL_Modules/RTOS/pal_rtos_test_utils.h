@@ -79,6 +79,7 @@ void palTimerFunc5(void const *argument);
 void palTimerFunc6(void const *argument);
 void palTimerFunc7(void const *argument);
 void palTimerFunc8(void const *argument);
+void palTimerFunc9(void const *argument);
 
 
 void palThreadFuncWaitForEverTest(void const *argument);
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2018 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Packets and bytes on the wire for sampling bursts, with the coalescing window this is built with.
+// The real M2MReportHandler runs on the manual clock of the unit tests. Every sample writes all the
+// resources of the observed object instances 1 ms apart, once every 10 s. Confirmable notifications
+// are acked after 30 ms and the ack drains the pending queue, as in M2MNsdlInterface. A notification
+// sent while its own window is still open carries only part of the burst.
+
+#include "mbed-client/m2mconfig.h"
+#include "mbed-client/m2mreportobserver.h"
+#include "mbed-client/m2mresourcebase.h"
+#include "mbed-client/m2mtimer.h"
+#include "include/m2mreporthandler.h"
+#include "m2m_fake_timer.h"
+#include <stdio.h>
+
+#define RESOURCES           50
+#define SAMPLES             10
+#define SAMPLE_INTERVAL     10000
+#define WRITE_INTERVAL      1
+#define ROUND_TRIP          30
+#define MAX_ROOTS           2
+
+// TLV payload of 50 float resources (1 + 2 + 4 bytes each), CoAP header with token and options,
+// DTLS 1.2 AES-CCM-8 record overhead and UDP/IPv4 headers. An ACK is an empty CoAP message.
+#define PAYLOAD_BYTES       (RESOURCES * 7)
+#define OVERHEAD_BYTES      (16 + 29 + 28)
+#define ACK_BYTES           (4 + 29 + 28)
+
+void M2MResourceBase::report_to_parents()
+{
+}
+
+class Root;
+
+class Transport : public M2MTimerObserver {
+public:
+    Transport() : _ack_timer(*this), _in_flight(NULL), _packets(0), _in_window(0), _acks(0), _bytes(0)
+    {
+    }
+
+    bool send(Root *root, int resources);
+
+    virtual void timer_expired(M2MTimerObserver::Type type);
+
+    M2MTimer    _ack_timer;
+    Root        *_in_flight;
+    unsigned    _packets;
+    unsigned    _in_window;
+    unsigned    _acks;
+    unsigned    _bytes;
+};
+
+class Root : public M2MReportObserver {
+public:
+    Root(Transport &transport, bool confirmable, int resources)
+        : _transport(transport), _handler(*this, M2MBase::OPAQUE), _resources(resources)
+    {
+        _handler.set_confirmable(confirmable);
+        _handler.set_under_observation(true);
+    }
+
+    virtual bool observation_to_be_sent(const m2m::Vector<uint16_t> & /*changed_instance_ids*/,
+                                        uint16_t /*obs_number*/,
+                                        bool /*send_object*/)
+    {
+        return _transport.send(this, _resources);
+    }
+
+    Transport           &_transport;
+    M2MReportHandler    _handler;
+    int                 _resources;
+};
+
+bool Transport::send(Root *root, int resources)
+{
+    if (_in_flight) {
+        return false;
+    }
+    root->_handler.set_notification_in_queue(false);
+    _packets++;
+    if (root->_handler.notification_coalescing()) {
+        _in_window++;
+    }
+    _bytes += resources * PAYLOAD_BYTES / RESOURCES + OVERHEAD_BYTES;
+    if (root->_handler.is_confirmable()) {
+        _in_flight = root;
+        _ack_timer.start_timer(ROUND_TRIP, M2MTimerObserver::Notdefined, true);
+    }
+    return true;
+}
+
+void Transport::timer_expired(M2MTimerObserver::Type /*type*/)
+{
+    _in_flight->_handler.set_notification_send_in_progress(false);
+    _in_flight = NULL;
+    _acks++;
+    _bytes += ACK_BYTES;
+    M2MReportHandler *next = M2MReportHandler::first_notification_to_send();
+    if (next) {
+        next->schedule_report(true);
+    }
+}
+
+static void run(bool confirmable, int root_count)
+{
+    Transport transport;
+    Root *roots[MAX_ROOTS];
+    const int resources = RESOURCES / root_count;
+
+    fake_timer_reset();
+    for (int i = 0; i < root_count; i++) {
+        roots[i] = new Root(transport, confirmable, resources);
+    }
+
+    for (int sample = 0; sample < SAMPLES; sample++) {
+        uint64_t time = (uint64_t)sample * SAMPLE_INTERVAL;
+        // Resources of the roots are written in turn, each write notifies its object instance
+        for (int r = 0; r < resources; r++) {
+            for (int i = 0; i < root_count; i++) {
+                fake_timer_advance(time);
+                roots[i]->_handler.set_notification_trigger(0);
+                time += WRITE_INTERVAL;
+            }
+        }
+    }
+    fake_timer_advance((uint64_t)SAMPLES * SAMPLE_INTERVAL);
+
+    printf("%-5s %5d %9d ms %15u %14u %6u %15u\n", confirmable ? "CON" : "NON", root_count,
+           MBED_CLIENT_NOTIFICATION_COALESCING_WINDOW, transport._packets, transport._in_window,
+           transport._acks, transport._bytes);
+
+    for (int i = 0; i < root_count; i++) {
+        delete roots[i];
+    }
+}
+
+int main(void)
+{
+    printf("%d resources written per sample, %d samples\n", RESOURCES, SAMPLES);
+    printf("%-5s %5s %12s %15s %14s %6s %15s\n", "mode", "roots", "window", "notifications", "sent in window",
+           "acks", "bytes on wire");
+    for (int root_count = 1; root_count <= MAX_ROOTS; root_count++) {
+        run(false, root_count);
+        run(true, root_count);
+    }
+    return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2018 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Cost of M2MResourceBase::set_value() against the number of callbacks in M2MCallbackStorage.
+// Every resource has a value updated callback, and every other one an execute callback as well,
+// so each set_value() looks up a callback type that is not stored for the resource.
+
+#include "mbed-client/m2minterfacefactory.h"
+#include "mbed-client/m2mobject.h"
+#include "mbed-client/m2mobjectinstance.h"
+#include "mbed-client/m2mresource.h"
+#include "include/m2mcallbackstorage.h"
+#include "pal.h"
+#include "ns_hal_init.h"
+#include <stdio.h>
+#include <time.h>
+
+#define RESOURCES_PER_OBJECT    10
+#define SET_VALUES              1000000
+#define TREE_HEAP_SIZE          (8 * 1024 * 1024)
+
+static const int resource_counts[] = { 10, 1000, 10000 };
+
+static void value_updated(const char *)
+{
+}
+
+static void execute(void *)
+{
+}
+
+static void run(int resource_count)
+{
+    char name[8];
+    M2MObjectList objects;
+    M2MResource **resources = new M2MResource*[resource_count];
+    M2MObjectInstance *instance = NULL;
+
+    for (int i = 0; i < resource_count; i++) {
+        if (i % RESOURCES_PER_OBJECT == 0) {
+            snprintf(name, sizeof(name), "%d", 10000 + i / RESOURCES_PER_OBJECT);
+            M2MObject *object = M2MInterfaceFactory::create_object(name);
+            instance = object->create_object_instance();
+            objects.push_back(object);
+        }
+        snprintf(name, sizeof(name), "%d", i % RESOURCES_PER_OBJECT);
+        M2MResource *resource = instance->create_dynamic_resource(name, "", M2MResourceInstance::INTEGER, false);
+        resource->set_value_updated_function((value_updated_callback2)value_updated);
+        if (i % 2) {
+            resource->set_execute_function((execute_callback_2)execute);
+        }
+        resources[i] = resource;
+    }
+    const uint32_t callbacks = M2MCallbackStorage::get_instance()->get_callback_count();
+
+    // Resources in a pseudo random order, so that the lookups do not walk the storage in order
+    uint32_t seed = 1;
+    clock_t start = clock();
+    for (int64_t i = 0; i < SET_VALUES; i++) {
+        seed = seed * 1103515245 + 12345;
+        resources[(seed >> 8) % resource_count]->set_value(i);
+    }
+    const double set_value = (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / SET_VALUES;
+    printf("%9d %10u %14.0f\n", resource_count, (unsigned)callbacks, set_value);
+
+    for (M2MObjectList::const_iterator obj = objects.begin(); obj != objects.end(); obj++) {
+        delete *obj;
+    }
+    delete [] resources;
+}
+
+int main(void)
+{
+    pal_init();
+    ns_hal_init(NULL, TREE_HEAP_SIZE, NULL, NULL);
+
+    printf("%d set_value() calls on resources picked at random\n", SET_VALUES);
+    printf("%9s %10s %14s\n", "resources", "callbacks", "set_value ns");
+    for (unsigned i = 0; i < sizeof(resource_counts) / sizeof(resource_counts[0]); i++) {
+        run(resource_counts[i]);
+    }
+    return 0;
+}
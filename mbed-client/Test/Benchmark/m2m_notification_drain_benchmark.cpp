@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2018 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Drain throughput of the pending notification queue against the object tree walk it replaced.
+// Each round marks a fixed number of resources pending, spread over the tree, and then drains
+// them one at a time the way M2MNsdlInterface::send_next_notification() does after every ack.
+
+#include "mbed-client/m2minterfacefactory.h"
+#include "mbed-client/m2mobject.h"
+#include "mbed-client/m2mobjectinstance.h"
+#include "mbed-client/m2mresource.h"
+#include "include/m2mreporthandler.h"
+#include "pal.h"
+#include "ns_hal_init.h"
+#include <stdio.h>
+#include <time.h>
+
+#define RESOURCES_PER_OBJECT    10
+#define PENDING_PER_ROUND       16
+#define TREE_HEAP_SIZE          (8 * 1024 * 1024)
+
+static const int object_counts[] = { 1, 10, 100, 1000 };
+
+// Report handlers are internal to M2MBase, which lets its test class reach them
+class Test_M2MBase {
+public:
+    static M2MReportHandler *report_handler(const M2MBase &base)
+    {
+        return base.report_handler();
+    }
+
+    static M2MReportHandler *create_report_handler(M2MBase &base)
+    {
+        return base.create_report_handler();
+    }
+};
+
+static M2MReportHandler *first_pending_in_tree(const M2MObjectList &objects)
+{
+    for (M2MObjectList::const_iterator obj = objects.begin(); obj != objects.end(); obj++) {
+        const M2MObjectInstanceList &instances = (*obj)->instances();
+        for (M2MObjectInstanceList::const_iterator inst = instances.begin(); inst != instances.end(); inst++) {
+            const M2MResourceList &resources = (*inst)->resources();
+            for (M2MResourceList::const_iterator res = resources.begin(); res != resources.end(); res++) {
+                M2MReportHandler *handler = Test_M2MBase::report_handler(**res);
+                if (handler && handler->notification_in_queue()) {
+                    return handler;
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+static void mark_pending(M2MReportHandler **handlers, int count)
+{
+    for (int i = 0; i < PENDING_PER_ROUND; i++) {
+        handlers[(long)i * count / PENDING_PER_ROUND]->set_notification_in_queue(true);
+    }
+}
+
+static double drain_ns(const M2MObjectList &objects, M2MReportHandler **handlers, int count,
+                       bool use_queue, int rounds)
+{
+    int drained = 0;
+    clock_t start = clock();
+    for (int round = 0; round < rounds; round++) {
+        mark_pending(handlers, count);
+        M2MReportHandler *handler;
+        while ((handler = use_queue ? M2MReportHandler::first_pending_notification() :
+                          first_pending_in_tree(objects)) != NULL) {
+            handler->set_notification_in_queue(false);
+            drained++;
+        }
+    }
+    return (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / drained;
+}
+
+static void run(int object_count)
+{
+    char name[8];
+    M2MObjectList objects;
+    const int count = object_count * RESOURCES_PER_OBJECT;
+    M2MReportHandler **handlers = new M2MReportHandler*[count];
+
+    for (int i = 0; i < object_count; i++) {
+        snprintf(name, sizeof(name), "%d", 10000 + i);
+        M2MObject *object = M2MInterfaceFactory::create_object(name);
+        M2MObjectInstance *instance = object->create_object_instance();
+        for (int r = 0; r < RESOURCES_PER_OBJECT; r++) {
+            snprintf(name, sizeof(name), "%d", r);
+            M2MResource *resource = instance->create_dynamic_resource(name, "", M2MResourceInstance::INTEGER, true);
+            handlers[i * RESOURCES_PER_OBJECT + r] = Test_M2MBase::create_report_handler(*resource);
+        }
+        objects.push_back(object);
+    }
+
+    const int rounds = 2000000 / count + 10;
+    const double walk = drain_ns(objects, handlers, count, false, rounds);
+    const double queue = drain_ns(objects, handlers, count, true, rounds);
+    printf("%9d %14.0f %14.0f %9.1fx\n", count, walk, queue, walk / queue);
+
+    for (M2MObjectList::const_iterator obj = objects.begin(); obj != objects.end(); obj++) {
+        delete *obj;
+    }
+    delete [] handlers;
+}
+
+int main(void)
+{
+    // The queue is relinked under the event scheduler mutex, which ns_hal_init() creates
+    pal_init();
+    ns_hal_init(NULL, TREE_HEAP_SIZE, NULL, NULL);
+
+    printf("%d pending notifications per round, drained one by one\n", PENDING_PER_ROUND);
+    printf("%9s %14s %14s %10s\n", "resources", "tree walk ns", "queue ns", "speedup");
+    for (unsigned i = 0; i < sizeof(object_counts) / sizeof(object_counts[0]); i++) {
+        run(object_counts[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2018 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Blockwise GET of an object as OMA-TLV, serialized the way M2MObject::handle_get_request() does.
+// The whole payload serialized at once is kept by mbed-coap until the last block is sent, serialized
+// per block only the requested block is held, at the cost of walking the object for every block.
+
+#include "mbed-client/m2minterfacefactory.h"
+#include "mbed-client/m2mobject.h"
+#include "mbed-client/m2mobjectinstance.h"
+#include "mbed-client/m2mresource.h"
+#include "include/m2mtlvserializer.h"
+#include "pal.h"
+#include "ns_hal_init.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RESOURCES_PER_INSTANCE  10
+#define BLOCK_SIZE              1024
+#define TREE_HEAP_SIZE          (8 * 1024 * 1024)
+
+static const int instance_counts[] = { 1, 10, 100, 1000 };
+
+static const char value[] = "value of a string resource";
+
+static double whole_ns(const M2MObject &object, int rounds, uint32_t &size)
+{
+    clock_t start = clock();
+    for (int round = 0; round < rounds; round++) {
+        uint8_t *data = M2MTLVSerializer::serialize(object.instances(), size);
+        free(data);
+    }
+    return (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / rounds;
+}
+
+static double blocks_ns(const M2MObject &object, int rounds, const uint8_t *expected)
+{
+    uint8_t block[BLOCK_SIZE];
+    uint32_t total_size = 0;
+    clock_t start = clock();
+    for (int round = 0; round < rounds; round++) {
+        uint32_t offset = 0;
+        do {
+            M2MTLVSerializer::serialize(object.instances(), 0, NULL, 0, total_size);
+            const uint32_t length = M2MTLVSerializer::serialize(object.instances(), offset, block, sizeof(block), total_size);
+            if (memcmp(block, expected + offset, length) != 0) {
+                printf("block at %u differs from the whole payload\n", (unsigned)offset);
+                exit(1);
+            }
+            offset += length;
+        } while (offset < total_size);
+    }
+    return (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / rounds;
+}
+
+static void run(int instance_count)
+{
+    char name[8];
+    M2MObject *object = M2MInterfaceFactory::create_object("10000");
+    for (int i = 0; i < instance_count; i++) {
+        M2MObjectInstance *instance = object->create_object_instance(i);
+        for (int r = 0; r < RESOURCES_PER_INSTANCE; r++) {
+            snprintf(name, sizeof(name), "%d", r);
+            M2MResource *resource;
+            if (r % 2) {
+                resource = instance->create_dynamic_resource(name, "", M2MResourceInstance::STRING, false);
+                resource->set_value((const uint8_t *)value, sizeof(value) - 1);
+            } else {
+                resource = instance->create_dynamic_resource(name, "", M2MResourceInstance::INTEGER, false);
+                resource->set_value((int64_t)i * r);
+            }
+        }
+    }
+
+    uint32_t size = 0;
+    uint8_t *expected = M2MTLVSerializer::serialize(object->instances(), size);
+    const uint32_t block_count = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const int rounds = 1000000 / (instance_count * RESOURCES_PER_INSTANCE) + 1;
+    const double whole = whole_ns(*object, rounds, size);
+    const double blocks = blocks_ns(*object, rounds / block_count + 1, expected);
+    printf("%9d %9u %7u %12.0f %12.0f %10u %10u\n", instance_count * RESOURCES_PER_INSTANCE,
+           (unsigned)size, (unsigned)block_count, whole, blocks,
+           (unsigned)size, (unsigned)(size < BLOCK_SIZE ? size : BLOCK_SIZE));
+
+    free(expected);
+    delete object;
+}
+
+int main(void)
+{
+    pal_init();
+    ns_hal_init(NULL, TREE_HEAP_SIZE, NULL, NULL);
+
+    printf("GET of an object as OMA-TLV in %d byte blocks, time to serve all blocks\n", BLOCK_SIZE);
+    printf("%9s %9s %7s %12s %12s %10s %10s\n", "resources", "bytes", "blocks",
+           "whole ns", "by block ns", "whole mem", "block mem");
+    for (unsigned i = 0; i < sizeof(instance_counts) / sizeof(instance_counts[0]); i++) {
+        run(instance_counts[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2018 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "m2m_fake_timer.h"
+#include "mbed-client/m2mtimer.h"
+#include "mbed-client/m2mvector.h"
+#include "eventOS_scheduler.h"
+
+class M2MTimerPimpl {
+public:
+    M2MTimerPimpl(M2MTimerObserver &observer)
+        : _observer(observer), _type(M2MTimerObserver::Notdefined), _deadline(0), _interval(0),
+          _single_shot(true), _running(false)
+    {
+    }
+
+    M2MTimerObserver        &_observer;
+    M2MTimerObserver::Type  _type;
+    uint64_t                _deadline;
+    uint64_t                _interval;
+    bool                    _single_shot;
+    bool                    _running;
+};
+
+static m2m::Vector<M2MTimerPimpl *> timers;
+static uint64_t now_ms;
+static int mutex_depth;
+
+M2MTimer::M2MTimer(M2MTimerObserver &observer)
+    : _observer(observer)
+{
+    _private_impl = new M2MTimerPimpl(observer);
+    timers.push_back(_private_impl);
+}
+
+M2MTimer::~M2MTimer()
+{
+    for (int i = 0; i < timers.size(); i++) {
+        if (timers[i] == _private_impl) {
+            timers.erase(i);
+            break;
+        }
+    }
+    delete _private_impl;
+}
+
+void M2MTimer::start_timer(uint64_t interval, M2MTimerObserver::Type type, bool single_shot)
+{
+    _private_impl->_type = type;
+    _private_impl->_interval = interval;
+    _private_impl->_deadline = now_ms + interval;
+    _private_impl->_single_shot = single_shot;
+    _private_impl->_running = true;
+}
+
+void M2MTimer::start_dtls_timer(uint64_t /*intermediate_interval*/, uint64_t total_interval, M2MTimerObserver::Type type)
+{
+    start_timer(total_interval, type, true);
+}
+
+void M2MTimer::stop_timer()
+{
+    _private_impl->_running = false;
+}
+
+bool M2MTimer::is_intermediate_interval_passed()
+{
+    return false;
+}
+
+bool M2MTimer::is_total_interval_passed()
+{
+    return !_private_impl->_running;
+}
+
+void fake_timer_reset()
+{
+    for (int i = 0; i < timers.size(); i++) {
+        timers[i]->_running = false;
+    }
+    now_ms = 0;
+}
+
+void fake_timer_advance(uint64_t time_ms)
+{
+    while (true) {
+        M2MTimerPimpl *next = NULL;
+        for (int i = 0; i < timers.size(); i++) {
+            M2MTimerPimpl *timer = timers[i];
+            if (timer->_running && timer->_deadline <= time_ms && (!next || timer->_deadline < next->_deadline)) {
+                next = timer;
+            }
+        }
+        if (!next) {
+            break;
+        }
+        now_ms = next->_deadline;
+        if (next->_single_shot) {
+            next->_running = false;
+        } else {
+            next->_deadline += next->_interval;
+        }
+        next->_observer.timer_expired(next->_type);
+    }
+    now_ms = time_ms;
+}
+
+uint64_t fake_timer_now()
+{
+    return now_ms;
+}
+
+int fake_scheduler_mutex_depth()
+{
+    return mutex_depth;
+}
+
+void eventOS_scheduler_mutex_wait(void)
+{
+    mutex_depth++;
+}
+
+void eventOS_scheduler_mutex_release(void)
+{
+    mutex_depth--;
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2018 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef M2M_FAKE_TIMER_H
+#define M2M_FAKE_TIMER_H
+
+#include <stdint.h>
+
+// M2MTimer on a manual clock, for the unit tests. Timers only fire from fake_timer_advance().
+
+/**
+ * \brief Resets the clock to 0 ms. Timers that are still running are stopped.
+ */
+void fake_timer_reset();
+
+/**
+ * \brief Moves the clock to the given time and fires, in deadline order, every timer
+ * expiring up to then. Timers started by the callbacks are fired too if they are due.
+ * \param time_ms Absolute time in milliseconds.
+ */
+void fake_timer_advance(uint64_t time_ms);
+
+/**
+ * \brief Returns the current time of the clock in milliseconds.
+ */
+uint64_t fake_timer_now();
+
+/**
+ * \brief Returns the nesting depth of the event scheduler mutex, 0 when it is not held.
+ */
+int fake_scheduler_mutex_depth();
+
+#endif // M2M_FAKE_TIMER_H
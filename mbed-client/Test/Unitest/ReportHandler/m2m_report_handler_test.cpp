@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2018 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mbed-client/m2mconfig.h"
+#include "mbed-client/m2mreportobserver.h"
+#include "mbed-client/m2mresourcebase.h"
+#include "mbed-client/m2mtimer.h"
+#include "include/m2mreporthandler.h"
+#include "m2m_fake_timer.h"
+
+extern "C" {
+#include "unity.h"
+#include "unity_fixture.h"
+}
+
+// Built with MBED_CONF_MBED_CLIENT_NOTIFICATION_COALESCING_WINDOW set, see the mbed-client tests in CMakeLists.txt
+#define WINDOW      MBED_CLIENT_NOTIFICATION_COALESCING_WINDOW
+#define ROUND_TRIP  (10 * WINDOW)
+#define MAX_SENDS   16
+
+class Root;
+
+// The handlers under test are not attached to resources, so they never report to parents
+void M2MResourceBase::report_to_parents()
+{
+}
+
+// Stands in for M2MNsdlInterface: one notification in flight at a time, confirmable ones
+// are acked after ROUND_TRIP, and every ack drains the pending queue the way
+// M2MNsdlInterface::send_next_notification() does.
+class Transport : public M2MTimerObserver {
+public:
+    Transport() : _ack_timer(*this), _in_flight(NULL), _send_count(0)
+    {
+    }
+
+    bool send(Root *root);
+
+    virtual void timer_expired(M2MTimerObserver::Type type);
+
+    M2MTimer    _ack_timer;
+    Root        *_in_flight;
+    Root        *_sent_root[MAX_SENDS];
+    uint64_t    _sent_time[MAX_SENDS];
+    int         _send_count;
+};
+
+// One observed object, object instance or resource with its own token and report handler
+class Root : public M2MReportObserver {
+public:
+    Root(Transport &transport, bool confirmable) : _transport(transport), _handler(*this, M2MBase::OPAQUE)
+    {
+        _handler.set_confirmable(confirmable);
+        _handler.set_under_observation(true);
+    }
+
+    // What M2MObjectInstance::notification_update() does on a value change
+    void change()
+    {
+        _handler.set_notification_trigger(0);
+    }
+
+    virtual bool observation_to_be_sent(const m2m::Vector<uint16_t> & /*changed_instance_ids*/,
+                                        uint16_t /*obs_number*/,
+                                        bool /*send_object*/)
+    {
+        return _transport.send(this);
+    }
+
+    Transport           &_transport;
+    M2MReportHandler    _handler;
+};
+
+bool Transport::send(Root *root)
+{
+    if (_in_flight) {
+        return false;
+    }
+    root->_handler.set_notification_in_queue(false);
+    if (_send_count < MAX_SENDS) {
+        _sent_root[_send_count] = root;
+        _sent_time[_send_count] = fake_timer_now();
+    }
+    _send_count++;
+    if (root->_handler.is_confirmable()) {
+        _in_flight = root;
+        _ack_timer.start_timer(ROUND_TRIP, M2MTimerObserver::Notdefined, true);
+    }
+    return true;
+}
+
+void Transport::timer_expired(M2MTimerObserver::Type /*type*/)
+{
+    _in_flight->_handler.set_notification_send_in_progress(false);
+    _in_flight = NULL;
+    M2MReportHandler *next = M2MReportHandler::first_notification_to_send();
+    if (next) {
+        next->schedule_report(true);
+    }
+}
+
+static void check_sent(const Transport &transport, int index, const Root &root, uint64_t time)
+{
+    TEST_ASSERT_TRUE(index < transport._send_count);
+    TEST_ASSERT_TRUE(transport._sent_root[index] == &root);
+    TEST_ASSERT_EQUAL_UINT32(time, transport._sent_time[index]);
+}
+
+TEST_GROUP(m2m_report_handler);
+
+TEST_SETUP(m2m_report_handler)
+{
+    fake_timer_reset();
+}
+
+TEST_TEAR_DOWN(m2m_report_handler)
+{
+    TEST_ASSERT_NULL(M2MReportHandler::first_pending_notification());
+    TEST_ASSERT_EQUAL_INT(0, fake_scheduler_mutex_depth());
+}
+
+TEST(m2m_report_handler, burstOnTwoRootsSendsOnePerRoot)
+{
+    Transport transport;
+    Root first(transport, false);
+    Root second(transport, false);
+
+    for (int t = 0; t < WINDOW / 2; t++) {
+        fake_timer_advance(t);
+        first.change();
+        fake_timer_advance(t + 1);
+        second.change();
+    }
+    fake_timer_advance(10 * WINDOW);
+
+    TEST_ASSERT_EQUAL_INT(2, transport._send_count);
+    check_sent(transport, 0, first, WINDOW);
+    check_sent(transport, 1, second, WINDOW + 1);
+}
+
+TEST(m2m_report_handler, queueDrainDoesNotCloseOpenWindow)
+{
+    Transport transport;
+    Root first(transport, true);
+    Root second(transport, true);
+
+    // first is sent when its window closes and stays in flight until 11 windows
+    first.change();
+    fake_timer_advance(2 * WINDOW);
+
+    // second's window closes while first is in flight, so it waits in the queue
+    second.change();
+    fake_timer_advance(10 * WINDOW + WINDOW / 2);
+
+    // first changes again just before its ack, and is still pending in the queue ahead of second
+    first.change();
+    TEST_ASSERT_TRUE(M2MReportHandler::first_pending_notification() == &first._handler);
+    TEST_ASSERT_TRUE(first._handler.notification_coalescing());
+
+    // The ack drains the queue. first's window is open, so second goes out and first keeps collecting.
+    fake_timer_advance(11 * WINDOW);
+    TEST_ASSERT_EQUAL_INT(2, transport._send_count);
+    check_sent(transport, 0, first, WINDOW);
+    check_sent(transport, 1, second, 11 * WINDOW);
+
+    // first's window closes while second is in flight, and it goes out with the next ack
+    fake_timer_advance(40 * WINDOW);
+    TEST_ASSERT_EQUAL_INT(3, transport._send_count);
+    check_sent(transport, 2, first, 21 * WINDOW);
+}
+
+TEST(m2m_report_handler, queuedNotificationWithoutWindowIsSentAtOnce)
+{
+    Transport transport;
+    Root first(transport, true);
+    Root second(transport, true);
+
+    first.change();
+    fake_timer_advance(WINDOW);
+    second.change();
+    fake_timer_advance(2 * WINDOW);
+    TEST_ASSERT_FALSE(second._handler.notification_coalescing());
+    TEST_ASSERT_TRUE(second._handler.notification_in_queue());
+
+    fake_timer_advance(11 * WINDOW);
+    TEST_ASSERT_EQUAL_INT(2, transport._send_count);
+    check_sent(transport, 1, second, 11 * WINDOW);
+    fake_timer_advance(30 * WINDOW);
+}
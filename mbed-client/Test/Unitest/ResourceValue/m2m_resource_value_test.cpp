@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2018 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mbed-client/m2mconfig.h"
+#include "mbed-client/m2minterfacefactory.h"
+#include "mbed-client/m2mobject.h"
+#include "mbed-client/m2mobjectinstance.h"
+#include "mbed-client/m2mresource.h"
+#include "sn_nsdl_lib.h"
+#include <stdlib.h>
+#include <string.h>
+
+extern "C" {
+#include "unity.h"
+#include "unity_fixture.h"
+}
+
+// Built with MBED_CONF_MBED_CLIENT_TYPED_VALUE_STORAGE set, see the mbed-client tests in CMakeLists.txt
+#if !MBED_CLIENT_TYPED_VALUE_STORAGE
+#error "The resource value tests need MBED_CLIENT_TYPED_VALUE_STORAGE"
+#endif
+
+static M2MObject *object;
+static M2MObjectInstance *instance;
+
+static M2MResource *create_resource(const char *name, M2MResourceInstance::ResourceType type)
+{
+    M2MResource *resource = instance->create_dynamic_resource(name, "", type, false);
+    TEST_ASSERT_NOT_NULL(resource);
+    return resource;
+}
+
+// Text currently held in the nsdl resource, without rendering a binary value
+static bool has_text(const M2MResource &resource)
+{
+    return resource.get_nsdl_resource()->resource != NULL;
+}
+
+static void assert_text(const char *expected, M2MResource &resource)
+{
+    const String text = resource.get_value_string();
+    TEST_ASSERT_EQUAL_UINT32(strlen(expected), text.size());
+    TEST_ASSERT_EQUAL_MEMORY(expected, text.c_str(), text.size());
+}
+
+TEST_GROUP(m2m_resource_value);
+
+TEST_SETUP(m2m_resource_value)
+{
+    object = M2MInterfaceFactory::create_object("10000");
+    instance = object->create_object_instance();
+    TEST_ASSERT_NOT_NULL(instance);
+}
+
+TEST_TEAR_DOWN(m2m_resource_value)
+{
+    delete object;
+    object = NULL;
+    instance = NULL;
+}
+
+TEST(m2m_resource_value, integerRoundTrip)
+{
+    M2MResource *resource = create_resource("1", M2MResourceInstance::INTEGER);
+
+    TEST_ASSERT_TRUE(resource->set_value((int64_t)INT64_MIN));
+    TEST_ASSERT_TRUE(resource->get_value_int() == INT64_MIN);
+    TEST_ASSERT_TRUE(resource->set_value((int64_t)1234567890123LL));
+    TEST_ASSERT_TRUE(resource->get_value_int() == 1234567890123LL);
+    TEST_ASSERT_FALSE(has_text(*resource));
+}
+
+TEST(m2m_resource_value, floatRoundTrip)
+{
+    M2MResource *resource = create_resource("1", M2MResourceInstance::FLOAT);
+
+    TEST_ASSERT_TRUE(resource->set_value_float(-2.5f));
+    TEST_ASSERT_EQUAL_FLOAT(-2.5f, resource->get_value_float());
+    TEST_ASSERT_FALSE(has_text(*resource));
+
+    // The rendered text reads back as the same value
+    const String text = resource->get_value_string();
+    TEST_ASSERT_EQUAL_FLOAT(-2.5f, (float)atof(text.c_str()));
+}
+
+TEST(m2m_resource_value, booleanRoundTrip)
+{
+    M2MResource *resource = create_resource("1", M2MResourceInstance::BOOLEAN);
+
+    TEST_ASSERT_TRUE(resource->set_value((int64_t)1));
+    TEST_ASSERT_TRUE(resource->get_value_int() == 1);
+    TEST_ASSERT_TRUE(resource->set_value((int64_t)0));
+    TEST_ASSERT_TRUE(resource->get_value_int() == 0);
+    assert_text("0", *resource);
+}
+
+TEST(m2m_resource_value, textIsRenderedWhenRead)
+{
+    M2MResource *resource = create_resource("1", M2MResourceInstance::INTEGER);
+
+    resource->set_value((int64_t)42);
+    TEST_ASSERT_FALSE(has_text(*resource));
+
+    TEST_ASSERT_EQUAL_UINT32(2, resource->value_length());
+    TEST_ASSERT_TRUE(has_text(*resource));
+    TEST_ASSERT_EQUAL_MEMORY("42", resource->value(), 2);
+
+    assert_text("42", *resource);
+
+    // A new value drops the rendered text
+    resource->set_value((int64_t)-7);
+    TEST_ASSERT_FALSE(has_text(*resource));
+    assert_text("-7", *resource);
+}
+
+TEST(m2m_resource_value, unchangedValueKeepsText)
+{
+    M2MResource *resource = create_resource("1", M2MResourceInstance::INTEGER);
+
+    resource->set_value((int64_t)42);
+    assert_text("42", *resource);
+    const uint8_t *text = resource->get_nsdl_resource()->resource;
+
+    resource->set_value((int64_t)42);
+    TEST_ASSERT_TRUE(resource->get_nsdl_resource()->resource == text);
+}
+
+TEST(m2m_resource_value, textValueReplacesTypedValue)
+{
+    M2MResource *integer = create_resource("1", M2MResourceInstance::INTEGER);
+
+    integer->set_value((int64_t)5);
+    TEST_ASSERT_TRUE(integer->get_value_int() == 5);
+    TEST_ASSERT_TRUE(integer->set_value((const uint8_t *)"17", 2));
+    TEST_ASSERT_TRUE(integer->get_value_int() == 17);
+    assert_text("17", *integer);
+
+    // The typed value is cached again on the next typed set
+    integer->set_value((int64_t)5);
+    TEST_ASSERT_TRUE(integer->get_value_int() == 5);
+    assert_text("5", *integer);
+
+    M2MResource *real = create_resource("2", M2MResourceInstance::FLOAT);
+
+    real->set_value_float(1.5f);
+    TEST_ASSERT_EQUAL_FLOAT(1.5f, real->get_value_float());
+    TEST_ASSERT_TRUE(real->set_value((const uint8_t *)"0.25", 4));
+    TEST_ASSERT_EQUAL_FLOAT(0.25f, real->get_value_float());
+    assert_text("0.25", *real);
+}
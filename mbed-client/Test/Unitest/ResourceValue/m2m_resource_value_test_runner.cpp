@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2018 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+extern "C" {
+#include "unity.h"
+#include "unity_fixture.h"
+}
+
+TEST_GROUP_RUNNER(m2m_resource_value)
+{
+    RUN_TEST_CASE(m2m_resource_value, integerRoundTrip);
+    RUN_TEST_CASE(m2m_resource_value, floatRoundTrip);
+    RUN_TEST_CASE(m2m_resource_value, booleanRoundTrip);
+    RUN_TEST_CASE(m2m_resource_value, textIsRenderedWhenRead);
+    RUN_TEST_CASE(m2m_resource_value, unchangedValueKeepsText);
+    RUN_TEST_CASE(m2m_resource_value, textValueReplacesTypedValue);
+}
+
+static void run_all_tests(void)
+{
+    RUN_TEST_GROUP(m2m_resource_value);
+}
+
+int main(int argc, const char *argv[])
+{
+    return UnityMain(argc, argv, run_all_tests);
+}
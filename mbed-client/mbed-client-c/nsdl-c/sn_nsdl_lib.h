@@ -203,6 +203,9 @@ typedef struct sn_nsdl_resource_parameters_ {
     bool                                        always_publish: 1;   /**< 1 if resource should always be published in registration or registration update **/
     unsigned                                    publish_value: 2;     /**< 0 for non-publishing,1 if resource value to be published in registration message,
                                                                          2 if resource value to be published in Base64 encoded format */
+#if SN_GRS_PATH_INDEX
+    struct sn_nsdl_resource_parameters_         *path_index_next;    /**< Next resource in the same path index bucket, owned by GRS */
+#endif
 } sn_nsdl_dynamic_resource_parameters_s;
 
 
@@ -381,6 +384,22 @@ extern int8_t sn_nsdl_process_coap(struct nsdl_s *handle, sn_coap_hdr_s *coap_pa
  */
 extern int8_t sn_nsdl_exec(struct nsdl_s *handle, uint32_t time);
 
+/**
+ * \fn extern int8_t sn_nsdl_get_next_exec_time(struct nsdl_s *handle, uint32_t *next_time);
+ *
+ * \brief Tells when sn_nsdl_exec() needs to be called next.
+ *
+ * Can be used to sleep until the next retransmission or timeout instead of calling sn_nsdl_exec() periodically.
+ *
+ * \param   *handle Pointer to nsdl-library handle
+ *
+ * \param  *next_time Filled with the time in seconds, in the same time base as given to sn_nsdl_exec().
+ *
+ * \return  0   Success
+ * \return  -1  Failure or nothing pending
+ */
+extern int8_t sn_nsdl_get_next_exec_time(struct nsdl_s *handle, uint32_t *next_time);
+
 /**
  * \fn  extern int8_t sn_nsdl_put_resource(struct nsdl_s *handle, const sn_nsdl_dynamic_resource_parameters_s *res);
  *
@@ -695,6 +714,27 @@ extern void sn_nsdl_remove_coap_block(struct nsdl_s *handle, sn_nsdl_addr_s *sou
  */
 extern int8_t sn_nsdl_remove_msg_from_retransmission(struct nsdl_s *handle, uint8_t *token, uint8_t token_len);
 
+/**
+ * \fn uint8_t *sn_nsdl_ref_tx_packet(struct nsdl_s *handle, const uint8_t *data_ptr)
+ *
+ * \brief Takes a reference to the CoAP packet given to the TX callback.
+ *        Transport can queue the packet instead of copying it. Valid only inside the TX callback.
+ *
+ * \param *handle Pointer to library handle
+ * \param *data_ptr Data pointer given to the TX callback
+ * \return Pointer to the same packet, NULL if the packet can not be shared
+ */
+extern uint8_t *sn_nsdl_ref_tx_packet(struct nsdl_s *handle, const uint8_t *data_ptr);
+
+/**
+ * \fn void sn_nsdl_release_tx_packet(uint8_t *packet_ptr)
+ *
+ * \brief Releases a packet reference taken with sn_nsdl_ref_tx_packet().
+ *
+ * \param *packet_ptr Pointer to the packet
+ */
+extern void sn_nsdl_release_tx_packet(uint8_t *packet_ptr);
+
 /**
  * \fn int8_t sn_nsdl_handle_block2_response_internally(struct nsdl_s *handle, uint8_t handle_response)
  *
@@ -60,6 +60,13 @@ struct grs_s {
 
     uint16_t resource_root_count;
     resource_list_t resource_root_list;
+
+#if SN_GRS_PATH_INDEX
+    /* Hash buckets of resources keyed on path, chained through path_index_next. Mirrors resource_root_list.
+     * NULL if the index could not be allocated, searches then fall back to a list scan. */
+    sn_nsdl_dynamic_resource_parameters_s **path_index;
+    uint16_t path_index_size;
+#endif
 };
 
 
@@ -44,6 +44,14 @@ static int8_t sn_grs_core_request(struct nsdl_s *handle, sn_nsdl_addr_s *src_add
 static uint8_t coap_tx_callback(uint8_t *, uint16_t, sn_nsdl_addr_s *, void *);
 static int8_t coap_rx_callback(sn_coap_hdr_s *coap_ptr, sn_nsdl_addr_s *address_ptr, void *param);
 static void sn_grs_free_coap_packet(struct nsdl_s *nsdl_handle, sn_coap_hdr_s *coap_packet_ptr, sn_nsdl_addr_s *src_addr_ptr);
+static void sn_grs_remove_from_list(struct grs_s *handle, sn_nsdl_dynamic_resource_parameters_s *resource_ptr);
+#if SN_GRS_PATH_INDEX
+static uint32_t sn_grs_path_hash(const char *path, uint16_t pathlen);
+static void sn_grs_path_index_free(struct grs_s *handle);
+static void sn_grs_path_index_add(struct grs_s *handle, sn_nsdl_dynamic_resource_parameters_s *resource_ptr);
+static void sn_grs_path_index_remove(struct grs_s *handle, sn_nsdl_dynamic_resource_parameters_s *resource_ptr);
+static sn_nsdl_dynamic_resource_parameters_s *sn_grs_path_index_search(struct grs_s *handle, const char *path, uint16_t pathlen);
+#endif
 
 /* Extern function prototypes */
 extern int8_t                       sn_nsdl_build_registration_body(struct nsdl_s *handle, sn_coap_hdr_s *message_ptr, uint8_t updating_registeration);
@@ -58,6 +66,9 @@ extern int8_t sn_grs_destroy(struct grs_s *handle)
     if( handle == NULL ){
         return 0;
     }
+#if SN_GRS_PATH_INDEX
+    sn_grs_path_index_free(handle);
+#endif
     ns_list_foreach_safe(sn_nsdl_dynamic_resource_parameters_s, tmp, &handle->resource_root_list) {
         ns_list_remove(&handle->resource_root_list, tmp);
         --handle->resource_root_count;
@@ -162,6 +173,8 @@ extern int8_t sn_grs_delete_resource(struct grs_s *handle, const char *path)
 {
     /* Local variables */
     sn_nsdl_dynamic_resource_parameters_s     *resource_temp  = NULL;
+    const char                                *path_temp_ptr  = NULL;
+    uint16_t                                  pathlen         = 0;
 
     /* Search if resource found */
     resource_temp = sn_grs_search_resource(handle, path, SN_GRS_SEARCH_METHOD);
@@ -171,18 +184,24 @@ extern int8_t sn_grs_delete_resource(struct grs_s *handle, const char *path)
         return SN_NSDL_FAILURE;
     }
 
-    /* If found, delete it and delete also subresources, if there is any */
-    do {
-        /* Remove from list */
-        ns_list_remove(&handle->resource_root_list, resource_temp);
-        --handle->resource_root_count;
+    /* If found, delete it */
+    sn_grs_remove_from_list(handle, resource_temp);
+    sn_grs_resource_info_free(handle, resource_temp);
 
-        /* Free */
-        sn_grs_resource_info_free(handle, resource_temp);
+    /* Delete also subresources, if there is any. All of them are collected in a single pass
+     * instead of restarting the search from the beginning of the list after every removal. */
+    pathlen = strlen(path);
+    path_temp_ptr = sn_grs_convert_uri(&pathlen, path);
 
-        /* Search for subresources */
-        resource_temp = sn_grs_search_resource(handle, path, SN_GRS_DELETE_METHOD);
-    } while (resource_temp != NULL);
+    ns_list_foreach_safe(sn_nsdl_dynamic_resource_parameters_s, resource_search_temp, &handle->resource_root_list) {
+        const char *temp_path = resource_search_temp->static_resource_parameters->path;
+        if (strlen(temp_path) > pathlen &&
+                temp_path[pathlen] == '/' &&
+                0 == memcmp(temp_path, path_temp_ptr, pathlen)) {
+            sn_grs_remove_from_list(handle, resource_search_temp);
+            sn_grs_resource_info_free(handle, resource_search_temp);
+        }
+    }
 
     return SN_NSDL_SUCCESS;
 }
@@ -208,6 +227,9 @@ int8_t sn_grs_put_resource(struct grs_s *handle, sn_nsdl_dynamic_resource_parame
 
     ns_list_add_to_start(&handle->resource_root_list, res);
     ++handle->resource_root_count;
+#if SN_GRS_PATH_INDEX
+    sn_grs_path_index_add(handle, res);
+#endif
 
     return SN_NSDL_SUCCESS;
 }
@@ -229,8 +251,7 @@ int8_t sn_grs_pop_resource(struct grs_s *handle, sn_nsdl_dynamic_resource_parame
         return SN_NSDL_FAILURE;
     }
 
-    ns_list_remove(&handle->resource_root_list, res);
-    --handle->resource_root_count;
+    sn_grs_remove_from_list(handle, res);
 
     return SN_NSDL_SUCCESS;
 }
@@ -460,16 +481,16 @@ extern int8_t sn_grs_send_coap_message(struct nsdl_s *handle, sn_nsdl_addr_s *ad
     /* Calculate message length */
     message_len = sn_coap_builder_calc_needed_packet_data_size_2(coap_hdr_ptr, handle->grs->coap->sn_coap_block_data_size);
 
-    /* Allocate memory for message and check was allocating successfully */
-    message_ptr = handle->grs->sn_grs_alloc(message_len);
+    /* Allocate shared packet buffer for message and check was allocating successfully */
+    message_ptr = sn_coap_protocol_packet_alloc(handle->grs->coap, message_len);
     if (message_ptr == NULL) {
         return SN_NSDL_FAILURE;
     }
 
-    /* Build CoAP message */
-    ret_val = sn_coap_protocol_build(handle->grs->coap, address_ptr, message_ptr, coap_hdr_ptr, (void *)handle);
+    /* Build CoAP message, resending list takes a reference instead of a copy */
+    ret_val = sn_coap_protocol_build_2(handle->grs->coap, address_ptr, message_ptr, message_len, coap_hdr_ptr, (void *)handle);
     if (ret_val < 0) {
-        handle->grs->sn_grs_free(message_ptr);
+        sn_coap_protocol_packet_release(message_ptr);
         message_ptr = 0;
         if (ret_val == -4) {
             return SN_NSDL_RESEND_QUEUE_FULL;
@@ -478,11 +499,11 @@ extern int8_t sn_grs_send_coap_message(struct nsdl_s *handle, sn_nsdl_addr_s *ad
         }
     }
 
-    /* Call tx callback function to send message */
-    ret_val = handle->grs->sn_grs_tx_callback(handle, SN_NSDL_PROTOCOL_COAP, message_ptr, message_len, address_ptr);
+    /* Call tx callback function to send message, transport may keep a reference to the buffer */
+    ret_val = sn_coap_protocol_send_packet(handle->grs->coap, message_ptr, message_len, address_ptr, (void *)handle);
 
-    /* Free allocated memory */
-    handle->grs->sn_grs_free(message_ptr);
+    /* Release own reference to the message */
+    sn_coap_protocol_packet_release(message_ptr);
     message_ptr = 0;
 
     if (ret_val == 0) {
@@ -566,6 +587,11 @@ sn_nsdl_dynamic_resource_parameters_s *sn_grs_search_resource(struct grs_s *hand
 
     /* Searchs exact path */
     if (search_method == SN_GRS_SEARCH_METHOD) {
+#if SN_GRS_PATH_INDEX
+        if (handle->path_index) {
+            return sn_grs_path_index_search(handle, path_temp_ptr, pathlen);
+        }
+#endif
         /* Scan all nodes on list */
         ns_list_foreach(sn_nsdl_dynamic_resource_parameters_s, resource_search_temp, &handle->resource_root_list) {
             /* If length equals.. */
@@ -605,6 +631,179 @@ sn_nsdl_dynamic_resource_parameters_s *sn_grs_search_resource(struct grs_s *hand
     return NULL;
 }
 
+/**
+ * \fn  static void sn_grs_remove_from_list(struct grs_s *handle, sn_nsdl_dynamic_resource_parameters_s *resource_ptr)
+ *
+ * \brief Unlinks resource from the resource list and from the path index
+ *
+ *  \param *resource_ptr    Pointer to the resource, must be on the list
+ *
+*/
+static void sn_grs_remove_from_list(struct grs_s *handle, sn_nsdl_dynamic_resource_parameters_s *resource_ptr)
+{
+#if SN_GRS_PATH_INDEX
+    sn_grs_path_index_remove(handle, resource_ptr);
+#endif
+    ns_list_remove(&handle->resource_root_list, resource_ptr);
+    --handle->resource_root_count;
+}
+
+#if SN_GRS_PATH_INDEX
+
+/* Minimum number of path index buckets, must be power of two */
+#define SN_GRS_PATH_INDEX_MIN_SIZE      16
+
+/* Largest power of two bucket count whose table still fits into a single sn_grs_alloc().
+ * Beyond this the chains simply grow longer. */
+#define SN_GRS_PATH_INDEX_MAX_SIZE      (sizeof(void *) > 4 ? 4096 : 8192)
+
+/**
+ * \fn  static uint32_t sn_grs_path_hash(const char *path, uint16_t pathlen)
+ *
+ * \brief Calculates 32-bit FNV-1a hash over the path
+ *
+*/
+static uint32_t sn_grs_path_hash(const char *path, uint16_t pathlen)
+{
+    uint32_t hash = 2166136261u;
+
+    for (uint16_t i = 0; i < pathlen; i++) {
+        hash ^= (uint8_t)path[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static uint16_t sn_grs_path_index_bucket(const struct grs_s *handle, const sn_nsdl_dynamic_resource_parameters_s *resource_ptr)
+{
+    const char *path = resource_ptr->static_resource_parameters->path;
+    return sn_grs_path_hash(path, strlen(path)) & (handle->path_index_size - 1);
+}
+
+static void sn_grs_path_index_free(struct grs_s *handle)
+{
+    if (handle->path_index) {
+        handle->sn_grs_free(handle->path_index);
+        handle->path_index = NULL;
+    }
+    handle->path_index_size = 0;
+}
+
+/**
+ * \fn  static int8_t sn_grs_path_index_rebuild(struct grs_s *handle)
+ *
+ * \brief Reallocates the path index for the current resource count and
+ *        refills it from the resource list.
+ *
+ *  \return 0 if success, -1 if failed. On failure the index is released and
+ *          searches fall back to scanning the resource list.
+ *
+*/
+static int8_t sn_grs_path_index_rebuild(struct grs_s *handle)
+{
+    uint16_t size = SN_GRS_PATH_INDEX_MIN_SIZE;
+
+    while (size < handle->resource_root_count && size < SN_GRS_PATH_INDEX_MAX_SIZE) {
+        size <<= 1;
+    }
+
+    sn_grs_path_index_free(handle);
+
+    handle->path_index = handle->sn_grs_alloc(size * sizeof(sn_nsdl_dynamic_resource_parameters_s *));
+    if (!handle->path_index) {
+        return SN_NSDL_FAILURE;
+    }
+    memset(handle->path_index, 0, size * sizeof(sn_nsdl_dynamic_resource_parameters_s *));
+    handle->path_index_size = size;
+
+    ns_list_foreach(sn_nsdl_dynamic_resource_parameters_s, resource_temp, &handle->resource_root_list) {
+        uint16_t bucket = sn_grs_path_index_bucket(handle, resource_temp);
+        resource_temp->path_index_next = handle->path_index[bucket];
+        handle->path_index[bucket] = resource_temp;
+    }
+
+    return SN_NSDL_SUCCESS;
+}
+
+/**
+ * \fn  static void sn_grs_path_index_add(struct grs_s *handle, sn_nsdl_dynamic_resource_parameters_s *resource_ptr)
+ *
+ * \brief Adds resource, already linked to the resource list, into the path index
+ *
+*/
+static void sn_grs_path_index_add(struct grs_s *handle, sn_nsdl_dynamic_resource_parameters_s *resource_ptr)
+{
+    uint16_t bucket;
+
+    /* Grow when there are more resources than buckets, or retry if earlier allocation failed.
+     * Rebuild also picks up the new resource from the list. */
+    if (!handle->path_index ||
+        (handle->resource_root_count > handle->path_index_size && handle->path_index_size < SN_GRS_PATH_INDEX_MAX_SIZE)) {
+        sn_grs_path_index_rebuild(handle);
+        return;
+    }
+
+    bucket = sn_grs_path_index_bucket(handle, resource_ptr);
+    resource_ptr->path_index_next = handle->path_index[bucket];
+    handle->path_index[bucket] = resource_ptr;
+}
+
+/**
+ * \fn  static void sn_grs_path_index_remove(struct grs_s *handle, sn_nsdl_dynamic_resource_parameters_s *resource_ptr)
+ *
+ * \brief Removes resource from the path index
+ *
+*/
+static void sn_grs_path_index_remove(struct grs_s *handle, sn_nsdl_dynamic_resource_parameters_s *resource_ptr)
+{
+    sn_nsdl_dynamic_resource_parameters_s **link_ptr;
+
+    if (!handle->path_index) {
+        return;
+    }
+
+    link_ptr = &handle->path_index[sn_grs_path_index_bucket(handle, resource_ptr)];
+    while (*link_ptr) {
+        if (*link_ptr == resource_ptr) {
+            *link_ptr = resource_ptr->path_index_next;
+            resource_ptr->path_index_next = NULL;
+            return;
+        }
+        link_ptr = &(*link_ptr)->path_index_next;
+    }
+}
+
+/**
+ * \fn  static sn_nsdl_dynamic_resource_parameters_s *sn_grs_path_index_search(struct grs_s *handle, const char *path, uint16_t pathlen)
+ *
+ * \brief Searches exact path from the path index
+ *
+ *  \param  *path           Pointer to the normalized path, not necessarily zero terminated
+ *
+ *  \param  pathlen         Length of the path
+ *
+ *  \return                 Pointer to the resource. If resource not found, return value is NULL
+ *
+*/
+static sn_nsdl_dynamic_resource_parameters_s *sn_grs_path_index_search(struct grs_s *handle, const char *path, uint16_t pathlen)
+{
+    sn_nsdl_dynamic_resource_parameters_s *resource_temp;
+
+    resource_temp = handle->path_index[sn_grs_path_hash(path, pathlen) & (handle->path_index_size - 1)];
+    while (resource_temp) {
+        const char *temp_path = resource_temp->static_resource_parameters->path;
+        if (strlen(temp_path) == pathlen && 0 == memcmp(temp_path, path, pathlen)) {
+            return resource_temp;
+        }
+        resource_temp = resource_temp->path_index_next;
+    }
+
+    return NULL;
+}
+
+#endif // SN_GRS_PATH_INDEX
+
 /**
  * \fn  static uint8_t *sn_grs_convert_uri(uint16_t *uri_len, uint8_t *uri_ptr)
  *
@@ -890,6 +890,14 @@ int8_t sn_nsdl_exec(struct nsdl_s *handle, uint32_t time)
     return sn_coap_protocol_exec(handle->grs->coap, time);
 }
 
+int8_t sn_nsdl_get_next_exec_time(struct nsdl_s *handle, uint32_t *next_time)
+{
+    if (!handle || !handle->grs) {
+        return SN_NSDL_FAILURE;
+    }
+    return sn_coap_protocol_get_next_exec_time(handle->grs->coap, next_time);
+}
+
 sn_nsdl_dynamic_resource_parameters_s *sn_nsdl_get_resource(struct nsdl_s *handle, const char *path_ptr)
 {
     /* Check parameters */
@@ -931,20 +939,20 @@ static int32_t sn_nsdl_internal_coap_send(struct nsdl_s *handle, sn_coap_hdr_s *
         return SN_NSDL_FAILURE;
     }
 
-    coap_message_ptr = handle->sn_nsdl_alloc(coap_message_len);
+    coap_message_ptr = sn_coap_protocol_packet_alloc(handle->grs->coap, coap_message_len);
     if (!coap_message_ptr) {
         return SN_NSDL_MEMORY_ALLOCATION_FAILED;
     }
 
-    /* Build message */
-    int16_t ret = sn_coap_protocol_build(handle->grs->coap, dst_addr_ptr, coap_message_ptr, coap_header_ptr, (void *)handle);
+    /* Build message. Resending list and transport share the buffer instead of copying it */
+    int16_t ret = sn_coap_protocol_build_2(handle->grs->coap, dst_addr_ptr, coap_message_ptr, coap_message_len, coap_header_ptr, (void *)handle);
     if (ret < 0) {
-        handle->sn_nsdl_free(coap_message_ptr);
+        sn_coap_protocol_packet_release(coap_message_ptr);
         return ret;
     }
 
-    handle->sn_nsdl_tx_callback(handle, SN_NSDL_PROTOCOL_COAP, coap_message_ptr, coap_message_len, dst_addr_ptr);
-    handle->sn_nsdl_free(coap_message_ptr);
+    sn_coap_protocol_send_packet(handle->grs->coap, coap_message_ptr, coap_message_len, dst_addr_ptr, (void *)handle);
+    sn_coap_protocol_packet_release(coap_message_ptr);
 
     return coap_header_ptr->msg_id;
 }
@@ -2225,6 +2233,20 @@ int8_t sn_nsdl_remove_msg_from_retransmission(struct nsdl_s *handle, uint8_t *to
 #endif
 }
 
+uint8_t *sn_nsdl_ref_tx_packet(struct nsdl_s *handle, const uint8_t *data_ptr)
+{
+    if (handle == NULL || handle->grs == NULL) {
+        return NULL;
+    }
+
+    return sn_coap_protocol_packet_ref_tx(handle->grs->coap, data_ptr);
+}
+
+void sn_nsdl_release_tx_packet(uint8_t *packet_ptr)
+{
+    sn_coap_protocol_packet_release(packet_ptr);
+}
+
 #ifdef RESOURCE_ATTRIBUTES_LIST
 static void sn_nsdl_free_attribute_value(sn_nsdl_attribute_item_s *attribute)
 {
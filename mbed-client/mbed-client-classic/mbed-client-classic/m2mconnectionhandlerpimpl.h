@@ -112,6 +112,14 @@ public:
                    uint16_t data_len,
                    sn_nsdl_addr_s *address_ptr);
 
+    /**
+    * @brief Queues a shared CoAP packet without copying it.
+    * The packet reference is released once sent, or right away on failure.
+    */
+    bool send_packet(uint8_t *packet_ptr,
+                     uint16_t data_len,
+                     sn_nsdl_addr_s *address_ptr);
+
     /**
     * @brief Listens for incoming data from remote server
     * @return true if successful else false.
@@ -299,13 +307,60 @@ public:
     void interface_event(palNetworkStatus_t status);
 
 private:
+    enum SendResult {
+        ESendIdle,      // nothing was sent, the queue is empty or the socket would block
+        ESendDone,      // at least one packet was sent
+        ESendFailed     // sending failed and the socket was closed
+    };
+
+    /**
+     * Queued outgoing packet. The struct and its data buffer are a single allocation,
+     * data points right after the struct and has room for capacity bytes.
+     * For a shared CoAP packet capacity is 0 and data points to shared_packet.
+     */
     typedef struct send_data_queue {
         uint8_t *data;
+        uint8_t *shared_packet;
         uint16_t offset;
         uint16_t data_len;
+        uint16_t capacity;
         ns_list_link_t link;
     } send_data_queue_s;
 
+    /**
+     * @brief Get a queue item with room for data_len bytes, from the pool if possible.
+     */
+    send_data_queue_s *alloc_send_item(uint16_t data_len);
+
+    /**
+     * @brief Return a sent queue item to the pool or free it.
+     */
+    void free_send_item(send_data_queue_s *data);
+
+    /**
+     * @brief Sends the first packet of the queue. A packet that could not be sent yet is put back.
+     * The observer's data_sent() is called once the packet is sent.
+     */
+    SendResult send_queued_item();
+
+#if MBED_CLIENT_SEND_QUEUE_DRAIN
+    /**
+     * @brief Sends all queued packets of a plain UDP connection with pal_sendToBatch().
+     * The observer's data_sent() is called for each packet sent, as when they are sent one at a time.
+     * Packets left over by a short batch are sent from a new ESocketSend event, the ones left over
+     * because the socket would block are sent from the socket's next event.
+     */
+    SendResult send_queued_batch();
+#endif
+
+#if MBED_CLIENT_RECEIVE_BATCH_SIZE
+    /**
+     * @brief Reads all available datagrams of a plain UDP connection with pal_receiveFromBatch().
+     * @return False if the receive buffers could not be allocated, nothing was read then.
+     */
+    bool receive_batch_handler();
+#endif
+
     /**
      * @brief Get first item from the queue list.
      */
@@ -393,6 +448,14 @@ private:
     // event sender and receiver threads.
     SocketState                                 _socket_state;
     send_data_list_t                            _linked_list_send_data;
+#if MBED_CLIENT_SEND_BUFFER_POOL_SIZE
+    send_data_list_t                            _send_data_pool;
+    uint16_t                                    _send_data_pool_count;
+#endif
+#if MBED_CLIENT_RECEIVE_BATCH_SIZE
+    // MBED_CLIENT_RECEIVE_BATCH_SIZE buffers of BUFFER_LENGTH bytes, allocated on first use
+    uint8_t                                     *_receive_buffers;
+#endif
     bool                                        _secure_connection;
     bool                                        _is_server_ping;
     arm_event_storage_t                         _event;
@@ -23,6 +23,7 @@
 #include "mbed-client/m2mconstants.h"
 #include "mbed-client/m2msecurity.h"
 #include "mbed-client/m2mconnectionhandler.h"
+#include "nsdl-c/sn_nsdl_lib.h"
 #if (PAL_DNS_API_VERSION == 2) || (PAL_DNS_API_VERSION == 3)
 #include "mbed-client/m2mtimer.h"
 #endif
@@ -203,6 +204,13 @@ M2MConnectionHandlerPimpl::M2MConnectionHandlerPimpl(M2MConnectionHandler *base,
     memset(&_ipV4Addr, 0, sizeof(palIpV4Addr_t));
     memset(&_ipV6Addr, 0, sizeof(palIpV6Addr_t));
     ns_list_init(&_linked_list_send_data);
+#if MBED_CLIENT_SEND_BUFFER_POOL_SIZE
+    ns_list_init(&_send_data_pool);
+    _send_data_pool_count = 0;
+#endif
+#if MBED_CLIENT_RECEIVE_BATCH_SIZE
+    _receive_buffers = NULL;
+#endif
 
     eventOS_scheduler_mutex_wait();
     if (M2MConnectionHandlerPimpl::_tasklet_id == -1) {
@@ -230,6 +238,19 @@ M2MConnectionHandlerPimpl::~M2MConnectionHandlerPimpl()
     close_socket();
     delete _security_impl;
     _security_impl = NULL;
+
+#if MBED_CLIENT_SEND_BUFFER_POOL_SIZE
+    while (!ns_list_is_empty(&_send_data_pool)) {
+        send_data_queue_s *data = (send_data_queue_s *)ns_list_get_first(&_send_data_pool);
+        ns_list_remove(&_send_data_pool, data);
+        free(data);
+    }
+#endif
+
+#if MBED_CLIENT_RECEIVE_BATCH_SIZE
+    free(_receive_buffers);
+#endif
+
     pal_destroy();
     tr_debug("~M2MConnectionHandlerPimpl() - OUT");
 }
@@ -625,13 +646,6 @@ bool M2MConnectionHandlerPimpl::send_data(uint8_t *data,
         return false;
     }
 
-    send_data_queue_s *out_data = (send_data_queue_s *)malloc(sizeof(send_data_queue_s));
-    if (!out_data) {
-        return false;
-    }
-
-    memset(out_data, 0, sizeof(send_data_queue_s));
-
     uint8_t offset = 0;
 #ifdef PAL_NET_TCP_AND_TLS_SUPPORT
     if (is_tcp_connection() && !_secure_connection) {
@@ -639,9 +653,12 @@ bool M2MConnectionHandlerPimpl::send_data(uint8_t *data,
     }
 #endif
 
-    out_data->data = (uint8_t *)malloc(data_len + offset);
-    if (!out_data->data) {
-        free(out_data);
+    if (data_len > UINT16_MAX - offset) {
+        return false;
+    }
+
+    send_data_queue_s *out_data = alloc_send_item(data_len + offset);
+    if (!out_data) {
         return false;
     }
 
@@ -668,21 +685,77 @@ bool M2MConnectionHandlerPimpl::send_data(uint8_t *data,
     return true;
 }
 
+bool M2MConnectionHandlerPimpl::send_packet(uint8_t *packet,
+                                            uint16_t data_len,
+                                            sn_nsdl_addr_s *address)
+{
+#ifdef PAL_NET_TCP_AND_TLS_SUPPORT
+    // TCP non-secure needs the length shim in front, so the packet is copied
+    if (is_tcp_connection() && !_secure_connection) {
+        bool success = send_data(packet, data_len, address);
+        sn_nsdl_release_tx_packet(packet);
+        return success;
+    }
+#endif
+
+    if (address == NULL || packet == NULL || !data_len || _socket_state < ESocketStateUnsecureConnection) {
+        tr_warn("M2MConnectionHandlerPimpl::send_packet() - too early");
+        sn_nsdl_release_tx_packet(packet);
+        return false;
+    }
+
+    send_data_queue_s *out_data = (send_data_queue_s *)malloc(sizeof(send_data_queue_s));
+    if (!out_data) {
+        sn_nsdl_release_tx_packet(packet);
+        return false;
+    }
+
+    out_data->data = packet;
+    out_data->shared_packet = packet;
+    out_data->offset = 0;
+    out_data->data_len = data_len;
+    out_data->capacity = 0;
+
+    claim_mutex();
+    ns_list_add_to_end(&_linked_list_send_data, out_data);
+    release_mutex();
+
+    send_event(ESocketSend);
+
+    return true;
+}
+
 void M2MConnectionHandlerPimpl::send_socket_data()
 {
     tr_debug("M2MConnectionHandlerPimpl::send_socket_data()");
+
+#if MBED_CLIENT_SEND_QUEUE_DRAIN
+    if (!is_tcp_connection() && _socket_state == ESocketStateUnsecureConnection) {
+        send_queued_batch();
+    } else {
+        // data_sent() of the previous packet may have closed the socket
+        while (send_queued_item() == ESendDone && _socket_state >= ESocketStateUnsecureConnection) {
+        }
+    }
+#else
+    send_queued_item();
+#endif
+}
+
+M2MConnectionHandlerPimpl::SendResult M2MConnectionHandlerPimpl::send_queued_item()
+{
     int bytes_sent = 0;
     bool success = true;
 
     send_data_queue_s *out_data = get_item_from_list();
     if (!out_data) {
-        return;
+        return ESendIdle;
     }
 
     if (!out_data->data || !out_data->data_len || _socket_state < ESocketStateUnsecureConnection) {
         tr_warn("M2MConnectionHandlerPimpl::send_socket_data() - too early");
         add_item_to_list(out_data);
-        return;
+        return ESendIdle;
     }
 
     // Loop until all the data is sent
@@ -695,7 +768,7 @@ void M2MConnectionHandlerPimpl::send_socket_data()
                 if (bytes_sent == M2MConnectionHandler::CONNECTION_ERROR_WANTS_WRITE) {
                     // Return and wait the next event
                     add_item_to_list(out_data);
-                    return;
+                    return ESendIdle;
                 }
 
                 if (bytes_sent != M2MConnectionHandler::CONNECTION_ERROR_WANTS_READ) {
@@ -730,7 +803,7 @@ void M2MConnectionHandlerPimpl::send_socket_data()
             if (ret == PAL_ERR_SOCKET_WOULD_BLOCK) {
                 // Return and wait next event
                 add_item_to_list(out_data);
-                return;
+                return ESendIdle;
             }
             if (ret < 0) {
                 tr_error("M2MConnectionHandlerPimpl::send_socket_data() - unsecure failed %" PRIx32, ret);
@@ -746,8 +819,7 @@ void M2MConnectionHandlerPimpl::send_socket_data()
         }
     }
 
-    free(out_data->data);
-    free(out_data);
+    free_send_item(out_data);
 
     if (!success) {
         if (bytes_sent == M2MConnectionHandler::SSL_PEER_CLOSE_NOTIFY) {
@@ -760,10 +832,88 @@ void M2MConnectionHandlerPimpl::send_socket_data()
             _observer.socket_error(bytes_sent, true);
         }
         close_socket();
-    } else {
-        _observer.data_sent();
+        return ESendFailed;
+    }
+
+    _observer.data_sent();
+    return ESendDone;
+}
+
+#if MBED_CLIENT_SEND_QUEUE_DRAIN
+M2MConnectionHandlerPimpl::SendResult M2MConnectionHandlerPimpl::send_queued_batch()
+{
+    send_data_queue_s *out_data[MBED_CLIENT_SEND_BATCH_SIZE];
+    palSocketSendBatchItem_t items[MBED_CLIENT_SEND_BATCH_SIZE];
+    SendResult result = ESendIdle;
+
+    for (;;) {
+        uint32_t count = 0;
+        uint32_t items_sent = 0;
+
+        claim_mutex();
+        while (count < MBED_CLIENT_SEND_BATCH_SIZE && !ns_list_is_empty(&_linked_list_send_data)) {
+            send_data_queue_s *data = (send_data_queue_s *)ns_list_get_first(&_linked_list_send_data);
+            ns_list_remove(&_linked_list_send_data, data);
+            out_data[count] = data;
+            items[count].buffer = data->data;
+            items[count].length = data->data_len;
+            count++;
+        }
+        release_mutex();
+
+        if (count == 0) {
+            break;
+        }
+
+        palStatus_t ret = pal_sendToBatch(_socket,
+                                          items,
+                                          count,
+                                          (palSocketAddress_t *)&_socket_address,
+                                          sizeof(_socket_address),
+                                          &items_sent);
+
+        for (uint32_t i = 0; i < items_sent; i++) {
+            free_send_item(out_data[i]);
+        }
+
+        if (items_sent < count) {
+            // Put the rest back in their original order
+            claim_mutex();
+            for (uint32_t i = count; i > items_sent; i--) {
+                ns_list_add_to_start(&_linked_list_send_data, out_data[i - 1]);
+            }
+            release_mutex();
+
+            if (ret < 0 && ret != PAL_ERR_SOCKET_WOULD_BLOCK) {
+                tr_error("M2MConnectionHandlerPimpl::send_queued_batch() - failed %" PRIx32, ret);
+                close_socket();
+                return ESendFailed;
+            }
+
+            // A socket that would block resumes from its writable callback (ESocketCallback).
+            // A short batch without an error gives no such callback, so the send is retried from a new event.
+            if (ret == PAL_SUCCESS) {
+                send_event(ESocketSend);
+            }
+        }
+
+        // The observer is told about each packet, as when they are sent one per event
+        for (uint32_t i = 0; i < items_sent; i++) {
+            _observer.data_sent();
+            result = ESendDone;
+            if (_socket_state != ESocketStateUnsecureConnection) {
+                return result;
+            }
+        }
+
+        if (items_sent < count) {
+            break;
+        }
     }
+
+    return result;
 }
+#endif // MBED_CLIENT_SEND_QUEUE_DRAIN
 
 bool M2MConnectionHandlerPimpl::start_listening_for_data()
 {
@@ -891,6 +1041,11 @@ void M2MConnectionHandlerPimpl::receive_handler()
         } while (rcv_size > 0 && _socket_state == ESocketStateSecureConnection);
 
     } else {
+#if MBED_CLIENT_RECEIVE_BATCH_SIZE
+        if (!is_tcp_connection() && receive_batch_handler()) {
+            return;
+        }
+#endif
         size_t recv;
         palStatus_t status;
         unsigned char recv_buffer[BUFFER_LENGTH];
@@ -938,6 +1093,57 @@ void M2MConnectionHandlerPimpl::receive_handler()
     }
 }
 
+#if MBED_CLIENT_RECEIVE_BATCH_SIZE
+bool M2MConnectionHandlerPimpl::receive_batch_handler()
+{
+    palSocketRecvBatchItem_t items[MBED_CLIENT_RECEIVE_BATCH_SIZE];
+    palStatus_t status;
+    uint32_t items_received;
+    bool zero_length_read;
+
+    if (!_receive_buffers) {
+        _receive_buffers = (uint8_t *)malloc(MBED_CLIENT_RECEIVE_BATCH_SIZE * BUFFER_LENGTH);
+        if (!_receive_buffers) {
+            tr_warn("M2MConnectionHandlerPimpl::receive_batch_handler() - no receive buffers, reading one datagram at a time");
+            return false;
+        }
+    }
+
+    // The observer processes each datagram before returning, so the buffers are reused for the next batch
+    do {
+        for (int i = 0; i < MBED_CLIENT_RECEIVE_BATCH_SIZE; i++) {
+            items[i].buffer = _receive_buffers + (i * BUFFER_LENGTH);
+            items[i].length = BUFFER_LENGTH;
+            items[i].bytesReceived = 0;
+            items[i].from = NULL;
+        }
+
+        status = pal_receiveFromBatch(_socket, items, MBED_CLIENT_RECEIVE_BATCH_SIZE, &items_received);
+        if (status == PAL_ERR_SOCKET_WOULD_BLOCK) {
+            return true;
+        } else if (status != PAL_SUCCESS) {
+            tr_error("M2MConnectionHandlerPimpl::receive_batch_handler() - SOCKET_READ_ERROR %" PRIx32, status);
+            _observer.socket_error(M2MConnectionHandler::SOCKET_READ_ERROR, true);
+            close_socket();
+            return true;
+        }
+
+        tr_debug("M2MConnectionHandlerPimpl::receive_batch_handler() - %" PRIu32 " datagrams received", items_received);
+
+        zero_length_read = (items_received == 0);
+        for (uint32_t i = 0; i < items_received && _socket_state == ESocketStateUnsecureConnection; i++) {
+            _observer.data_available((uint8_t *)items[i].buffer, items[i].bytesReceived, _address);
+            if (items[i].bytesReceived == 0) {
+                zero_length_read = true;
+            }
+        }
+        // keep reading until the socket would block or a read returns no data, as in receive_handler()
+    } while (!zero_length_read && _socket_state == ESocketStateUnsecureConnection);
+
+    return true;
+}
+#endif // MBED_CLIENT_RECEIVE_BATCH_SIZE
+
 void M2MConnectionHandlerPimpl::claim_mutex()
 {
     eventOS_scheduler_mutex_wait();
@@ -1034,20 +1240,80 @@ void M2MConnectionHandlerPimpl::close_socket()
     claim_mutex();
     /*ns_list_foreach_safe(M2MConnectionHandlerPimpl::send_data_queue_s, tmp, &_linked_list_send_data) {
         ns_list_remove(&_linked_list_send_data, tmp);
-        free(tmp->data);
-        free(tmp);
+        free_send_item(tmp);
     }*/
     // Workaround for IAR compilation issue. ns_list_foreach does not compile with IAR.
     // Error[Pe144]: a value of type "void *" cannot be used to initialize an entity of type "M2MConnectionHandlerPimpl::send_data_queue *"
     while (!ns_list_is_empty(&_linked_list_send_data)) {
         send_data_queue_s *data = (send_data_queue_s *)ns_list_get_first(&_linked_list_send_data);
         ns_list_remove(&_linked_list_send_data, data);
-        free(data->data);
-        free(data);
+        free_send_item(data);
     }
     release_mutex();
 }
 
+M2MConnectionHandlerPimpl::send_data_queue_s *M2MConnectionHandlerPimpl::alloc_send_item(uint16_t data_len)
+{
+    send_data_queue_s *data = NULL;
+    uint16_t capacity = data_len;
+
+#if MBED_CLIENT_SEND_BUFFER_POOL_SIZE
+    if (data_len <= MBED_CLIENT_SEND_BUFFER_SIZE) {
+        // Size small packets for the pool, so that they can be reused after sending.
+        capacity = MBED_CLIENT_SEND_BUFFER_SIZE;
+
+        claim_mutex();
+        data = (send_data_queue_s *)ns_list_get_first(&_send_data_pool);
+        if (data) {
+            ns_list_remove(&_send_data_pool, data);
+            _send_data_pool_count--;
+        }
+        release_mutex();
+    }
+#endif
+
+    if (!data) {
+        data = (send_data_queue_s *)malloc(sizeof(send_data_queue_s) + capacity);
+        if (!data) {
+            return NULL;
+        }
+        data->capacity = capacity;
+    }
+
+    data->data = (uint8_t *)(data + 1);
+    data->shared_packet = NULL;
+    data->offset = 0;
+    data->data_len = 0;
+
+    return data;
+}
+
+void M2MConnectionHandlerPimpl::free_send_item(send_data_queue_s *data)
+{
+    if (data->shared_packet) {
+        // Packet reference counts are owned by the CoAP library, touch them only under the scheduler mutex
+        claim_mutex();
+        sn_nsdl_release_tx_packet(data->shared_packet);
+        release_mutex();
+        free(data);
+        return;
+    }
+
+#if MBED_CLIENT_SEND_BUFFER_POOL_SIZE
+    if (data->capacity == MBED_CLIENT_SEND_BUFFER_SIZE) {
+        claim_mutex();
+        if (_send_data_pool_count < MBED_CLIENT_SEND_BUFFER_POOL_SIZE) {
+            ns_list_add_to_start(&_send_data_pool, data);
+            _send_data_pool_count++;
+            data = NULL;
+        }
+        release_mutex();
+    }
+#endif
+
+    free(data);
+}
+
 M2MConnectionHandlerPimpl::send_data_queue_s *M2MConnectionHandlerPimpl::get_item_from_list()
 {
     claim_mutex();
@@ -812,6 +812,25 @@ protected: // from M2MReportObserver
      */
     static bool is_blockwise_needed(const nsdl_s *nsdl, uint32_t payload_len);
 
+    /**
+     * \brief Resolves the part of a GET response payload that goes into the response, for payloads
+     *        that are serialized one block at a time instead of in full. If the payload does not fit
+     *        in one block, sets the Block2 and Size2 options of the response.
+     * \param nsdl An NSDL handler for the CoAP library.
+     * \param received_coap_header The received CoAP message from the server.
+     * \param coap_response The CoAP response to be sent to server.
+     * \param total_size Size of the whole payload.
+     * \param offset Offset of the part to be sent.
+     * \param length Length of the part to be sent.
+     * \return False if the requested block is past the end of the payload or the options can't be allocated.
+     */
+    static bool set_response_block(nsdl_s *nsdl,
+                                   const sn_coap_hdr_s &received_coap_header,
+                                   sn_coap_hdr_s &coap_response,
+                                   uint32_t total_size,
+                                   uint32_t &offset,
+                                   uint32_t &length);
+
     /**
      * \brief Handles subscription request.
      * \param nsdl An NSDL handler for the CoAP library.
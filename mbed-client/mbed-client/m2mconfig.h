@@ -81,6 +81,29 @@ using namespace m2m;
  */
 
 #undef MBED_CLIENT_MEMORY_OPTIMIZED_API
+
+/**
+ * \def SN_GRS_PATH_INDEX
+ *
+ * \brief If enabled, the resource server keeps a hash index of the registered
+ * resource paths so that incoming requests are dispatched without scanning
+ * the whole resource list. Costs one pointer per hash slot.
+ * By default this is disabled.
+ */
+#undef SN_GRS_PATH_INDEX    /* 0 */
+
+/**
+ * \def MBED_CLIENT_RESOURCE_PATH_INDEX
+ *
+ * \brief If enabled, M2MNsdlInterface keeps a hash index from resource path to
+ * M2MBase so that incoming requests find their target object, instance or
+ * resource without walking the object tree. Costs about two pointers per
+ * registered object, instance and resource.
+ * By default this is enabled with MBED_CLOUD_CLIENT_EDGE_EXTENSION and
+ * disabled otherwise.
+ */
+#undef MBED_CLIENT_RESOURCE_PATH_INDEX    /* 0 */
+
 #if defined (__ICCARM__)
 #define m2m_deprecated
 #else
@@ -174,6 +197,46 @@ typedef struct mbedtls_entropy {
 #define MEMORY_OPTIMIZED_API MBED_CONF_MBED_CLIENT_MEMORY_OPTIMIZED_API
 #endif
 
+#ifdef MBED_CONF_MBED_CLIENT_GRS_PATH_INDEX
+#define SN_GRS_PATH_INDEX MBED_CONF_MBED_CLIENT_GRS_PATH_INDEX
+#endif
+
+#ifdef MBED_CONF_MBED_CLIENT_RESOURCE_PATH_INDEX
+#define MBED_CLIENT_RESOURCE_PATH_INDEX MBED_CONF_MBED_CLIENT_RESOURCE_PATH_INDEX
+#endif
+
+#ifdef MBED_CONF_MBED_CLIENT_SEND_BUFFER_POOL_SIZE
+#define MBED_CLIENT_SEND_BUFFER_POOL_SIZE MBED_CONF_MBED_CLIENT_SEND_BUFFER_POOL_SIZE
+#endif
+
+#ifdef MBED_CONF_MBED_CLIENT_SEND_BUFFER_SIZE
+#define MBED_CLIENT_SEND_BUFFER_SIZE MBED_CONF_MBED_CLIENT_SEND_BUFFER_SIZE
+#endif
+
+#ifdef MBED_CONF_MBED_CLIENT_SEND_QUEUE_DRAIN
+#define MBED_CLIENT_SEND_QUEUE_DRAIN MBED_CONF_MBED_CLIENT_SEND_QUEUE_DRAIN
+#endif
+
+#ifdef MBED_CONF_MBED_CLIENT_SEND_BATCH_SIZE
+#define MBED_CLIENT_SEND_BATCH_SIZE MBED_CONF_MBED_CLIENT_SEND_BATCH_SIZE
+#endif
+
+#ifdef MBED_CONF_MBED_CLIENT_RECEIVE_BATCH_SIZE
+#define MBED_CLIENT_RECEIVE_BATCH_SIZE MBED_CONF_MBED_CLIENT_RECEIVE_BATCH_SIZE
+#endif
+
+#ifdef MBED_CONF_MBED_CLIENT_TYPED_VALUE_STORAGE
+#define MBED_CLIENT_TYPED_VALUE_STORAGE MBED_CONF_MBED_CLIENT_TYPED_VALUE_STORAGE
+#endif
+
+#ifdef MBED_CONF_MBED_CLIENT_SENML_CBOR
+#define MBED_CLIENT_SENML_CBOR MBED_CONF_MBED_CLIENT_SENML_CBOR
+#endif
+
+#ifdef MBED_CONF_MBED_CLIENT_NOTIFICATION_COALESCING_WINDOW
+#define MBED_CLIENT_NOTIFICATION_COALESCING_WINDOW MBED_CONF_MBED_CLIENT_NOTIFICATION_COALESCING_WINDOW
+#endif
+
 #ifdef MBED_CONF_MBED_CLIENT_MAX_CERTIFICATE_SIZE
 #define MAX_CERTIFICATE_SIZE MBED_CONF_MBED_CLIENT_MAX_CERTIFICATE_SIZE
 #else
@@ -213,4 +276,64 @@ typedef struct mbedtls_entropy {
 #define MBED_CLIENT_SN_COAP_RESENDING_QUEUE_SIZE_MSGS 5
 #endif
 
+#ifndef SN_GRS_PATH_INDEX
+#define SN_GRS_PATH_INDEX 0
+#endif
+
+#ifndef MBED_CLIENT_RESOURCE_PATH_INDEX
+#ifdef MBED_CLOUD_CLIENT_EDGE_EXTENSION
+#define MBED_CLIENT_RESOURCE_PATH_INDEX 1
+#else
+#define MBED_CLIENT_RESOURCE_PATH_INDEX 0
+#endif
+#endif
+
+// Number of sent packet buffers the connection handler keeps for reuse, 0 frees every buffer after sending.
+#ifndef MBED_CLIENT_SEND_BUFFER_POOL_SIZE
+#define MBED_CLIENT_SEND_BUFFER_POOL_SIZE 0
+#endif
+
+// Size of the pooled send buffers, including the 4 byte length header of non-secure TCP.
+// Larger packets get a buffer of their own, which is freed after sending.
+#ifndef MBED_CLIENT_SEND_BUFFER_SIZE
+#define MBED_CLIENT_SEND_BUFFER_SIZE 1152
+#endif
+
+// Send every queued packet in one send event instead of one packet per event.
+// Plain UDP packets are then passed to pal_sendToBatch() up to MBED_CLIENT_SEND_BATCH_SIZE at a time.
+#ifndef MBED_CLIENT_SEND_QUEUE_DRAIN
+#define MBED_CLIENT_SEND_QUEUE_DRAIN 0
+#endif
+
+#ifndef MBED_CLIENT_SEND_BATCH_SIZE
+#define MBED_CLIENT_SEND_BATCH_SIZE 16
+#endif
+
+// Number of datagrams a plain UDP connection reads with one pal_receiveFromBatch() call, 0 reads one
+// datagram at a time into a stack buffer. The receive buffers are allocated once and reused.
+#ifndef MBED_CLIENT_RECEIVE_BATCH_SIZE
+#define MBED_CLIENT_RECEIVE_BATCH_SIZE 0
+#endif
+
+// Keep INTEGER, BOOLEAN, TIME and FLOAT resource values in binary form. The text form is
+// rendered only when it is read, instead of on every set_value() and parsed on every get_value_int().
+// Costs 16 bytes per resource.
+#ifndef MBED_CLIENT_TYPED_VALUE_STORAGE
+#define MBED_CLIENT_TYPED_VALUE_STORAGE 0
+#endif
+
+// Support SenML-CBOR (LwM2M 1.1, content format 112) in addition to OMA-TLV for reads,
+// writes and notifications of objects, object instances and resources, and for bootstrap
+// writes. Notifications carry the system time as base time once it is set. Uses tinycbor.
+#ifndef MBED_CLIENT_SENML_CBOR
+#define MBED_CLIENT_SENML_CBOR 0
+#endif
+
+// Time in milliseconds for which a notification is held back after the first value change, so that
+// all the changes of an observed object, object instance or resource within the window are sent in
+// one notification. Applies only when pmin allows sending right away. 0 sends every change at once.
+#ifndef MBED_CLIENT_NOTIFICATION_COALESCING_WINDOW
+#define MBED_CLIENT_NOTIFICATION_COALESCING_WINDOW 0
+#endif
+
 #endif // M2MCONFIG_H
@@ -113,6 +113,18 @@ public:
                    uint16_t data_len,
                    sn_nsdl_addr_s *address_ptr);
 
+    /**
+    * \brief Sends a shared CoAP packet to the connected server without copying it.
+    * \param packet_ptr The packet, referenced with sn_nsdl_ref_tx_packet().
+    * \param data_len The length of the packet.
+    * \param address_ptr The address structure to which the data needs to be sent.
+    * \return True if data is queued successfully, else false.
+    * \note The reference is released by the handler, also if sending fails.
+    */
+    bool send_packet(uint8_t *packet_ptr,
+                     uint16_t data_len,
+                     sn_nsdl_addr_s *address_ptr);
+
     /**
     * \brief Listens to the incoming data from a remote server.
     * \return True if successful, else false.
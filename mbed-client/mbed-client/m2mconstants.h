@@ -240,5 +240,6 @@ const uint8_t COAP_CONTENT_OMA_TLV_TYPE_OLD = 99;
 const uint16_t COAP_CONTENT_OMA_TLV_TYPE = 11542;
 const uint16_t COAP_CONTENT_OMA_JSON_TYPE = 11543;
 const uint8_t COAP_CONTENT_OMA_OPAQUE_TYPE = 42;
+const uint8_t COAP_CONTENT_OMA_SENML_CBOR_TYPE = 112;
 
 #endif // M2MCONSTANTS_H
@@ -491,6 +491,25 @@ private:
 
     M2MResourceBase::ResourceType convert_data_type(M2MBase::DataType type) const;
 
+#if MBED_CLIENT_TYPED_VALUE_STORAGE
+    /**
+     * \brief Checks whether a value set with set_value(int64_t) or set_value_float()
+     * can be kept in binary form only.
+     * \param float_value True for set_value_float().
+     */
+    bool can_store_typed_value(bool float_value) const;
+
+    /**
+     * \brief Marks the binary value as the current one and reports it if it has changed.
+     */
+    void update_typed_value(bool changed);
+
+    /**
+     * \brief Renders the text form of a binary value into the nsdl resource, if it is outdated.
+     */
+    void render_typed_value() const;
+#endif
+
     void read_data_from_application(M2MCallbackAssociation *item, nsdl_s *nsdl, const sn_coap_hdr_s *received_coap,
                                     sn_coap_hdr_s *coap_response, size_t &payload_len);
 
@@ -500,6 +519,24 @@ private:
     M2MBlockMessage     *_block_message_data;
 #endif
 
+#if MBED_CLIENT_TYPED_VALUE_STORAGE
+    /**
+     * Binary copy of an INTEGER, BOOLEAN, TIME or FLOAT value. If text_stale is set, the value
+     * was set in binary form and the text in the nsdl resource is rendered when it is read.
+     */
+    struct typed_value_s {
+        typed_value_s() : int_value(0), valid(false), text_stale(false) {}
+        union {
+            int64_t int_value;
+            float   float_value;
+        };
+        bool valid;
+        bool text_stale;
+    };
+
+    mutable typed_value_s   _typed_value;
+#endif
+
     friend class Test_M2MResourceInstance;
     friend class Test_M2MResource;
     friend class Test_M2MObjectInstance;
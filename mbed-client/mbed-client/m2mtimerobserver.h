@@ -40,6 +40,7 @@ public:
         RegistrationFlowTimer,
         StaggerWaitTimer,
         DnsQueryFallback,
+        NotificationCoalescing,
         TypeNotUsed // Last item. Add new types above this!
     }Type;
 
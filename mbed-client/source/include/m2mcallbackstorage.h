@@ -16,14 +16,12 @@
 #ifndef __M2M_CALLBACK_STORAGE_H__
 #define __M2M_CALLBACK_STORAGE_H__
 
-#include "mbed-client/m2mvector.h"
+#include <stdint.h>
 
 class M2MBase;
 class M2MCallbackAssociation;
 class M2MCallbackStorage;
 
-typedef m2m::Vector<M2MCallbackAssociation> M2MCallbackAssociationList;
-
 // XXX: this should not be visible for client code
 class M2MCallbackAssociation {
 public:
@@ -92,7 +90,10 @@ public:
     M2MCallbackAssociation(const M2MBase *object, void *callback, M2MCallbackType type, void *client_args);
 
 public:
-    /** Object, where the callback is associated to. This is used as key on searches, must not be null. */
+    /**
+     * Object, where the callback is associated to. This is used as key on searches, must not be null
+     * for a stored association. A null object marks a free slot in the storage table.
+     */
     const M2MBase *_object;
 
     /**
@@ -115,6 +116,8 @@ public:
 class M2MCallbackStorage {
 public:
 
+    M2MCallbackStorage();
+
     ~M2MCallbackStorage();
 
     // get the shared instance of the storage.
@@ -147,9 +150,11 @@ public:
 
     static void *get_callback(const M2MBase &object, M2MCallbackAssociation::M2MCallbackType type);
 
+    // The returned item is valid until the next add_callback() or remove_callback() call.
     static M2MCallbackAssociation *get_association_item(const M2MBase &object, M2MCallbackAssociation::M2MCallbackType type);
-    // XXX: this is actually not needed unless the client has multiple callbacks per object and type.
-    inline const M2MCallbackAssociationList &get_callbacks() const;
+
+    // number of stored callbacks
+    inline uint32_t get_callback_count() const;
 
 private:
     bool does_callback_exist(const M2MBase &object, void *callback, M2MCallbackAssociation::M2MCallbackType type) const;
@@ -160,6 +165,12 @@ private:
 
     M2MCallbackAssociation *do_get_association_item(const M2MBase &object, M2MCallbackAssociation::M2MCallbackType type) const;
 
+    void grow_table();
+    void insert_association(const M2MCallbackAssociation &association);
+    void remove_slot(uint32_t index);
+
+    static uint32_t slot_index(const M2MBase *object, M2MCallbackAssociation::M2MCallbackType type, uint32_t mask);
+
 private:
 
     /**
@@ -169,18 +180,24 @@ private:
     static M2MCallbackStorage *_static_instance;
 
     /**
-     * Callback objects stored. There combination of <object>+<type> is used on searches and
-     * the code does not fully support for adding multiple callbacks for <object>+<type> -pair.
-     * But that should not be too hard if the feature was added to M2M object API too, it just
-     * requires the M2M objects to iterate through the callbacks associated to it, not just call
-     * the get_callback(<object>,<type>) and call the first one.
+     * Callback objects stored in an open addressed hash table keyed by the <object>+<type> -pair,
+     * so a lookup costs the same regardless of how many callbacks the client has registered.
+     * Collisions are resolved with linear probing and removal shifts the following entries back,
+     * so no tombstones are needed. There can be only one callback per <object>+<type> -pair,
+     * the M2M objects always remove the old callback before setting a new one.
      */
-    M2MCallbackAssociationList _callbacks;
+    M2MCallbackAssociation *_callbacks;
+
+    /** Size of the _callbacks table, zero or a power of two. */
+    uint32_t _capacity;
+
+    /** Number of used slots in the _callbacks table. */
+    uint32_t _count;
 };
 
-inline const M2MCallbackAssociationList &M2MCallbackStorage::get_callbacks() const
+inline uint32_t M2MCallbackStorage::get_callback_count() const
 {
-    return _callbacks;
+    return _count;
 }
 
 #endif // !__M2M_CALLBACK_STORAGE_H__
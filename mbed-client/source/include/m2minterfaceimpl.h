@@ -347,6 +347,10 @@ protected: // From M2MNsdlObserver
                                     uint16_t data_len,
                                     sn_nsdl_addr_s *address_ptr);
 
+    virtual void coap_packet_ready(uint8_t *packet_ptr,
+                                   uint16_t data_len,
+                                   sn_nsdl_addr_s *address_ptr);
+
     virtual void client_registered(M2MServer *server_object);
 
     virtual void registration_updated(const M2MServer &server_object);
@@ -583,6 +587,11 @@ private: // state machine state functions
 
     void update_network_latency_configurations_with_rtt();
 
+    /**
+     * Helper method for handling a failure to queue CoAP data for sending.
+     */
+    void coap_send_failed();
+
     /**
      * @brief Callback function which is called when POST comes to resource 1/0/4. Triggers de-registration.
      * @param argument, Pointer to M2MResource::M2MExecuteParameter.
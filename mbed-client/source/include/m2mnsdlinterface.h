@@ -585,6 +585,47 @@ private:
                            const String &object_name,
                            const String &resource_instance) const;
 
+#if MBED_CLIENT_RESOURCE_PATH_INDEX
+    /**
+     * @brief Adds base to the path index, if it is not there yet.
+     * @param base Object, object instance, resource or resource instance.
+     */
+    void path_index_add(M2MBase *base);
+
+    /**
+     * @brief Removes base from the path index.
+     * @param base Base to be removed.
+     */
+    void path_index_remove(const M2MBase *base);
+
+    /**
+     * @brief Removes base and everything under it from the path index.
+     * @param base Root of the tree to be removed.
+     */
+    void path_index_remove_tree(const M2MBase *base);
+
+    /**
+     * @brief Looks up the path index.
+     * @param path Path to search.
+     * @return Base with the given path, NULL if not indexed.
+     */
+    M2MBase *path_index_find(const char *path) const;
+
+    /**
+     * @brief Reallocates the path index and re-inserts all the entries.
+     * @param size New slot count, power of two.
+     * @return true if successful, false if allocation failed and the old index is kept.
+     */
+    bool path_index_resize(uint32_t size);
+#endif
+
+    /**
+     * @brief Drops the queued and in progress notifications of base and everything under it,
+     * so that the pending notification queue doesn't hold handlers of a removed object.
+     * @param base Root of the tree.
+     */
+    static void cancel_pending_notifications(const M2MBase *base);
+
     bool object_present(M2MBase *base) const;
 
     int object_index(M2MBase *base) const;
@@ -640,6 +681,15 @@ private:
     */
     bool parse_bootstrap_message(sn_coap_hdr_s *coap_header, M2MNsdlInterface::ObjectType lwm2m_object_type);
 
+#if MBED_CLIENT_SENML_CBOR
+    /**
+     * @brief Parse bootstrap SenML-CBOR message.
+     * @param coap_header, Received CoAP message
+     * @return True if parsing was succesful else false
+    */
+    bool parse_bootstrap_senml_cbor_message(sn_coap_hdr_s *coap_header, M2MNsdlInterface::ObjectType lwm2m_object_type);
+#endif
+
     /**
      * @brief Handle bootstrap errors.
      * @param error, M2MInterface error code for the failure.
@@ -725,6 +775,12 @@ private:
 
     void send_coap_ping();
 
+    /**
+     * @brief Starts the NSDL execution timer for the next CoAP retransmission,
+     * timeout or CoAP ping, stops it if none is pending.
+     */
+    void schedule_nsdl_execution();
+
     void send_empty_ack(const sn_coap_hdr_s *header, sn_nsdl_addr_s *address);
 
     struct M2MNsdlInterface::nsdl_coap_data_s *create_coap_event_data(sn_coap_hdr_s *received_coap_header,
@@ -793,7 +849,6 @@ private:
     M2MConnectionHandler                    &_connection_handler;
     String                                  _endpoint_name;
     String                                  _internal_endpoint_name;
-    uint32_t                                _counter_for_nsdl;
     uint32_t                                _next_coap_ping_send_time;
     char                                    *_server_address; // BS or M2M address
     request_context_list_t                  _request_context_list;
@@ -816,6 +871,11 @@ private:
     bool                                    _alert_mode;
     NotificationQueueOption                 _last_notif_queue_event;
     sn_coap_msg_code_e                      _current_request_code;
+#if MBED_CLIENT_RESOURCE_PATH_INDEX
+    M2MBase                                 **_path_index; // Open addressing hash table keyed on uri_path()
+    uint32_t                                _path_index_size;
+    uint32_t                                _path_index_count;
+#endif
 
     friend class Test_M2MNsdlInterface;
 
@@ -42,6 +42,23 @@ public :
                                     uint16_t data_len,
                                     sn_nsdl_addr_s *address_ptr) = 0;
 
+    /**
+    * @brief Informs that coap message is ready in a shared packet buffer.
+    * By default the packet is handed to coap_message_ready() and released,
+    * so observers that can't queue a shared packet don't have to implement this.
+    * @param packet_ptr, Packet referenced with sn_nsdl_ref_tx_packet(),
+    * the observer must release the reference.
+    * @param data_len, Length of the packet.
+    * @param address_ptr, Address structure of the server.
+    */
+    virtual void coap_packet_ready(uint8_t *packet_ptr,
+                                   uint16_t data_len,
+                                   sn_nsdl_addr_s *address_ptr)
+    {
+        coap_message_ready(packet_ptr, data_len, address_ptr);
+        sn_nsdl_release_tx_packet(packet_ptr);
+    }
+
     /**
     * @brief Informs that client is registered successfully.
     * @param server_object, Server object associated with
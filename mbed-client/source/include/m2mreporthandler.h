@@ -20,7 +20,8 @@
 #include <stdint.h>
 #include "mbed-client/m2mconfig.h"
 #include "mbed-client/m2mbase.h"
-#if defined (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS) && (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS == 1)
+#if (defined (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS) && (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS == 1)) || \
+    (MBED_CLIENT_NOTIFICATION_COALESCING_WINDOW > 0)
 #include "mbed-client/m2mtimerobserver.h"
 #endif
 #include "mbed-client/m2mresourceinstance.h"
@@ -58,7 +59,8 @@ typedef union low_step_u {
  *  This class is handles all the observation related operations.
  */
 class M2MReportHandler
-#if defined (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS) && (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS == 1)
+#if (defined (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS) && (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS == 1)) || \
+    (MBED_CLIENT_NOTIFICATION_COALESCING_WINDOW > 0)
     : public M2MTimerObserver
 #endif
 {
@@ -66,6 +68,9 @@ private:
     // Prevents the use of assignment operator by accident.
     M2MReportHandler &operator=(const M2MReportHandler & /*other*/);
 
+    // Prevents copying by accident, handler is linked to the pending notification queue.
+    M2MReportHandler(const M2MReportHandler & /*other*/);
+
 public:
 
     M2MReportHandler(M2MReportObserver &observer, M2MBase::DataType type);
@@ -201,7 +206,9 @@ public:
     /**
      * @brief Schedule a report, if the pmin is exceeded
      * report immediately, otherwise store the state to be
-     * reported once the time fires.
+     * reported once the time fires. With a coalescing window
+     * configured, an immediate report is sent when the window
+     * ends, together with all the changes made during it.
      *
      * @param in_queue If the message is queued message then it must be send even if
      * current and last values are the same.
@@ -271,6 +278,38 @@ public:
      */
     bool is_confirmable() const;
 
+    /**
+     * @brief Returns the first report handler which has a notification queued or in progress.
+     * Handlers are kept in the order in which their notification became pending.
+     * The queue is relinked under the event scheduler mutex, so walk it with that mutex held.
+     *
+     * @return First pending report handler, NULL if there is none.
+     */
+    static M2MReportHandler *first_pending_notification();
+
+    /**
+     * @brief Returns the report handler following this one in the pending notification queue.
+     *
+     * @return Next pending report handler, NULL if this is the last one or not in the queue.
+     */
+    M2MReportHandler *next_pending_notification() const;
+
+    /**
+     * @brief Returns the first pending report handler whose notification can be sent now,
+     * skipping the ones which are not observed or still have a coalescing window open.
+     * Walk it with the event scheduler mutex held, as first_pending_notification().
+     *
+     * @return Report handler to send next, NULL if there is none.
+     */
+    static M2MReportHandler *first_notification_to_send();
+
+    /**
+     * @brief Returns whether a coalescing window is open. Its notification is sent when the window closes.
+     *
+     * @return True if changes are being coalesced, always false when the window is not configured.
+     */
+    bool notification_coalescing() const;
+
 #if defined (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS) && (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS == 1)
     /**
      * @brief Start the pmin and pmax timers without setting object under observation
@@ -281,7 +320,10 @@ public:
     * @brief Stop pmin & pmax timers.
     */
     void stop_timers();
+#endif
 
+#if (defined (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS) && (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS == 1)) || \
+    (MBED_CLIENT_NOTIFICATION_COALESCING_WINDOW > 0)
 protected : // from M2MTimerObserver
 
     virtual void timer_expired(M2MTimerObserver::Type type =
@@ -337,6 +379,12 @@ private:
     */
     static uint8_t *alloc_copy(const uint8_t *source, uint32_t size);
 
+    /**
+     * \brief Adds or removes this handler from the pending notification queue
+     * depending on the notification in queue and send in progress flags.
+    */
+    void update_pending_notification();
+
     /**
      * \brief New value is ready to be sent.
     */
@@ -384,6 +432,14 @@ private:
     bool                        _waiting_to_report;
     bool                        _confirmable;
     M2MResourceBase             *_resource_base;
+#if MBED_CLIENT_NOTIFICATION_COALESCING_WINDOW > 0
+    M2MTimer                    _coalescing_timer;
+    bool                        _coalescing;
+#endif
+    M2MReportHandler            *_pending_next;
+    M2MReportHandler            *_pending_prev;
+    static M2MReportHandler     *_pending_head;
+    static M2MReportHandler     *_pending_tail;
     friend class Test_M2MReportHandler;
     friend class Test_M2MResourceInstance;
 };
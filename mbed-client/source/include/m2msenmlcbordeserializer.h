@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2020 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef M2M_SENML_CBOR_DESERIALIZER_H
+#define M2M_SENML_CBOR_DESERIALIZER_H
+
+#include "include/m2msenmlcborserializer.h"
+
+#if MBED_CLIENT_SENML_CBOR
+
+#include "include/m2mtlvdeserializer.h"
+
+/**
+ * @brief M2MSenMLCBORDeserializer
+ * Applies a SenML-CBOR (content format 112) write request to resources and
+ * resource instances. Record names are resolved against the base name as in
+ * RFC 8428 chapter 4.5 and must point inside the targeted object, object
+ * instance or resource. The whole payload is validated before any value is
+ * changed. As with OMA-TLV, a Put updates existing resources only and a Post
+ * also creates the resources and resource instances that are missing, typed
+ * after the value of their record. Errors are reported with the same codes as
+ * the OMA-TLV deserializer, so the request handlers can map them the same way.
+ */
+class M2MSenMLCBORDeserializer {
+
+public:
+
+    /**
+     * Writes the records of the payload into existing instances of the object,
+     * as for a bootstrap write to "/0" or "POST /3303" after creating the instance.
+     */
+    static M2MTLVDeserializer::Error deserialize_object_instances(const uint8_t *cbor,
+                                                                  uint32_t cbor_size,
+                                                                  M2MObject &object,
+                                                                  M2MTLVDeserializer::Operation operation);
+
+    /**
+     * Writes the records of the payload into the resources of the object instance,
+     * as for "PUT /3/0" or "POST /3/0".
+     */
+    static M2MTLVDeserializer::Error deserialize_resources(const uint8_t *cbor,
+                                                           uint32_t cbor_size,
+                                                           M2MObjectInstance &object_instance,
+                                                           M2MTLVDeserializer::Operation operation);
+
+    /**
+     * Writes the records of the payload into a resource or its instances,
+     * as for "PUT /3/0/1" or "PUT /3/0/7".
+     */
+    static M2MTLVDeserializer::Error deserialize_resource(const uint8_t *cbor,
+                                                          uint32_t cbor_size,
+                                                          M2MResource &resource);
+
+    /**
+     * Reads the id below the target from the name of the first record: the object instance id
+     * for an object, the resource id for an object instance.
+     * @return False if the payload or the name is not valid.
+     */
+    static bool instance_id(const uint8_t *cbor, uint32_t cbor_size, const M2MBase &target, uint16_t &id);
+
+private:
+
+    static M2MTLVDeserializer::Error deserialize(const uint8_t *cbor,
+                                                 uint32_t cbor_size,
+                                                 M2MBase &target,
+                                                 M2MTLVDeserializer::Operation operation,
+                                                 bool update_value);
+
+    static bool enter_records(const uint8_t *cbor, uint32_t cbor_size, CborParser &parser, CborValue &array, CborValue &record);
+
+    static bool read_record(CborValue &record, char *base_name, char *full_name, CborValue &value, int &value_label);
+
+    static const char *relative_name(const M2MBase &target, const char *name);
+
+    static bool read_id(const char *&name, uint16_t &id);
+
+    static M2MResourceBase *find_resource(M2MBase &target, const char *name, int value_label, const CborValue &value,
+                                          M2MTLVDeserializer::Operation operation, bool update_value,
+                                          M2MTLVDeserializer::Error &error);
+
+    static M2MResourceBase::ResourceType value_type(const CborValue &value, int value_label);
+
+    static M2MTLVDeserializer::Error set_value(M2MResourceBase &resource, const CborValue &value,
+                                               int value_label, bool update_value);
+
+    static bool read_float(const CborValue &value, float &result);
+};
+
+#endif // MBED_CLIENT_SENML_CBOR
+
+#endif // M2M_SENML_CBOR_DESERIALIZER_H
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2020 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef M2M_SENML_CBOR_SERIALIZER_H
+#define M2M_SENML_CBOR_SERIALIZER_H
+
+#include "mbed-client/m2mconfig.h"
+
+#if MBED_CLIENT_SENML_CBOR
+
+#include "mbed-client/m2mvector.h"
+#include "mbed-client/m2mobject.h"
+#include "mbed-client/m2mobjectinstance.h"
+#include "mbed-client/m2mresource.h"
+
+#include "tinycbor.h"
+
+/* SenML labels, see RFC 8428 chapter 6 */
+#define SENML_BASE_NAME     -2
+#define SENML_BASE_TIME     -3
+#define SENML_NAME          0
+#define SENML_VALUE         2
+#define SENML_STRING_VALUE  3
+#define SENML_BOOLEAN_VALUE 4
+#define SENML_TIME          6
+#define SENML_DATA_VALUE    8
+
+/* LwM2M 1.1 extension label for Objlnk values */
+#define SENML_OBJLNK_VALUE  "vlo"
+
+/**
+ * @brief M2MSenMLCBORSerializer
+ * Constructs the SenML-CBOR representation (RFC 8428, content format 112)
+ * of objects, object instances and resources as specified in OMA-LWM2M 1.1,
+ * chapter 7.4.5. One record is generated for every readable resource and
+ * resource instance. The path of the requested entity is written as base
+ * name of the first record only, the records carry just the path relative
+ * to it. When an object has instances with enough records, every instance
+ * starts with its own path as base name instead, so that its records carry
+ * just the resource ids. A base time, when given, is written into the first
+ * record and applies to all the records.
+ */
+class M2MSenMLCBORSerializer {
+
+public:
+
+    /**
+     * Serialises the given object instances of an object, for example as
+     * response to "GET /3" or as notification of changed instances. Names
+     * of the records are relative to "/<object>/".
+     * @param object Object owning the instances.
+     * @param object_instance_list Instances to serialise.
+     * @param size Size of the generated payload.
+     * @param base_time Time the values were read, in seconds since the epoch. 0 to leave out the base time.
+     * @return Payload allocated with malloc, or NULL if there is nothing to serialise.
+     */
+    static uint8_t *serialize(const M2MObject &object, const M2MObjectInstanceList &object_instance_list, uint32_t &size,
+                              uint64_t base_time = 0);
+
+    /**
+     * Serialises all the resources of an object instance, as response to "GET /3/0".
+     * Names of the records are relative to "/<object>/<instance>/".
+     */
+    static uint8_t *serialize(const M2MObjectInstance &object_instance, uint32_t &size, uint64_t base_time = 0);
+
+    /**
+     * Serialises a resource with all its instances, or a single resource instance.
+     */
+    static uint8_t *serialize(const M2MResourceBase &resource, uint32_t &size, uint64_t base_time = 0);
+
+private:
+
+    /**
+     * Base fields still to be written, they go into the next record.
+     */
+    struct BaseFields {
+        const char *name;
+        uint64_t time;
+    };
+
+    static uint8_t *serialize(const M2MBase &base, const M2MObjectInstanceList *object_instance_list, uint32_t &size,
+                              uint64_t base_time);
+
+    static uint32_t record_count(const M2MBase &base, const M2MObjectInstanceList *object_instance_list);
+
+    static uint32_t record_count(const M2MResourceList &resource_list);
+
+    static uint32_t record_count(const M2MResource &resource);
+
+    static bool use_instance_base_names(const M2MObjectInstanceList &object_instance_list, size_t object_base_name_length);
+
+    static bool write_records(const M2MBase &base, const M2MObjectInstanceList *object_instance_list,
+                              uint64_t base_time, CborEncoder &encoder);
+
+    static bool write_records(const M2MObjectInstanceList &object_instance_list, const char *object_base_name,
+                              BaseFields &base, CborEncoder &encoder);
+
+    static bool write_records(const M2MResourceList &resource_list, const char *prefix,
+                              BaseFields &base, CborEncoder &encoder);
+
+    static bool write_records(const M2MResource &resource, const char *prefix,
+                              BaseFields &base, CborEncoder &encoder);
+
+    static bool write_record(const M2MResourceBase &resource, const char *name,
+                             BaseFields &base, CborEncoder &encoder);
+};
+
+#endif // MBED_CLIENT_SENML_CBOR
+
+#endif // M2M_SENML_CBOR_SERIALIZER_H
@@ -13,6 +13,9 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#ifndef M2M_TLV_DESERIALIZER_H
+#define M2M_TLV_DESERIALIZER_H
+
 #include "mbed-client/m2mvector.h"
 #include "mbed-client/m2mobject.h"
 #include "mbed-client/m2mobjectinstance.h"
@@ -199,3 +202,5 @@ public:
 
     friend class Test_M2MTLVDeserializer;
 };
+
+#endif // M2M_TLV_DESERIALIZER_H
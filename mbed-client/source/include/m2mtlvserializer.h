@@ -76,29 +76,80 @@ public:
 
     static uint8_t* serialize(const M2MResource *resource, uint32_t &size);
 
+    /**
+     * Serialises only the bytes [offset, offset + buffer_size) of the OMA-TLV
+     * generated for the given object instances into a caller provided buffer.
+     * The whole TLV is never built, so a large payload can be streamed one
+     * CoAP block at a time. Pass a zero buffer_size to get only the total size.
+     * @param total_size Size of the whole OMA-TLV, zero if there is nothing to serialise.
+     * @return Number of bytes written into the buffer.
+     */
+    static uint32_t serialize(const M2MObjectInstanceList &object_instance_list, uint32_t offset,
+                              uint8_t *buffer, uint32_t buffer_size, uint32_t &total_size);
+
+    /**
+     * Serialises the given part of the OMA-TLV of given resources.
+     * @see serialize(const M2MObjectInstanceList &, uint32_t, uint8_t *, uint32_t, uint32_t &)
+     */
+    static uint32_t serialize(const M2MResourceList &resource_list, uint32_t offset,
+                              uint8_t *buffer, uint32_t buffer_size, uint32_t &total_size);
+
+    /**
+     * Serialises the given part of the OMA-TLV of a resource.
+     * @see serialize(const M2MObjectInstanceList &, uint32_t, uint8_t *, uint32_t, uint32_t &)
+     */
+    static uint32_t serialize(const M2MResource *resource, uint32_t offset,
+                              uint8_t *buffer, uint32_t buffer_size, uint32_t &total_size);
+
 private :
 
-    static uint8_t* serialize_object_instances(const M2MObjectInstanceList &object_instance_list, uint32_t &size);
+    /**
+     * Output of one encoding pass. The encoder walks through the whole TLV,
+     * but only the bytes falling into the window [offset, offset + buffer_size)
+     * are copied into the buffer, the rest are just counted in position.
+     */
+    struct tlv_writer_s {
+        uint8_t     *buffer;
+        uint32_t    offset;
+        uint32_t    buffer_size;
+        uint32_t    position;
+    };
 
-    static uint8_t* serialize_resources(const M2MResourceList &resource_list, uint32_t &size, bool &valid);
+    static uint32_t written_length(const tlv_writer_s &writer, uint32_t total_size);
 
-    static bool serialize(uint16_t id, const M2MObjectInstance *object_instance, uint8_t *&data, uint32_t &size);
-    
-    static bool serialize(const M2MResource *resource, uint8_t *&data, uint32_t &size);
+    static bool is_valid(const M2MResourceList &resource_list);
 
-    static bool serialize_resource(const M2MResource *resource, uint8_t *&data, uint32_t &size);
+    static bool is_readable(const M2MBase *base);
 
-    static bool serialize_multiple_resource(const M2MResource *resource, uint8_t *&data, uint32_t &size);
+    static uint32_t object_instances_size(const M2MObjectInstanceList &object_instance_list);
 
-    static bool serialize_resource_instance(uint16_t id, const M2MResourceInstance *resource, uint8_t *&data, uint32_t &size);
-    
-    static bool serialize_TILV (uint8_t type, uint16_t id, uint8_t *value, uint32_t value_length, uint8_t *&data, uint32_t &size);
+    static uint32_t resources_size(const M2MResourceList &resource_list);
 
-    static void serialize_id(uint16_t id, uint32_t &size, uint8_t *id_ptr);
+    static uint32_t resource_size(const M2MResource *resource);
 
-    static void serialize_length(uint32_t length, uint32_t &size, uint8_t *length_ptr);
+    static uint32_t resource_instances_size(const M2MResourceInstanceList &instance_list);
 
-    static bool serialize_TLV_binary_int(const M2MResourceBase *resource, uint8_t type, uint16_t id, uint8_t *&data, uint32_t &size);
+    static uint32_t value_length(const M2MResourceBase *resource);
 
-    static bool serialize_TLV_binary_float(const M2MResourceBase *resource, uint8_t type, uint16_t id, uint8_t *&data, uint32_t &size);
+    static uint32_t tlv_size(uint16_t id, uint32_t value_length);
+
+    static void write_object_instances(const M2MObjectInstanceList &object_instance_list, tlv_writer_s &writer);
+
+    static void write_resources(const M2MResourceList &resource_list, tlv_writer_s &writer);
+
+    static void write_resource(const M2MResource *resource, tlv_writer_s &writer);
+
+    static void write_resource_instances(const M2MResourceInstanceList &instance_list, tlv_writer_s &writer);
+
+    static void write_value(const M2MResourceBase *resource, uint8_t type, uint16_t id, tlv_writer_s &writer);
+
+    static bool is_window_full(const tlv_writer_s &writer);
+
+    static bool write_header(uint8_t type, uint16_t id, uint32_t value_length, tlv_writer_s &writer);
+
+    static void write_bytes(const uint8_t *data, uint32_t length, tlv_writer_s &writer);
+
+    static void serialize_id(uint16_t id, uint32_t &size, uint8_t *id_ptr);
+
+    static void serialize_length(uint32_t length, uint32_t &size, uint8_t *length_ptr);
 };
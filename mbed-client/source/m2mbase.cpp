@@ -1020,6 +1020,54 @@ bool M2MBase::is_blockwise_needed(const nsdl_s *nsdl, uint32_t payload_len)
         return false;
     }
 }
+
+bool M2MBase::set_response_block(nsdl_s *nsdl,
+                                 const sn_coap_hdr_s &received_coap_header,
+                                 sn_coap_hdr_s &coap_response,
+                                 uint32_t total_size,
+                                 uint32_t &offset,
+                                 uint32_t &length)
+{
+    uint32_t block_number = 0;
+    uint16_t block_size = sn_nsdl_get_block_size(nsdl);
+
+    if (received_coap_header.options_list_ptr && received_coap_header.options_list_ptr->block2 != -1) {
+        uint8_t block_temp = received_coap_header.options_list_ptr->block2 & 0x07;
+        /* Resolve block parameters */
+        block_size = 1u << (block_temp + 4);
+        block_number = received_coap_header.options_list_ptr->block2 >> 4;
+    }
+
+    offset = 0;
+    length = total_size;
+    if (total_size <= block_size || block_size == 0) {
+        return block_number == 0;
+    }
+
+    offset = block_number * block_size;
+    if (offset >= total_size) {
+        tr_error("M2MBase::set_response_block() - requested block past the end of payload");
+        return false;
+    }
+    length = total_size - offset;
+    if (length > block_size) {
+        length = block_size;
+    }
+
+    if (!sn_nsdl_alloc_options_list(nsdl, &coap_response)) {
+        tr_error("M2MBase::set_response_block() - failed to allocate coap options");
+        return false;
+    }
+    coap_response.options_list_ptr->use_size2 = true;
+    coap_response.options_list_ptr->size2 = total_size;
+    coap_response.options_list_ptr->block2 = (block_number << 4) | sn_coap_convert_block_size(block_size);
+    // Set more bit into response
+    if (offset + length < total_size) {
+        coap_response.options_list_ptr->block2 |= 0x08;
+    }
+    return true;
+}
+
 void M2MBase::cancel_observation(M2MBase::MessageDeliveryStatus status, bool notify)
 {
     tr_info("M2MBase::cancel_observation()");
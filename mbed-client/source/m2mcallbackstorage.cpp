@@ -47,15 +47,84 @@ void M2MCallbackStorage::delete_instance()
     M2MCallbackStorage::_static_instance = NULL;
 }
 
+// Table starts at this size and doubles when it gets 3/4 full
+#define CALLBACK_TABLE_INITIAL_SIZE 16
+
+M2MCallbackStorage::M2MCallbackStorage()
+: _callbacks(NULL), _capacity(0), _count(0)
+{
+}
+
 M2MCallbackStorage::~M2MCallbackStorage()
 {
-    // Go through the list and delete all the FP<n> objects if there are any.
     // If the system is done properly, each m2mobject should actually
     // remove its callbacks from its destructor so there is nothing here to do
-    // find any association to given object and delete them from the vector
-    for (int index = _callbacks.size()-1; index >=0; index --) {
-        _callbacks.erase(index);
+    // but to release the table itself.
+    delete [] _callbacks;
+}
+
+uint32_t M2MCallbackStorage::slot_index(const M2MBase *object, M2MCallbackAssociation::M2MCallbackType type, uint32_t mask)
+{
+    // The objects are heap allocated, so the lowest bits of the address carry no information.
+    // Fold the address down to 32 bits and mix it with a multiplicative hash.
+    uint64_t key = (uint64_t)(uintptr_t)object;
+    uint32_t hash = (uint32_t)(key >> 3) ^ (uint32_t)(key >> 32);
+    hash = (hash + (uint32_t)type) * 2654435761u;
+    return (hash ^ (hash >> 16)) & mask;
+}
+
+void M2MCallbackStorage::grow_table()
+{
+    const uint32_t new_capacity = _capacity ? _capacity * 2 : CALLBACK_TABLE_INITIAL_SIZE;
+    M2MCallbackAssociation *new_callbacks = new M2MCallbackAssociation[new_capacity];
+    for (uint32_t index = 0; index < new_capacity; index++) {
+        new_callbacks[index]._object = NULL;
     }
+
+    M2MCallbackAssociation *old_callbacks = _callbacks;
+    const uint32_t old_capacity = _capacity;
+    _callbacks = new_callbacks;
+    _capacity = new_capacity;
+    _count = 0;
+
+    for (uint32_t index = 0; index < old_capacity; index++) {
+        if (old_callbacks[index]._object) {
+            insert_association(old_callbacks[index]);
+        }
+    }
+    delete [] old_callbacks;
+}
+
+void M2MCallbackStorage::insert_association(const M2MCallbackAssociation &association)
+{
+    // Caller has checked that the pair is not in the table and there is room for it
+    const uint32_t mask = _capacity - 1;
+    uint32_t index = slot_index(association._object, association._type, mask);
+    while (_callbacks[index]._object) {
+        index = (index + 1) & mask;
+    }
+    _callbacks[index] = association;
+    _count++;
+}
+
+void M2MCallbackStorage::remove_slot(uint32_t index)
+{
+    // Shift the following entries of the probe sequence back so that
+    // every entry stays reachable from its home slot without tombstones.
+    const uint32_t mask = _capacity - 1;
+    uint32_t hole = index;
+    uint32_t next = (hole + 1) & mask;
+    while (_callbacks[next]._object) {
+        const uint32_t home = slot_index(_callbacks[next]._object, _callbacks[next]._type, mask);
+        // Entry may move to the hole only if its home is not cyclically within (hole, next]
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            _callbacks[hole] = _callbacks[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    _callbacks[hole]._object = NULL;
+    _count--;
 }
 
 bool M2MCallbackStorage::add_callback(const M2MBase &object,
@@ -76,11 +145,15 @@ bool M2MCallbackStorage::do_add_callback(const M2MBase &object, void *callback,
 {
     bool add_success = false;
 
-    // verify that the same callback is not re-added.
-    if (!does_callback_exist(object, callback, type)) {
+    // verify that the same callback is not re-added and the pair does not have another callback already.
+    if (!do_get_association_item(object, type)) {
 
+        // keep the load factor below 3/4 so that probe sequences stay short
+        if ((_count + 1) * 4 > _capacity * 3) {
+            grow_table();
+        }
         const M2MCallbackAssociation association(&object, callback, type, client_args);
-        _callbacks.push_back(association);
+        insert_association(association);
         add_success = true;
     }
     return add_success;
@@ -99,13 +172,9 @@ void M2MCallbackStorage::remove_callbacks(const M2MBase &object)
 
 void M2MCallbackStorage::do_remove_callbacks(const M2MBase &object)
 {
-    // find any association to given object and delete them from the vector
-    for (int index = 0; index < _callbacks.size();) {
-        if (_callbacks[index]._object == &object) {
-            _callbacks.erase(index);
-        } else {
-            index++;
-        }
+    // find any association to given object and delete them from the table
+    for (int type = 0; type <= M2MCallbackAssociation::M2MResourceInstanceReadCallback; type++) {
+        do_remove_callback(object, (M2MCallbackAssociation::M2MCallbackType)type);
     }
 }
 #endif
@@ -124,12 +193,10 @@ void* M2MCallbackStorage::remove_callback(const M2MBase &object, M2MCallbackAsso
 void* M2MCallbackStorage::do_remove_callback(const M2MBase &object, M2MCallbackAssociation::M2MCallbackType type)
 {
     void* callback = NULL;
-    for (int index = 0; index < _callbacks.size(); index++) {
-
-        if ((_callbacks[index]._object == &object) && (_callbacks[index]._type == type)) {
-            callback = _callbacks[index]._callback;
-            _callbacks.erase(index);
-        }
+    M2MCallbackAssociation *item = do_get_association_item(object, type);
+    if (item) {
+        callback = item->_callback;
+        remove_slot((uint32_t)(item - _callbacks));
     }
     return callback;
 }
@@ -148,16 +215,9 @@ void* M2MCallbackStorage::get_callback(const M2MBase &object, M2MCallbackAssocia
 void* M2MCallbackStorage::do_get_callback(const M2MBase &object, M2MCallbackAssociation::M2MCallbackType type) const
 {
     void* callback = NULL;
-    if (!_callbacks.empty()) {
-        M2MCallbackAssociationList::const_iterator it = _callbacks.begin();
-
-        for ( ; it != _callbacks.end(); it++ ) {
-
-            if ((it->_object == &object) && (it->_type == type)) {
-                callback = it->_callback;
-                break;
-            }
-        }
+    const M2MCallbackAssociation *item = do_get_association_item(object, type);
+    if (item) {
+        callback = item->_callback;
     }
     return callback;
 }
@@ -176,15 +236,18 @@ M2MCallbackAssociation* M2MCallbackStorage::get_association_item(const M2MBase &
 M2MCallbackAssociation* M2MCallbackStorage::do_get_association_item(const M2MBase &object, M2MCallbackAssociation::M2MCallbackType type) const
 {
     M2MCallbackAssociation* callback_association = NULL;
-    if (!_callbacks.empty()) {
-        M2MCallbackAssociationList::const_iterator it = _callbacks.begin();
+    if (_count) {
+        const uint32_t mask = _capacity - 1;
+        uint32_t index = slot_index(&object, type, mask);
 
-        for ( ; it != _callbacks.end(); it++ ) {
+        // the table is never full, so the probe always ends on a free slot
+        while (_callbacks[index]._object) {
 
-            if ((it->_object == &object) && (it->_type == type)) {
-                callback_association = (M2MCallbackAssociation*)it;
+            if ((_callbacks[index]._object == &object) && (_callbacks[index]._type == type)) {
+                callback_association = &_callbacks[index];
                 break;
             }
+            index = (index + 1) & mask;
         }
     }
     return callback_association;
@@ -202,17 +265,10 @@ bool M2MCallbackStorage::does_callback_exist(const M2MBase &object, M2MCallbackA
 bool M2MCallbackStorage::does_callback_exist(const M2MBase &object, void *callback, M2MCallbackAssociation::M2MCallbackType type) const
 {
     bool match_found = false;
+    const M2MCallbackAssociation *item = do_get_association_item(object, type);
 
-    if (!_callbacks.empty()) {
-        M2MCallbackAssociationList::const_iterator it = _callbacks.begin();
-
-        for ( ; it != _callbacks.end(); it++ ) {
-
-            if ((it->_object == &object) && (it->_callback == callback) && (it->_type == type)) {
-                match_found = true;
-                break;
-            }
-        }
+    if (item && (item->_callback == callback)) {
+        match_found = true;
     }
 
     return match_found;
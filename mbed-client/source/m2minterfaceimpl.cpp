@@ -375,15 +375,37 @@ void M2MInterfaceImpl::coap_message_ready(uint8_t *data_ptr,
     if (_current_state != STATE_IDLE) {
         internal_event(STATE_SENDING_COAP_DATA);
         if (!_connection_handler.send_data(data_ptr, data_len, address_ptr)) {
-            internal_event(STATE_IDLE);
             tr_error("M2MInterfaceImpl::coap_message_ready() - M2MInterface::NetworkError");
-            if (!_reconnecting) {
-                _queue_mode_timer_ongoing = false;
-                socket_error(M2MConnectionHandler::SOCKET_SEND_ERROR, true);
-            } else {
-                socket_error(M2MConnectionHandler::SOCKET_ABORT);
-            }
+            coap_send_failed();
+        }
+    }
+}
+
+void M2MInterfaceImpl::coap_packet_ready(uint8_t *packet_ptr,
+                                         uint16_t data_len,
+                                         sn_nsdl_addr_s *address_ptr)
+{
+    tr_debug("M2MInterfaceImpl::coap_packet_ready");
+    if (_current_state != STATE_IDLE) {
+        internal_event(STATE_SENDING_COAP_DATA);
+        // Connection handler releases the packet reference also on failure
+        if (!_connection_handler.send_packet(packet_ptr, data_len, address_ptr)) {
+            tr_error("M2MInterfaceImpl::coap_packet_ready() - M2MInterface::NetworkError");
+            coap_send_failed();
         }
+    } else {
+        sn_nsdl_release_tx_packet(packet_ptr);
+    }
+}
+
+void M2MInterfaceImpl::coap_send_failed()
+{
+    internal_event(STATE_IDLE);
+    if (!_reconnecting) {
+        _queue_mode_timer_ongoing = false;
+        socket_error(M2MConnectionHandler::SOCKET_SEND_ERROR, true);
+    } else {
+        socket_error(M2MConnectionHandler::SOCKET_ABORT);
     }
 }
 
@@ -29,6 +29,8 @@
 #include "include/m2mnsdlobserver.h"
 #include "include/m2mtlvdeserializer.h"
 #include "include/m2mtlvserializer.h"
+#include "include/m2msenmlcborserializer.h"
+#include "include/m2msenmlcbordeserializer.h"
 #include "include/m2mnsdlinterface.h"
 #include "include/m2mreporthandler.h"
 #include "mbed-client/m2mstring.h"
@@ -88,6 +90,40 @@
 
 #define REGISTRATION_UPDATE_DELAY 10 // wait 10ms before sending registration update for PUT to resource 1/0/1
 
+#if MBED_CLIENT_RESOURCE_PATH_INDEX
+#define PATH_INDEX_MIN_SIZE 32 // slot count, must be power of two
+
+static uint32_t path_index_hash(const char *path)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    while (*path) {
+        hash ^= (uint8_t)*path++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+#endif
+
+// Seconds since the first call, for the CoAP library. The event timer ticks are accumulated
+// into whole seconds so that the time keeps increasing when the tick counter wraps around.
+static uint32_t nsdl_time()
+{
+    static uint32_t seconds = 0;
+    static uint32_t counted_ticks = 0;
+    static bool started = false;
+
+    const uint32_t ticks = eventOS_event_timer_ticks();
+    if (!started) {
+        counted_ticks = ticks;
+        started = true;
+    }
+    const uint32_t elapsed = (ticks - counted_ticks) / EVENTOS_EVENT_TIMER_HZ;
+    seconds += elapsed;
+    counted_ticks += elapsed * EVENTOS_EVENT_TIMER_HZ;
+    return seconds;
+}
+
 const char *MCC_VERSION = "mccv=4.9.1";
 
 int8_t M2MNsdlInterface::_tasklet_id = -1;
@@ -230,7 +266,6 @@ M2MNsdlInterface::M2MNsdlInterface(M2MNsdlObserver &observer, M2MConnectionHandl
       _nsdl_execution_timer(*this),
       _registration_timer(*this),
       _connection_handler(connection_handler),
-      _counter_for_nsdl(0),
       _next_coap_ping_send_time(0),
       _server_address(NULL),
       _custom_uri_query_params(NULL),
@@ -249,6 +284,11 @@ M2MNsdlInterface::M2MNsdlInterface(M2MNsdlObserver &observer, M2MConnectionHandl
       _alert_mode(false),
       _last_notif_queue_event(M2MNsdlInterface::SEND_NOTIFICATION),
       _current_request_code(COAP_MSG_CODE_EMPTY)
+#if MBED_CLIENT_RESOURCE_PATH_INDEX
+      , _path_index(NULL),
+      _path_index_size(0),
+      _path_index_count(0)
+#endif
 {
     tr_debug("M2MNsdlInterface::M2MNsdlInterface()");
 
@@ -269,6 +309,7 @@ M2MNsdlInterface::M2MNsdlInterface(M2MNsdlObserver &observer, M2MConnectionHandl
                                 &(__nsdl_c_memory_alloc), &(__nsdl_c_memory_free), &(__nsdl_c_auto_obs_token));
 
     sn_nsdl_set_context(_nsdl_handle, this);
+    sn_coap_protocol_set_system_time_callback(_nsdl_handle->grs->coap, &nsdl_time);
 
     ns_hal_init(NULL, MBED_CLIENT_EVENT_LOOP_SIZE, NULL, NULL);
     eventOS_scheduler_mutex_wait();
@@ -297,6 +338,9 @@ M2MNsdlInterface::~M2MNsdlInterface()
 
     delete _notification_handler;
     _base_list.clear();
+#if MBED_CLIENT_RESOURCE_PATH_INDEX
+    memory_free(_path_index);
+#endif
     _security = NULL;
     delete _server;
     sn_nsdl_destroy(_nsdl_handle);
@@ -463,6 +507,12 @@ bool M2MNsdlInterface::create_nsdl_list_structure(const M2MBaseList &list)
             success = create_nsdl_structure(*it);
             if (!success) {
                 tr_debug("M2MNsdlInterface::create_nsdl_list_structure - fail to create resource");
+#if MBED_CLIENT_RESOURCE_PATH_INDEX
+                // Object is not added to the list, so it must not be found either
+                if (!object_present(*it)) {
+                    path_index_remove_tree(*it);
+                }
+#endif
                 break;
             }
 
@@ -746,14 +796,20 @@ uint8_t *M2MNsdlInterface::alloc_string_copy(const uint8_t *source, uint16_t siz
     return result;
 }
 
-uint8_t M2MNsdlInterface::send_to_server_callback(struct nsdl_s * /*nsdl_handle*/,
+uint8_t M2MNsdlInterface::send_to_server_callback(struct nsdl_s *nsdl_handle,
                                                   sn_nsdl_capab_e /*protocol*/,
                                                   uint8_t *data_ptr,
                                                   uint16_t data_len,
                                                   sn_nsdl_addr_s *address)
 {
     tr_debug("M2MNsdlInterface::send_to_server_callback(data size %d)", data_len);
-    _observer.coap_message_ready(data_ptr, data_len, address);
+    // Queue the packet shared with the CoAP resending list instead of copying it, when possible
+    uint8_t *packet_ptr = sn_nsdl_ref_tx_packet(nsdl_handle, data_ptr);
+    if (packet_ptr) {
+        _observer.coap_packet_ready(packet_ptr, data_len, address);
+    } else {
+        _observer.coap_message_ready(data_ptr, data_len, address);
+    }
     return 1;
 }
 
@@ -1334,9 +1390,13 @@ bool M2MNsdlInterface::process_received_data(uint8_t *data,
         return true;
     }
 
-    return (0 == sn_nsdl_process_coap(_nsdl_handle,
-                                      coap_packet_ptr,
-                                      address)) ? true : false;
+    if (sn_nsdl_process_coap(_nsdl_handle, coap_packet_ptr, address) != 0) {
+        return false;
+    }
+
+    // The message may have added blockwise or duplicate detection data with a new deadline
+    schedule_nsdl_execution();
+    return true;
 }
 
 void M2MNsdlInterface::stop_timers()
@@ -1375,9 +1435,9 @@ bool M2MNsdlInterface::alert_mode() const
 void M2MNsdlInterface::timer_expired(M2MTimerObserver::Type type)
 {
     if (M2MTimerObserver::NsdlExecution == type) {
-        sn_nsdl_exec(_nsdl_handle, _counter_for_nsdl);
-        _counter_for_nsdl++;
+        sn_nsdl_exec(_nsdl_handle, nsdl_time());
         send_coap_ping();
+        schedule_nsdl_execution();
     } else if ((M2MTimerObserver::Registration) == type &&
                (is_unregister_ongoing() == false) &&
                (is_update_register_ongoing() == false)) {
@@ -1543,6 +1603,9 @@ void M2MNsdlInterface::resource_to_be_deleted(M2MBase *base)
     tr_debug("M2MNsdlInterface::resource_to_be_deleted() %p", base);
     claim_mutex();
     remove_nsdl_resource(base);
+#if MBED_CLIENT_RESOURCE_PATH_INDEX
+    path_index_remove_tree(base);
+#endif
 #if !defined(DISABLE_DELAYED_RESPONSE) || defined(ENABLE_ASYNC_REST_RESPONSE)
     remove_items_from_response_list_for_uri(base->uri_path());
 #endif
@@ -1607,6 +1670,10 @@ void M2MNsdlInterface::remove_object(M2MBase *object)
         for (; it != _base_list.end(); it++, index++) {
             if ((*it)->base_type() == M2MBase::Object && (*it) == rem_object) {
                 _base_list.erase(index);
+#if MBED_CLIENT_RESOURCE_PATH_INDEX
+                path_index_remove_tree(rem_object);
+#endif
+                cancel_pending_notifications(rem_object);
                 break;
             }
         }
@@ -1769,6 +1836,10 @@ bool M2MNsdlInterface::create_nsdl_resource(M2MBase *base)
 
         result = sn_nsdl_put_resource(_nsdl_handle, nsdl_resource);
 
+#if MBED_CLIENT_RESOURCE_PATH_INDEX
+        path_index_add(base);
+#endif
+
         // Put under observation if auto-obs feature is set.
         if (nsdl_resource &&
                 nsdl_resource->auto_observable &&
@@ -1858,6 +1929,13 @@ uint32_t M2MNsdlInterface::registration_time() const
 M2MBase *M2MNsdlInterface::find_resource(const String &object_name) const
 {
     tr_debug("M2MNsdlInterface::find_resource(object level) - from %p name (%s) ", this, object_name.c_str());
+#if MBED_CLIENT_RESOURCE_PATH_INDEX
+    // Index holds everything created through create_nsdl_resource(), other bases are still found by the tree walk below
+    M2MBase *indexed = path_index_find(object_name.c_str());
+    if (indexed) {
+        return indexed;
+    }
+#endif
     M2MObject *current = NULL;
     M2MBase *found = NULL;
     if (!_base_list.empty()) {
@@ -2004,6 +2082,161 @@ M2MBase *M2MNsdlInterface::find_resource(const M2MResource *resource,
     return res;
 }
 
+#if MBED_CLIENT_RESOURCE_PATH_INDEX
+void M2MNsdlInterface::path_index_add(M2MBase *base)
+{
+#ifdef MBED_CLOUD_CLIENT_EDGE_EXTENSION
+    // Endpoint directories are never returned by find_resource()
+    if (base->base_type() == M2MBase::ObjectDirectory) {
+        return;
+    }
+#endif
+
+    // Keep load factor at most 1/2 so that probe sequences stay short
+    if ((_path_index_count + 1) * 2 > _path_index_size) {
+        uint32_t size = _path_index_size ? _path_index_size * 2 : PATH_INDEX_MIN_SIZE;
+        if (!path_index_resize(size) && _path_index_count + 1 >= _path_index_size) {
+            // Table is full, base is still found by the tree walk
+            tr_warn("M2MNsdlInterface::path_index_add - index not updated");
+            return;
+        }
+    }
+
+    const char *path = base->uri_path();
+    const uint32_t mask = _path_index_size - 1;
+    uint32_t i = path_index_hash(path) & mask;
+    while (_path_index[i]) {
+        // First one with a given path wins, like it does in the tree walk
+        if (_path_index[i] == base || strcmp(_path_index[i]->uri_path(), path) == 0) {
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+    _path_index[i] = base;
+    _path_index_count++;
+}
+
+void M2MNsdlInterface::path_index_remove(const M2MBase *base)
+{
+    if (!_path_index_count) {
+        return;
+    }
+
+    const uint32_t mask = _path_index_size - 1;
+    uint32_t i = path_index_hash(base->uri_path()) & mask;
+    while (_path_index[i] != base) {
+        if (!_path_index[i]) {
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+
+    // Backward shift deletion, move up every following entry whose home slot is not between the hole and itself
+    uint32_t j = i;
+    for (;;) {
+        j = (j + 1) & mask;
+        if (!_path_index[j]) {
+            break;
+        }
+        const uint32_t home = path_index_hash(_path_index[j]->uri_path()) & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            _path_index[i] = _path_index[j];
+            i = j;
+        }
+    }
+    _path_index[i] = NULL;
+    _path_index_count--;
+}
+
+void M2MNsdlInterface::path_index_remove_tree(const M2MBase *base)
+{
+    switch (base->base_type()) {
+#ifdef MBED_CLOUD_CLIENT_EDGE_EXTENSION
+        case M2MBase::ObjectDirectory: {
+            const M2MObjectList &list = static_cast<const M2MEndpoint *>(base)->objects();
+            M2MObjectList::const_iterator it = list.begin();
+            for (; it != list.end(); it++) {
+                path_index_remove_tree(*it);
+            }
+            break;
+        }
+#endif
+        case M2MBase::Object: {
+            const M2MObjectInstanceList &list = static_cast<const M2MObject *>(base)->instances();
+            M2MObjectInstanceList::const_iterator it = list.begin();
+            for (; it != list.end(); it++) {
+                path_index_remove_tree(*it);
+            }
+            break;
+        }
+        case M2MBase::ObjectInstance: {
+            const M2MResourceList &list = static_cast<const M2MObjectInstance *>(base)->resources();
+            M2MResourceList::const_iterator it = list.begin();
+            for (; it != list.end(); it++) {
+                path_index_remove_tree(*it);
+            }
+            break;
+        }
+        case M2MBase::Resource: {
+            const M2MResource *resource = static_cast<const M2MResource *>(base);
+            if (resource->supports_multiple_instances()) {
+                const M2MResourceInstanceList &list = resource->resource_instances();
+                M2MResourceInstanceList::const_iterator it = list.begin();
+                for (; it != list.end(); it++) {
+                    path_index_remove(*it);
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    path_index_remove(base);
+}
+
+M2MBase *M2MNsdlInterface::path_index_find(const char *path) const
+{
+    if (!_path_index_count) {
+        return NULL;
+    }
+
+    const uint32_t mask = _path_index_size - 1;
+    uint32_t i = path_index_hash(path) & mask;
+    while (_path_index[i]) {
+        if (strcmp(_path_index[i]->uri_path(), path) == 0) {
+            return _path_index[i];
+        }
+        i = (i + 1) & mask;
+    }
+    return NULL;
+}
+
+bool M2MNsdlInterface::path_index_resize(uint32_t size)
+{
+    M2MBase **index = (M2MBase **)memory_alloc(size * sizeof(M2MBase *));
+    if (!index) {
+        return false;
+    }
+    memset(index, 0, size * sizeof(M2MBase *));
+
+    const uint32_t mask = size - 1;
+    for (uint32_t i = 0; i < _path_index_size; i++) {
+        if (_path_index[i]) {
+            uint32_t j = path_index_hash(_path_index[i]->uri_path()) & mask;
+            while (index[j]) {
+                j = (j + 1) & mask;
+            }
+            index[j] = _path_index[i];
+        }
+    }
+
+    memory_free(_path_index);
+    _path_index = index;
+    _path_index_size = size;
+    return true;
+}
+#endif // MBED_CLIENT_RESOURCE_PATH_INDEX
+
 bool M2MNsdlInterface::object_present(M2MBase *base) const
 {
     bool success = false;
@@ -2057,11 +2290,56 @@ bool M2MNsdlInterface::remove_object_from_list(M2MBase *object)
     if (object && (-1 != (index = object_index(object)))) {
         tr_debug("  object found at index %d", index);
         _base_list.erase(index);
+#if MBED_CLIENT_RESOURCE_PATH_INDEX
+        path_index_remove_tree(object);
+#endif
+        cancel_pending_notifications(object);
         success = true;
     }
     return success;
 }
 
+void M2MNsdlInterface::cancel_pending_notifications(const M2MBase *base)
+{
+    switch (base->base_type()) {
+        case M2MBase::Object: {
+            const M2MObjectInstanceList &list = static_cast<const M2MObject *>(base)->instances();
+            M2MObjectInstanceList::const_iterator it = list.begin();
+            for (; it != list.end(); it++) {
+                cancel_pending_notifications(*it);
+            }
+            break;
+        }
+        case M2MBase::ObjectInstance: {
+            const M2MResourceList &list = static_cast<const M2MObjectInstance *>(base)->resources();
+            M2MResourceList::const_iterator it = list.begin();
+            for (; it != list.end(); it++) {
+                cancel_pending_notifications(*it);
+            }
+            break;
+        }
+        case M2MBase::Resource: {
+            const M2MResource *resource = static_cast<const M2MResource *>(base);
+            if (resource->supports_multiple_instances()) {
+                const M2MResourceInstanceList &list = resource->resource_instances();
+                M2MResourceInstanceList::const_iterator it = list.begin();
+                for (; it != list.end(); it++) {
+                    cancel_pending_notifications(*it);
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    M2MReportHandler *handler = base->report_handler();
+    if (handler) {
+        handler->set_notification_in_queue(false);
+        handler->set_notification_send_in_progress(false);
+    }
+}
+
 M2MInterface::Error M2MNsdlInterface::interface_error(const sn_coap_hdr_s &coap_header)
 {
     M2MInterface::Error error;
@@ -2156,7 +2434,14 @@ void M2MNsdlInterface::send_object_observation(M2MObject *object,
 
         // Send whole object structure
         if (send_object) {
-            value = M2MTLVSerializer::serialize(object->instances(), length);
+#if MBED_CLIENT_SENML_CBOR
+            if (object->coap_content_type() == COAP_CONTENT_OMA_SENML_CBOR_TYPE) {
+                value = M2MSenMLCBORSerializer::serialize(*object, object->instances(), length, pal_osGetTime());
+            } else
+#endif
+            {
+                value = M2MTLVSerializer::serialize(object->instances(), length);
+            }
         }
         // Send only changed object instances
         else {
@@ -2170,7 +2455,14 @@ void M2MNsdlInterface::send_object_observation(M2MObject *object,
                 }
             }
             if (!list.empty()) {
-                value = M2MTLVSerializer::serialize(list, length);
+#if MBED_CLIENT_SENML_CBOR
+                if (object->coap_content_type() == COAP_CONTENT_OMA_SENML_CBOR_TYPE) {
+                    value = M2MSenMLCBORSerializer::serialize(*object, list, length, pal_osGetTime());
+                } else
+#endif
+                {
+                    value = M2MTLVSerializer::serialize(list, length);
+                }
                 list.clear();
             }
         }
@@ -2199,7 +2491,14 @@ void M2MNsdlInterface::send_object_instance_observation(M2MObjectInstance *objec
         uint8_t token[MAX_TOKEN_SIZE];
         uint8_t token_length = 0;
 
-        value = M2MTLVSerializer::serialize(object_instance->resources(), length);
+#if MBED_CLIENT_SENML_CBOR
+        if (object_instance->coap_content_type() == COAP_CONTENT_OMA_SENML_CBOR_TYPE) {
+            value = M2MSenMLCBORSerializer::serialize(*object_instance, length, pal_osGetTime());
+        } else
+#endif
+        {
+            value = M2MTLVSerializer::serialize(object_instance->resources(), length);
+        }
 
         object_instance->get_observation_token((uint8_t *)&token, token_length);
 
@@ -2227,14 +2526,21 @@ void M2MNsdlInterface::send_resource_observation(M2MResource *resource,
 
         resource->get_observation_token((uint8_t *)token, token_length);
         uint16_t content_type = resource->coap_content_type();
-        if (M2MResourceBase::OPAQUE == resource->resource_instance_type()) {
-            content_type = COAP_CONTENT_OMA_OPAQUE_TYPE;
-        }
+#if MBED_CLIENT_SENML_CBOR
+        if (content_type == COAP_CONTENT_OMA_SENML_CBOR_TYPE) {
+            value = M2MSenMLCBORSerializer::serialize(*resource, length, pal_osGetTime());
+        } else
+#endif
+        {
+            if (M2MResourceBase::OPAQUE == resource->resource_instance_type()) {
+                content_type = COAP_CONTENT_OMA_OPAQUE_TYPE;
+            }
 
-        if (resource->resource_instance_count() > 0 || content_type == COAP_CONTENT_OMA_TLV_TYPE) {
-            value = M2MTLVSerializer::serialize(resource, length);
-        } else {
-            resource->get_value(value, length);
+            if (resource->resource_instance_count() > 0 || content_type == COAP_CONTENT_OMA_TLV_TYPE) {
+                value = M2MTLVSerializer::serialize(resource, length);
+            } else {
+                resource->get_value(value, length);
+            }
         }
 
         resource->report_handler()->set_blockwise_notify(M2MBase::is_blockwise_needed(_nsdl_handle, length));
@@ -2304,6 +2610,9 @@ void M2MNsdlInterface::handle_bootstrap_put_message(sn_coap_hdr_s *coap_header,
         }
 
         if (content_type != COAP_CONTENT_OMA_TLV_TYPE &&
+#if MBED_CLIENT_SENML_CBOR
+                content_type != COAP_CONTENT_OMA_SENML_CBOR_TYPE &&
+#endif
                 content_type != COAP_CONTENT_OMA_TLV_TYPE_OLD) {
             tr_error("M2MNsdlInterface::handle_bootstrap_put_message - content_type %d", content_type);
             success = false;
@@ -2367,6 +2676,11 @@ bool M2MNsdlInterface::parse_bootstrap_message(sn_coap_hdr_s *coap_header,
     bool ret = false;
     bool is_obj_instance = false;
     uint16_t instance_id = 0;
+#if MBED_CLIENT_SENML_CBOR
+    if (_security && coap_header->content_format == COAP_CONTENT_OMA_SENML_CBOR_TYPE) {
+        return parse_bootstrap_senml_cbor_message(coap_header, lwm2m_object_type);
+    }
+#endif
     if (_security) {
         ret = is_obj_instance = M2MTLVDeserializer::is_object_instance(coap_header->payload_ptr);
         if (!is_obj_instance) {
@@ -2451,6 +2765,57 @@ bool M2MNsdlInterface::parse_bootstrap_message(sn_coap_hdr_s *coap_header,
     return ret;
 }
 
+#if MBED_CLIENT_SENML_CBOR
+bool M2MNsdlInterface::parse_bootstrap_senml_cbor_message(sn_coap_hdr_s *coap_header,
+                                                          M2MNsdlInterface::ObjectType lwm2m_object_type)
+{
+    tr_info("M2MNsdlInterface::parse_bootstrap_senml_cbor_message");
+    // Records carry the full path, so writes to an object and to an object instance
+    // are both resolved against the object
+    M2MObject *object = NULL;
+    M2MTLVDeserializer::Operation operation = M2MTLVDeserializer::Put;
+    switch (lwm2m_object_type) {
+        case M2MNsdlInterface::SECURITY: {
+            uint16_t instance_id = 0;
+            if (!M2MSenMLCBORDeserializer::instance_id(coap_header->payload_ptr, coap_header->payload_len,
+                                                       *_security, instance_id)) {
+                return false;
+            }
+            if (_security->object_instance(instance_id) == NULL) {
+                tr_debug("M2MNsdlInterface::parse_bootstrap_senml_cbor_message - create instance %d", instance_id);
+                _security->create_object_instance(M2MSecurity::M2MServer);
+                change_operation_mode(_security, M2MBase::PUT_ALLOWED);
+            }
+            object = _security;
+            break;
+        }
+        case M2MNsdlInterface::SERVER:
+            object = _server;
+            // As with OMA-TLV, the resources missing from the server instance are created
+            operation = M2MTLVDeserializer::Post;
+            break;
+        case M2MNsdlInterface::DEVICE:
+            object = static_cast<M2MObject *>(M2MInterfaceFactory::create_device());
+            break;
+        default:
+            break;
+    }
+    if (!object) {
+        return false;
+    }
+
+    M2MTLVDeserializer::Error error = M2MSenMLCBORDeserializer::deserialize_object_instances(coap_header->payload_ptr,
+                                                                                             coap_header->payload_len,
+                                                                                             *object,
+                                                                                             operation);
+    if (error != M2MTLVDeserializer::None) {
+        tr_error("M2MNsdlInterface::parse_bootstrap_senml_cbor_message - error %d", error);
+        return false;
+    }
+    return true;
+}
+#endif // MBED_CLIENT_SENML_CBOR
+
 void M2MNsdlInterface::handle_bootstrap_finished(sn_coap_hdr_s *coap_header, sn_nsdl_addr_s *address)
 {
     char buffer[MAX_ALLOWED_ERROR_STRING_LENGTH];
@@ -2822,10 +3187,30 @@ void M2MNsdlInterface::start_nsdl_execution_timer()
 {
     tr_debug("M2MNsdlInterface::start_nsdl_execution_timer");
     _nsdl_execution_timer_running = true;
+    schedule_nsdl_execution();
+}
+
+void M2MNsdlInterface::schedule_nsdl_execution()
+{
+    if (!_nsdl_execution_timer_running) {
+        return;
+    }
+
+    uint32_t next_time;
+    bool pending = (sn_nsdl_get_next_exec_time(_nsdl_handle, &next_time) == 0);
+    if (_binding_mode == M2MInterface::TCP && _registered &&
+            (!pending || _next_coap_ping_send_time < next_time)) {
+        next_time = _next_coap_ping_send_time;
+        pending = true;
+    }
+
     _nsdl_execution_timer.stop_timer();
-    _nsdl_execution_timer.start_timer(ONE_SECOND_TIMER * 1000,
-                                      M2MTimerObserver::NsdlExecution,
-                                      false);
+    if (pending) {
+        const uint32_t now = nsdl_time();
+        const uint32_t delay = (next_time > now) ? next_time - now : 0;
+        _nsdl_execution_timer.start_timer(delay * (uint64_t)1000,
+                                          M2MTimerObserver::NsdlExecution);
+    }
 }
 
 void M2MNsdlInterface::stop_nsdl_execution_timer()
@@ -3019,8 +3404,12 @@ void M2MNsdlInterface::clear_received_blockwise_messages()
 void M2MNsdlInterface::send_coap_ping()
 {
     if (_binding_mode == M2MInterface::TCP && _registered &&
-            _counter_for_nsdl == _next_coap_ping_send_time &&
-            !coap_ping_in_process()) {
+            nsdl_time() >= _next_coap_ping_send_time) {
+        // Move the deadline also when a ping is still in process, otherwise it would stay in the past
+        calculate_new_coap_ping_send_time();
+        if (coap_ping_in_process()) {
+            return;
+        }
 
         tr_info("M2MNsdlInterface::send_coap_ping()");
 
@@ -3041,14 +3430,23 @@ void M2MNsdlInterface::calculate_new_coap_ping_send_time()
         return;
     }
 
-    _next_coap_ping_send_time = _counter_for_nsdl + MBED_CLIENT_TCP_KEEPALIVE_INTERVAL;
+    _next_coap_ping_send_time = nsdl_time() + MBED_CLIENT_TCP_KEEPALIVE_INTERVAL;
 }
 
 void M2MNsdlInterface::send_next_notification(NotificationQueueOption option)
 {
     tr_info("M2MNsdlInterface::send_next_notification - option %d", option);
     claim_mutex();
-    if (!_base_list.empty()) {
+    // Sending only needs to visit the handlers that have something pending. After REMOVE_NOTIFICATION
+    // the timers of every handler have to be restarted, so the whole tree is walked in that case.
+    if (option == SEND_NOTIFICATION && _last_notif_queue_event != REMOVE_NOTIFICATION) {
+        M2MReportHandler *reporter = M2MReportHandler::first_notification_to_send();
+        if (reporter) {
+            reporter->schedule_report(true);
+            release_mutex();
+            return;
+        }
+    } else if (!_base_list.empty()) {
         M2MBaseList::const_iterator base_iterator;
         base_iterator = _base_list.begin();
         for (; base_iterator != _base_list.end(); base_iterator++) {
@@ -3213,6 +3611,9 @@ void M2MNsdlInterface::set_registration_status(bool registered)
     if (!registered) {
         remove_ping_from_response_list();
     }
+
+    // CoAP ping is sent only while registered
+    schedule_nsdl_execution();
 }
 
 bool M2MNsdlInterface::is_registered() const
@@ -4034,7 +4435,7 @@ bool M2MNsdlInterface::handle_notification_queue(M2MObject &object, M2MNsdlInter
                 reporter->start_timers();
             }
 
-            if (reporter->is_under_observation() &&
+            if (reporter->is_under_observation() && !reporter->notification_coalescing() &&
                     (reporter->notification_in_queue() || reporter->notification_send_in_progress())) {
                 reporter->schedule_report(true);
                 scheduled = true;
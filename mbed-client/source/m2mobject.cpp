@@ -26,6 +26,8 @@
 #include "mbed-client/m2mconstants.h"
 #include "include/m2mtlvserializer.h"
 #include "include/m2mtlvdeserializer.h"
+#include "include/m2msenmlcborserializer.h"
+#include "include/m2msenmlcbordeserializer.h"
 #include "include/m2mreporthandler.h"
 #include "mbed-trace/mbed_trace.h"
 #include "mbed-client/m2mstringbuffer.h"
@@ -251,6 +253,9 @@ sn_coap_hdr_s *M2MObject::handle_get_request(nsdl_s *nsdl,
                 // Check if preferred content type is supported
                 if (content_type_present) {
                     if (coap_response->content_format != COAP_CONTENT_OMA_TLV_TYPE_OLD &&
+#if MBED_CLIENT_SENML_CBOR
+                            coap_response->content_format != COAP_CONTENT_OMA_SENML_CBOR_TYPE &&
+#endif
                             coap_response->content_format != COAP_CONTENT_OMA_TLV_TYPE) {
                         is_content_type_supported = false;
                     }
@@ -259,6 +264,9 @@ sn_coap_hdr_s *M2MObject::handle_get_request(nsdl_s *nsdl,
                 if (is_content_type_supported) {
                     if (!content_type_present &&
                             (M2MBase::coap_content_type() == COAP_CONTENT_OMA_TLV_TYPE ||
+#if MBED_CLIENT_SENML_CBOR
+                             M2MBase::coap_content_type() == COAP_CONTENT_OMA_SENML_CBOR_TYPE ||
+#endif
                              M2MBase::coap_content_type() == COAP_CONTENT_OMA_TLV_TYPE_OLD)) {
                         coap_response->content_format = sn_coap_content_format_e(M2MBase::coap_content_type());
                     }
@@ -267,8 +275,32 @@ sn_coap_hdr_s *M2MObject::handle_get_request(nsdl_s *nsdl,
                     if (COAP_CONTENT_OMA_TLV_TYPE == coap_response->content_format ||
                             COAP_CONTENT_OMA_TLV_TYPE_OLD == coap_response->content_format) {
                         set_coap_content_type(coap_response->content_format);
-                        data = M2MTLVSerializer::serialize(_instance_list, data_length);
+                        if (received_coap_header->options_list_ptr &&
+                                received_coap_header->options_list_ptr->observe != -1) {
+                            data = M2MTLVSerializer::serialize(_instance_list, data_length);
+                        } else {
+                            // Serialize only the requested block, so that the whole payload is not kept for the blockwise transfer
+                            uint32_t total_size = 0;
+                            uint32_t offset = 0;
+                            M2MTLVSerializer::serialize(_instance_list, 0, NULL, 0, total_size);
+                            if (set_response_block(nsdl, *received_coap_header, *coap_response, total_size, offset, data_length)) {
+                                data = data_length ? (uint8_t *)malloc(data_length) : NULL;
+                                if (data) {
+                                    M2MTLVSerializer::serialize(_instance_list, offset, data, data_length, total_size);
+                                } else {
+                                    data_length = 0;
+                                }
+                            } else {
+                                msg_code = COAP_MSG_CODE_RESPONSE_BAD_OPTION;
+                            }
+                        }
+                    }
+#if MBED_CLIENT_SENML_CBOR
+                    else if (COAP_CONTENT_OMA_SENML_CBOR_TYPE == coap_response->content_format) {
+                        set_coap_content_type(coap_response->content_format);
+                        data = M2MSenMLCBORSerializer::serialize(*this, _instance_list, data_length);
                     }
+#endif
 
                     coap_response->payload_len = data_length;
                     coap_response->payload_ptr = data;
@@ -282,7 +314,7 @@ sn_coap_hdr_s *M2MObject::handle_get_request(nsdl_s *nsdl,
                                 handle_observation(nsdl, *received_coap_header, *coap_response, observation_handler, msg_code);
                             }
                         }
-                    } else {
+                    } else if (msg_code != COAP_MSG_CODE_RESPONSE_BAD_OPTION) {
                         msg_code = COAP_MSG_CODE_RESPONSE_UNSUPPORTED_CONTENT_FORMAT; // Content format not supported
                     }
                 } else {
@@ -380,6 +412,9 @@ sn_coap_hdr_s *M2MObject::handle_post_request(nsdl_s *nsdl,
                 } // if(received_coap_header->content_format)
                 if (!content_type_present &&
                         (M2MBase::coap_content_type() == COAP_CONTENT_OMA_TLV_TYPE ||
+#if MBED_CLIENT_SENML_CBOR
+                         M2MBase::coap_content_type() == COAP_CONTENT_OMA_SENML_CBOR_TYPE ||
+#endif
                          M2MBase::coap_content_type() == COAP_CONTENT_OMA_TLV_TYPE_OLD)) {
                     coap_content_type = M2MBase::coap_content_type();
                 }
@@ -387,6 +422,9 @@ sn_coap_hdr_s *M2MObject::handle_post_request(nsdl_s *nsdl,
                 tr_debug("M2MObject::handle_post_request() - Request Content-type: %d", coap_content_type);
 
                 if (COAP_CONTENT_OMA_TLV_TYPE == coap_content_type ||
+#if MBED_CLIENT_SENML_CBOR
+                        COAP_CONTENT_OMA_SENML_CBOR_TYPE == coap_content_type ||
+#endif
                         COAP_CONTENT_OMA_TLV_TYPE_OLD == coap_content_type) {
                     set_coap_content_type(coap_content_type);
                     uint32_t instance_id = 0;
@@ -403,9 +441,29 @@ sn_coap_hdr_s *M2MObject::handle_post_request(nsdl_s *nsdl,
 
 
                     bool is_obj_instance = false;
-                    is_obj_instance = M2MTLVDeserializer::is_object_instance(received_coap_header->payload_ptr);
+                    uint32_t payload_instance_id = 0;
+#if MBED_CLIENT_SENML_CBOR
+                    if (COAP_CONTENT_OMA_SENML_CBOR_TYPE == coap_content_type) {
+                        // SenML-CBOR records always name the instance they belong to
+                        uint16_t senml_instance_id = 0;
+                        is_obj_instance = M2MSenMLCBORDeserializer::instance_id(received_coap_header->payload_ptr,
+                                                                                received_coap_header->payload_len,
+                                                                                *this, senml_instance_id);
+                        payload_instance_id = senml_instance_id;
+                        if (!is_obj_instance) {
+                            tr_error("M2MObject::handle_post_request() - no instance id in SenML-CBOR");
+                            msg_code = COAP_MSG_CODE_RESPONSE_BAD_REQUEST;
+                        }
+                    } else
+#endif
+                    {
+                        is_obj_instance = M2MTLVDeserializer::is_object_instance(received_coap_header->payload_ptr);
+                        if (is_obj_instance) {
+                            payload_instance_id = M2MTLVDeserializer::instance_id(received_coap_header->payload_ptr);
+                        }
+                    }
                     if (is_obj_instance) {
-                        if (M2MTLVDeserializer::instance_id(received_coap_header->payload_ptr) >= UINT16_MAX) {
+                        if (payload_instance_id >= UINT16_MAX) {
                             tr_error("M2MObject::handle_post_request() - id must be less than 65535");
                             msg_code = COAP_MSG_CODE_RESPONSE_METHOD_NOT_ALLOWED;
                         }
@@ -414,8 +472,8 @@ sn_coap_hdr_s *M2MObject::handle_post_request(nsdl_s *nsdl,
                     if (COAP_MSG_CODE_RESPONSE_CHANGED == msg_code) {
                         bool obj_instance_exists = false;
                         if (is_obj_instance) {
-                            instance_id = M2MTLVDeserializer::instance_id(received_coap_header->payload_ptr);
-                            tr_debug("M2MObject::handle_post_request() - instance id in TLV: %" PRIu32, instance_id);
+                            instance_id = payload_instance_id;
+                            tr_debug("M2MObject::handle_post_request() - instance id in payload: %" PRIu32, instance_id);
                             // Check if instance id already exists
                             if (object_instance(instance_id)) {
                                 obj_instance_exists = true;
@@ -428,6 +486,14 @@ sn_coap_hdr_s *M2MObject::handle_post_request(nsdl_s *nsdl,
                             }
 
                             M2MTLVDeserializer::Error error = M2MTLVDeserializer::None;
+#if MBED_CLIENT_SENML_CBOR
+                            if (COAP_CONTENT_OMA_SENML_CBOR_TYPE == coap_content_type) {
+                                error = M2MSenMLCBORDeserializer::deserialize_object_instances(received_coap_header->payload_ptr,
+                                                                                               received_coap_header->payload_len,
+                                                                                               *this,
+                                                                                               M2MTLVDeserializer::Post);
+                            } else
+#endif
                             if (is_obj_instance) {
                                 tr_debug("M2MObject::handle_post_request() - TLV data contains ObjectInstance");
                                 error = M2MTLVDeserializer::deserialise_object_instances(received_coap_header->payload_ptr,
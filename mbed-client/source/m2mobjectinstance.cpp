@@ -30,6 +30,8 @@
 #include "mbed-client/m2mstringbuffer.h"
 #include "include/m2mtlvserializer.h"
 #include "include/m2mtlvdeserializer.h"
+#include "include/m2msenmlcborserializer.h"
+#include "include/m2msenmlcbordeserializer.h"
 #include "include/m2mreporthandler.h"
 #include "mbed-trace/mbed_trace.h"
 #include "include/m2mcallbackstorage.h"
@@ -498,6 +500,9 @@ sn_coap_hdr_s *M2MObjectInstance::handle_get_request(nsdl_s *nsdl,
                 // Check if preferred content type is supported
                 if (content_type_present) {
                     if (coap_response->content_format != COAP_CONTENT_OMA_TLV_TYPE_OLD &&
+#if MBED_CLIENT_SENML_CBOR
+                            coap_response->content_format != COAP_CONTENT_OMA_SENML_CBOR_TYPE &&
+#endif
                             coap_response->content_format != COAP_CONTENT_OMA_TLV_TYPE) {
                         is_content_type_supported = false;
                     }
@@ -506,6 +511,9 @@ sn_coap_hdr_s *M2MObjectInstance::handle_get_request(nsdl_s *nsdl,
                 if (is_content_type_supported) {
                     if (!content_type_present &&
                             (M2MBase::coap_content_type() == COAP_CONTENT_OMA_TLV_TYPE ||
+#if MBED_CLIENT_SENML_CBOR
+                             M2MBase::coap_content_type() == COAP_CONTENT_OMA_SENML_CBOR_TYPE ||
+#endif
                              M2MBase::coap_content_type() == COAP_CONTENT_OMA_TLV_TYPE_OLD)) {
                         coap_response->content_format = sn_coap_content_format_e(M2MBase::coap_content_type());
                     }
@@ -514,8 +522,32 @@ sn_coap_hdr_s *M2MObjectInstance::handle_get_request(nsdl_s *nsdl,
                     if (COAP_CONTENT_OMA_TLV_TYPE == coap_response->content_format  ||
                             COAP_CONTENT_OMA_TLV_TYPE_OLD == coap_response->content_format) {
                         set_coap_content_type(coap_response->content_format);
-                        data = M2MTLVSerializer::serialize(_resource_list, data_length);
+                        if (received_coap_header->options_list_ptr &&
+                                received_coap_header->options_list_ptr->observe != -1) {
+                            data = M2MTLVSerializer::serialize(_resource_list, data_length);
+                        } else {
+                            // Serialize only the requested block, so that the whole payload is not kept for the blockwise transfer
+                            uint32_t total_size = 0;
+                            uint32_t offset = 0;
+                            M2MTLVSerializer::serialize(_resource_list, 0, NULL, 0, total_size);
+                            if (set_response_block(nsdl, *received_coap_header, *coap_response, total_size, offset, data_length)) {
+                                data = data_length ? (uint8_t *)malloc(data_length) : NULL;
+                                if (data) {
+                                    M2MTLVSerializer::serialize(_resource_list, offset, data, data_length, total_size);
+                                } else {
+                                    data_length = 0;
+                                }
+                            } else {
+                                msg_code = COAP_MSG_CODE_RESPONSE_BAD_OPTION;
+                            }
+                        }
                     }
+#if MBED_CLIENT_SENML_CBOR
+                    else if (COAP_CONTENT_OMA_SENML_CBOR_TYPE == coap_response->content_format) {
+                        set_coap_content_type(coap_response->content_format);
+                        data = M2MSenMLCBORSerializer::serialize(*this, data_length);
+                    }
+#endif
 
                     coap_response->payload_len = data_length;
                     coap_response->payload_ptr = data;
@@ -531,7 +563,7 @@ sn_coap_hdr_s *M2MObjectInstance::handle_get_request(nsdl_s *nsdl,
                                 handle_observation(nsdl, *received_coap_header, *coap_response, observation_handler, msg_code);
                             }
                         }
-                    } else {
+                    } else if (msg_code != COAP_MSG_CODE_RESPONSE_BAD_OPTION) {
                         msg_code = COAP_MSG_CODE_RESPONSE_UNSUPPORTED_CONTENT_FORMAT; // Content format not supported
                     }
                 } else {
@@ -596,6 +628,9 @@ sn_coap_hdr_s *M2MObjectInstance::handle_put_request(nsdl_s *nsdl,
         } else if ((operation() & M2MBase::PUT_ALLOWED) != 0) {
             if (!content_type_present &&
                     (M2MBase::coap_content_type() == COAP_CONTENT_OMA_TLV_TYPE ||
+#if MBED_CLIENT_SENML_CBOR
+                     M2MBase::coap_content_type() == COAP_CONTENT_OMA_SENML_CBOR_TYPE ||
+#endif
                      M2MBase::coap_content_type() == COAP_CONTENT_OMA_TLV_TYPE_OLD)) {
                 coap_content_type = M2MBase::coap_content_type();
             }
@@ -603,14 +638,27 @@ sn_coap_hdr_s *M2MObjectInstance::handle_put_request(nsdl_s *nsdl,
             tr_debug("M2MObjectInstance::handle_put_request() - Request Content-type: %d", coap_content_type);
 
             if (COAP_CONTENT_OMA_TLV_TYPE == coap_content_type ||
+#if MBED_CLIENT_SENML_CBOR
+                    COAP_CONTENT_OMA_SENML_CBOR_TYPE == coap_content_type ||
+#endif
                     COAP_CONTENT_OMA_TLV_TYPE_OLD == coap_content_type) {
                 set_coap_content_type(coap_content_type);
                 M2MTLVDeserializer::Error error = M2MTLVDeserializer::None;
                 if (received_coap_header->payload_ptr) {
-                    error = M2MTLVDeserializer::deserialize_resources(
-                                received_coap_header->payload_ptr,
-                                received_coap_header->payload_len, *this,
-                                M2MTLVDeserializer::Put);
+#if MBED_CLIENT_SENML_CBOR
+                    if (COAP_CONTENT_OMA_SENML_CBOR_TYPE == coap_content_type) {
+                        error = M2MSenMLCBORDeserializer::deserialize_resources(
+                                    received_coap_header->payload_ptr,
+                                    received_coap_header->payload_len, *this,
+                                    M2MTLVDeserializer::Put);
+                    } else
+#endif
+                    {
+                        error = M2MTLVDeserializer::deserialize_resources(
+                                    received_coap_header->payload_ptr,
+                                    received_coap_header->payload_len, *this,
+                                    M2MTLVDeserializer::Put);
+                    }
                     switch (error) {
                         case M2MTLVDeserializer::None:
                             if (observation_handler) {
@@ -630,6 +678,9 @@ sn_coap_hdr_s *M2MObjectInstance::handle_put_request(nsdl_s *nsdl,
                         case M2MTLVDeserializer::OutOfMemory:
                             msg_code = COAP_MSG_CODE_RESPONSE_REQUEST_ENTITY_TOO_LARGE;
                             break;
+                        case M2MTLVDeserializer::NotAccepted:
+                            msg_code = COAP_MSG_CODE_RESPONSE_NOT_ACCEPTABLE;
+                            break;
                     }
                 }
             } else {
@@ -673,6 +724,9 @@ sn_coap_hdr_s *M2MObjectInstance::handle_post_request(nsdl_s *nsdl,
             }
             if (!content_type_present &&
                     (M2MBase::coap_content_type() == COAP_CONTENT_OMA_TLV_TYPE ||
+#if MBED_CLIENT_SENML_CBOR
+                     M2MBase::coap_content_type() == COAP_CONTENT_OMA_SENML_CBOR_TYPE ||
+#endif
                      M2MBase::coap_content_type() == COAP_CONTENT_OMA_TLV_TYPE_OLD)) {
                 coap_content_type = M2MBase::coap_content_type();
             }
@@ -680,13 +734,26 @@ sn_coap_hdr_s *M2MObjectInstance::handle_post_request(nsdl_s *nsdl,
             tr_debug("M2MObjectInstance::handle_post_request() - Request Content-type: %d", coap_content_type);
 
             if (COAP_CONTENT_OMA_TLV_TYPE == coap_content_type ||
+#if MBED_CLIENT_SENML_CBOR
+                    COAP_CONTENT_OMA_SENML_CBOR_TYPE == coap_content_type ||
+#endif
                     COAP_CONTENT_OMA_TLV_TYPE_OLD == coap_content_type) {
                 set_coap_content_type(coap_content_type);
                 M2MTLVDeserializer::Error error = M2MTLVDeserializer::None;
-                error = M2MTLVDeserializer::deserialize_resources(
-                            received_coap_header->payload_ptr,
-                            received_coap_header->payload_len, *this,
-                            M2MTLVDeserializer::Post);
+#if MBED_CLIENT_SENML_CBOR
+                if (COAP_CONTENT_OMA_SENML_CBOR_TYPE == coap_content_type) {
+                    error = M2MSenMLCBORDeserializer::deserialize_resources(
+                                received_coap_header->payload_ptr,
+                                received_coap_header->payload_len, *this,
+                                M2MTLVDeserializer::Post);
+                } else
+#endif
+                {
+                    error = M2MTLVDeserializer::deserialize_resources(
+                                received_coap_header->payload_ptr,
+                                received_coap_header->payload_len, *this,
+                                M2MTLVDeserializer::Post);
+                }
 
                 switch (error) {
                     case M2MTLVDeserializer::None:
@@ -697,7 +764,17 @@ sn_coap_hdr_s *M2MObjectInstance::handle_post_request(nsdl_s *nsdl,
 
                         if (coap_response->options_list_ptr) {
 
-                            uint16_t instance_id = M2MTLVDeserializer::instance_id(received_coap_header->payload_ptr);
+                            uint16_t instance_id = 0;
+#if MBED_CLIENT_SENML_CBOR
+                            if (COAP_CONTENT_OMA_SENML_CBOR_TYPE == coap_content_type) {
+                                M2MSenMLCBORDeserializer::instance_id(received_coap_header->payload_ptr,
+                                                                      received_coap_header->payload_len,
+                                                                      *this, instance_id);
+                            } else
+#endif
+                            {
+                                instance_id = M2MTLVDeserializer::instance_id(received_coap_header->payload_ptr);
+                            }
                             StringBuffer<MAX_PATH_SIZE_3> obj_name;
                             if (!build_path(obj_name, _parent.name(), M2MBase::instance_id(), instance_id)) {
                                 msg_code = COAP_MSG_CODE_RESPONSE_INTERNAL_SERVER_ERROR;
@@ -31,11 +31,15 @@
 #include "mbed-client/m2mtimer.h"
 #include "include/m2mreporthandler.h"
 #include "mbed-trace/mbed_trace.h"
+#include "eventOS_scheduler.h"
 #include <string.h>
 #include <stdlib.h>
 
 #define TRACE_GROUP "mClt"
 
+M2MReportHandler *M2MReportHandler::_pending_head = NULL;
+M2MReportHandler *M2MReportHandler::_pending_tail = NULL;
+
 M2MReportHandler::M2MReportHandler(M2MReportObserver &observer, M2MBase::DataType type)
     : _observer(observer),
       _is_under_observation(false),
@@ -72,7 +76,13 @@ M2MReportHandler::M2MReportHandler(M2MReportObserver &observer, M2MBase::DataTyp
 #endif
       _waiting_to_report(false),
       _confirmable(true),
-      _resource_base(NULL)
+      _resource_base(NULL),
+#if MBED_CLIENT_NOTIFICATION_COALESCING_WINDOW > 0
+      _coalescing_timer(*this),
+      _coalescing(false),
+#endif
+      _pending_next(NULL),
+      _pending_prev(NULL)
 {
     tr_debug("M2MReportHandler::M2MReportHandler()");
 #if defined (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS) && (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS == 1)
@@ -93,6 +103,9 @@ M2MReportHandler::M2MReportHandler(M2MReportObserver &observer, M2MBase::DataTyp
 M2MReportHandler::~M2MReportHandler()
 {
     tr_debug("M2MReportHandler::~M2MReportHandler()");
+    _notification_in_queue = false;
+    _notification_send_in_progress = false;
+    update_pending_notification();
     free(_token);
 }
 
@@ -246,10 +259,14 @@ bool M2MReportHandler::parse_notification_attribute(const char *query,
 
     return success;
 }
+#endif
 
+#if (defined (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS) && (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS == 1)) || \
+    (MBED_CLIENT_NOTIFICATION_COALESCING_WINDOW > 0)
 void M2MReportHandler::timer_expired(M2MTimerObserver::Type type)
 {
     switch (type) {
+#if defined (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS) && (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS == 1)
         case M2MTimerObserver::PMinTimer: {
             tr_debug("M2MReportHandler::timer_expired - PMIN");
 
@@ -280,10 +297,25 @@ void M2MReportHandler::timer_expired(M2MTimerObserver::Type type)
             }
         }
         break;
+#endif
+#if MBED_CLIENT_NOTIFICATION_COALESCING_WINDOW > 0
+        case M2MTimerObserver::NotificationCoalescing: {
+            tr_debug("M2MReportHandler::timer_expired - COALESCING");
+            _coalescing = false;
+            // Nothing to do if pmax already sent the changes of the window
+            if (_notify) {
+                report();
+            }
+        }
+        break;
+#endif
         default:
             break;
     }
 }
+#endif
+
+#if defined (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS) && (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS == 1)
 
 bool M2MReportHandler::set_notification_attribute(const char *option,
                                                   M2MBase::BaseType type,
@@ -372,15 +404,28 @@ void M2MReportHandler::schedule_report(bool in_queue)
     tr_debug("M2MReportHandler::schedule_report()");
     _notify = true;
 #if defined (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS) && (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS == 1)
-    if ((_attribute_state & M2MReportHandler::Pmin) != M2MReportHandler::Pmin ||
-            _pmin_exceeded ||
-            _pmin_quiet_period) {
-        report(in_queue);
+    if ((_attribute_state & M2MReportHandler::Pmin) == M2MReportHandler::Pmin &&
+            !_pmin_exceeded &&
+            !_pmin_quiet_period) {
+        // Reported once the pmin timer fires
+        return;
     }
-#else
-    report(in_queue);
 #endif
-
+#if MBED_CLIENT_NOTIFICATION_COALESCING_WINDOW > 0
+    // Changes made while the window is open are sent when it closes, also when the queue
+    // is drained meanwhile. Queued notifications are sent right away, new changes open the window.
+    if (_coalescing) {
+        return;
+    }
+    if (!in_queue) {
+        _coalescing = true;
+        _coalescing_timer.start_timer(MBED_CLIENT_NOTIFICATION_COALESCING_WINDOW,
+                                      M2MTimerObserver::NotificationCoalescing,
+                                      true);
+        return;
+    }
+#endif
+    report(in_queue);
 }
 
 void M2MReportHandler::report(bool in_queue)
@@ -564,6 +609,11 @@ void M2MReportHandler::set_default_values()
     _changed_instance_ids.clear();
     _notification_in_queue = false;
     _notification_send_in_progress = false;
+    update_pending_notification();
+#if MBED_CLIENT_NOTIFICATION_COALESCING_WINDOW > 0
+    _coalescing_timer.stop_timer();
+    _coalescing = false;
+#endif
 #if defined (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS) && (MBED_CONF_MBED_CLIENT_ENABLE_OBSERVATION_PARAMETERS == 1)
     _pmin_quiet_period = false;
     if (_resource_type == M2MBase::FLOAT) {
@@ -792,6 +842,7 @@ uint8_t *M2MReportHandler::alloc_copy(const uint8_t *source, uint32_t size)
 void M2MReportHandler::set_notification_in_queue(bool to_queue)
 {
     _notification_in_queue = to_queue;
+    update_pending_notification();
 }
 
 bool M2MReportHandler::notification_in_queue() const
@@ -802,6 +853,7 @@ bool M2MReportHandler::notification_in_queue() const
 void M2MReportHandler::set_notification_send_in_progress(bool progress)
 {
     _notification_send_in_progress = progress;
+    update_pending_notification();
 }
 
 bool M2MReportHandler::notification_send_in_progress() const
@@ -864,3 +916,69 @@ bool M2MReportHandler::is_confirmable() const
 {
     return _confirmable;
 }
+
+M2MReportHandler *M2MReportHandler::first_pending_notification()
+{
+    return _pending_head;
+}
+
+M2MReportHandler *M2MReportHandler::next_pending_notification() const
+{
+    return _pending_next;
+}
+
+M2MReportHandler *M2MReportHandler::first_notification_to_send()
+{
+    M2MReportHandler *reporter = _pending_head;
+    for (; reporter; reporter = reporter->_pending_next) {
+        if (reporter->_is_under_observation && !reporter->notification_coalescing()) {
+            break;
+        }
+    }
+    return reporter;
+}
+
+bool M2MReportHandler::notification_coalescing() const
+{
+#if MBED_CLIENT_NOTIFICATION_COALESCING_WINDOW > 0
+    return _coalescing;
+#else
+    return false;
+#endif
+}
+
+void M2MReportHandler::update_pending_notification()
+{
+    const bool pending = _notification_in_queue || _notification_send_in_progress;
+
+    // Value setters run in application context, the drain runs in the event loop. The list is
+    // shared, so relink it under the scheduler mutex, which is what M2MNsdlInterface::claim_mutex() takes.
+    eventOS_scheduler_mutex_wait();
+    const bool queued = (_pending_head == this) || (_pending_prev != NULL);
+
+    if (pending && !queued) {
+        // Append to the end so that notifications are drained in the order they became pending
+        _pending_next = NULL;
+        _pending_prev = _pending_tail;
+        if (_pending_tail) {
+            _pending_tail->_pending_next = this;
+        } else {
+            _pending_head = this;
+        }
+        _pending_tail = this;
+    } else if (!pending && queued) {
+        if (_pending_prev) {
+            _pending_prev->_pending_next = _pending_next;
+        } else {
+            _pending_head = _pending_next;
+        }
+        if (_pending_next) {
+            _pending_next->_pending_prev = _pending_prev;
+        } else {
+            _pending_tail = _pending_prev;
+        }
+        _pending_next = NULL;
+        _pending_prev = NULL;
+    }
+    eventOS_scheduler_mutex_release();
+}
@@ -19,6 +19,8 @@
 #include "include/m2mreporthandler.h"
 #include "include/m2mtlvserializer.h"
 #include "include/m2mtlvdeserializer.h"
+#include "include/m2msenmlcborserializer.h"
+#include "include/m2msenmlcbordeserializer.h"
 #include "mbed-trace/mbed_trace.h"
 
 #include <stdlib.h>
@@ -339,6 +341,9 @@ sn_coap_hdr_s* M2MResource::handle_get_request(nsdl_s *nsdl,
                     // Check if preferred content type is supported
                     if (content_type_present) {
                         if (coap_response->content_format != COAP_CONTENT_OMA_TLV_TYPE_OLD &&
+#if MBED_CLIENT_SENML_CBOR
+                            coap_response->content_format != COAP_CONTENT_OMA_SENML_CBOR_TYPE &&
+#endif
                             coap_response->content_format != COAP_CONTENT_OMA_TLV_TYPE) {
                             is_content_type_supported = false;
                         }
@@ -347,6 +352,9 @@ sn_coap_hdr_s* M2MResource::handle_get_request(nsdl_s *nsdl,
                     if (is_content_type_supported) {
                         if(!content_type_present &&
                            (M2MBase::coap_content_type() == COAP_CONTENT_OMA_TLV_TYPE ||
+#if MBED_CLIENT_SENML_CBOR
+                            M2MBase::coap_content_type() == COAP_CONTENT_OMA_SENML_CBOR_TYPE ||
+#endif
                             M2MBase::coap_content_type() == COAP_CONTENT_OMA_TLV_TYPE_OLD)) {
                             coap_response->content_format = sn_coap_content_format_e(M2MBase::coap_content_type());
                         }
@@ -359,8 +367,32 @@ sn_coap_hdr_s* M2MResource::handle_get_request(nsdl_s *nsdl,
                         if(COAP_CONTENT_OMA_TLV_TYPE == coap_response->content_format ||
                            COAP_CONTENT_OMA_TLV_TYPE_OLD == coap_response->content_format) {
                             set_coap_content_type(coap_response->content_format);
-                            data = M2MTLVSerializer::serialize(this, data_length);
+                            if (received_coap_header->options_list_ptr &&
+                                    received_coap_header->options_list_ptr->observe != -1) {
+                                data = M2MTLVSerializer::serialize(this, data_length);
+                            } else {
+                                // Serialize only the requested block, so that the whole payload is not kept for the blockwise transfer
+                                uint32_t total_size = 0;
+                                uint32_t offset = 0;
+                                M2MTLVSerializer::serialize(this, 0, NULL, 0, total_size);
+                                if (set_response_block(nsdl, *received_coap_header, *coap_response, total_size, offset, data_length)) {
+                                    data = data_length ? (uint8_t *)malloc(data_length) : NULL;
+                                    if (data) {
+                                        M2MTLVSerializer::serialize(this, offset, data, data_length, total_size);
+                                    } else {
+                                        data_length = 0;
+                                    }
+                                } else {
+                                    msg_code = COAP_MSG_CODE_RESPONSE_BAD_OPTION;
+                                }
+                            }
                         }
+#if MBED_CLIENT_SENML_CBOR
+                        else if (COAP_CONTENT_OMA_SENML_CBOR_TYPE == coap_response->content_format) {
+                            set_coap_content_type(coap_response->content_format);
+                            data = M2MSenMLCBORSerializer::serialize(*this, data_length);
+                        }
+#endif
 
                         coap_response->payload_len = data_length;
                         coap_response->payload_ptr = data;
@@ -407,6 +439,9 @@ sn_coap_hdr_s* M2MResource::handle_put_request(nsdl_s *nsdl,
     sn_coap_hdr_s * coap_response = NULL;
     if (supports_multiple_instances() ||
         (received_coap_header->content_format == COAP_CONTENT_OMA_TLV_TYPE ||
+#if MBED_CLIENT_SENML_CBOR
+         received_coap_header->content_format == COAP_CONTENT_OMA_SENML_CBOR_TYPE ||
+#endif
          received_coap_header->content_format == COAP_CONTENT_OMA_TLV_TYPE_OLD)) {
         coap_response = sn_nsdl_build_response(nsdl,
                                                received_coap_header,
@@ -443,12 +478,34 @@ sn_coap_hdr_s* M2MResource::handle_put_request(nsdl_s *nsdl,
                     M2MBase::coap_content_type() == COAP_CONTENT_OMA_TLV_TYPE_OLD)) {
                     coap_content_type = COAP_CONTENT_OMA_TLV_TYPE;
                 }
+#if MBED_CLIENT_SENML_CBOR
+                else if (!content_type_present &&
+                         M2MBase::coap_content_type() == COAP_CONTENT_OMA_SENML_CBOR_TYPE) {
+                    coap_content_type = COAP_CONTENT_OMA_SENML_CBOR_TYPE;
+                }
+#endif
 
                 tr_debug("M2MResource::handle_put_request() - Request Content-type: %d", coap_content_type);
 
-                if (COAP_CONTENT_OMA_TLV_TYPE == coap_content_type || COAP_CONTENT_OMA_TLV_TYPE_OLD == coap_content_type) {
+                if (COAP_CONTENT_OMA_TLV_TYPE == coap_content_type ||
+#if MBED_CLIENT_SENML_CBOR
+                    COAP_CONTENT_OMA_SENML_CBOR_TYPE == coap_content_type ||
+#endif
+                    COAP_CONTENT_OMA_TLV_TYPE_OLD == coap_content_type) {
                     set_coap_content_type(coap_content_type);
                     M2MTLVDeserializer::Error error = M2MTLVDeserializer::None;
+#if MBED_CLIENT_SENML_CBOR
+                    if (COAP_CONTENT_OMA_SENML_CBOR_TYPE == coap_content_type) {
+                        if ((strcmp(uri_path(), FIRMWARE_PACKAGE_URI_PATH) == 0) && received_coap_header->payload_len > MAX_FIRMWARE_PACKAGE_URI_PATH_LEN) {
+                            // Firmware object uri path is limited to be max MAX_FIRMWARE_PACKAGE_URI_PATH_LEN bytes
+                            error = M2MTLVDeserializer::NotAccepted;
+                        } else {
+                            error = M2MSenMLCBORDeserializer::deserialize_resource(received_coap_header->payload_ptr,
+                                                                                   received_coap_header->payload_len,
+                                                                                   *this);
+                        }
+                    } else
+#endif
                     if (supports_multiple_instances()) {
                         error = M2MTLVDeserializer::deserialize_resource_instances(received_coap_header->payload_ptr,
                                                                          received_coap_header->payload_len,
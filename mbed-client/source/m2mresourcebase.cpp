@@ -34,6 +34,7 @@
 #include "include/m2mreporthandler.h"
 #include "include/nsdllinker.h"
 #include "include/m2mtlvserializer.h"
+#include "include/m2msenmlcborserializer.h"
 #include "mbed-client/m2mblockmessage.h"
 #include "mbed-trace/mbed_trace.h"
 #include "sn_grs.h"
@@ -49,6 +50,15 @@
 // (space needed for -3.402823 × 10^38) + (magic decimal 6 digits added as no precision is added to "%f") + trailing zero
 #define REGISTRY_FLOAT_STRING_MAX_LEN 48
 
+static uint32_t float_to_string(float value, char *buffer)
+{
+    /* write the float value to a decimal number string */
+#if MBED_MINIMAL_PRINTF
+    return snprintf(buffer, REGISTRY_FLOAT_STRING_MAX_LEN, "%f", value);
+#else
+    return snprintf(buffer, REGISTRY_FLOAT_STRING_MAX_LEN, "%e", value);
+#endif
+}
 
 
 M2MResourceBase::M2MResourceBase(
@@ -214,6 +224,10 @@ void M2MResourceBase::clear_value()
     free(res->resource);
     res->resource = NULL;
     res->resource_len = 0;
+#if MBED_CLIENT_TYPED_VALUE_STORAGE
+    _typed_value.valid = false;
+    _typed_value.text_stale = false;
+#endif
 
     report();
 }
@@ -223,14 +237,19 @@ bool M2MResourceBase::set_value_float(float value)
     bool success;
     char buffer[REGISTRY_FLOAT_STRING_MAX_LEN];
 
-    // Convert value to string
-    /* write the float value to a decimal number string and copy it into a buffer allocated for caller */
-#if MBED_MINIMAL_PRINTF
-    uint32_t size = snprintf(buffer, REGISTRY_FLOAT_STRING_MAX_LEN, "%f", value);
-#else
-    uint32_t size = snprintf(buffer, REGISTRY_FLOAT_STRING_MAX_LEN, "%e", value);
+#if MBED_CLIENT_TYPED_VALUE_STORAGE
+    if (can_store_typed_value(true)) {
+        // get_value_float() also caches a value that was set as text
+        const bool changed = (get_value_float() != value) || !_typed_value.valid;
+        _typed_value.float_value = value;
+        update_typed_value(changed);
+        return true;
+    }
 #endif
 
+    // Convert value to string
+    uint32_t size = float_to_string(value, buffer);
+
     success = set_value((const uint8_t *)buffer, size);
 
     return success;
@@ -240,6 +259,17 @@ bool M2MResourceBase::set_value(int64_t value)
 {
     bool success;
     char buffer[REGISTRY_INT64_STRING_MAX_LEN];
+
+#if MBED_CLIENT_TYPED_VALUE_STORAGE
+    if (can_store_typed_value(false)) {
+        // get_value_int() also caches a value that was set as text
+        const bool changed = (get_value_int() != value) || !_typed_value.valid;
+        _typed_value.int_value = value;
+        update_typed_value(changed);
+        return true;
+    }
+#endif
+
     uint32_t size = m2m::itoa_c(value, buffer);
 
     success = set_value((const uint8_t *)buffer, size);
@@ -297,11 +327,86 @@ void M2MResourceBase::update_value(uint8_t *value, const uint32_t value_length)
     free(res->resource);
     res->resource = value;
     res->resource_len = value_length;
+#if MBED_CLIENT_TYPED_VALUE_STORAGE
+    _typed_value.valid = false;
+    _typed_value.text_stale = false;
+#endif
     if (changed) {
         report_value_change();
     }
 }
 
+#if MBED_CLIENT_TYPED_VALUE_STORAGE
+bool M2MResourceBase::can_store_typed_value(bool float_value) const
+{
+    const M2MResourceBase::ResourceType type = resource_instance_type();
+    if (float_value) {
+        if (type != M2MResourceBase::FLOAT) {
+            return false;
+        }
+    } else if (type != M2MResourceBase::INTEGER &&
+               type != M2MResourceBase::BOOLEAN &&
+               type != M2MResourceBase::TIME) {
+        return false;
+    }
+
+    // Static resources and values published in registration are read as text by mbed-client-c
+    if (mode() != M2MBase::Dynamic || get_nsdl_resource()->publish_value > 0) {
+        return false;
+    }
+
+    // Values stored by the application, or passed to its value set callback, stay as text
+    if (M2MBase::get_lwm2m_parameters()->read_write_callback_set ||
+            M2MCallbackStorage::get_callback(*this, M2MCallbackAssociation::M2MResourceBaseValueSetCallback)) {
+        return false;
+    }
+
+    return true;
+}
+
+void M2MResourceBase::update_typed_value(bool changed)
+{
+    // An unchanged value keeps its text, if there is any
+    if (!changed) {
+        return;
+    }
+
+    // The old text is outdated, it is rendered again only if it is read
+    sn_nsdl_dynamic_resource_parameters_s *res = get_nsdl_resource();
+    free(res->resource);
+    res->resource = NULL;
+    res->resource_len = 0;
+    _typed_value.valid = true;
+    _typed_value.text_stale = true;
+
+    report_value_change();
+}
+
+void M2MResourceBase::render_typed_value() const
+{
+    if (!_typed_value.text_stale) {
+        return;
+    }
+
+    char buffer[REGISTRY_FLOAT_STRING_MAX_LEN];
+    uint32_t size;
+    if (resource_instance_type() == M2MResourceBase::FLOAT) {
+        size = float_to_string(_typed_value.float_value, buffer);
+    } else {
+        size = m2m::itoa_c(_typed_value.int_value, buffer);
+    }
+
+    uint8_t *text = alloc_string_copy((const uint8_t *)buffer, size);
+    if (text) {
+        sn_nsdl_dynamic_resource_parameters_s *res = get_nsdl_resource();
+        free(res->resource);
+        res->resource = text;
+        res->resource_len = size;
+        _typed_value.text_stale = false;
+    }
+}
+#endif
+
 void M2MResourceBase::report_to_parents()
 {
     M2MBase::Observation observation_level = M2MBase::observation_level();
@@ -392,6 +497,10 @@ bool M2MResourceBase::has_value_changed(const uint8_t *value, const uint32_t val
     bool changed = false;
     sn_nsdl_dynamic_resource_parameters_s *res = get_nsdl_resource();
 
+#if MBED_CLIENT_TYPED_VALUE_STORAGE
+    render_typed_value();
+#endif
+
     if (value_len != res->resource_len) {
         changed = true;
     } else if (value && !res->resource) {
@@ -501,6 +610,10 @@ void M2MResourceBase::get_value(uint8_t *&value, uint32_t &value_length)
         value = NULL;
     }
 
+#if MBED_CLIENT_TYPED_VALUE_STORAGE
+    render_typed_value();
+#endif
+
     sn_nsdl_dynamic_resource_parameters_s *res = get_nsdl_resource();
     if (res->resource && res->resource_len > 0) {
         value = alloc_string_copy(res->resource, res->resource_len);
@@ -514,6 +627,13 @@ int64_t M2MResourceBase::get_value_int() const
 {
     int64_t value_int = 0;
 
+#if MBED_CLIENT_TYPED_VALUE_STORAGE
+    const bool int_type = (resource_instance_type() != M2MResourceBase::FLOAT);
+    if (_typed_value.valid && int_type) {
+        return _typed_value.int_value;
+    }
+#endif
+
     const char *value_string = (char *)value();
     const uint32_t value_len = value_length();
 
@@ -532,6 +652,13 @@ int64_t M2MResourceBase::get_value_int() const
             // is behind the selection of log level
             tr_warn("M2MResourceBase::get_value_int(): conversion failed");
         }
+#if MBED_CLIENT_TYPED_VALUE_STORAGE
+        else if (int_type) {
+            // Later reads and threshold checks do not need to parse the text again
+            _typed_value.int_value = value_int;
+            _typed_value.valid = true;
+        }
+#endif
     }
     return value_int;
 }
@@ -540,6 +667,9 @@ String M2MResourceBase::get_value_string() const
 {
     // XXX: do a better constructor to avoid pointless malloc
     String value;
+#if MBED_CLIENT_TYPED_VALUE_STORAGE
+    render_typed_value();
+#endif
     if (get_nsdl_resource()->resource) {
         value.append_raw((char *)get_nsdl_resource()->resource, get_nsdl_resource()->resource_len);
     }
@@ -550,6 +680,13 @@ float M2MResourceBase::get_value_float() const
 {
     float value_float = 0;
 
+#if MBED_CLIENT_TYPED_VALUE_STORAGE
+    const bool float_type = (resource_instance_type() == M2MResourceBase::FLOAT);
+    if (_typed_value.valid && float_type) {
+        return _typed_value.float_value;
+    }
+#endif
+
     const char *value_string = (char *)value();
     const uint32_t value_len = value_length();
 
@@ -563,6 +700,12 @@ float M2MResourceBase::get_value_float() const
         temp[value_len] = 0;
 
         value_float = atof(temp);
+#if MBED_CLIENT_TYPED_VALUE_STORAGE
+        if (float_type) {
+            _typed_value.float_value = value_float;
+            _typed_value.valid = true;
+        }
+#endif
     }
 
     return value_float;
@@ -570,11 +713,17 @@ float M2MResourceBase::get_value_float() const
 
 uint8_t *M2MResourceBase::value() const
 {
+#if MBED_CLIENT_TYPED_VALUE_STORAGE
+    render_typed_value();
+#endif
     return get_nsdl_resource()->resource;
 }
 
 uint32_t M2MResourceBase::value_length() const
 {
+#if MBED_CLIENT_TYPED_VALUE_STORAGE
+    render_typed_value();
+#endif
     return get_nsdl_resource()->resource_len;
 }
 
@@ -607,6 +756,9 @@ sn_coap_hdr_s *M2MResourceBase::handle_get_request(nsdl_s *nsdl,
             if ((received_coap_header->options_list_ptr->accept == COAP_CONTENT_OMA_OPAQUE_TYPE) ||
                 (received_coap_header->options_list_ptr->accept == COAP_CONTENT_OMA_PLAIN_TEXT_TYPE) ||
                 (received_coap_header->options_list_ptr->accept == COAP_CONTENT_OMA_TLV_TYPE_OLD) ||
+#if MBED_CLIENT_SENML_CBOR
+                (received_coap_header->options_list_ptr->accept == COAP_CONTENT_OMA_SENML_CBOR_TYPE) ||
+#endif
                 (received_coap_header->options_list_ptr->accept == COAP_CONTENT_OMA_TLV_TYPE)) {
                 coap_response->content_format = received_coap_header->options_list_ptr->accept;
                 set_coap_content_type(coap_response->content_format);
@@ -654,7 +806,13 @@ sn_coap_hdr_s *M2MResourceBase::handle_get_request(nsdl_s *nsdl,
             if (coap_response->content_format == COAP_CONTENT_OMA_TLV_TYPE ||
                     coap_response->content_format == COAP_CONTENT_OMA_TLV_TYPE_OLD) {
                 coap_response->payload_ptr = M2MTLVSerializer::serialize(&get_parent_resource(), payload_len);
-            } else {
+            }
+#if MBED_CLIENT_SENML_CBOR
+            else if (coap_response->content_format == COAP_CONTENT_OMA_SENML_CBOR_TYPE) {
+                coap_response->payload_ptr = M2MSenMLCBORSerializer::serialize(*this, payload_len);
+            }
+#endif
+            else {
                 get_value(coap_response->payload_ptr, (uint32_t &)payload_len);
             }
         }
@@ -896,6 +1054,10 @@ void M2MResourceBase::publish_value_in_registration_msg(bool publish_value)
         pub_value = (uint8_t)publish_value;
     }
     param->dynamic_resource_params->publish_value = pub_value;
+#if MBED_CLIENT_TYPED_VALUE_STORAGE
+    // Registration message reads the text directly
+    render_typed_value();
+#endif
 }
 
 void M2MResourceBase::read_data_from_application(M2MCallbackAssociation *item,
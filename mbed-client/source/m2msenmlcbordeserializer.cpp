@@ -0,0 +1,488 @@
+/*
+ * Copyright (c) 2020 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "include/m2msenmlcbordeserializer.h"
+
+#if MBED_CLIENT_SENML_CBOR
+
+#include "mbed-client/m2mconstants.h"
+#include "mbed-client/m2mresourceinstance.h"
+#include "mbed-trace/mbed_trace.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define TRACE_GROUP "mClt"
+
+// Internal label for the text label SENML_OBJLNK_VALUE, outside of the integer label range in use
+#define SENML_LABEL_OBJLNK_VALUE 0x100
+
+M2MTLVDeserializer::Error M2MSenMLCBORDeserializer::deserialize_object_instances(const uint8_t *cbor,
+                                                                                 uint32_t cbor_size,
+                                                                                 M2MObject &object,
+                                                                                 M2MTLVDeserializer::Operation operation)
+{
+    tr_debug("M2MSenMLCBORDeserializer::deserialize_object_instances()");
+    // Validate the whole payload first, so that a failing record does not leave a partial update behind
+    M2MTLVDeserializer::Error error = deserialize(cbor, cbor_size, object, operation, false);
+    if (error == M2MTLVDeserializer::None) {
+        error = deserialize(cbor, cbor_size, object, operation, true);
+    }
+    return error;
+}
+
+M2MTLVDeserializer::Error M2MSenMLCBORDeserializer::deserialize_resources(const uint8_t *cbor,
+                                                                          uint32_t cbor_size,
+                                                                          M2MObjectInstance &object_instance,
+                                                                          M2MTLVDeserializer::Operation operation)
+{
+    tr_debug("M2MSenMLCBORDeserializer::deserialize_resources()");
+    M2MTLVDeserializer::Error error = deserialize(cbor, cbor_size, object_instance, operation, false);
+    if (error == M2MTLVDeserializer::None) {
+        error = deserialize(cbor, cbor_size, object_instance, operation, true);
+    }
+    return error;
+}
+
+M2MTLVDeserializer::Error M2MSenMLCBORDeserializer::deserialize_resource(const uint8_t *cbor,
+                                                                         uint32_t cbor_size,
+                                                                         M2MResource &resource)
+{
+    tr_debug("M2MSenMLCBORDeserializer::deserialize_resource()");
+    M2MTLVDeserializer::Error error = deserialize(cbor, cbor_size, resource, M2MTLVDeserializer::Put, false);
+    if (error == M2MTLVDeserializer::None) {
+        error = deserialize(cbor, cbor_size, resource, M2MTLVDeserializer::Put, true);
+    }
+    return error;
+}
+
+bool M2MSenMLCBORDeserializer::instance_id(const uint8_t *cbor, uint32_t cbor_size, const M2MBase &target, uint16_t &id)
+{
+    CborParser parser;
+    CborValue array;
+    CborValue record;
+    CborValue value;
+    int value_label = -1;
+    char base_name[M2MBase::MAX_PATH_SIZE];
+    char full_name[M2MBase::MAX_PATH_SIZE];
+    base_name[0] = '\0';
+    if (!enter_records(cbor, cbor_size, parser, array, record) || cbor_value_at_end(&record) ||
+            !read_record(record, base_name, full_name, value, value_label)) {
+        return false;
+    }
+    const char *name = relative_name(target, full_name);
+    return name && read_id(name, id);
+}
+
+M2MTLVDeserializer::Error M2MSenMLCBORDeserializer::deserialize(const uint8_t *cbor,
+                                                                uint32_t cbor_size,
+                                                                M2MBase &target,
+                                                                M2MTLVDeserializer::Operation operation,
+                                                                bool update_value)
+{
+    CborParser parser;
+    CborValue array;
+    CborValue record;
+    if (!enter_records(cbor, cbor_size, parser, array, record)) {
+        return M2MTLVDeserializer::NotValid;
+    }
+
+    // Base name applies to all the following records until a new one is given
+    char base_name[M2MBase::MAX_PATH_SIZE];
+    base_name[0] = '\0';
+
+    while (!cbor_value_at_end(&record)) {
+        char full_name[M2MBase::MAX_PATH_SIZE];
+        CborValue value;
+        int value_label = -1;
+        if (!read_record(record, base_name, full_name, value, value_label)) {
+            return M2MTLVDeserializer::NotValid;
+        }
+
+        M2MTLVDeserializer::Error error = M2MTLVDeserializer::None;
+        M2MResourceBase *resource = find_resource(target, full_name, value_label, value, operation, update_value, error);
+        if (error != M2MTLVDeserializer::None) {
+            return error;
+        }
+        // No resource without an error is one the update pass creates
+        if (resource) {
+            error = set_value(*resource, value, value_label, update_value);
+            if (error != M2MTLVDeserializer::None) {
+                return error;
+            }
+        }
+    }
+
+    return M2MTLVDeserializer::None;
+}
+
+bool M2MSenMLCBORDeserializer::enter_records(const uint8_t *cbor, uint32_t cbor_size, CborParser &parser,
+                                             CborValue &array, CborValue &record)
+{
+    return cbor && cbor_parser_init(cbor, cbor_size, 0, &parser, &array) == CborNoError &&
+           cbor_value_is_array(&array) &&
+           cbor_value_enter_container(&array, &record) == CborNoError;
+}
+
+bool M2MSenMLCBORDeserializer::read_record(CborValue &record, char *base_name, char *full_name,
+                                           CborValue &value, int &value_label)
+{
+    CborValue field;
+    if (!cbor_value_is_map(&record) || cbor_value_enter_container(&record, &field) != CborNoError) {
+        return false;
+    }
+
+    char name[M2MBase::MAX_PATH_SIZE];
+    name[0] = '\0';
+    value_label = -1;
+
+    while (!cbor_value_at_end(&field)) {
+        int label = -1;
+        if (cbor_value_is_integer(&field)) {
+            cbor_value_get_int(&field, &label);
+        } else if (cbor_value_is_text_string(&field)) {
+            bool is_objlnk = false;
+            cbor_value_text_string_equals(&field, SENML_OBJLNK_VALUE, &is_objlnk);
+            if (is_objlnk) {
+                label = SENML_LABEL_OBJLNK_VALUE;
+            }
+        } else {
+            return false;
+        }
+        if (cbor_value_advance(&field) != CborNoError || cbor_value_at_end(&field)) {
+            return false;
+        }
+
+        if (label == SENML_BASE_NAME || label == SENML_NAME) {
+            char *buffer = (label == SENML_BASE_NAME) ? base_name : name;
+            size_t length = M2MBase::MAX_PATH_SIZE;
+            if (!cbor_value_is_text_string(&field) ||
+                    cbor_value_copy_text_string(&field, buffer, &length, NULL) != CborNoError ||
+                    length >= M2MBase::MAX_PATH_SIZE) {
+                return false;
+            }
+            buffer[length] = '\0';
+        } else if (label == SENML_VALUE || label == SENML_STRING_VALUE ||
+                   label == SENML_BOOLEAN_VALUE || label == SENML_DATA_VALUE ||
+                   label == SENML_LABEL_OBJLNK_VALUE) {
+            if (value_label != -1) {
+                // A record carries exactly one value
+                return false;
+            }
+            value = field;
+            value_label = label;
+        }
+        // Time and other labels are not stored, the values do not carry timestamps
+
+        if (cbor_value_advance(&field) != CborNoError) {
+            return false;
+        }
+    }
+
+    if (value_label == -1 || cbor_value_leave_container(&record, &field) != CborNoError) {
+        return false;
+    }
+
+    const size_t base_length = strlen(base_name);
+    const size_t name_length = strlen(name);
+    if (base_length + name_length >= M2MBase::MAX_PATH_SIZE) {
+        return false;
+    }
+    memcpy(full_name, base_name, base_length);
+    memcpy(full_name + base_length, name, name_length + 1);
+    return true;
+}
+
+const char *M2MSenMLCBORDeserializer::relative_name(const M2MBase &target, const char *name)
+{
+    // Name must be inside the target, "/3/0/1" or "3/0/1" for target "3/0"
+    const char *path = target.uri_path();
+    const size_t path_length = strlen(path);
+    if (name[0] == '/') {
+        name++;
+    }
+    if (strncmp(name, path, path_length) != 0 ||
+            (name[path_length] != '\0' && name[path_length] != '/')) {
+        tr_error("M2MSenMLCBORDeserializer::relative_name() - %s not in %s", name, path);
+        return NULL;
+    }
+    name += path_length;
+    if (*name == '/') {
+        name++;
+    }
+    return name;
+}
+
+bool M2MSenMLCBORDeserializer::read_id(const char *&name, uint16_t &id)
+{
+    if (*name < '0' || *name > '9') {
+        return false;
+    }
+    char *end = NULL;
+    const unsigned long value = strtoul(name, &end, 10);
+    if ((*end != '\0' && *end != '/') || value > UINT16_MAX) {
+        return false;
+    }
+    id = (uint16_t)value;
+    name = (*end == '/') ? end + 1 : end;
+    return true;
+}
+
+M2MResourceBase *M2MSenMLCBORDeserializer::find_resource(M2MBase &target, const char *name, int value_label,
+                                                         const CborValue &value,
+                                                         M2MTLVDeserializer::Operation operation,
+                                                         bool update_value,
+                                                         M2MTLVDeserializer::Error &error)
+{
+    error = M2MTLVDeserializer::NotFound;
+
+    name = relative_name(target, name);
+    if (!name) {
+        return NULL;
+    }
+
+    M2MObjectInstance *object_instance = NULL;
+    M2MResource *resource = NULL;
+    if (target.base_type() == M2MBase::Object) {
+        uint16_t instance_id = 0;
+        if (*name == '\0') {
+            error = M2MTLVDeserializer::NotValid;
+            return NULL;
+        }
+        if (read_id(name, instance_id)) {
+            object_instance = ((M2MObject &)target).object_instance(instance_id);
+        }
+        if (!object_instance) {
+            tr_error("M2MSenMLCBORDeserializer::find_resource() - object instance not found");
+            return NULL;
+        }
+    } else if (target.base_type() == M2MBase::ObjectInstance) {
+        object_instance = (M2MObjectInstance *)&target;
+    } else if (target.base_type() == M2MBase::Resource) {
+        resource = (M2MResource *)&target;
+    }
+
+    if (object_instance) {
+        char resource_name[M2MBase::MAX_PATH_SIZE];
+        const char *separator = strchr(name, '/');
+        const size_t length = separator ? (size_t)(separator - name) : strlen(name);
+        memcpy(resource_name, name, length);
+        resource_name[length] = '\0';
+        name = separator ? separator + 1 : name + length;
+        resource = object_instance->resource(resource_name);
+
+        if (!resource && operation == M2MTLVDeserializer::Post) {
+            // Create a new resource as the OMA-TLV deserializer does, typed after the value of the record
+            const char *id_name = resource_name;
+            const char *instance_name = name;
+            uint16_t resource_id = 0;
+            uint16_t instance_id = 0;
+            if (!read_id(id_name, resource_id) || *id_name != '\0' ||
+                    (*instance_name != '\0' && (!read_id(instance_name, instance_id) || *instance_name != '\0'))) {
+                tr_error("M2MSenMLCBORDeserializer::find_resource() - invalid id in %s", resource_name);
+                return NULL;
+            }
+            if (!update_value) {
+                error = M2MTLVDeserializer::None;
+                return NULL;
+            }
+            resource = object_instance->create_dynamic_resource(resource_id, "", value_type(value, value_label),
+                                                                true, *name != '\0');
+            if (!resource) {
+                error = M2MTLVDeserializer::OutOfMemory;
+                return NULL;
+            }
+            resource->set_operation(M2MBase::GET_PUT_POST_DELETE_ALLOWED);
+        }
+    }
+
+    if (!resource) {
+        tr_error("M2MSenMLCBORDeserializer::find_resource() - resource not found");
+        return NULL;
+    }
+    if ((resource->operation() & M2MBase::PUT_ALLOWED) == 0) {
+        error = M2MTLVDeserializer::NotAllowed;
+        return NULL;
+    }
+
+    if (!resource->supports_multiple_instances()) {
+        if (*name != '\0') {
+            return NULL;
+        }
+        error = M2MTLVDeserializer::None;
+        return resource;
+    }
+
+    // Multiple instance resource, the name ends with the instance id
+    uint16_t instance_id = 0;
+    if (*name == '\0') {
+        error = M2MTLVDeserializer::NotValid;
+        return NULL;
+    }
+    if (!read_id(name, instance_id) || *name != '\0') {
+        return NULL;
+    }
+    M2MResourceInstance *resource_instance = resource->resource_instance(instance_id);
+    if (!resource_instance && operation == M2MTLVDeserializer::Post) {
+        if (!update_value) {
+            error = M2MTLVDeserializer::None;
+            return NULL;
+        }
+        resource_instance = resource->get_parent_object_instance().create_dynamic_resource_instance(
+                                resource->name(), "", resource->resource_instance_type(), true, instance_id);
+        if (!resource_instance) {
+            error = M2MTLVDeserializer::OutOfMemory;
+            return NULL;
+        }
+        resource_instance->set_operation(M2MBase::GET_PUT_POST_DELETE_ALLOWED);
+    }
+    if (resource_instance) {
+        error = M2MTLVDeserializer::None;
+    }
+    return resource_instance;
+}
+
+M2MResourceBase::ResourceType M2MSenMLCBORDeserializer::value_type(const CborValue &value, int value_label)
+{
+    switch (value_label) {
+        case SENML_VALUE:
+            return cbor_value_is_integer(&value) ? M2MResourceBase::INTEGER : M2MResourceBase::FLOAT;
+        case SENML_BOOLEAN_VALUE:
+            return M2MResourceBase::BOOLEAN;
+        case SENML_DATA_VALUE:
+            return M2MResourceBase::OPAQUE;
+        case SENML_LABEL_OBJLNK_VALUE:
+            return M2MResourceBase::OBJLINK;
+        case SENML_STRING_VALUE:
+        default:
+            return M2MResourceBase::STRING;
+    }
+}
+
+M2MTLVDeserializer::Error M2MSenMLCBORDeserializer::set_value(M2MResourceBase &resource, const CborValue &value,
+                                                              int value_label, bool update_value)
+{
+    bool success = true;
+    switch (resource.resource_instance_type()) {
+        case M2MResourceBase::INTEGER:
+        case M2MResourceBase::TIME: {
+            int64_t int_value = 0;
+            if (value_label != SENML_VALUE || !cbor_value_is_integer(&value) ||
+                    cbor_value_get_int64_checked(&value, &int_value) != CborNoError) {
+                return M2MTLVDeserializer::NotValid;
+            }
+            if ((strcmp(resource.uri_path(), SERVER_LIFETIME_PATH) == 0) && (int_value < MINIMUM_REGISTRATION_TIME)) {
+                // Check that lifetime can't go below 60s
+                return M2MTLVDeserializer::NotAccepted;
+            }
+            if (update_value) {
+                success = resource.set_value(int_value);
+            }
+            break;
+        }
+        case M2MResourceBase::FLOAT: {
+            float float_value = 0;
+            if (value_label != SENML_VALUE || !read_float(value, float_value)) {
+                return M2MTLVDeserializer::NotValid;
+            }
+            if (update_value) {
+                success = resource.set_value_float(float_value);
+            }
+            break;
+        }
+        case M2MResourceBase::BOOLEAN: {
+            bool bool_value = false;
+            if (value_label != SENML_BOOLEAN_VALUE || !cbor_value_is_boolean(&value)) {
+                return M2MTLVDeserializer::NotValid;
+            }
+            if (update_value) {
+                cbor_value_get_boolean(&value, &bool_value);
+                success = resource.set_value((int64_t)bool_value);
+            }
+            break;
+        }
+        case M2MResourceBase::OPAQUE:
+        case M2MResourceBase::OBJLINK:
+        case M2MResourceBase::STRING:
+        default: {
+            const int expected_label = (resource.resource_instance_type() == M2MResourceBase::OPAQUE) ? SENML_DATA_VALUE :
+                                       (resource.resource_instance_type() == M2MResourceBase::OBJLINK) ? SENML_LABEL_OBJLNK_VALUE :
+                                       SENML_STRING_VALUE;
+            const bool is_byte_string = (expected_label == SENML_DATA_VALUE);
+            if (value_label != expected_label ||
+                    (is_byte_string ? !cbor_value_is_byte_string(&value) : !cbor_value_is_text_string(&value))) {
+                return M2MTLVDeserializer::NotValid;
+            }
+            if (update_value) {
+                uint8_t *buffer = NULL;
+                size_t length = 0;
+                CborError cbor_error = is_byte_string ?
+                                       cbor_value_dup_byte_string(&value, &buffer, &length, NULL) :
+                                       cbor_value_dup_text_string(&value, (char **)&buffer, &length, NULL);
+                if (cbor_error != CborNoError) {
+                    return (cbor_error == CborErrorOutOfMemory) ? M2MTLVDeserializer::OutOfMemory :
+                           M2MTLVDeserializer::NotValid;
+                }
+                if (length > 0) {
+                    success = resource.set_value(buffer, length);
+                } else {
+                    resource.clear_value();
+                }
+                free(buffer);
+            }
+            break;
+        }
+    }
+
+    return success ? M2MTLVDeserializer::None : M2MTLVDeserializer::OutOfMemory;
+}
+
+bool M2MSenMLCBORDeserializer::read_float(const CborValue &value, float &result)
+{
+    if (cbor_value_is_integer(&value)) {
+        int64_t int_value = 0;
+        if (cbor_value_get_int64_checked(&value, &int_value) != CborNoError) {
+            return false;
+        }
+        result = (float)int_value;
+    } else if (cbor_value_is_float(&value)) {
+        cbor_value_get_float(&value, &result);
+    } else if (cbor_value_is_double(&value)) {
+        double double_value = 0;
+        cbor_value_get_double(&value, &double_value);
+        result = (float)double_value;
+    } else if (cbor_value_is_half_float(&value)) {
+        // IEEE 754 binary16, see RFC 7049 appendix D
+        uint16_t half = 0;
+        cbor_value_get_half_float(&value, &half);
+        const int exponent = (half >> 10) & 0x1f;
+        const int mantissa = half & 0x3ff;
+        float magnitude;
+        if (exponent == 0) {
+            magnitude = ldexpf((float)mantissa, -24);
+        } else if (exponent != 31) {
+            magnitude = ldexpf((float)(mantissa + 1024), exponent - 25);
+        } else {
+            magnitude = (mantissa == 0) ? INFINITY : NAN;
+        }
+        result = (half & 0x8000) ? -magnitude : magnitude;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+#endif // MBED_CLIENT_SENML_CBOR
@@ -0,0 +1,328 @@
+/*
+ * Copyright (c) 2020 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "include/m2msenmlcborserializer.h"
+
+#if MBED_CLIENT_SENML_CBOR
+
+#include "mbed-client/m2mconstants.h"
+#include "mbed-client/m2mresourceinstance.h"
+#include "mbed-client/m2mstringbuffer.h"
+#include "mbed-trace/mbed_trace.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_GROUP "mClt"
+
+uint8_t *M2MSenMLCBORSerializer::serialize(const M2MObject &object, const M2MObjectInstanceList &object_instance_list, uint32_t &size,
+                                          uint64_t base_time)
+{
+    return serialize(object, &object_instance_list, size, base_time);
+}
+
+uint8_t *M2MSenMLCBORSerializer::serialize(const M2MObjectInstance &object_instance, uint32_t &size, uint64_t base_time)
+{
+    return serialize(object_instance, NULL, size, base_time);
+}
+
+uint8_t *M2MSenMLCBORSerializer::serialize(const M2MResourceBase &resource, uint32_t &size, uint64_t base_time)
+{
+    return serialize(resource, NULL, size, base_time);
+}
+
+uint8_t *M2MSenMLCBORSerializer::serialize(const M2MBase &base, const M2MObjectInstanceList *object_instance_list, uint32_t &size,
+                                          uint64_t base_time)
+{
+    size = 0;
+    if (!record_count(base, object_instance_list)) {
+        return NULL;
+    }
+
+    // First pass encodes into an empty buffer, tinycbor then just counts the bytes needed.
+    // Second pass encodes into a buffer of exactly that size.
+    CborEncoder encoder;
+    cbor_encoder_init(&encoder, NULL, 0, 0);
+    if (!write_records(base, object_instance_list, base_time, encoder)) {
+        tr_error("M2MSenMLCBORSerializer::serialize() - encoding failed");
+        return NULL;
+    }
+    const size_t needed = cbor_encoder_get_extra_bytes_needed(&encoder);
+
+    uint8_t *data = (uint8_t *)malloc(needed);
+    if (!data) {
+        tr_error("M2MSenMLCBORSerializer::serialize() - out of memory");
+        return NULL;
+    }
+
+    cbor_encoder_init(&encoder, data, needed, 0);
+    if (!write_records(base, object_instance_list, base_time, encoder) ||
+            cbor_encoder_get_extra_bytes_needed(&encoder) ||
+            cbor_encoder_get_buffer_size(&encoder, data) != needed) {
+        // Values changed between the passes
+        tr_error("M2MSenMLCBORSerializer::serialize() - size mismatch");
+        free(data);
+        return NULL;
+    }
+
+    size = needed;
+    return data;
+}
+
+uint32_t M2MSenMLCBORSerializer::record_count(const M2MBase &base, const M2MObjectInstanceList *object_instance_list)
+{
+    uint32_t count = 0;
+    if (object_instance_list) {
+        M2MObjectInstanceList::const_iterator it = object_instance_list->begin();
+        for (; it != object_instance_list->end(); it++) {
+            count += record_count((*it)->resources());
+        }
+    } else if (base.base_type() == M2MBase::ObjectInstance) {
+        count = record_count(((const M2MObjectInstance &)base).resources());
+    } else if (base.base_type() == M2MBase::Resource) {
+        count = record_count((const M2MResource &)base);
+    } else if (base.base_type() == M2MBase::ResourceInstance) {
+        count = 1;
+    }
+    return count;
+}
+
+uint32_t M2MSenMLCBORSerializer::record_count(const M2MResourceList &resource_list)
+{
+    uint32_t count = 0;
+    M2MResourceList::const_iterator it = resource_list.begin();
+    for (; it != resource_list.end(); it++) {
+        if (((*it)->operation() & M2MBase::GET_ALLOWED) == M2MBase::GET_ALLOWED) {
+            count += record_count(**it);
+        }
+    }
+    return count;
+}
+
+uint32_t M2MSenMLCBORSerializer::record_count(const M2MResource &resource)
+{
+    if (!resource.supports_multiple_instances()) {
+        return 1;
+    }
+
+    uint32_t count = 0;
+    const M2MResourceInstanceList &instance_list = resource.resource_instances();
+    M2MResourceInstanceList::const_iterator it = instance_list.begin();
+    for (; it != instance_list.end(); it++) {
+        if (((*it)->operation() & M2MBase::GET_ALLOWED) == M2MBase::GET_ALLOWED) {
+            count++;
+        }
+    }
+    return count;
+}
+
+bool M2MSenMLCBORSerializer::use_instance_base_names(const M2MObjectInstanceList &object_instance_list,
+                                                     size_t object_base_name_length)
+{
+    // Bytes saved on the names of the records against the bytes of the extra base names,
+    // each one being a label, a string header and the path. The first base name is written
+    // anyway and just gets longer.
+    int32_t saved = 0;
+    bool first = true;
+    M2MObjectInstanceList::const_iterator it = object_instance_list.begin();
+    for (; it != object_instance_list.end(); it++) {
+        const uint32_t count = record_count((*it)->resources());
+        if (!count) {
+            continue;
+        }
+        StringBuffer<M2MBase::MAX_PATH_SIZE_4> prefix;
+        if (!prefix.append_int((*it)->instance_id()) || !prefix.append('/')) {
+            return false;
+        }
+        saved += (int32_t)(count * prefix.get_size());
+        if (first) {
+            saved -= (int32_t)prefix.get_size();
+            first = false;
+        } else {
+            const size_t length = object_base_name_length + prefix.get_size();
+            saved -= (int32_t)(1 + ((length < 24) ? 1 : 2) + length);
+        }
+    }
+    return saved > 0;
+}
+
+bool M2MSenMLCBORSerializer::write_records(const M2MBase &base, const M2MObjectInstanceList *object_instance_list,
+                                           uint64_t base_time, CborEncoder &encoder)
+{
+    // The size pass gets CborErrorOutOfMemory from every call by design, that error is
+    // left out here and the caller verifies the size of the encoding pass instead.
+    CborEncoder array;
+    int error = cbor_encoder_create_array(&encoder, &array, record_count(base, object_instance_list));
+
+    // Base name is the path of the requested entity, it is written only into the first record
+    StringBuffer<M2MBase::MAX_PATH_SIZE> base_name;
+    if (!base_name.append('/') || !base_name.append(base.uri_path())) {
+        return false;
+    }
+    const bool is_container = object_instance_list ||
+                              base.base_type() == M2MBase::ObjectInstance ||
+                              (base.base_type() == M2MBase::Resource &&
+                               ((const M2MResource &)base).supports_multiple_instances());
+    if (is_container && !base_name.append('/')) {
+        return false;
+    }
+    BaseFields base_fields = { base_name.c_str(), base_time };
+
+    bool success = true;
+    if (object_instance_list) {
+        success = write_records(*object_instance_list, base_name.c_str(), base_fields, array);
+    } else if (base.base_type() == M2MBase::ObjectInstance) {
+        success = write_records(((const M2MObjectInstance &)base).resources(), "", base_fields, array);
+    } else if (is_container) {
+        success = write_records((const M2MResource &)base, "", base_fields, array);
+    } else {
+        success = write_record((const M2MResourceBase &)base, "", base_fields, array);
+    }
+
+    error |= cbor_encoder_close_container(&encoder, &array);
+    return success && (error & ~CborErrorOutOfMemory) == CborNoError;
+}
+
+bool M2MSenMLCBORSerializer::write_records(const M2MObjectInstanceList &object_instance_list, const char *object_base_name,
+                                           BaseFields &base, CborEncoder &encoder)
+{
+    // Base name stays in effect until the next one, so either every instance gets its own
+    // and its records are named "<resource>", or the object path is used for all of them
+    // and the records are named "<instance>/<resource>".
+    const bool instance_base_names = use_instance_base_names(object_instance_list, strlen(object_base_name));
+
+    M2MObjectInstanceList::const_iterator it = object_instance_list.begin();
+    for (; it != object_instance_list.end(); it++) {
+        StringBuffer<M2MBase::MAX_PATH_SIZE_4> prefix;
+        if (!prefix.append_int((*it)->instance_id()) || !prefix.append('/')) {
+            return false;
+        }
+        if (!instance_base_names) {
+            if (!write_records((*it)->resources(), prefix.c_str(), base, encoder)) {
+                return false;
+            }
+            continue;
+        }
+        if (!record_count((*it)->resources())) {
+            continue;
+        }
+        StringBuffer<M2MBase::MAX_PATH_SIZE> instance_base_name;
+        if (!instance_base_name.append(object_base_name) || !instance_base_name.append(prefix.c_str())) {
+            return false;
+        }
+        base.name = instance_base_name.c_str();
+        if (!write_records((*it)->resources(), "", base, encoder)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool M2MSenMLCBORSerializer::write_records(const M2MResourceList &resource_list, const char *prefix,
+                                           BaseFields &base, CborEncoder &encoder)
+{
+    M2MResourceList::const_iterator it = resource_list.begin();
+    for (; it != resource_list.end(); it++) {
+        if (((*it)->operation() & M2MBase::GET_ALLOWED) == M2MBase::GET_ALLOWED) {
+            StringBuffer<M2MBase::MAX_PATH_SIZE> name;
+            if (!name.append(prefix) || !name.append((*it)->name())) {
+                return false;
+            }
+            if ((*it)->supports_multiple_instances()) {
+                if (!name.append('/') || !write_records(**it, name.c_str(), base, encoder)) {
+                    return false;
+                }
+            } else if (!write_record(**it, name.c_str(), base, encoder)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool M2MSenMLCBORSerializer::write_records(const M2MResource &resource, const char *prefix,
+                                           BaseFields &base, CborEncoder &encoder)
+{
+    const M2MResourceInstanceList &instance_list = resource.resource_instances();
+    M2MResourceInstanceList::const_iterator it = instance_list.begin();
+    for (; it != instance_list.end(); it++) {
+        if (((*it)->operation() & M2MBase::GET_ALLOWED) == M2MBase::GET_ALLOWED) {
+            StringBuffer<M2MBase::MAX_PATH_SIZE> name;
+            if (!name.append(prefix) || !name.append_int((*it)->instance_id()) ||
+                    !write_record(**it, name.c_str(), base, encoder)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* See, OMA-TS-LightweightM2M_Core-V1_1-20180710-A, chapter 7.4.5 */
+bool M2MSenMLCBORSerializer::write_record(const M2MResourceBase &resource, const char *name,
+                                          BaseFields &base, CborEncoder &encoder)
+{
+    CborEncoder map;
+    int error = cbor_encoder_create_map(&encoder, &map,
+                                        (base.name ? 1 : 0) + (base.time ? 1 : 0) + (name[0] ? 1 : 0) + 1);
+
+    if (base.name) {
+        error |= cbor_encode_int(&map, SENML_BASE_NAME);
+        error |= cbor_encode_text_stringz(&map, base.name);
+        base.name = NULL;
+    }
+    if (base.time) {
+        error |= cbor_encode_int(&map, SENML_BASE_TIME);
+        error |= cbor_encode_uint(&map, base.time);
+        base.time = 0;
+    }
+    if (name[0]) {
+        error |= cbor_encode_int(&map, SENML_NAME);
+        error |= cbor_encode_text_stringz(&map, name);
+    }
+
+    switch (resource.resource_instance_type()) {
+        case M2MResourceBase::INTEGER:
+        case M2MResourceBase::TIME:
+            error |= cbor_encode_int(&map, SENML_VALUE);
+            error |= cbor_encode_int(&map, resource.get_value_int());
+            break;
+        case M2MResourceBase::FLOAT:
+            error |= cbor_encode_int(&map, SENML_VALUE);
+            error |= cbor_encode_float(&map, resource.get_value_float());
+            break;
+        case M2MResourceBase::BOOLEAN:
+            error |= cbor_encode_int(&map, SENML_BOOLEAN_VALUE);
+            error |= cbor_encode_boolean(&map, resource.get_value_int() != 0);
+            break;
+        case M2MResourceBase::OPAQUE:
+            error |= cbor_encode_int(&map, SENML_DATA_VALUE);
+            error |= cbor_encode_byte_string(&map, resource.value(), resource.value_length());
+            break;
+        case M2MResourceBase::OBJLINK:
+            error |= cbor_encode_text_stringz(&map, SENML_OBJLNK_VALUE);
+            error |= cbor_encode_text_string(&map, (const char *)resource.value(), resource.value_length());
+            break;
+        case M2MResourceBase::STRING:
+        default:
+            error |= cbor_encode_int(&map, SENML_STRING_VALUE);
+            error |= cbor_encode_text_string(&map, (const char *)resource.value(), resource.value_length());
+            break;
+    }
+
+    error |= cbor_encoder_close_container(&encoder, &map);
+    return (error & ~CborErrorOutOfMemory) == CborNoError;
+}
+
+#endif // MBED_CLIENT_SENML_CBOR
@@ -17,6 +17,7 @@
 #include "mbed-client/m2mconstants.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include "common_functions.h"
 
 #define TRACE_GROUP "mClt"
@@ -27,245 +28,306 @@
 
 uint8_t *M2MTLVSerializer::serialize(const M2MObjectInstanceList &object_instance_list, uint32_t &size)
 {
-    return serialize_object_instances(object_instance_list, size);
+    // First pass computes the exact size, second pass encodes into a single buffer
+    size = object_instances_size(object_instance_list);
+    uint8_t *data = size ? (uint8_t *)malloc(size) : NULL;
+    if (data) {
+        tlv_writer_s writer = { data, 0, size, 0 };
+        write_object_instances(object_instance_list, writer);
+    } else {
+        size = 0;
+    }
+    return data;
 }
 
 uint8_t *M2MTLVSerializer::serialize(const M2MResourceList &resource_list, uint32_t &size)
 {
-    bool valid = true;
-    return serialize_resources(resource_list, size, valid);
+    size = resources_size(resource_list);
+    uint8_t *data = size ? (uint8_t *)malloc(size) : NULL;
+    if (data) {
+        tlv_writer_s writer = { data, 0, size, 0 };
+        write_resources(resource_list, writer);
+    } else {
+        size = 0;
+    }
+    return data;
 }
 
 uint8_t *M2MTLVSerializer::serialize(const M2MResource *resource, uint32_t &size)
 {
-    uint8_t *data = NULL;
-    serialize(resource, data, size);
+    size = resource_size(resource);
+    uint8_t *data = size ? (uint8_t *)malloc(size) : NULL;
+    if (data) {
+        tlv_writer_s writer = { data, 0, size, 0 };
+        write_resource(resource, writer);
+    } else {
+        size = 0;
+    }
     return data;
 }
 
-uint8_t *M2MTLVSerializer::serialize_object_instances(const M2MObjectInstanceList &object_instance_list, uint32_t &size)
+uint32_t M2MTLVSerializer::serialize(const M2MObjectInstanceList &object_instance_list, uint32_t offset,
+                                     uint8_t *buffer, uint32_t buffer_size, uint32_t &total_size)
+{
+    total_size = object_instances_size(object_instance_list);
+    tlv_writer_s writer = { buffer, offset, buffer_size, 0 };
+    write_object_instances(object_instance_list, writer);
+    return written_length(writer, total_size);
+}
+
+uint32_t M2MTLVSerializer::serialize(const M2MResourceList &resource_list, uint32_t offset,
+                                     uint8_t *buffer, uint32_t buffer_size, uint32_t &total_size)
 {
-    uint8_t *data = NULL;
-
-    if (!object_instance_list.empty()) {
-        M2MObjectInstanceList::const_iterator it;
-        it = object_instance_list.begin();
-        for (; it != object_instance_list.end(); it++) {
-            uint16_t id = (*it)->instance_id();
-            serialize(id, *it, data, size);
+    total_size = resources_size(resource_list);
+    tlv_writer_s writer = { buffer, offset, buffer_size, 0 };
+    write_resources(resource_list, writer);
+    return written_length(writer, total_size);
+}
+
+uint32_t M2MTLVSerializer::serialize(const M2MResource *resource, uint32_t offset,
+                                     uint8_t *buffer, uint32_t buffer_size, uint32_t &total_size)
+{
+    total_size = resource_size(resource);
+    tlv_writer_s writer = { buffer, offset, buffer_size, 0 };
+    write_resource(resource, writer);
+    return written_length(writer, total_size);
+}
+
+uint32_t M2MTLVSerializer::written_length(const tlv_writer_s &writer, uint32_t total_size)
+{
+    if (writer.offset >= total_size) {
+        return 0;
+    }
+    const uint32_t remaining = total_size - writer.offset;
+    return remaining < writer.buffer_size ? remaining : writer.buffer_size;
+}
+
+bool M2MTLVSerializer::is_valid(const M2MResourceList &resource_list)
+{
+    M2MResourceList::const_iterator it = resource_list.begin();
+    for (; it != resource_list.end(); it++) {
+        if ((*it)->name_id() == -1) {
+            return false;
         }
     }
-    return data;
+    return true;
 }
 
-uint8_t *M2MTLVSerializer::serialize_resources(const M2MResourceList &resource_list, uint32_t &size, bool &valid)
+bool M2MTLVSerializer::is_readable(const M2MBase *base)
 {
-    uint8_t *data = NULL;
+    return (base->operation() & M2MBase::GET_ALLOWED) == M2MBase::GET_ALLOWED;
+}
+
+/* Size functions, these must skip exactly the same items as the write functions below */
 
-    if (!resource_list.empty()) {
-        M2MResourceList::const_iterator it;
-        it = resource_list.begin();
+uint32_t M2MTLVSerializer::object_instances_size(const M2MObjectInstanceList &object_instance_list)
+{
+    uint32_t size = 0;
+    M2MObjectInstanceList::const_iterator it = object_instance_list.begin();
+    for (; it != object_instance_list.end(); it++) {
+        // object instances with unserializable resources are left out
+        if (is_valid((*it)->resources())) {
+            size += tlv_size((*it)->instance_id(), resources_size((*it)->resources()));
+        }
+    }
+    return size;
+}
+
+uint32_t M2MTLVSerializer::resources_size(const M2MResourceList &resource_list)
+{
+    uint32_t size = 0;
+    if (is_valid(resource_list)) {
+        M2MResourceList::const_iterator it = resource_list.begin();
         for (; it != resource_list.end(); it++) {
-            if ((*it)->name_id() == -1) {
-                valid = false;
-                break;
+            if (is_readable(*it)) {
+                size += resource_size(*it);
             }
         }
-        if (valid) {
-            it = resource_list.begin();
-            for (; it != resource_list.end(); it++) {
-                if (((*it)->operation() & M2MBase::GET_ALLOWED) == M2MBase::GET_ALLOWED) {
-                    if (!serialize(*it, data, size)) {
-                        /* serializing has failed */
-                        /* free data so far */
-                        free(data);
-                        /* invalidate */
-                        valid = false;
-                        /* return NULL immediately */
-                        return NULL;
-                    }
-                }
-            }
+    }
+    return size;
+}
+
+uint32_t M2MTLVSerializer::resource_size(const M2MResource *resource)
+{
+    uint32_t size = 0;
+    if (resource->name_id() != -1) {
+        if (!resource->supports_multiple_instances()) {
+            size = tlv_size(resource->name_id(), value_length(resource));
+        } else if (is_readable(resource)) {
+            size = tlv_size(resource->name_id(), resource_instances_size(resource->resource_instances()));
         }
     }
-    return data;
+    return size;
 }
 
-bool M2MTLVSerializer::serialize(uint16_t id, const M2MObjectInstance *object_instance, uint8_t *&data, uint32_t &size)
+uint32_t M2MTLVSerializer::resource_instances_size(const M2MResourceInstanceList &instance_list)
 {
-    uint8_t *resource_data = NULL;
-    uint32_t resource_size = 0;
-    bool success;
-
-    bool valid = true;
-    resource_data = serialize_resources(object_instance->resources(), resource_size, valid);
-    if (valid) {
-        if (serialize_TILV(TYPE_OBJECT_INSTANCE, id, resource_data, resource_size, data, size)) {
-            success = true;
-        } else {
-            /* serializing object instance failed */
-            success = false;
+    uint32_t size = 0;
+    M2MResourceInstanceList::const_iterator it = instance_list.begin();
+    for (; it != instance_list.end(); it++) {
+        if (is_readable(*it)) {
+            size += tlv_size((*it)->instance_id(), value_length(*it));
         }
-        free(resource_data);
-    } else {
-        /* serializing resources failed */
-        success = false;
     }
-    return success;
+    return size;
 }
 
-bool M2MTLVSerializer::serialize(const M2MResource *resource, uint8_t *&data, uint32_t &size)
+/* See, OMA-TS-LightweightM2M-V1_0-20170208-A, Appendix C, Data Types */
+uint32_t M2MTLVSerializer::value_length(const M2MResourceBase *resource)
 {
-    bool success = false;
-    if (resource->name_id() != -1) {
-        success = resource->supports_multiple_instances() ?
-                  serialize_multiple_resource(resource, data, size) :
-                  serialize_resource(resource, data, size);
+    switch (resource->resource_instance_type()) {
+        case M2MResourceBase::BOOLEAN:
+            return 1;
+        case M2MResourceBase::INTEGER:
+        case M2MResourceBase::TIME:
+            return 8;
+        case M2MResourceBase::FLOAT:
+            return 4;
+        default:
+            return resource->value_length();
     }
-    return success;
 }
 
-bool M2MTLVSerializer::serialize_resource(const M2MResource *resource, uint8_t *&data, uint32_t &size)
+uint32_t M2MTLVSerializer::tlv_size(uint16_t id, uint32_t value_length)
 {
-    bool success = false;
-    if (resource->name_id() != -1) {
-        if ((resource->resource_instance_type() == M2MResourceBase::INTEGER) ||
-                (resource->resource_instance_type() == M2MResourceBase::BOOLEAN) ||
-                (resource->resource_instance_type() == M2MResourceBase::TIME)) {
-            success = serialize_TLV_binary_int(resource, TYPE_RESOURCE, resource->name_id(), data, size);
-        } else if (resource->resource_instance_type() == M2MResourceBase::FLOAT) {
-            success = serialize_TLV_binary_float(resource, TYPE_RESOURCE, resource->name_id(), data, size);
-        } else {
-            success = serialize_TILV(TYPE_RESOURCE, resource->name_id(),
-                                     resource->value(), resource->value_length(), data, size);
+    uint32_t id_size = id > 255 ? 2 : 1;
+    uint32_t length_size = value_length > 65535 ? 3 :
+                           value_length > 255 ? 2 :
+                           value_length > 7 ? 1 : 0;
+    return TLV_TYPE_SIZE + id_size + length_size + value_length;
+}
+
+/* Write functions */
+
+void M2MTLVSerializer::write_object_instances(const M2MObjectInstanceList &object_instance_list, tlv_writer_s &writer)
+{
+    // Nothing after the output window is written, so the walk stops there
+    M2MObjectInstanceList::const_iterator it = object_instance_list.begin();
+    for (; it != object_instance_list.end() && !is_window_full(writer); it++) {
+        const M2MResourceList &resource_list = (*it)->resources();
+        if (is_valid(resource_list)) {
+            if (write_header(TYPE_OBJECT_INSTANCE, (*it)->instance_id(), resources_size(resource_list), writer)) {
+                write_resources(resource_list, writer);
+            }
         }
     }
-    return success;
 }
 
-bool M2MTLVSerializer::serialize_multiple_resource(const M2MResource *resource, uint8_t *&data, uint32_t &size)
+void M2MTLVSerializer::write_resources(const M2MResourceList &resource_list, tlv_writer_s &writer)
 {
-    bool success = false;
-    uint8_t *nested_data = NULL;
-    uint32_t nested_data_size = 0;
-
-    const M2MResourceInstanceList &instance_list = resource->resource_instances();
-    if (!instance_list.empty()) {
-        M2MResourceInstanceList::const_iterator it;
-        it = instance_list.begin();
-        for (; it != instance_list.end(); it++) {
-            uint16_t id = (*it)->instance_id();
-            if (((*it)->operation() & M2MBase::GET_ALLOWED) == M2MBase::GET_ALLOWED) {
-                if (!serialize_resource_instance(id, (*it), nested_data, nested_data_size)) {
-                    /* serializing instance has failed */
-                    /* free data so far allocated */
-                    free(nested_data);
-                    /* return fail immediately*/
-                    success = false;
-                    return success;
-                }
+    if (is_valid(resource_list)) {
+        M2MResourceList::const_iterator it = resource_list.begin();
+        for (; it != resource_list.end() && !is_window_full(writer); it++) {
+            if (is_readable(*it)) {
+                write_resource(*it, writer);
             }
         }
     }
-    if (resource->name_id() != -1 &&
-            (resource->operation() & M2MBase::GET_ALLOWED) == M2MBase::GET_ALLOWED) {
-        success = serialize_TILV(TYPE_MULTIPLE_RESOURCE, resource->name_id(),
-                                 nested_data, nested_data_size, data, size);
-    }
-
-    free(nested_data);
-    return success;
 }
 
-bool M2MTLVSerializer::serialize_resource_instance(uint16_t id, const M2MResourceInstance *resource, uint8_t *&data, uint32_t &size)
+void M2MTLVSerializer::write_resource(const M2MResource *resource, tlv_writer_s &writer)
 {
-    bool success;
-
-    if ((resource->resource_instance_type() == M2MResourceBase::INTEGER) ||
-            (resource->resource_instance_type() == M2MResourceBase::BOOLEAN) ||
-            (resource->resource_instance_type() == M2MResourceBase::TIME)) {
-        success = serialize_TLV_binary_int(resource, TYPE_RESOURCE_INSTANCE, id, data, size);
-    } else if (resource->resource_instance_type() == M2MResourceBase::FLOAT) {
-        success = serialize_TLV_binary_float(resource, TYPE_RESOURCE_INSTANCE, id, data, size);
-    } else {
-        success = serialize_TILV(TYPE_RESOURCE_INSTANCE, id, resource->value(), resource->value_length(), data, size);
+    if (resource->name_id() != -1) {
+        if (!resource->supports_multiple_instances()) {
+            write_value(resource, TYPE_RESOURCE, resource->name_id(), writer);
+        } else if (is_readable(resource)) {
+            const M2MResourceInstanceList &instance_list = resource->resource_instances();
+            if (write_header(TYPE_MULTIPLE_RESOURCE, resource->name_id(), resource_instances_size(instance_list), writer)) {
+                write_resource_instances(instance_list, writer);
+            }
+        }
     }
+}
 
-    return success;
+void M2MTLVSerializer::write_resource_instances(const M2MResourceInstanceList &instance_list, tlv_writer_s &writer)
+{
+    M2MResourceInstanceList::const_iterator it = instance_list.begin();
+    for (; it != instance_list.end() && !is_window_full(writer); it++) {
+        if (is_readable(*it)) {
+            write_value(*it, TYPE_RESOURCE_INSTANCE, (*it)->instance_id(), writer);
+        }
+    }
 }
 
 /* See, OMA-TS-LightweightM2M-V1_0-20170208-A, Appendix C,
- * Data Types, Integer, Boolean and Time TLV Format */
-bool M2MTLVSerializer::serialize_TLV_binary_int(const M2MResourceBase *resource, uint8_t type, uint16_t id, uint8_t *&data, uint32_t &size)
+ * Data Types, Integer, Boolean, Time and Float (32 bit only) TLV Format */
+void M2MTLVSerializer::write_value(const M2MResourceBase *resource, uint8_t type, uint16_t id, tlv_writer_s &writer)
 {
-    int64_t valueInt = resource->get_value_int();
-    uint32_t buffer_size;
+    const uint32_t length = value_length(resource);
+    if (!write_header(type, id, length, writer)) {
+        return;
+    }
+
     /* max len 8 bytes */
     uint8_t buffer[8];
-
-    if (resource->resource_instance_type() == M2MResourceBase::BOOLEAN) {
-        buffer_size = 1;
-        buffer[0] = valueInt;
-    } else {
-        buffer_size = 8;
-        common_write_64_bit(valueInt, buffer);
+    switch (resource->resource_instance_type()) {
+        case M2MResourceBase::BOOLEAN:
+            buffer[0] = resource->get_value_int();
+            write_bytes(buffer, length, writer);
+            break;
+        case M2MResourceBase::INTEGER:
+        case M2MResourceBase::TIME:
+            common_write_64_bit(resource->get_value_int(), buffer);
+            write_bytes(buffer, length, writer);
+            break;
+        case M2MResourceBase::FLOAT:
+            common_write_32_bit(resource->get_value_float(), buffer);
+            write_bytes(buffer, length, writer);
+            break;
+        default:
+            write_bytes(resource->value(), length, writer);
+            break;
     }
-
-    return serialize_TILV(type, id, buffer, buffer_size, data, size);
 }
 
-/* See, OMA-TS-LightweightM2M-V1_0-20170208-A, Appendix C,
- * Data Type Float (32 bit only) TLV Format */
-bool M2MTLVSerializer::serialize_TLV_binary_float(const M2MResourceBase *resource, uint8_t type, uint16_t id, uint8_t *&data, uint32_t &size)
+bool M2MTLVSerializer::is_window_full(const tlv_writer_s &writer)
 {
-    float valueFloat = resource->get_value_float();
-    /* max len 8 bytes */
-    uint8_t buffer[4];
-
-    common_write_32_bit(valueFloat, buffer);
-
-    return serialize_TILV(type, id, buffer, 4, data, size);
+    return writer.position >= writer.offset + writer.buffer_size;
 }
 
-
-bool M2MTLVSerializer::serialize_TILV(uint8_t type, uint16_t id, uint8_t *value, uint32_t value_length, uint8_t *&data, uint32_t &size)
+bool M2MTLVSerializer::write_header(uint8_t type, uint16_t id, uint32_t value_length, tlv_writer_s &writer)
 {
-    uint8_t *tlv = 0;
-    const uint32_t type_length = TLV_TYPE_SIZE;
+    // Elements which do not overlap with the output window are skipped as a whole
+    const uint32_t element_size = tlv_size(id, value_length);
+    if (is_window_full(writer) || writer.position + element_size <= writer.offset) {
+        writer.position += element_size;
+        return false;
+    }
+
     type += id < 256 ? 0 : ID16;
     type += value_length < 8 ? value_length :
             value_length < 256 ? LENGTH8 :
             value_length < 65536 ? LENGTH16 : LENGTH24;
-    uint8_t tlv_type;
-    tlv_type = type & 0xFF;
 
+    uint8_t header[TLV_TYPE_SIZE + MAX_TLV_ID_SIZE + MAX_TLV_LENGTH_SIZE];
     uint32_t id_size;
-    uint8_t id_array[MAX_TLV_ID_SIZE];
-    serialize_id(id, id_size, id_array);
-
     uint32_t length_size;
-    uint8_t length_array[MAX_TLV_LENGTH_SIZE];
-    serialize_length(value_length, length_size, length_array);
+    header[0] = type;
+    serialize_id(id, id_size, header + TLV_TYPE_SIZE);
+    serialize_length(value_length, length_size, header + TLV_TYPE_SIZE + id_size);
 
-    tlv = (uint8_t *)malloc(size + type_length + id_size + length_size + value_length);
-    if (!tlv) {
-        /* memory allocation has failed */
-        /* return failure immediately */
-        return false;
-        /* eventually NULL will be returned to serializer public method caller */
+    write_bytes(header, TLV_TYPE_SIZE + id_size + length_size, writer);
+    return true;
+}
+
+void M2MTLVSerializer::write_bytes(const uint8_t *data, uint32_t length, tlv_writer_s &writer)
+{
+    // Copy only the part falling into the output window
+    const uint32_t window_end = writer.offset + writer.buffer_size;
+    const uint32_t data_start = writer.position;
+    uint32_t start = data_start;
+    uint32_t end = data_start + length;
+    writer.position = end;
+
+    if (start < writer.offset) {
+        start = writer.offset;
     }
-    if (data) {
-        memcpy(tlv, data, size);
-        free(data);
+    if (end > window_end) {
+        end = window_end;
+    }
+    if (data && start < end) {
+        memcpy(writer.buffer + (start - writer.offset), data + (start - data_start), end - start);
     }
-    memcpy(tlv + size, &tlv_type, type_length);
-    memcpy(tlv + size + type_length, id_array, id_size);
-    memcpy(tlv + size + type_length + id_size, length_array, length_size);
-    memcpy(tlv + size + type_length + id_size + length_size, value, value_length);
-
-    data = tlv;
-    size += type_length + id_size + length_size + value_length;
-    return true;
 }
 
 void M2MTLVSerializer::serialize_id(uint16_t id, uint32_t &size, uint8_t *id_ptr)
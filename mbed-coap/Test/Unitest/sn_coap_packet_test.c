@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2018 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Memory accounting of confirmable messages in flight: the caller, the resending list and a
+// transport that queues what it is given must all share one copy of the packet.
+
+#include "ns_types.h"
+#include "sn_coap_header.h"
+#include "sn_coap_protocol.h"
+#include "unity.h"
+#include "unity_fixture.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define PAYLOAD_SIZE    1000
+#define MAX_QUEUED      4
+
+// Blocks are prefixed with their size, so that the allocator knows what is live
+typedef union {
+    size_t size;
+    void *align;
+} test_block_header_s;
+
+static size_t live_bytes;
+static size_t live_packet_blocks;
+
+static struct coap_s *coap;
+static uint8_t payload[PAYLOAD_SIZE];
+static uint8_t server_ip[] = { 127, 0, 0, 1 };
+static sn_nsdl_addr_s server_addr;
+
+// The transport queue: references taken in the TX callback, as M2MConnectionHandler::send_packet() does
+static uint8_t *queued[MAX_QUEUED];
+static int queued_count;
+static uint8_t *last_tx_ptr;
+static int tx_count;
+
+static void *test_malloc(uint16_t size)
+{
+    test_block_header_s *block = malloc(sizeof(test_block_header_s) + size);
+    if (!block) {
+        return NULL;
+    }
+    block->size = size;
+    live_bytes += size;
+    if (size >= PAYLOAD_SIZE) {
+        live_packet_blocks++;
+    }
+    return block + 1;
+}
+
+static void test_free(void *ptr)
+{
+    test_block_header_s *block;
+    if (!ptr) {
+        return;
+    }
+    block = (test_block_header_s *)ptr - 1;
+    live_bytes -= block->size;
+    if (block->size >= PAYLOAD_SIZE) {
+        live_packet_blocks--;
+    }
+    free(block);
+}
+
+static uint8_t test_tx(uint8_t *data_ptr, uint16_t data_len, sn_nsdl_addr_s *address_ptr, void *param)
+{
+    (void)data_len;
+    (void)address_ptr;
+    (void)param;
+    last_tx_ptr = data_ptr;
+    tx_count++;
+    if (queued_count < MAX_QUEUED) {
+        queued[queued_count] = sn_coap_protocol_packet_ref_tx(coap, data_ptr);
+        if (queued[queued_count]) {
+            queued_count++;
+        }
+    }
+    return 1;
+}
+
+static int8_t test_rx(sn_coap_hdr_s *header, sn_nsdl_addr_s *address_ptr, void *param)
+{
+    (void)header;
+    (void)address_ptr;
+    (void)param;
+    return 0;
+}
+
+// The transport sent everything it queued
+static void transport_flush(void)
+{
+    for (int i = 0; i < queued_count; i++) {
+        sn_coap_protocol_packet_release(queued[i]);
+    }
+    queued_count = 0;
+}
+
+// Builds and sends a confirmable POST the way sn_nsdl and sn_grs do, returns its message ID
+static uint16_t send_con(void)
+{
+    sn_coap_hdr_s header;
+    uint16_t packet_len;
+    uint8_t *packet_ptr;
+
+    memset(&header, 0, sizeof(header));
+    header.msg_type = COAP_MSG_TYPE_CONFIRMABLE;
+    header.msg_code = COAP_MSG_CODE_REQUEST_POST;
+    header.content_format = COAP_CT_NONE;
+    header.payload_ptr = payload;
+    header.payload_len = PAYLOAD_SIZE;
+
+    packet_len = sn_coap_builder_calc_needed_packet_data_size_2(&header, 0);
+    packet_ptr = sn_coap_protocol_packet_alloc(coap, packet_len);
+    TEST_ASSERT_NOT_NULL(packet_ptr);
+    TEST_ASSERT_EQUAL_INT(packet_len, sn_coap_protocol_build_2(coap, &server_addr, packet_ptr, packet_len, &header, NULL));
+    TEST_ASSERT_EQUAL_INT(1, sn_coap_protocol_send_packet(coap, packet_ptr, packet_len, &server_addr, NULL));
+    sn_coap_protocol_packet_release(packet_ptr);
+
+    return header.msg_id;
+}
+
+static void receive_ack(uint16_t msg_id)
+{
+    sn_coap_hdr_s header;
+    sn_coap_hdr_s *parsed;
+    uint8_t packet[4];
+
+    memset(&header, 0, sizeof(header));
+    header.msg_type = COAP_MSG_TYPE_ACKNOWLEDGEMENT;
+    header.msg_code = COAP_MSG_CODE_EMPTY;
+    header.content_format = COAP_CT_NONE;
+    header.msg_id = msg_id;
+    TEST_ASSERT_EQUAL_INT(sizeof(packet), sn_coap_builder(packet, &header));
+
+    parsed = sn_coap_protocol_parse(coap, &server_addr, sizeof(packet), packet, NULL);
+    TEST_ASSERT_NOT_NULL(parsed);
+    sn_coap_parser_release_allocated_coap_msg_mem(coap, parsed);
+}
+
+TEST_GROUP(sn_coap_packet);
+
+TEST_SETUP(sn_coap_packet)
+{
+    live_bytes = 0;
+    live_packet_blocks = 0;
+    queued_count = 0;
+    tx_count = 0;
+    last_tx_ptr = NULL;
+    memset(payload, 0xA5, sizeof(payload));
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.type = SN_NSDL_ADDRESS_TYPE_IPV4;
+    server_addr.addr_len = sizeof(server_ip);
+    server_addr.addr_ptr = server_ip;
+    server_addr.port = 5684;
+
+    coap = sn_coap_protocol_init(test_malloc, test_free, test_tx, test_rx);
+    TEST_ASSERT_NOT_NULL(coap);
+    TEST_ASSERT_EQUAL_INT(0, sn_coap_protocol_set_retransmission_buffer(coap, MAX_QUEUED, 0));
+}
+
+TEST_TEAR_DOWN(sn_coap_packet)
+{
+    transport_flush();
+    sn_coap_protocol_destroy(coap);
+    TEST_ASSERT_EQUAL_UINT32(0, live_bytes);
+}
+
+TEST(sn_coap_packet, conMessageInFlightIsHeldOnce)
+{
+    uint16_t msg_id = send_con();
+
+    // The transport queue and the resending list hold the same buffer the message was built in
+    TEST_ASSERT_EQUAL_INT(1, queued_count);
+    TEST_ASSERT_EQUAL_PTR(last_tx_ptr, queued[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, live_packet_blocks);
+
+    // Sent, but not yet acked: the resending list keeps the only copy
+    transport_flush();
+    TEST_ASSERT_EQUAL_UINT32(1, live_packet_blocks);
+
+    receive_ack(msg_id);
+    TEST_ASSERT_EQUAL_UINT32(0, live_packet_blocks);
+}
+
+TEST(sn_coap_packet, resendSharesTheStoredCopy)
+{
+    uint8_t *sent_ptr;
+
+    send_con();
+    sent_ptr = last_tx_ptr;
+    transport_flush();
+
+    // Well past the first resend time: the stored buffer itself goes to the transport
+    TEST_ASSERT_EQUAL_INT(0, sn_coap_protocol_exec(coap, 1000));
+    TEST_ASSERT_EQUAL_INT(2, tx_count);
+    TEST_ASSERT_EQUAL_PTR(sent_ptr, last_tx_ptr);
+    TEST_ASSERT_EQUAL_INT(1, queued_count);
+    TEST_ASSERT_EQUAL_UINT32(1, live_packet_blocks);
+}
+
+TEST(sn_coap_packet, eachConMessageInFlightIsHeldOnce)
+{
+    uint16_t first_id = send_con();
+    uint16_t second_id = send_con();
+
+    TEST_ASSERT_EQUAL_INT(2, queued_count);
+    TEST_ASSERT_EQUAL_UINT32(2, live_packet_blocks);
+
+    transport_flush();
+    TEST_ASSERT_EQUAL_UINT32(2, live_packet_blocks);
+
+    receive_ack(first_id);
+    TEST_ASSERT_EQUAL_UINT32(1, live_packet_blocks);
+    receive_ack(second_id);
+    TEST_ASSERT_EQUAL_UINT32(0, live_packet_blocks);
+}
+
+TEST(sn_coap_packet, legacyBuildStoresOneCopy)
+{
+    sn_coap_hdr_s header;
+    uint8_t *packet_ptr;
+    uint16_t packet_len;
+
+    memset(&header, 0, sizeof(header));
+    header.msg_type = COAP_MSG_TYPE_CONFIRMABLE;
+    header.msg_code = COAP_MSG_CODE_REQUEST_POST;
+    header.content_format = COAP_CT_NONE;
+    header.payload_ptr = payload;
+    header.payload_len = PAYLOAD_SIZE;
+
+    // The caller owns its buffer, so the resending list has to take a copy of it
+    packet_len = sn_coap_builder_calc_needed_packet_data_size_2(&header, 0);
+    packet_ptr = malloc(packet_len);
+    TEST_ASSERT_NOT_NULL(packet_ptr);
+    TEST_ASSERT_EQUAL_INT(packet_len, sn_coap_protocol_build(coap, &server_addr, packet_ptr, &header, NULL));
+    free(packet_ptr);
+    TEST_ASSERT_EQUAL_UINT32(1, live_packet_blocks);
+
+    receive_ack(header.msg_id);
+    TEST_ASSERT_EQUAL_UINT32(0, live_packet_blocks);
+}
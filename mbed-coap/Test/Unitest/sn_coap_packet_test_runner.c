@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2018 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "unity.h"
+#include "unity_fixture.h"
+
+TEST_GROUP_RUNNER(sn_coap_packet)
+{
+    RUN_TEST_CASE(sn_coap_packet, conMessageInFlightIsHeldOnce);
+    RUN_TEST_CASE(sn_coap_packet, resendSharesTheStoredCopy);
+    RUN_TEST_CASE(sn_coap_packet, eachConMessageInFlightIsHeldOnce);
+    RUN_TEST_CASE(sn_coap_packet, legacyBuildStoresOneCopy);
+}
+
+static void run_all_tests(void)
+{
+    RUN_TEST_GROUP(sn_coap_packet);
+}
+
+int main(int argc, const char *argv[])
+{
+    return UnityMain(argc, argv, run_all_tests);
+}
@@ -235,6 +235,69 @@ typedef struct sn_coap_hdr_ {
     sn_coap_options_list_s *options_list_ptr;   /**< Must be set to NULL if not used */
 } sn_coap_hdr_s;
 
+/* !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!! */
+/* !!! Zero-copy parsed message view !!! */
+/* !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!! */
+
+/**
+ * \brief Option of a message parsed with sn_coap_parser_view(), pointing into the packet buffer
+ *
+ * Repeatable options, such as Uri-Path, have one value per option in the packet.
+ * Walk them with sn_coap_option_iterator_init() and sn_coap_option_iterator_next().
+ */
+typedef struct sn_coap_option_view_ {
+    const uint8_t  *first_ptr;          /**< First value of the option. NULL if the option is not present */
+    uint16_t        first_len;          /**< Length of the first value */
+    uint16_t        count;              /**< Number of values, 0 if the option is not present */
+    uint16_t        joined_len;         /**< Length of all the values joined with one byte separators, as sn_coap_parser() stores them */
+} sn_coap_option_view_s;
+
+/**
+ * \brief Iterator over the values of a repeatable option view
+ */
+typedef struct sn_coap_option_iterator_ {
+    const uint8_t  *next_ptr;
+    uint16_t        next_len;
+    uint16_t        left;
+} sn_coap_option_iterator_s;
+
+/**
+ * \brief CoAP message parsed without allocations by sn_coap_parser_view()
+ *
+ * All the pointers reference the parsed packet buffer and are valid only as long as it is.
+ * Values have the same defaults as the fields of sn_coap_hdr_s and sn_coap_options_list_s.
+ */
+typedef struct sn_coap_hdr_view_ {
+    coap_version_e          coap_version;
+    sn_coap_msg_type_e      msg_type;
+    sn_coap_msg_code_e      msg_code;
+    uint16_t                msg_id;
+    uint16_t                payload_len;
+    sn_coap_content_format_e content_format;    /**< COAP_CT_NONE if not present */
+    sn_coap_content_format_e accept;            /**< COAP_CT_NONE if not present */
+
+    unsigned int            use_size1:1;
+    unsigned int            use_size2:1;
+    uint32_t                max_age;
+    uint32_t                size1;
+    uint32_t                size2;
+    int32_t                 uri_port;           /**< -1 if not present */
+    int32_t                 observe;            /**< COAP_OBSERVE_NONE if not present */
+    int32_t                 block1;             /**< -1 if not present */
+    int32_t                 block2;             /**< -1 if not present */
+
+    const uint8_t          *payload_ptr;        /**< NULL if there is no payload */
+
+    sn_coap_option_view_s   token;
+    sn_coap_option_view_s   uri_path;
+    sn_coap_option_view_s   uri_query;
+    sn_coap_option_view_s   uri_host;
+    sn_coap_option_view_s   location_path;
+    sn_coap_option_view_s   location_query;
+    sn_coap_option_view_s   etag;
+    sn_coap_option_view_s   proxy_uri;
+} sn_coap_hdr_view_s;
+
 /* * * * * * * * * * * * * * */
 /* * * * ENUMERATIONS  * * * */
 /* * * * * * * * * * * * * * */
@@ -312,6 +375,46 @@ typedef struct sn_nsdl_addr_ {
  */
 extern sn_coap_hdr_s *sn_coap_parser(struct coap_s *handle, uint16_t packet_data_len, uint8_t *packet_data_ptr, coap_version_e *coap_version_ptr);
 
+/**
+ * \fn int8_t sn_coap_parser_view(uint16_t packet_data_len, const uint8_t *packet_data_ptr, sn_coap_hdr_view_s *dst_view_ptr)
+ *
+ * \brief Parses CoAP message from given Packet data without allocating or copying anything
+ *
+ *        Performs the same checks as sn_coap_parser(), and also rejects an option value cut short by
+ *        the end of the packet. Options and payload are returned as pointers into the packet data,
+ *        which must be kept until the view is no longer used.
+ *
+ * \param packet_data_len is length of given Packet data to be parsed to CoAP message
+ *
+ * \param *packet_data_ptr is source for Packet data to be parsed to CoAP message
+ *
+ * \param *dst_view_ptr is destination for the parsed CoAP message
+ *
+ * \return 0 on success.\n
+ *         -1 if the message is malformed (sn_coap_parser() would return COAP_STATUS_PARSER_ERROR_IN_HEADER)\n
+ *         -2 if a given pointer is NULL or the packet is shorter than a CoAP header
+ */
+extern int8_t sn_coap_parser_view(uint16_t packet_data_len, const uint8_t *packet_data_ptr, sn_coap_hdr_view_s *dst_view_ptr);
+
+/**
+ * \brief Starts iterating over the values of an option of a parsed message view
+ *
+ * \param *iterator_ptr is the iterator to initialise
+ * \param *option_ptr is the option, e.g. &view.uri_path
+ */
+extern void sn_coap_option_iterator_init(sn_coap_option_iterator_s *iterator_ptr, const sn_coap_option_view_s *option_ptr);
+
+/**
+ * \brief Returns the next value of an option of a parsed message view
+ *
+ * \param *iterator_ptr is the iterator set up by sn_coap_option_iterator_init()
+ * \param **value_pptr is destination for a pointer to the value in the packet data
+ * \param *value_len_ptr is destination for the length of the value
+ *
+ * \return true if a value was returned, false when there are no more values
+ */
+extern bool sn_coap_option_iterator_next(sn_coap_option_iterator_s *iterator_ptr, const uint8_t **value_pptr, uint16_t *value_len_ptr);
+
 /**
  * \fn void sn_coap_parser_release_allocated_coap_msg_mem(struct coap_s *handle, sn_coap_hdr_s *freed_coap_msg_ptr)
  *
@@ -370,6 +473,32 @@ extern uint16_t sn_coap_builder_calc_needed_packet_data_size(const sn_coap_hdr_s
  */
 extern int16_t sn_coap_builder_2(uint8_t *dst_packet_data_ptr, const sn_coap_hdr_s *src_coap_msg_ptr, uint16_t blockwise_payload_size);
 
+/**
+ * \fn int16_t sn_coap_builder_3(uint8_t *dst_packet_data_ptr, uint16_t dst_packet_data_size, const sn_coap_hdr_s *src_coap_msg_ptr)
+ *
+ * \brief Builds an outgoing message buffer from a CoAP header structure in one pass.
+ *
+ *        Unlike sn_coap_builder_2(), the message is validated while it is written, so
+ *        sn_coap_builder_calc_needed_packet_data_size_2() does not need to be called
+ *        first. Any buffer large enough for the message can be used, for example one
+ *        sized for the largest message the application sends.
+ *
+ *        Payload is written as given; a blockwised message must have its payload_len
+ *        set to the block size before building.
+ *
+ * \param *dst_packet_data_ptr is pointer to allocated destination to built CoAP packet
+ *
+ * \param dst_packet_data_size is size of the destination buffer
+ *
+ * \param *src_coap_msg_ptr is pointer to source structure for building Packet data
+ *
+ * \return Return value is byte count of built Packet data. In failure cases:\n
+ *          -1 = Failure in given CoAP header structure\n
+ *          -2 = Failure in given pointer (= NULL)\n
+ *          -3 = Destination buffer is too small
+ */
+extern int16_t sn_coap_builder_3(uint8_t *dst_packet_data_ptr, uint16_t dst_packet_data_size, const sn_coap_hdr_s *src_coap_msg_ptr);
+
 /**
  * \fn uint16_t sn_coap_builder_calc_needed_packet_data_size_2(sn_coap_hdr_s *src_coap_msg_ptr, uint16_t blockwise_payload_size)
  *
@@ -91,6 +91,99 @@ extern int8_t sn_coap_protocol_destroy(struct coap_s *handle);
  */
 extern int16_t sn_coap_protocol_build(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint8_t *dst_packet_data_ptr, sn_coap_hdr_s *src_coap_msg_ptr, void *param);
 
+/**
+ * \fn int16_t sn_coap_protocol_build_2(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint8_t *dst_packet_data_ptr, uint16_t dst_packet_data_size, sn_coap_hdr_s *src_coap_msg_ptr, void *param)
+ *
+ * \brief Builds Packet data in one pass and shares the same buffer for resending
+ *
+ *        Message is built with sn_coap_builder_3(). dst_packet_data_ptr must be allocated with
+ *        sn_coap_protocol_packet_alloc(). Instead of copying a confirmable message, the resending
+ *        list takes a reference to the buffer. The caller always releases its own reference with
+ *        sn_coap_protocol_packet_release(), also when an error is returned.
+ *
+ * \param *dst_addr_ptr is pointer to destination address where CoAP message
+ *        will be sent
+ *
+ * \param *dst_packet_data_ptr is pointer to destination of built Packet data
+ *
+ * \param dst_packet_data_size is size of the destination buffer
+ *
+ * \param *src_coap_msg_ptr is pointer to source of built Packet data
+ *
+ * \param param void pointer that will be passed to tx/rx function callback when those are called.
+ *
+ * \return Return value is byte count of built Packet data. In failure cases
+ *         same values as sn_coap_protocol_build() and:\n
+ *          -3 = Destination buffer is too small
+ */
+extern int16_t sn_coap_protocol_build_2(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint8_t *dst_packet_data_ptr, uint16_t dst_packet_data_size, sn_coap_hdr_s *src_coap_msg_ptr, void *param);
+
+/**
+ * \fn uint8_t *sn_coap_protocol_packet_alloc(struct coap_s *handle, uint16_t packet_len)
+ *
+ * \brief Allocates a reference counted Packet data buffer
+ *
+ *        The buffer can be shared by the caller, the resending list and the transport
+ *        without copying. It is freed when the last reference is released. Reference
+ *        counts are not atomic, so all holders must use the buffer from the thread
+ *        that runs the CoAP library.
+ *
+ * \param *handle Pointer to CoAP library handle, its allocator is used
+ *
+ * \param packet_len Size of the Packet data
+ *
+ * \return Pointer to Packet data holding one reference, NULL if allocation failed
+ */
+extern uint8_t *sn_coap_protocol_packet_alloc(struct coap_s *handle, uint16_t packet_len);
+
+/**
+ * \fn void sn_coap_protocol_packet_release(uint8_t *packet_ptr)
+ *
+ * \brief Releases one reference to a buffer from sn_coap_protocol_packet_alloc()
+ *
+ * \param *packet_ptr Pointer to Packet data, NULL is ignored
+ */
+extern void sn_coap_protocol_packet_release(uint8_t *packet_ptr);
+
+/**
+ * \fn uint8_t *sn_coap_protocol_packet_ref_tx(struct coap_s *handle, const uint8_t *data_ptr)
+ *
+ * \brief Takes a reference to the Packet data being transmitted
+ *
+ *        Can be called only from the TX callback. If the data passed to the callback is a
+ *        reference counted buffer, the transport can queue it instead of copying the data.
+ *
+ * \param *handle Pointer to CoAP library handle
+ *
+ * \param *data_ptr Data pointer given to the TX callback
+ *
+ * \return New reference to data_ptr, to be released with sn_coap_protocol_packet_release(),
+ *         or NULL if the data is not a shareable buffer
+ */
+extern uint8_t *sn_coap_protocol_packet_ref_tx(struct coap_s *handle, const uint8_t *data_ptr);
+
+/**
+ * \fn uint8_t sn_coap_protocol_send_packet(struct coap_s *handle, uint8_t *packet_ptr, uint16_t packet_len, sn_nsdl_addr_s *dst_addr_ptr, void *param)
+ *
+ * \brief Passes a buffer from sn_coap_protocol_packet_alloc() to the TX callback
+ *
+ *        During the call the TX callback can take its own reference with
+ *        sn_coap_protocol_packet_ref_tx(). The caller keeps its reference.
+ *
+ * \param *handle Pointer to CoAP library handle
+ *
+ * \param *packet_ptr Pointer to built Packet data
+ *
+ * \param packet_len Length of the Packet data
+ *
+ * \param *dst_addr_ptr Pointer to destination address
+ *
+ * \param param void pointer that will be passed to tx function callback
+ *
+ * \return Return value of the TX callback, 0 if parameters are invalid
+ */
+extern uint8_t sn_coap_protocol_send_packet(struct coap_s *handle, uint8_t *packet_ptr, uint16_t packet_len, sn_nsdl_addr_s *dst_addr_ptr, void *param);
+
 /**
  * \fn sn_coap_hdr_s *sn_coap_protocol_parse(struct coap_s *handle, sn_nsdl_addr_s *src_addr_ptr, uint16_t packet_data_len, uint8_t *packet_data_ptr)
  *
@@ -134,6 +227,47 @@ extern sn_coap_hdr_s *sn_coap_protocol_parse(struct coap_s *handle, sn_nsdl_addr
 
 extern int8_t sn_coap_protocol_exec(struct coap_s *handle, uint32_t current_time);
 
+/**
+ * \fn int8_t sn_coap_protocol_get_next_exec_time(struct coap_s *handle, uint32_t *next_time)
+ *
+ * \brief Tells when sn_coap_protocol_exec() has work to do next, that is the earliest
+ *        message re-sending time or expiry time of duplication or blockwise data.
+ *
+ *        Caller can use this to sleep until the given time instead of calling
+ *        sn_coap_protocol_exec() periodically. Value must be re-read after any
+ *        CoAP message has been built or parsed, as those can add new entries.
+ *
+ * \param *handle Pointer to CoAP library handle
+ *
+ * \param *next_time Filled with the System time, in the same time base as given to
+ *        sn_coap_protocol_exec(), at which sn_coap_protocol_exec() should be called next.
+ *        Time can be in the past if work is already due.
+ *
+ * \return  0 if next_time was set
+ *          -1 if failed or if there is nothing pending
+ */
+extern int8_t sn_coap_protocol_get_next_exec_time(struct coap_s *handle, uint32_t *next_time);
+
+/**
+ * \fn int8_t sn_coap_protocol_set_system_time_callback(struct coap_s *handle, uint32_t (*system_time_callback)(void))
+ *
+ * \brief Sets a function that returns the current System time, in the same time base as given to
+ *        sn_coap_protocol_exec().
+ *
+ *        Messages stored for re-sending, duplicate detection or blockwise transfer are then timed
+ *        from the current time instead of the time of the last sn_coap_protocol_exec() call.
+ *        This is needed if sn_coap_protocol_exec() is called only when
+ *        sn_coap_protocol_get_next_exec_time() tells it to be.
+ *
+ * \param *handle Pointer to CoAP library handle
+ *
+ * \param system_time_callback Function returning the System time, NULL to use the time of
+ *        the last sn_coap_protocol_exec() call
+ *
+ * \return  0 = success, -1 = failure
+ */
+extern int8_t sn_coap_protocol_set_system_time_callback(struct coap_s *handle, uint32_t (*system_time_callback)(void));
+
 /**
  * \fn int8_t sn_coap_protocol_set_block_size(uint16_t block_size)
  *
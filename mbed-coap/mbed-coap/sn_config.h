@@ -223,6 +223,23 @@
 #define SN_COAP_MAX_ALLOWED_DUPLICATION_MESSAGE_COUNT   6
 #endif
 
+/**
+ * \def SN_COAP_INDEXED_MESSAGE_LOOKUP
+ * \brief Number of hash buckets used to index the duplicate detection list and the resending queue.
+ * With the index, the searches done for every received packet (duplicate check, removal of the
+ * acknowledged message) do not scan the whole lists. Useful when the duplication buffer or the
+ * resending queue is configured large. Costs one pointer per bucket per index.
+ * Must be power of two. Setting this to 0 disables the feature.
+ * By default, this feature is disabled.
+ */
+#ifdef MBED_CONF_MBED_CLIENT_SN_COAP_INDEXED_MESSAGE_LOOKUP
+#define SN_COAP_INDEXED_MESSAGE_LOOKUP MBED_CONF_MBED_CLIENT_SN_COAP_INDEXED_MESSAGE_LOOKUP
+#endif
+
+#ifndef SN_COAP_INDEXED_MESSAGE_LOOKUP
+#define SN_COAP_INDEXED_MESSAGE_LOOKUP              0   /**< Number of index hash buckets, 0 disables indexing */
+#endif
+
 /**
  * \def SN_COAP_DUPLICATION_MAX_TIME_MSGS_STORED
  * \brief Maximum time in seconds howe long message is kept for duplicate detection.
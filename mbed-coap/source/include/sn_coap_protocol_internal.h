@@ -43,6 +43,12 @@ struct sn_coap_hdr_;
 
 int8_t prepare_blockwise_message(struct coap_s *handle, struct sn_coap_hdr_ *coap_hdr_ptr);
 
+/* Header of a reference counted Packet data buffer, the Packet data follows right after it */
+typedef struct coap_packet_buffer_ {
+    void                (*free_fn)(void *); /* Free function of the CoAP handle which allocated the buffer */
+    uint16_t            ref_count;          /* Number of holders: caller, resending list, transport queue */
+} coap_packet_buffer_s;
+
 /* Structure which is stored to Linked list for message sending purposes */
 typedef struct coap_send_msg_ {
     uint8_t             resending_counter;  /* Tells how many times message is still tried to resend */
@@ -53,6 +59,11 @@ typedef struct coap_send_msg_ {
     void                *param;             /* Extra parameter that will be passed to TX/RX callback functions */
 
     ns_list_link_t      link;
+
+#if SN_COAP_INDEXED_MESSAGE_LOOKUP
+    struct coap_send_msg_ *msg_id_next;     /* Next message in the same message ID index bucket */
+    struct coap_send_msg_ *token_next;      /* Next message in the same token index bucket */
+#endif
 } coap_send_msg_s;
 
 typedef NS_LIST_HEAD(coap_send_msg_s, link) coap_send_msg_list_t;
@@ -66,6 +77,9 @@ typedef struct coap_duplication_info_ {
     sn_nsdl_addr_s      *address;
     void                *param;
     ns_list_link_t      link;
+#if SN_COAP_INDEXED_MESSAGE_LOOKUP
+    struct coap_duplication_info_ *index_next; /* Next info in the same index bucket */
+#endif
 } coap_duplication_info_s;
 
 typedef NS_LIST_HEAD(coap_duplication_info_s, link) coap_duplication_info_list_t;
@@ -111,14 +125,24 @@ struct coap_s {
     uint8_t (*sn_coap_tx_callback)(uint8_t *, uint16_t, sn_nsdl_addr_s *, void *);
     int8_t (*sn_coap_rx_callback)(sn_coap_hdr_s *, sn_nsdl_addr_s *, void *);
 
+    const uint8_t *tx_packet_ptr; /* Packet data buffer being passed to TX callback, see sn_coap_protocol_packet_ref_tx() */
+
     #if ENABLE_RESENDINGS /* If Message resending is not used at all, this part of code will not be compiled */
         coap_send_msg_list_t linked_list_resent_msgs; /* Active resending messages are stored to this Linked list */
         uint16_t count_resent_msgs;
+        uint32_t size_resent_msgs; /* Total packet length of active resending messages */
+    #if SN_COAP_INDEXED_MESSAGE_LOOKUP
+        coap_send_msg_s *resent_msgs_by_msg_id[SN_COAP_INDEXED_MESSAGE_LOOKUP]; /* Hash index of resending messages keyed on message ID */
+        coap_send_msg_s *resent_msgs_by_token[SN_COAP_INDEXED_MESSAGE_LOOKUP];  /* Hash index of resending messages keyed on token */
+    #endif
     #endif
 
     #if SN_COAP_DUPLICATION_MAX_MSGS_COUNT /* If Message duplication detection is not used at all, this part of code will not be compiled */
         coap_duplication_info_list_t  linked_list_duplication_msgs; /* Messages for duplicated messages detection is stored to this Linked list */
         uint16_t                      count_duplication_msgs;
+    #if SN_COAP_INDEXED_MESSAGE_LOOKUP
+        coap_duplication_info_s       *duplication_msgs_index[SN_COAP_INDEXED_MESSAGE_LOOKUP]; /* Hash index of duplication infos keyed on message ID and port */
+    #endif
     #endif
 
     #if SN_COAP_BLOCKWISE_ENABLED || SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE /* If Message blockwise is not enabled, this part of code will not be compiled */
@@ -127,6 +151,7 @@ struct coap_s {
     #endif
 
     uint32_t system_time;    /* System time seconds */
+    uint32_t (*sn_coap_system_time_callback)(void); /* Reads the current system time, see sn_coap_protocol_set_system_time_callback() */
     uint16_t sn_coap_block_data_size;
     uint8_t sn_coap_resending_queue_msgs;
     uint32_t sn_coap_resending_queue_bytes;
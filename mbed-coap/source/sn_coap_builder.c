@@ -36,18 +36,34 @@
 #include "mbed-trace/mbed_trace.h"
 
 #define TRACE_GROUP "coap"
+/* * * * LOCAL TYPES * * * */
+
+/* Walks the parts of a repeatable option string (Uri-Path, Uri-Query etc.) in one pass */
+typedef struct sn_coap_builder_option_part_iterator_ {
+    const uint8_t *query_ptr;
+    uint16_t      query_len;
+    uint16_t      position_index; /* Next character searched for the start of a part */
+    uint16_t      length_index;   /* Next character counted into the length of a part */
+    uint16_t      tail_len;       /* Length of the unterminated last part */
+    uint8_t       part_index;
+    uint8_t       separator;
+} sn_coap_builder_option_part_iterator_s;
+
 /* * * * LOCAL FUNCTION PROTOTYPES * * * */
-static int8_t   sn_coap_builder_header_build(uint8_t **dst_packet_data_pptr, const sn_coap_hdr_s *src_coap_msg_ptr);
-static int8_t   sn_coap_builder_options_build(uint8_t **dst_packet_data_pptr, const sn_coap_hdr_s *src_coap_msg_ptr);
+static int16_t  sn_coap_builder_build(uint8_t *dst_packet_data_ptr, const uint8_t *dst_end_ptr, const sn_coap_hdr_s *src_coap_msg_ptr);
+static int8_t   sn_coap_builder_header_build(uint8_t **dst_packet_data_pptr, const uint8_t *dst_end_ptr, const sn_coap_hdr_s *src_coap_msg_ptr);
+static int8_t   sn_coap_builder_options_build(uint8_t **dst_packet_data_pptr, const uint8_t *dst_end_ptr, const sn_coap_hdr_s *src_coap_msg_ptr);
 static uint16_t sn_coap_builder_options_calc_option_size(uint16_t query_len, const uint8_t *query_ptr, sn_coap_option_numbers_e option);
-static int16_t  sn_coap_builder_options_build_add_one_option(uint8_t **dst_packet_data_pptr, uint16_t option_len, const uint8_t *option_ptr, sn_coap_option_numbers_e option_number, uint16_t *previous_option_number);
-static void     sn_coap_builder_options_build_add_multiple_option(uint8_t **dst_packet_data_pptr, const uint8_t *src_pptr, uint16_t src_len_ptr, sn_coap_option_numbers_e option, uint16_t *previous_option_number);
-static uint8_t  sn_coap_builder_options_build_add_uint_option(uint8_t **dst_packet_data_pptr, uint32_t value, sn_coap_option_numbers_e option_number, uint16_t *previous_option_number);
-static uint8_t  sn_coap_builder_options_get_option_part_count(uint16_t query_len, const uint8_t *query_ptr, sn_coap_option_numbers_e option);
-static uint16_t sn_coap_builder_options_get_option_part_length_from_whole_option_string(uint16_t query_len, const uint8_t *query_ptr, uint8_t query_index, sn_coap_option_numbers_e option);
-static int16_t  sn_coap_builder_options_get_option_part_position(uint16_t query_len, const uint8_t *query_ptr, uint8_t query_index, sn_coap_option_numbers_e option);
-static void     sn_coap_builder_payload_build(uint8_t **dst_packet_data_pptr, const sn_coap_hdr_s *src_coap_msg_ptr);
+static bool     sn_coap_builder_options_check_part_length(uint16_t part_len, sn_coap_option_numbers_e option);
+static int8_t   sn_coap_builder_options_build_add_one_option(uint8_t **dst_packet_data_pptr, const uint8_t *dst_end_ptr, uint16_t option_len, const uint8_t *option_ptr, sn_coap_option_numbers_e option_number, uint16_t *previous_option_number);
+static int8_t   sn_coap_builder_options_build_add_multiple_option(uint8_t **dst_packet_data_pptr, const uint8_t *dst_end_ptr, const uint8_t *src_pptr, uint16_t src_len_ptr, sn_coap_option_numbers_e option, uint16_t *previous_option_number);
+static int8_t   sn_coap_builder_options_build_add_uint_option(uint8_t **dst_packet_data_pptr, const uint8_t *dst_end_ptr, uint32_t value, sn_coap_option_numbers_e option_number, uint16_t *previous_option_number);
+static uint16_t sn_coap_builder_options_get_option_part_count(uint16_t query_len, const uint8_t *query_ptr, sn_coap_option_numbers_e option);
+static void     sn_coap_builder_options_part_iterator_init(sn_coap_builder_option_part_iterator_s *iterator_ptr, uint16_t query_len, const uint8_t *query_ptr, sn_coap_option_numbers_e option);
+static const uint8_t *sn_coap_builder_options_part_iterator_next(sn_coap_builder_option_part_iterator_s *iterator_ptr, uint16_t *part_len_ptr);
+static int8_t   sn_coap_builder_payload_build(uint8_t **dst_packet_data_pptr, const uint8_t *dst_end_ptr, const sn_coap_hdr_s *src_coap_msg_ptr);
 static uint8_t  sn_coap_builder_options_calculate_jump_need(const sn_coap_hdr_s *src_coap_msg_ptr);
+static bool     sn_coap_builder_has_room(const uint8_t *dst_ptr, const uint8_t *dst_end_ptr, uint32_t needed_len);
 
 sn_coap_hdr_s *sn_coap_build_response(struct coap_s *handle, const sn_coap_hdr_s *coap_packet_ptr, uint8_t msg_code)
 {
@@ -103,8 +119,6 @@ int16_t sn_coap_builder(uint8_t *dst_packet_data_ptr, const sn_coap_hdr_s *src_c
 
 int16_t sn_coap_builder_2(uint8_t *dst_packet_data_ptr, const sn_coap_hdr_s *src_coap_msg_ptr, uint16_t blockwise_payload_size)
 {
-    uint8_t *base_packet_data_ptr;
-
     /* * * * Check given pointers  * * * */
     if (dst_packet_data_ptr == NULL || src_coap_msg_ptr == NULL) {
         return -2;
@@ -120,16 +134,52 @@ int16_t sn_coap_builder_2(uint8_t *dst_packet_data_ptr, const sn_coap_hdr_s *src
     // XXX: this should not be needed anymore but I have no courage to remove it yet.
     memset(dst_packet_data_ptr, 0, dst_byte_count_to_be_built);
 
+    /* Message is already validated and the caller has sized the buffer, so the build is not bounded */
+    return sn_coap_builder_build(dst_packet_data_ptr, NULL, src_coap_msg_ptr);
+}
+
+int16_t sn_coap_builder_3(uint8_t *dst_packet_data_ptr, uint16_t dst_packet_data_size, const sn_coap_hdr_s *src_coap_msg_ptr)
+{
+    /* * * * Check given pointers  * * * */
+    if (dst_packet_data_ptr == NULL || src_coap_msg_ptr == NULL) {
+        return -2;
+    }
+
+    /* Built length is returned as int16_t */
+    if (dst_packet_data_size > INT16_MAX) {
+        dst_packet_data_size = INT16_MAX;
+    }
+
+    return sn_coap_builder_build(dst_packet_data_ptr, dst_packet_data_ptr + dst_packet_data_size, src_coap_msg_ptr);
+}
+
+/**
+ * \fn static int16_t sn_coap_builder_build(uint8_t *dst_packet_data_ptr, const uint8_t *dst_end_ptr, const sn_coap_hdr_s *src_coap_msg_ptr)
+ *
+ * \brief Validates and builds Packet data in one pass
+ *
+ * \param *dst_packet_data_ptr is destination for built Packet data
+ *
+ * \param *dst_end_ptr is end of destination buffer, NULL if the buffer is known to be large enough
+ *
+ * \param *src_coap_msg_ptr is source for building Packet data
+ *
+ * \return Return value is byte count of built Packet data, -1 for invalid message and -3 if buffer is too small
+ */
+static int16_t sn_coap_builder_build(uint8_t *dst_packet_data_ptr, const uint8_t *dst_end_ptr, const sn_coap_hdr_s *src_coap_msg_ptr)
+{
     /* * * * Store base (= original) destination Packet data pointer for later usage * * * */
-    base_packet_data_ptr = dst_packet_data_ptr;
+    uint8_t *base_packet_data_ptr = dst_packet_data_ptr;
+    int8_t  status;
 
     /* * * * * * * * * * * * * * * * * * */
     /* * * * Header part building  * * * */
     /* * * * * * * * * * * * * * * * * * */
-    if (sn_coap_builder_header_build(&dst_packet_data_ptr, src_coap_msg_ptr) != 0) {
+    status = sn_coap_builder_header_build(&dst_packet_data_ptr, dst_end_ptr, src_coap_msg_ptr);
+    if (status != 0) {
         /* Header building failed */
-        tr_error("sn_coap_builder_2 - header building failed!");
-        return -1;
+        tr_error("sn_coap_builder_build - header building failed!");
+        return status;
     }
 
     /* If else than Reset message because Reset message must be empty */
@@ -137,16 +187,25 @@ int16_t sn_coap_builder_2(uint8_t *dst_packet_data_ptr, const sn_coap_hdr_s *src
         /* * * * * * * * * * * * * * * * * * */
         /* * * * Options part building * * * */
         /* * * * * * * * * * * * * * * * * * */
-        sn_coap_builder_options_build(&dst_packet_data_ptr, src_coap_msg_ptr);
+        status = sn_coap_builder_options_build(&dst_packet_data_ptr, dst_end_ptr, src_coap_msg_ptr);
+        if (status != 0) {
+            tr_error("sn_coap_builder_build - options building failed!");
+            return status;
+        }
 
         /* * * * * * * * * * * * * * * * * * */
         /* * * * Payload part building * * * */
         /* * * * * * * * * * * * * * * * * * */
-        sn_coap_builder_payload_build(&dst_packet_data_ptr, src_coap_msg_ptr);
+        status = sn_coap_builder_payload_build(&dst_packet_data_ptr, dst_end_ptr, src_coap_msg_ptr);
+        if (status != 0) {
+            tr_error("sn_coap_builder_build - payload building failed!");
+            return status;
+        }
     }
     /* * * * Return built Packet data length * * * */
     return (dst_packet_data_ptr - base_packet_data_ptr);
 }
+
 uint16_t sn_coap_builder_calc_needed_packet_data_size(const sn_coap_hdr_s *src_coap_msg_ptr)
 {
     return sn_coap_builder_calc_needed_packet_data_size_2(src_coap_msg_ptr, SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE);
@@ -197,7 +256,7 @@ uint16_t sn_coap_builder_calc_needed_packet_data_size_2(const sn_coap_hdr_s *src
                 tr_error("sn_coap_builder_calc_needed_packet_data_size_2 - content format too large!");
                 return 0;
             }
-            returned_byte_count += sn_coap_builder_options_build_add_uint_option(NULL, src_coap_msg_ptr->content_format, COAP_OPTION_CONTENT_FORMAT, &tempInt);
+            returned_byte_count += sn_coap_builder_options_build_add_uint_option(NULL, NULL, src_coap_msg_ptr->content_format, COAP_OPTION_CONTENT_FORMAT, &tempInt);
         }
         /* If options list pointer exists */
         if (src_coap_msg_ptr->options_list_ptr != NULL) {
@@ -210,11 +269,11 @@ uint16_t sn_coap_builder_calc_needed_packet_data_size_2(const sn_coap_hdr_s *src
                     tr_error("sn_coap_builder_calc_needed_packet_data_size_2 - accept too large!");
                     return 0;
                 }
-                returned_byte_count += sn_coap_builder_options_build_add_uint_option(NULL, src_options_list_ptr->accept, COAP_OPTION_ACCEPT, &tempInt);
+                returned_byte_count += sn_coap_builder_options_build_add_uint_option(NULL, NULL, src_options_list_ptr->accept, COAP_OPTION_ACCEPT, &tempInt);
             }
             /* MAX AGE - An integer option, omitted for default. Up to 4 bytes */
             if (src_options_list_ptr->max_age != COAP_OPTION_MAX_AGE_DEFAULT) {
-                returned_byte_count += sn_coap_builder_options_build_add_uint_option(NULL, src_options_list_ptr->max_age, COAP_OPTION_MAX_AGE, &tempInt);
+                returned_byte_count += sn_coap_builder_options_build_add_uint_option(NULL, NULL, src_options_list_ptr->max_age, COAP_OPTION_MAX_AGE, &tempInt);
             }
             /* PROXY URI - Length of this option is  1-1034 bytes */
             if (src_options_list_ptr->proxy_uri_ptr != NULL) {
@@ -282,7 +341,7 @@ uint16_t sn_coap_builder_calc_needed_packet_data_size_2(const sn_coap_hdr_s *src
                     tr_error("sn_coap_builder_calc_needed_packet_data_size_2 - uri port too large!");
                     return 0;
                 }
-                returned_byte_count += sn_coap_builder_options_build_add_uint_option(NULL, src_options_list_ptr->uri_port, COAP_OPTION_URI_PORT, &tempInt);
+                returned_byte_count += sn_coap_builder_options_build_add_uint_option(NULL, NULL, src_options_list_ptr->uri_port, COAP_OPTION_URI_PORT, &tempInt);
             }
             /* lOCATION QUERY - Repeatable option. Length of this option is 0-255 bytes */
             if (src_options_list_ptr->location_query_ptr != NULL) {
@@ -300,7 +359,7 @@ uint16_t sn_coap_builder_calc_needed_packet_data_size_2(const sn_coap_hdr_s *src
                 if ((uint32_t) src_options_list_ptr->observe > 0xffffff) {
                     return 0;
                 }
-                returned_byte_count += sn_coap_builder_options_build_add_uint_option(NULL, src_options_list_ptr->observe, COAP_OPTION_OBSERVE, &tempInt);
+                returned_byte_count += sn_coap_builder_options_build_add_uint_option(NULL, NULL, src_options_list_ptr->observe, COAP_OPTION_OBSERVE, &tempInt);
             }
             /* URI QUERY - Repeatable option. Length of this option is 1-255 */
             if (src_options_list_ptr->uri_query_ptr != NULL) {
@@ -320,11 +379,11 @@ uint16_t sn_coap_builder_calc_needed_packet_data_size_2(const sn_coap_hdr_s *src
                     tr_error("sn_coap_builder_calc_needed_packet_data_size_2 - block1 too large!");
                     return 0;
                 }
-                returned_byte_count += sn_coap_builder_options_build_add_uint_option(NULL, src_options_list_ptr->block1, COAP_OPTION_BLOCK1, &tempInt);
+                returned_byte_count += sn_coap_builder_options_build_add_uint_option(NULL, NULL, src_options_list_ptr->block1, COAP_OPTION_BLOCK1, &tempInt);
             }
             /* SIZE1 - Length of this option is 0-4 bytes */
             if (src_options_list_ptr->use_size1) {
-                returned_byte_count += sn_coap_builder_options_build_add_uint_option(NULL, src_options_list_ptr->size1, COAP_OPTION_SIZE1, &tempInt);
+                returned_byte_count += sn_coap_builder_options_build_add_uint_option(NULL, NULL, src_options_list_ptr->size1, COAP_OPTION_SIZE1, &tempInt);
             }
             /* BLOCK 2 - An integer option, up to 3 bytes */
             if (src_options_list_ptr->block2 != COAP_OPTION_BLOCK_NONE) {
@@ -332,11 +391,11 @@ uint16_t sn_coap_builder_calc_needed_packet_data_size_2(const sn_coap_hdr_s *src
                     tr_error("sn_coap_builder_calc_needed_packet_data_size_2 - block2 too large!");
                     return 0;
                 }
-                returned_byte_count += sn_coap_builder_options_build_add_uint_option(NULL, src_options_list_ptr->block2, COAP_OPTION_BLOCK2, &tempInt);
+                returned_byte_count += sn_coap_builder_options_build_add_uint_option(NULL, NULL, src_options_list_ptr->block2, COAP_OPTION_BLOCK2, &tempInt);
             }
             /* SIZE2 - Length of this option is 0-4 bytes */
             if (src_coap_msg_ptr->options_list_ptr->use_size2) {
-                returned_byte_count += sn_coap_builder_options_build_add_uint_option(NULL, src_options_list_ptr->size2, COAP_OPTION_SIZE2, &tempInt);
+                returned_byte_count += sn_coap_builder_options_build_add_uint_option(NULL, NULL, src_options_list_ptr->size2, COAP_OPTION_SIZE2, &tempInt);
             }
         }
 #if SN_COAP_BLOCKWISE_ENABLED || SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE
@@ -489,17 +548,19 @@ static uint8_t sn_coap_builder_options_calculate_jump_need(const sn_coap_hdr_s *
 }
 
 /**
- * \fn static int8_t sn_coap_builder_header_build(uint8_t **dst_packet_data_pptr, sn_coap_hdr_s *src_coap_msg_ptr)
+ * \fn static int8_t sn_coap_builder_header_build(uint8_t **dst_packet_data_pptr, const uint8_t *dst_end_ptr, sn_coap_hdr_s *src_coap_msg_ptr)
  *
  * \brief Builds Header part of Packet data
  *
  * \param **dst_packet_data_pptr is destination for built Packet data
  *
+ * \param *dst_end_ptr is end of destination buffer, NULL if not checked
+ *
  * \param *src_coap_msg_ptr is source for building Packet data
  *
- * \return Return value is 0 in ok case and -1 in failure case
+ * \return Return value is 0 in ok case, -1 in failure case and -3 if buffer is too small
  **************************************************************************** */
-static int8_t sn_coap_builder_header_build(uint8_t **dst_packet_data_pptr, const sn_coap_hdr_s *src_coap_msg_ptr)
+static int8_t sn_coap_builder_header_build(uint8_t **dst_packet_data_pptr, const uint8_t *dst_end_ptr, const sn_coap_hdr_s *src_coap_msg_ptr)
 {
     /* * * * Check validity of Header values * * * */
     if (sn_coap_header_validity_check(src_coap_msg_ptr, COAP_VERSION) != 0) {
@@ -507,6 +568,10 @@ static int8_t sn_coap_builder_header_build(uint8_t **dst_packet_data_pptr, const
         return -1;
     }
 
+    if (!sn_coap_builder_has_room(*dst_packet_data_pptr, dst_end_ptr, COAP_HEADER_LENGTH)) {
+        return -3;
+    }
+
     uint8_t* dest_packet = *dst_packet_data_pptr;
 
     /* Set CoAP Version, Message type and Token length */
@@ -526,17 +591,22 @@ static int8_t sn_coap_builder_header_build(uint8_t **dst_packet_data_pptr, const
 }
 
 /**
- * \fn static int8_t sn_coap_builder_options_build(uint8_t **dst_packet_data_pptr, sn_coap_hdr_s *src_coap_msg_ptr)
+ * \fn static int8_t sn_coap_builder_options_build(uint8_t **dst_packet_data_pptr, const uint8_t *dst_end_ptr, sn_coap_hdr_s *src_coap_msg_ptr)
  *
  * \brief Builds Options part of Packet data
  *
+ * Option values are validated while they are written, with the same limits
+ * as sn_coap_builder_calc_needed_packet_data_size_2().
+ *
  * \param **dst_packet_data_pptr is destination for built Packet data
  *
+ * \param *dst_end_ptr is end of destination buffer, NULL if not checked
+ *
  * \param *src_coap_msg_ptr is source for building Packet data
  *
- * \return Return value is 0 in every case
+ * \return Return value is 0 in ok case, -1 for invalid option and -3 if buffer is too small
  */
-static int8_t sn_coap_builder_options_build(uint8_t **dst_packet_data_pptr, const sn_coap_hdr_s *src_coap_msg_ptr)
+static int8_t sn_coap_builder_options_build(uint8_t **dst_packet_data_pptr, const uint8_t *dst_end_ptr, const sn_coap_hdr_s *src_coap_msg_ptr)
 {
     /* * * * Check if Options are used at all  * * * */
     if (src_coap_msg_ptr->uri_path_ptr == NULL && src_coap_msg_ptr->token_ptr == NULL &&
@@ -549,8 +619,18 @@ static int8_t sn_coap_builder_options_build(uint8_t **dst_packet_data_pptr, cons
     }
 
     /* * * * First add Token option  * * * */
+    if (src_coap_msg_ptr->token_ptr != NULL && (src_coap_msg_ptr->token_len > 8 || src_coap_msg_ptr->token_len < 1)) {
+        tr_error("sn_coap_builder_options_build - token too large!");
+        return -1;
+    }
+    if (!sn_coap_builder_has_room(*dst_packet_data_pptr, dst_end_ptr, src_coap_msg_ptr->token_len)) {
+        return -3;
+    }
     if (src_coap_msg_ptr->token_len && src_coap_msg_ptr->token_ptr) {
         memcpy(*dst_packet_data_pptr, src_coap_msg_ptr->token_ptr, src_coap_msg_ptr->token_len);
+    } else if (dst_end_ptr) {
+        /* Unbounded builds rely on the buffer being zeroed by the caller */
+        memset(*dst_packet_data_pptr, 0, src_coap_msg_ptr->token_len);
     }
     (*dst_packet_data_pptr) += src_coap_msg_ptr->token_len;
 
@@ -558,6 +638,7 @@ static int8_t sn_coap_builder_options_build(uint8_t **dst_packet_data_pptr, cons
 
     /* * * * Initialize previous Option number for new built message * * * */
     uint16_t previous_option_number = 0;
+    int8_t   status;
 
     //missing: COAP_OPTION_IF_MATCH, COAP_OPTION_IF_NONE_MATCH, COAP_OPTION_SIZE
 
@@ -566,87 +647,158 @@ static int8_t sn_coap_builder_options_build(uint8_t **dst_packet_data_pptr, cons
     /* Check if less used options are used at all */
     if (src_options_list_ptr != NULL) {
         /* * * * Build Uri-Host option * * * */
-        sn_coap_builder_options_build_add_one_option(dst_packet_data_pptr, src_options_list_ptr->uri_host_len,
-                     src_options_list_ptr->uri_host_ptr, COAP_OPTION_URI_HOST, &previous_option_number);
+        if (src_options_list_ptr->uri_host_ptr != NULL &&
+                (src_options_list_ptr->uri_host_len < 1 || src_options_list_ptr->uri_host_len > 255)) {
+            tr_error("sn_coap_builder_options_build - uri host too large!");
+            return -1;
+        }
+        if (sn_coap_builder_options_build_add_one_option(dst_packet_data_pptr, dst_end_ptr, src_options_list_ptr->uri_host_len,
+                     src_options_list_ptr->uri_host_ptr, COAP_OPTION_URI_HOST, &previous_option_number) < 0) {
+            return -3;
+        }
 
         /* * * * Build ETag option  * * * */
-        sn_coap_builder_options_build_add_multiple_option(dst_packet_data_pptr, src_options_list_ptr->etag_ptr,
+        status = sn_coap_builder_options_build_add_multiple_option(dst_packet_data_pptr, dst_end_ptr, src_options_list_ptr->etag_ptr,
                      src_options_list_ptr->etag_len, COAP_OPTION_ETAG, &previous_option_number);
+        if (status < 0) {
+            return status;
+        }
 
         /* * * * Build Observe option  * * * * */
         if (src_options_list_ptr->observe != COAP_OBSERVE_NONE) {
-            sn_coap_builder_options_build_add_uint_option(dst_packet_data_pptr, src_options_list_ptr->observe,
-                         COAP_OPTION_OBSERVE, &previous_option_number);
+            if ((uint32_t) src_options_list_ptr->observe > 0xffffff) {
+                tr_error("sn_coap_builder_options_build - observe too large!");
+                return -1;
+            }
+            if (sn_coap_builder_options_build_add_uint_option(dst_packet_data_pptr, dst_end_ptr, src_options_list_ptr->observe,
+                         COAP_OPTION_OBSERVE, &previous_option_number) < 0) {
+                return -3;
+            }
         }
 
         /* * * * Build Uri-Port option * * * */
         if (src_options_list_ptr->uri_port != COAP_OPTION_URI_PORT_NONE) {
-            sn_coap_builder_options_build_add_uint_option(dst_packet_data_pptr, src_options_list_ptr->uri_port,
-                         COAP_OPTION_URI_PORT, &previous_option_number);
+            if ((uint32_t) src_options_list_ptr->uri_port > 0xffff) {
+                tr_error("sn_coap_builder_options_build - uri port too large!");
+                return -1;
+            }
+            if (sn_coap_builder_options_build_add_uint_option(dst_packet_data_pptr, dst_end_ptr, src_options_list_ptr->uri_port,
+                         COAP_OPTION_URI_PORT, &previous_option_number) < 0) {
+                return -3;
+            }
         }
 
         /* * * * Build Location-Path option  * * * */
-        sn_coap_builder_options_build_add_multiple_option(dst_packet_data_pptr, src_options_list_ptr->location_path_ptr,
+        status = sn_coap_builder_options_build_add_multiple_option(dst_packet_data_pptr, dst_end_ptr, src_options_list_ptr->location_path_ptr,
                      src_options_list_ptr->location_path_len, COAP_OPTION_LOCATION_PATH, &previous_option_number);
+        if (status < 0) {
+            return status;
+        }
     }
     /* * * * Build Uri-Path option * * * */
-    sn_coap_builder_options_build_add_multiple_option(dst_packet_data_pptr, src_coap_msg_ptr->uri_path_ptr,
+    status = sn_coap_builder_options_build_add_multiple_option(dst_packet_data_pptr, dst_end_ptr, src_coap_msg_ptr->uri_path_ptr,
              src_coap_msg_ptr->uri_path_len, COAP_OPTION_URI_PATH, &previous_option_number);
+    if (status < 0) {
+        return status;
+    }
 
     /* * * * Build Content-Type option * * * */
     if (src_coap_msg_ptr->content_format != COAP_CT_NONE) {
-        sn_coap_builder_options_build_add_uint_option(dst_packet_data_pptr, src_coap_msg_ptr->content_format,
-                     COAP_OPTION_CONTENT_FORMAT, &previous_option_number);
+        if ((uint32_t) src_coap_msg_ptr->content_format > 0xffff) {
+            tr_error("sn_coap_builder_options_build - content format too large!");
+            return -1;
+        }
+        if (sn_coap_builder_options_build_add_uint_option(dst_packet_data_pptr, dst_end_ptr, src_coap_msg_ptr->content_format,
+                     COAP_OPTION_CONTENT_FORMAT, &previous_option_number) < 0) {
+            return -3;
+        }
     }
 
     if (src_options_list_ptr != NULL) {
         /* * * * Build Max-Age option  * * * */
         if (src_options_list_ptr->max_age != COAP_OPTION_MAX_AGE_DEFAULT) {
-            sn_coap_builder_options_build_add_uint_option(dst_packet_data_pptr, src_options_list_ptr->max_age,
-                         COAP_OPTION_MAX_AGE, &previous_option_number);
+            if (sn_coap_builder_options_build_add_uint_option(dst_packet_data_pptr, dst_end_ptr, src_options_list_ptr->max_age,
+                         COAP_OPTION_MAX_AGE, &previous_option_number) < 0) {
+                return -3;
+            }
         }
 
         /* * * * Build Uri-Query option  * * * * */
-        sn_coap_builder_options_build_add_multiple_option(dst_packet_data_pptr, src_options_list_ptr->uri_query_ptr,
+        status = sn_coap_builder_options_build_add_multiple_option(dst_packet_data_pptr, dst_end_ptr, src_options_list_ptr->uri_query_ptr,
                      src_options_list_ptr->uri_query_len, COAP_OPTION_URI_QUERY, &previous_option_number);
+        if (status < 0) {
+            return status;
+        }
 
         /* * * * Build Accept option  * * * * */
-        if (src_coap_msg_ptr->options_list_ptr->accept != COAP_CT_NONE) {
-            sn_coap_builder_options_build_add_uint_option(dst_packet_data_pptr, src_options_list_ptr->accept,
-                         COAP_OPTION_ACCEPT, &previous_option_number);
+        if (src_options_list_ptr->accept != COAP_CT_NONE) {
+            if ((uint32_t) src_options_list_ptr->accept > 0xffff) {
+                tr_error("sn_coap_builder_options_build - accept too large!");
+                return -1;
+            }
+            if (sn_coap_builder_options_build_add_uint_option(dst_packet_data_pptr, dst_end_ptr, src_options_list_ptr->accept,
+                         COAP_OPTION_ACCEPT, &previous_option_number) < 0) {
+                return -3;
+            }
         }
 
         /* * * * Build Location-Query option * * * */
-        sn_coap_builder_options_build_add_multiple_option(dst_packet_data_pptr, src_options_list_ptr->location_query_ptr,
+        status = sn_coap_builder_options_build_add_multiple_option(dst_packet_data_pptr, dst_end_ptr, src_options_list_ptr->location_query_ptr,
                      src_options_list_ptr->location_query_len, COAP_OPTION_LOCATION_QUERY, &previous_option_number);
+        if (status < 0) {
+            return status;
+        }
 
         /* * * * Build Block2 option * * * * */
-        if (src_coap_msg_ptr->options_list_ptr->block2 != COAP_OPTION_BLOCK_NONE) {
-            sn_coap_builder_options_build_add_uint_option(dst_packet_data_pptr, src_options_list_ptr->block2,
-                         COAP_OPTION_BLOCK2, &previous_option_number);
+        if (src_options_list_ptr->block2 != COAP_OPTION_BLOCK_NONE) {
+            if ((uint32_t) src_options_list_ptr->block2 > 0xffffff) {
+                tr_error("sn_coap_builder_options_build - block2 too large!");
+                return -1;
+            }
+            if (sn_coap_builder_options_build_add_uint_option(dst_packet_data_pptr, dst_end_ptr, src_options_list_ptr->block2,
+                         COAP_OPTION_BLOCK2, &previous_option_number) < 0) {
+                return -3;
+            }
         }
 
         /* * * * Build Block1 option * * * * */
-        if (src_coap_msg_ptr->options_list_ptr->block1 != COAP_OPTION_BLOCK_NONE) {
-            sn_coap_builder_options_build_add_uint_option(dst_packet_data_pptr, src_options_list_ptr->block1,
-                         COAP_OPTION_BLOCK1, &previous_option_number);
+        if (src_options_list_ptr->block1 != COAP_OPTION_BLOCK_NONE) {
+            if ((uint32_t) src_options_list_ptr->block1 > 0xffffff) {
+                tr_error("sn_coap_builder_options_build - block1 too large!");
+                return -1;
+            }
+            if (sn_coap_builder_options_build_add_uint_option(dst_packet_data_pptr, dst_end_ptr, src_options_list_ptr->block1,
+                         COAP_OPTION_BLOCK1, &previous_option_number) < 0) {
+                return -3;
+            }
         }
 
         /* * * * Build Size2 option * * * */
-        if (src_coap_msg_ptr->options_list_ptr->use_size2) {
-            sn_coap_builder_options_build_add_uint_option(dst_packet_data_pptr, src_options_list_ptr->size2,
-                         COAP_OPTION_SIZE2, &previous_option_number);
+        if (src_options_list_ptr->use_size2) {
+            if (sn_coap_builder_options_build_add_uint_option(dst_packet_data_pptr, dst_end_ptr, src_options_list_ptr->size2,
+                         COAP_OPTION_SIZE2, &previous_option_number) < 0) {
+                return -3;
+            }
         }
 
         /* * * * Build Proxy-Uri option * * * */
-        sn_coap_builder_options_build_add_one_option(dst_packet_data_pptr, src_options_list_ptr->proxy_uri_len,
-                     src_options_list_ptr->proxy_uri_ptr, COAP_OPTION_PROXY_URI, &previous_option_number);
+        if (src_options_list_ptr->proxy_uri_ptr != NULL &&
+                (src_options_list_ptr->proxy_uri_len < 1 || src_options_list_ptr->proxy_uri_len > 1034)) {
+            tr_error("sn_coap_builder_options_build - proxy uri too large!");
+            return -1;
+        }
+        if (sn_coap_builder_options_build_add_one_option(dst_packet_data_pptr, dst_end_ptr, src_options_list_ptr->proxy_uri_len,
+                     src_options_list_ptr->proxy_uri_ptr, COAP_OPTION_PROXY_URI, &previous_option_number) < 0) {
+            return -3;
+        }
 
 
         /* * * * Build Size1 option * * * */
         if (src_options_list_ptr->use_size1) {
-            sn_coap_builder_options_build_add_uint_option(dst_packet_data_pptr, src_options_list_ptr->size1,
-                         COAP_OPTION_SIZE1, &previous_option_number);
+            if (sn_coap_builder_options_build_add_uint_option(dst_packet_data_pptr, dst_end_ptr, src_options_list_ptr->size1,
+                         COAP_OPTION_SIZE1, &previous_option_number) < 0) {
+                return -3;
+            }
         }
     }
 
@@ -655,26 +807,29 @@ static int8_t sn_coap_builder_options_build(uint8_t **dst_packet_data_pptr, cons
 }
 
 /**
- * \fn static int16_t sn_coap_builder_options_build_add_one_option(uint8_t **dst_packet_data_pptr, uint16_t option_value_len, uint8_t *option_value_ptr, sn_coap_option_numbers_e option_number)
+ * \fn static int8_t sn_coap_builder_options_build_add_one_option(uint8_t **dst_packet_data_pptr, const uint8_t *dst_end_ptr, uint16_t option_value_len, uint8_t *option_value_ptr, sn_coap_option_numbers_e option_number)
  *
  * \brief Adds Options part of Packet data
  *
  * \param **dst_packet_data_pptr is destination for built Packet data
  *
+ * \param *dst_end_ptr is end of destination buffer, NULL if not checked
+ *
  * \param option_value_len is Option value length to be added
  *
  * \param *option_value_ptr is pointer to Option value data to be added
  *
  * \param option_number is Option number to be added
  *
- * \return Return value is 0 if option was not added, 1 if added
+ * \return Return value is 0 if option was added or there was no option, -3 if buffer is too small
  */
-static int16_t sn_coap_builder_options_build_add_one_option(uint8_t **dst_packet_data_pptr, uint16_t option_len,
+static int8_t sn_coap_builder_options_build_add_one_option(uint8_t **dst_packet_data_pptr, const uint8_t *dst_end_ptr, uint16_t option_len,
         const uint8_t *option_ptr, sn_coap_option_numbers_e option_number, uint16_t *previous_option_number)
 {
     /* Check if there is option at all */
     if (option_ptr != NULL) {
         uint16_t option_delta;
+        uint8_t  header_len = 1;
 
         option_delta = (option_number - *previous_option_number);
 
@@ -689,10 +844,22 @@ static int16_t sn_coap_builder_options_build_add_one_option(uint8_t **dst_packet
 
         else if (option_len > 12 && option_len < 269) {
             first_byte = 0x0D;
+            header_len += 1;
         }
 
         else /*if (option_len >= 269)*/ {
             first_byte = 0x0E;
+            header_len += 2;
+        }
+
+        if (option_delta > 12 && option_delta < 269) {
+            header_len += 1;
+        } else if (option_delta >= 269) {
+            header_len += 2;
+        }
+
+        if (!sn_coap_builder_has_room(*dst_packet_data_pptr, dst_end_ptr, (uint32_t)header_len + option_len)) {
+            return -3;
         }
 
         uint8_t *dest_packet = *dst_packet_data_pptr;
@@ -741,8 +908,6 @@ static int16_t sn_coap_builder_options_build_add_one_option(uint8_t **dst_packet
         dest_packet += option_len;
 
         *dst_packet_data_pptr = dest_packet;
-
-        return 1;
     }
 
     /* Success */
@@ -755,13 +920,15 @@ static int16_t sn_coap_builder_options_build_add_one_option(uint8_t **dst_packet
  * \param **dst_packet_data_pptr is destination for built Packet data; NULL
  *        to compute size only.
  *
+ * \param *dst_end_ptr is end of destination buffer, NULL if not checked
+ *
  * \param option_value is Option value to be added
  *
  * \param option_number is Option number to be added
  *
- * \return Return value is total option size, or -1 in write failure case
+ * \return Return value is total option size, or -3 if buffer is too small
  */
-static uint8_t sn_coap_builder_options_build_add_uint_option(uint8_t **dst_packet_data_pptr, uint32_t option_value, sn_coap_option_numbers_e option_number, uint16_t *previous_option_number)
+static int8_t sn_coap_builder_options_build_add_uint_option(uint8_t **dst_packet_data_pptr, const uint8_t *dst_end_ptr, uint32_t option_value, sn_coap_option_numbers_e option_number, uint16_t *previous_option_number)
 {
     uint8_t payload[4];
     uint8_t len = 0;
@@ -775,9 +942,10 @@ static uint8_t sn_coap_builder_options_build_add_uint_option(uint8_t **dst_packe
 
     /* If output pointer isn't NULL, write it out */
     if (dst_packet_data_pptr) {
-        // No need to check & handle return value, as the function returns failure only if the option pointer is zero
-        // and it is pointing to a local variable here.
-        sn_coap_builder_options_build_add_one_option(dst_packet_data_pptr, len, payload, option_number, previous_option_number);
+        // The option pointer points to a local variable here, so the only possible failure is running out of buffer.
+        if (sn_coap_builder_options_build_add_one_option(dst_packet_data_pptr, dst_end_ptr, len, payload, option_number, previous_option_number) < 0) {
+            return -3;
+        }
     }
 
     /* Return the total option size */
@@ -785,46 +953,52 @@ static uint8_t sn_coap_builder_options_build_add_uint_option(uint8_t **dst_packe
 }
 
 /**
- * \fn static int16_t sn_coap_builder_options_build_add_multiple_option(uint8_t **dst_packet_data_pptr, uint8_t **src_pptr, uint16_t *src_len_ptr, sn_coap_option_numbers_e option)
+ * \fn static int8_t sn_coap_builder_options_build_add_multiple_option(uint8_t **dst_packet_data_pptr, const uint8_t *dst_end_ptr, uint8_t **src_pptr, uint16_t *src_len_ptr, sn_coap_option_numbers_e option)
  *
  * \brief Builds Option Uri-Query from given CoAP Header structure to Packet data
  *
  * \param **dst_packet_data_pptr is destination for built Packet data
  *
+ * \param *dst_end_ptr is end of destination buffer, NULL if not checked
+ *
  * \param uint8_t **src_ptr
  *
  *  \param uint16_t src_len
  *
  *  \paramsn_coap_option_numbers_e option option to be added
  *
- * \return Return value is 0 always
+ * \return Return value is 0 in ok case, -1 for invalid part length and -3 if buffer is too small
  */
-static void sn_coap_builder_options_build_add_multiple_option(uint8_t **dst_packet_data_pptr, const uint8_t *src_pptr, uint16_t src_len, sn_coap_option_numbers_e option, uint16_t *previous_option_number)
+static int8_t sn_coap_builder_options_build_add_multiple_option(uint8_t **dst_packet_data_pptr, const uint8_t *dst_end_ptr, const uint8_t *src_pptr, uint16_t src_len, sn_coap_option_numbers_e option, uint16_t *previous_option_number)
 {
     /* Check if there is option at all */
     if (src_pptr != NULL) {
-        const uint8_t *query_ptr            = src_pptr;
-        uint8_t     query_part_count        = 0;
-        uint16_t    query_len               = src_len;
-        uint8_t     i                       = 0;
-        uint16_t    query_part_offset       = 0;
+        sn_coap_builder_option_part_iterator_s iterator;
+        uint16_t    query_part_count        = 0;
+        uint16_t    i                       = 0;
 
         /* Get query part count */
-        query_part_count = sn_coap_builder_options_get_option_part_count(query_len, query_ptr, option);
+        query_part_count = sn_coap_builder_options_get_option_part_count(src_len, src_pptr, option);
+        sn_coap_builder_options_part_iterator_init(&iterator, src_len, src_pptr, option);
 
         /* * * * Options by adding all parts to option * * * */
         for (i = 0; i < query_part_count; i++) {
-            /* Get length of query part */
-            uint16_t one_query_part_len = sn_coap_builder_options_get_option_part_length_from_whole_option_string(query_len, query_ptr, i, option);
+            uint16_t one_query_part_len;
+            const uint8_t *one_query_part_ptr = sn_coap_builder_options_part_iterator_next(&iterator, &one_query_part_len);
 
-            /* Get position of query part */
-            query_part_offset = sn_coap_builder_options_get_option_part_position(query_len, query_ptr, i, option);
+            if (!sn_coap_builder_options_check_part_length(one_query_part_len, option)) {
+                tr_error("sn_coap_builder_options_build_add_multiple_option - option %d part too large!", option);
+                return -1;
+            }
 
             /* Add Uri-query's one part to Options */
-            sn_coap_builder_options_build_add_one_option(dst_packet_data_pptr, one_query_part_len, src_pptr + query_part_offset, option, previous_option_number);
+            if (sn_coap_builder_options_build_add_one_option(dst_packet_data_pptr, dst_end_ptr, one_query_part_len, one_query_part_ptr, option, previous_option_number) < 0) {
+                return -3;
+            }
         }
     }
     /* Success */
+    return 0;
 }
 
 
@@ -841,10 +1015,13 @@ static void sn_coap_builder_options_build_add_multiple_option(uint8_t **dst_pack
  */
 static uint16_t sn_coap_builder_options_calc_option_size(uint16_t query_len, const uint8_t *query_ptr, sn_coap_option_numbers_e option)
 {
-    uint8_t     query_part_count    = sn_coap_builder_options_get_option_part_count(query_len, query_ptr, option);
-    uint8_t     i                   = 0;
+    sn_coap_builder_option_part_iterator_s iterator;
+    uint16_t    query_part_count    = sn_coap_builder_options_get_option_part_count(query_len, query_ptr, option);
+    uint16_t    i                   = 0;
     uint16_t    ret_value           = 0;
 
+    sn_coap_builder_options_part_iterator_init(&iterator, query_len, query_ptr, option);
+
     /* * * * * * * * * * * * * * * * * * * * * * * * */
     /* * * * Calculate Uri-query options length  * * */
     /* * * * * * * * * * * * * * * * * * * * * * * * */
@@ -852,34 +1029,12 @@ static uint16_t sn_coap_builder_options_calc_option_size(uint16_t query_len, con
         /* * * Length of Option number and Option value length * * */
 
         /* Get length of Query part */
-        uint16_t one_query_part_len = sn_coap_builder_options_get_option_part_length_from_whole_option_string(query_len, query_ptr, i, option);
+        uint16_t one_query_part_len;
+        sn_coap_builder_options_part_iterator_next(&iterator, &one_query_part_len);
 
         /* Check option length */
-        switch (option) {
-            case (COAP_OPTION_ETAG):            /* Length 1-8 */
-                if (one_query_part_len < 1 || one_query_part_len > 8) {
-                    return 0;
-                }
-                break;
-            case (COAP_OPTION_LOCATION_PATH):   /* Length 0-255 */
-            case (COAP_OPTION_URI_PATH):        /* Length 0-255 */
-            case (COAP_OPTION_LOCATION_QUERY):  /* Length 0-255 */
-                if (one_query_part_len > 255) {
-                    return 0;
-                }
-                break;
-            case (COAP_OPTION_URI_QUERY):       /* Length 1-255 */
-                if (one_query_part_len < 1 || one_query_part_len > 255) {
-                    return 0;
-                }
-                break;
-//            case (COAP_OPTION_ACCEPT):          /* Length 0-2 */
-//                if (one_query_part_len > 2) {
-//                    return 0;
-//                }
-//                break;
-            default:
-                break; //impossible scenario currently
+        if (!sn_coap_builder_options_check_part_length(one_query_part_len, option)) {
+            return 0;
         }
 
         /* Check if 4 bits are enough for writing Option value length */
@@ -907,10 +1062,53 @@ static uint16_t sn_coap_builder_options_calc_option_size(uint16_t query_len, con
     return ret_value;
 }
 
+/**
+ * \fn static bool sn_coap_builder_options_check_part_length(uint16_t part_len, sn_coap_option_numbers_e option)
+ *
+ * \brief Checks length of one part of a repeatable option
+ *
+ * \param part_len is length of the option part
+ *
+ * \param option is option number of the option
+ *
+ * \return Return value is true if length is allowed for the option
+ */
+static bool sn_coap_builder_options_check_part_length(uint16_t part_len, sn_coap_option_numbers_e option)
+{
+    switch (option) {
+        case (COAP_OPTION_ETAG):            /* Length 1-8 */
+            if (part_len < 1 || part_len > 8) {
+                return false;
+            }
+            break;
+        case (COAP_OPTION_LOCATION_PATH):   /* Length 0-255 */
+        case (COAP_OPTION_URI_PATH):        /* Length 0-255 */
+        case (COAP_OPTION_LOCATION_QUERY):  /* Length 0-255 */
+            if (part_len > 255) {
+                return false;
+            }
+            break;
+        case (COAP_OPTION_URI_QUERY):       /* Length 1-255 */
+            if (part_len < 1 || part_len > 255) {
+                return false;
+            }
+            break;
+//        case (COAP_OPTION_ACCEPT):          /* Length 0-2 */
+//            if (part_len > 2) {
+//                return false;
+//            }
+//            break;
+        default:
+            break; //impossible scenario currently
+    }
+
+    return true;
+}
+
 
 
 /**
- * \fn static uint8_t sn_coap_builder_options_get_option_part_count(uint16_t query_len, uint8_t *query_ptr, sn_coap_option_numbers_e option)
+ * \fn static uint16_t sn_coap_builder_options_get_option_part_count(uint16_t query_len, uint8_t *query_ptr, sn_coap_option_numbers_e option)
  *
  * \brief Gets query part count from whole option string
  *
@@ -920,9 +1118,9 @@ static uint16_t sn_coap_builder_options_calc_option_size(uint16_t query_len, con
  *
  * \return Return value is count of query parts
  */
-static uint8_t sn_coap_builder_options_get_option_part_count(uint16_t query_len, const uint8_t *query_ptr, sn_coap_option_numbers_e option)
+static uint16_t sn_coap_builder_options_get_option_part_count(uint16_t query_len, const uint8_t *query_ptr, sn_coap_option_numbers_e option)
 {
-    uint8_t  returned_query_count = 0;
+    uint16_t returned_query_count = 0;
     uint16_t query_len_index      = 0;
     uint8_t  char_to_search       = '&';
 
@@ -944,139 +1142,118 @@ static uint8_t sn_coap_builder_options_get_option_part_count(uint16_t query_len,
 }
 
 /**
- * \fn static uint16_t sn_coap_builder_options_get_option_part_length_from_whole_option_string(uint16_t query_len,
-                                                                             uint8_t *query_ptr,
-                                                                             uint8_t query_index, sn_coap_option_numbers_e option)
+ * \fn static void sn_coap_builder_options_part_iterator_init(sn_coap_builder_option_part_iterator_s *iterator_ptr, uint16_t query_len, const uint8_t *query_ptr, sn_coap_option_numbers_e option)
+ *
+ * \brief Prepares iterator for walking parts of whole option string
  *
- * \brief Gets one's query part length from whole query string
+ * \param *iterator_ptr is iterator to be initialized
  *
  * \param query_len is length of whole string
  *
  * \param *query_ptr is pointer to the start of whole string
  *
- * \param query_index is query part index to be found
- *
- * \param sn_coap_option_numbers_e option is option number of the option
- *
- * \return Return value is length of query part
+ * \param option is option number of the option
  */
-static uint16_t sn_coap_builder_options_get_option_part_length_from_whole_option_string(uint16_t query_len, const uint8_t *query_ptr,
-        uint8_t query_index, sn_coap_option_numbers_e option)
+static void sn_coap_builder_options_part_iterator_init(sn_coap_builder_option_part_iterator_s *iterator_ptr, uint16_t query_len,
+        const uint8_t *query_ptr, sn_coap_option_numbers_e option)
 {
-    uint16_t returned_query_part_len = 0;
-    uint8_t  temp_query_index        = 0;
-    uint16_t query_len_index         = 0;
-    uint8_t  char_to_search          = '&';
+    iterator_ptr->query_ptr = query_ptr;
+    iterator_ptr->query_len = query_len;
+    iterator_ptr->position_index = 1;
+    iterator_ptr->length_index = 0;
+    iterator_ptr->tail_len = 0;
+    iterator_ptr->part_index = 0;
+    iterator_ptr->separator = '&';
 
     if (option == COAP_OPTION_URI_PATH || option == COAP_OPTION_LOCATION_PATH) {
-        char_to_search = '/';
+        iterator_ptr->separator = '/';
     }
-
-    /* Loop whole query and search '\0' characters */
-    for (query_len_index = 0; query_len_index < query_len; query_len_index++) {
-        /* Store character to temp_char for helping debugging */
-        uint8_t temp_char = *query_ptr;
-
-        /* If new query part starts */
-        if (temp_char == char_to_search && returned_query_part_len > 0) { /* returned_query_part_len > 0 is for querys which start with "\0" */
-            /* If query part index is wanted */
-            if (temp_query_index == query_index) {
-                /* Return length of query part */
-                return returned_query_part_len;
-            } else {
-                /* Reset length of query part because wanted query part finding continues*/
-                returned_query_part_len = 0;
-            }
-
-            /* Next query part is looped */
-            temp_query_index++;
-        } else if (temp_char != char_to_search) { /* Else if query part continues */
-            /* Increase query part length */
-            returned_query_part_len++;
-        }
-
-        query_ptr++;
-    }
-
-    /* Return length of query part in cases that query part does not finish to '\0' character (last query part can be like that) */
-    return returned_query_part_len;
 }
 
 /**
- * \fn static uint16_t sn_coap_builder_options_get_option_part_position(uint16_t query_len,
-                                                               uint8_t *query_ptr,
-                                                               uint8_t query_index, sn_coap_option_numbers_e option)
+ * \fn static const uint8_t *sn_coap_builder_options_part_iterator_next(sn_coap_builder_option_part_iterator_s *iterator_ptr, uint16_t *part_len_ptr)
  *
- * \brief Gets query part position in whole query
+ * \brief Gets next part of whole option string
  *
- * \param query_len is length of whole query
+ * Both the position and the length of a part are found by continuing from
+ * where the previous part ended, so walking all parts is linear in the
+ * string length. Empty parts between separators are handled the same way
+ * as before: their position points at the separator but their length is
+ * taken from the next non-empty part.
  *
- * \param *query_ptr is pointer to the start of whole query
+ * \param *iterator_ptr is iterator set up by sn_coap_builder_options_part_iterator_init()
  *
- * \param query_index is query part index to be found
+ * \param *part_len_ptr is where length of the part is written
  *
- * \return Return value is position (= offset) of query part in whole query. In
- *         fail cases -1 is returned.
+ * \return Return value is pointer to the start of the part
  */
-static int16_t sn_coap_builder_options_get_option_part_position(uint16_t query_len, const uint8_t *query_ptr,
-        uint8_t query_index, sn_coap_option_numbers_e option)
+static const uint8_t *sn_coap_builder_options_part_iterator_next(sn_coap_builder_option_part_iterator_s *iterator_ptr, uint16_t *part_len_ptr)
 {
-    uint16_t returned_query_part_offset = 0;
-    uint8_t  temp_query_index           = 0;
-    uint16_t query_len_index            = 0;
-    uint8_t  char_to_search             = '&';
-
-    if (option == COAP_OPTION_URI_PATH || option == COAP_OPTION_LOCATION_PATH) {
-        char_to_search = '/';
-    }
-
-    if (query_index == 0) {
-        if (*query_ptr == 0 || *query_ptr == char_to_search) {
-            return 1;
-        } else {
-            return 0;
+    const uint8_t *query_ptr = iterator_ptr->query_ptr;
+    uint16_t      part_offset;
+    uint16_t      part_len = 0;
+
+    /* First part skips a leading separator, others start after the next separator */
+    if (iterator_ptr->part_index == 0) {
+        part_offset = 0;
+        if (iterator_ptr->query_len && (query_ptr[0] == 0 || query_ptr[0] == iterator_ptr->separator)) {
+            part_offset = 1;
+        }
+    } else {
+        while (iterator_ptr->position_index < iterator_ptr->query_len &&
+                query_ptr[iterator_ptr->position_index] != iterator_ptr->separator) {
+            iterator_ptr->position_index++;
         }
+        /* Plus one is for passing separator */
+        iterator_ptr->position_index++;
+        part_offset = iterator_ptr->position_index;
     }
-
-    /* Loop whole query and search separator characters */
-    for (query_len_index = 0; query_len_index < query_len; query_len_index++) {
-        /* Store character to temp_char for helping debugging */
-        uint8_t temp_char = *query_ptr;
-
-        /* If new query part starts */
-        if (temp_char == char_to_search && returned_query_part_offset > 0) { /* returned_query_part_offset > 0 is for querys which start with searched char */
-            /* If query part index is wanted */
-            if (temp_query_index == (query_index - 1)) {
-                /* Return offset of query part */
-                return (returned_query_part_offset + 1); /* Plus one is for passing separator */
+    iterator_ptr->part_index++;
+
+    /* Length counts characters up to the separator ending a non-empty part */
+    if (iterator_ptr->length_index >= iterator_ptr->query_len) {
+        part_len = iterator_ptr->tail_len;
+    } else {
+        bool part_ended = false;
+        while (iterator_ptr->length_index < iterator_ptr->query_len && !part_ended) {
+            if (query_ptr[iterator_ptr->length_index] != iterator_ptr->separator) {
+                part_len++;
+            } else if (part_len > 0) {
+                part_ended = true;
             }
-
-            /* Next query part is looped */
-            temp_query_index++;
+            iterator_ptr->length_index++;
+        }
+        if (!part_ended) {
+            iterator_ptr->tail_len = part_len;
         }
-
-        returned_query_part_offset++;
-
-        query_ptr++;
     }
 
-    return -1; //Dead code?
+    *part_len_ptr = part_len;
+    return query_ptr + part_offset;
 }
 
 
 /**
- * \fn static void sn_coap_builder_payload_build(uint8_t **dst_packet_data_pptr, sn_coap_hdr_s *src_coap_msg_ptr)
+ * \fn static int8_t sn_coap_builder_payload_build(uint8_t **dst_packet_data_pptr, const uint8_t *dst_end_ptr, sn_coap_hdr_s *src_coap_msg_ptr)
  *
  * \brief Builds Options part of Packet data
  *
  * \param **dst_packet_data_pptr is destination for built Packet data
  *
+ * \param *dst_end_ptr is end of destination buffer, NULL if not checked
+ *
  * \param *src_coap_msg_ptr is source for building Packet data
+ *
+ * \return Return value is 0 in ok case and -3 if buffer is too small
  */
-static void sn_coap_builder_payload_build(uint8_t **dst_packet_data_pptr, const sn_coap_hdr_s *src_coap_msg_ptr)
+static int8_t sn_coap_builder_payload_build(uint8_t **dst_packet_data_pptr, const uint8_t *dst_end_ptr, const sn_coap_hdr_s *src_coap_msg_ptr)
 {
     /* Check if Payload is used at all */
     if (src_coap_msg_ptr->payload_len && src_coap_msg_ptr->payload_ptr != NULL) {
+        if (!sn_coap_builder_has_room(*dst_packet_data_pptr, dst_end_ptr, (uint32_t)src_coap_msg_ptr->payload_len + 1)) {
+            return -3;
+        }
+
         /* Write Payload marker */
 
         **dst_packet_data_pptr = 0xff;
@@ -1088,4 +1265,24 @@ static void sn_coap_builder_payload_build(uint8_t **dst_packet_data_pptr, const
         /* Increase destination Packet data pointer */
         (*dst_packet_data_pptr) += src_coap_msg_ptr->payload_len;
     }
+
+    return 0;
+}
+
+/**
+ * \fn static bool sn_coap_builder_has_room(const uint8_t *dst_ptr, const uint8_t *dst_end_ptr, uint32_t needed_len)
+ *
+ * \brief Checks that destination buffer can take given amount of bytes
+ *
+ * \param *dst_ptr is current write position
+ *
+ * \param *dst_end_ptr is end of destination buffer, NULL if not checked
+ *
+ * \param needed_len is count of bytes to be written
+ *
+ * \return Return value is true if bytes fit
+ */
+static bool sn_coap_builder_has_room(const uint8_t *dst_ptr, const uint8_t *dst_end_ptr, uint32_t needed_len)
+{
+    return dst_end_ptr == NULL || (uint32_t)(dst_end_ptr - dst_ptr) >= needed_len;
 }
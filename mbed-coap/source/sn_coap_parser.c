@@ -46,7 +46,7 @@ static void     sn_coap_parser_header_parse(uint8_t **packet_data_pptr, sn_coap_
 static int8_t   sn_coap_parser_options_parse(struct coap_s *handle, uint8_t **packet_data_pptr, sn_coap_hdr_s *dst_coap_msg_ptr, uint8_t *packet_data_start_ptr, uint16_t packet_len);
 static int8_t   sn_coap_parser_options_parse_multiple_options(struct coap_s *handle, uint8_t **packet_data_pptr, uint16_t packet_left_len,  uint8_t **dst_pptr, uint16_t *dst_len_ptr, sn_coap_option_numbers_e option, uint16_t option_number_len);
 static int16_t  sn_coap_parser_options_count_needed_memory_multiple_option(uint8_t *packet_data_ptr, uint16_t packet_left_len, sn_coap_option_numbers_e option, uint16_t option_number_len);
-static int8_t   sn_coap_parser_payload_parse(uint16_t packet_data_len, uint8_t *packet_data_start_ptr, uint8_t **packet_data_pptr, sn_coap_hdr_s *dst_coap_msg_ptr);
+static int8_t   sn_coap_parser_payload_parse(uint16_t packet_data_len, uint8_t *packet_data_start_ptr, uint8_t **packet_data_pptr, uint8_t **dst_payload_pptr, uint16_t *dst_payload_len_ptr);
 
 sn_coap_hdr_s *sn_coap_parser_init_message(sn_coap_hdr_s *coap_msg_ptr)
 {
@@ -163,7 +163,8 @@ sn_coap_hdr_s *sn_coap_parser(struct coap_s *handle, uint16_t packet_data_len, u
     }
 
     /* * * * Payload parsing * * * */
-    if (sn_coap_parser_payload_parse(packet_data_len, packet_data_ptr, &data_temp_ptr, parsed_and_returned_coap_msg_ptr) == -1) {
+    if (sn_coap_parser_payload_parse(packet_data_len, packet_data_ptr, &data_temp_ptr,
+                                     &parsed_and_returned_coap_msg_ptr->payload_ptr, &parsed_and_returned_coap_msg_ptr->payload_len) == -1) {
         parsed_and_returned_coap_msg_ptr->coap_status = COAP_STATUS_PARSER_ERROR_IN_HEADER;
         return parsed_and_returned_coap_msg_ptr;
     }
@@ -910,34 +911,36 @@ static int16_t sn_coap_parser_options_count_needed_memory_multiple_option(uint8_
 }
 
 /**
- * \fn static void sn_coap_parser_payload_parse(uint16_t packet_data_len, uint8_t *packet_data_ptr, uint8_t **packet_data_pptr, sn_coap_hdr_s *dst_coap_msg_ptr)
+ * \fn static int8_t sn_coap_parser_payload_parse(uint16_t packet_data_len, uint8_t *packet_data_start_ptr, uint8_t **packet_data_pptr, uint8_t **dst_payload_pptr, uint16_t *dst_payload_len_ptr)
  *
  * \brief Parses CoAP message's Payload part from given Packet data
  *
  * \param packet_data_len is length of given Packet data to be parsed to CoAP message
  *
- * \param *packet_data_ptr is start of source for Packet data to be parsed to CoAP message
+ * \param *packet_data_start_ptr is start of source for Packet data to be parsed to CoAP message
  *
  * \param **packet_data_pptr is source for Packet data to be parsed to CoAP message
  *
- * \param *dst_coap_msg_ptr is destination for parsed CoAP message
+ * \param **dst_payload_pptr is destination for the payload pointer, left untouched if there is no payload
+ *
+ * \param *dst_payload_len_ptr is destination for the payload length, left untouched if there is no payload
  *****************************************************************************/
-static int8_t sn_coap_parser_payload_parse(uint16_t packet_data_len, uint8_t *packet_data_start_ptr, uint8_t **packet_data_pptr, sn_coap_hdr_s *dst_coap_msg_ptr)
+static int8_t sn_coap_parser_payload_parse(uint16_t packet_data_len, uint8_t *packet_data_start_ptr, uint8_t **packet_data_pptr, uint8_t **dst_payload_pptr, uint16_t *dst_payload_len_ptr)
 {
     /* If there is payload */
     if ((*packet_data_pptr - packet_data_start_ptr) < packet_data_len) {
         if (**packet_data_pptr == 0xff) {
             (*packet_data_pptr)++;
             /* Parse Payload length */
-            dst_coap_msg_ptr->payload_len = packet_data_len - (*packet_data_pptr - packet_data_start_ptr);
+            *dst_payload_len_ptr = packet_data_len - (*packet_data_pptr - packet_data_start_ptr);
 
             /* The presence of a marker followed by a zero-length payload MUST be processed as a message format error */
-            if (dst_coap_msg_ptr->payload_len == 0) {
+            if (*dst_payload_len_ptr == 0) {
                 return -1;
             }
 
             /* Parse Payload by setting CoAP message's payload_ptr to point Payload in Packet data */
-            dst_coap_msg_ptr->payload_ptr = *packet_data_pptr;
+            *dst_payload_pptr = *packet_data_pptr;
         }
         /* No payload marker.. */
         else {
@@ -948,3 +951,356 @@ static int8_t sn_coap_parser_payload_parse(uint16_t packet_data_len, uint8_t *pa
     return 0;
 }
 
+
+/**
+ * \brief Fills the view of an option that has one value in the packet
+ */
+static void sn_coap_parser_view_set_option(sn_coap_option_view_s *dst_option_ptr, const uint8_t *value_ptr, uint16_t value_len)
+{
+    dst_option_ptr->first_ptr = value_ptr;
+    dst_option_ptr->first_len = value_len;
+    dst_option_ptr->count = 1;
+    dst_option_ptr->joined_len = value_len;
+}
+
+/**
+ * \brief Fills the view of a repeatable option and moves the packet pointer over all of its values
+ *
+ * Unlike sn_coap_parser_options_parse_multiple_options(), an option value cut short by the end
+ * of the packet is an error.
+ *
+ * \param **packet_data_pptr points to the first value of the option, moved after the last one
+ * \param *packet_data_start_ptr is pointer to data packet start
+ * \param packet_len is total packet length
+ * \param *dst_option_ptr is destination for the option view
+ * \param max_value_len is the maximum length of one value
+ * \param option_number_len is the length of the first value
+ *
+ * \return Return value is 0 in ok case and -1 in failure case
+ */
+static int8_t sn_coap_parser_view_multiple_options(uint8_t **packet_data_pptr, uint8_t *packet_data_start_ptr, uint16_t packet_len,
+                                                   sn_coap_option_view_s *dst_option_ptr, uint16_t max_value_len, uint16_t option_number_len)
+{
+    uint16_t message_left;
+    uint16_t option_count = 0;
+    uint16_t joined_len = 0;
+
+    dst_option_ptr->first_ptr = *packet_data_pptr;
+    dst_option_ptr->first_len = option_number_len;
+
+    /* Loop all options with the same number, they follow each other with option delta 0 */
+    for (;;) {
+        if (option_number_len > max_value_len ||
+            0 != sn_coap_parser_check_packet_ptr(*packet_data_pptr, packet_data_start_ptr, packet_len, option_number_len)) {
+            return -1;
+        }
+
+        if (option_count) {
+            joined_len++; /* separator */
+        }
+        joined_len += option_number_len;
+        option_count++;
+
+        message_left = sn_coap_parser_move_packet_ptr(packet_data_pptr, packet_data_start_ptr, packet_len, option_number_len);
+        if (message_left == 0 || ((**packet_data_pptr >> COAP_OPTIONS_OPTION_NUMBER_SHIFT) != 0)) {
+            break;
+        }
+
+        option_number_len = (**packet_data_pptr & 0x0F);
+        message_left = sn_coap_parser_move_packet_ptr(packet_data_pptr, packet_data_start_ptr, packet_len, 1);
+        if (parse_ext_option(&option_number_len, packet_data_pptr, packet_data_start_ptr, packet_len, &message_left) != 0) {
+            return -1;
+        }
+
+        /* sn_coap_parser() drops an empty value at the very end of the packet, do the same */
+        if (message_left == 0 && option_number_len == 0) {
+            break;
+        }
+    }
+
+    dst_option_ptr->count = option_count;
+    dst_option_ptr->joined_len = joined_len;
+
+    return 0;
+}
+
+/**
+ * \brief Parses CoAP message's Options part into a view, without allocations
+ *
+ * Performs the same checks as sn_coap_parser_options_parse().
+ *
+ * \return Return value is 0 in ok case and -1 in failure case
+ */
+static int8_t sn_coap_parser_view_options_parse(uint8_t **packet_data_pptr, sn_coap_hdr_view_s *dst_view_ptr, uint8_t *packet_data_start_ptr, uint16_t packet_len)
+{
+    uint16_t previous_option_number = 0;
+    uint16_t message_left           = sn_coap_parser_move_packet_ptr(packet_data_pptr, packet_data_start_ptr, packet_len, 0);
+    uint8_t  token_len              = *packet_data_start_ptr & COAP_HEADER_TOKEN_LENGTH_MASK;
+
+    /*  Parse token, if exists  */
+    if (token_len) {
+        if ((token_len > 8) ||
+            (0 != sn_coap_parser_check_packet_ptr(*packet_data_pptr, packet_data_start_ptr, packet_len, token_len))) {
+            tr_error("sn_coap_parser_view - token not valid!");
+            return -1;
+        }
+
+        sn_coap_parser_view_set_option(&dst_view_ptr->token, *packet_data_pptr, token_len);
+        message_left = sn_coap_parser_move_packet_ptr(packet_data_pptr, packet_data_start_ptr, packet_len, token_len);
+    }
+
+    /* Loop all Options */
+    while (message_left && (**packet_data_pptr != 0xff)) {
+        uint16_t option_len = (**packet_data_pptr & 0x0F);
+        uint16_t option_number = (**packet_data_pptr >> COAP_OPTIONS_OPTION_NUMBER_SHIFT);
+        int8_t   ret_status = 0;
+
+        message_left = sn_coap_parser_move_packet_ptr(packet_data_pptr, packet_data_start_ptr, packet_len, 1);
+
+        if (parse_ext_option(&option_number, packet_data_pptr, packet_data_start_ptr, packet_len, &message_left) != 0) {
+            return -1;
+        }
+        if (sn_coap_parser_add_u16_limit(option_number, previous_option_number, &option_number) != 0) {
+            return -1;
+        }
+        if (parse_ext_option(&option_len, packet_data_pptr, packet_data_start_ptr, packet_len, &message_left) != 0) {
+            return -1;
+        }
+
+        previous_option_number = option_number;
+
+        if (message_left < option_len) {
+            tr_error("sn_coap_parser_view - **packet_data_pptr would overflow when parsing options!");
+            return -1;
+        }
+
+        switch (option_number) {
+            case COAP_OPTION_CONTENT_FORMAT:
+                if ((option_len > 2) || (dst_view_ptr->content_format != COAP_CT_NONE)) {
+                    ret_status = -1;
+                    break;
+                }
+                dst_view_ptr->content_format = (sn_coap_content_format_e) sn_coap_parser_options_parse_uint(packet_data_pptr, option_len);
+                break;
+
+            case COAP_OPTION_MAX_AGE:
+                if (option_len > 4) {
+                    ret_status = -1;
+                    break;
+                }
+                dst_view_ptr->max_age = sn_coap_parser_options_parse_uint(packet_data_pptr, option_len);
+                break;
+
+            case COAP_OPTION_PROXY_URI:
+                if ((option_len > 1034) || (option_len < 1) || dst_view_ptr->proxy_uri.count) {
+                    ret_status = -1;
+                    break;
+                }
+                sn_coap_parser_view_set_option(&dst_view_ptr->proxy_uri, *packet_data_pptr, option_len);
+                sn_coap_parser_move_packet_ptr(packet_data_pptr, packet_data_start_ptr, packet_len, option_len);
+                break;
+
+            case COAP_OPTION_URI_HOST:
+                if ((option_len > 255) || (option_len < 1) || dst_view_ptr->uri_host.count) {
+                    ret_status = -1;
+                    break;
+                }
+                sn_coap_parser_view_set_option(&dst_view_ptr->uri_host, *packet_data_pptr, option_len);
+                sn_coap_parser_move_packet_ptr(packet_data_pptr, packet_data_start_ptr, packet_len, option_len);
+                break;
+
+            case COAP_OPTION_ETAG:
+                if (dst_view_ptr->etag.count) {
+                    ret_status = -1;
+                    break;
+                }
+                ret_status = sn_coap_parser_view_multiple_options(packet_data_pptr, packet_data_start_ptr, packet_len, &dst_view_ptr->etag, 8, option_len);
+                break;
+
+            case COAP_OPTION_LOCATION_PATH:
+                if (dst_view_ptr->location_path.count) {
+                    ret_status = -1;
+                    break;
+                }
+                ret_status = sn_coap_parser_view_multiple_options(packet_data_pptr, packet_data_start_ptr, packet_len, &dst_view_ptr->location_path, 255, option_len);
+                break;
+
+            case COAP_OPTION_LOCATION_QUERY:
+                if (dst_view_ptr->location_query.count) {
+                    ret_status = -1;
+                    break;
+                }
+                ret_status = sn_coap_parser_view_multiple_options(packet_data_pptr, packet_data_start_ptr, packet_len, &dst_view_ptr->location_query, 255, option_len);
+                break;
+
+            case COAP_OPTION_URI_PATH:
+                if (dst_view_ptr->uri_path.count) {
+                    ret_status = -1;
+                    break;
+                }
+                ret_status = sn_coap_parser_view_multiple_options(packet_data_pptr, packet_data_start_ptr, packet_len, &dst_view_ptr->uri_path, 255, option_len);
+                break;
+
+            case COAP_OPTION_URI_QUERY:
+                ret_status = sn_coap_parser_view_multiple_options(packet_data_pptr, packet_data_start_ptr, packet_len, &dst_view_ptr->uri_query, 255, option_len);
+                break;
+
+            case COAP_OPTION_URI_PORT:
+                if ((option_len > 2) || dst_view_ptr->uri_port != COAP_OPTION_URI_PORT_NONE) {
+                    ret_status = -1;
+                    break;
+                }
+                dst_view_ptr->uri_port = sn_coap_parser_options_parse_uint(packet_data_pptr, option_len);
+                break;
+
+            case COAP_OPTION_OBSERVE:
+                if ((option_len > 2) || dst_view_ptr->observe != COAP_OBSERVE_NONE) {
+                    ret_status = -1;
+                    break;
+                }
+                dst_view_ptr->observe = sn_coap_parser_options_parse_uint(packet_data_pptr, option_len);
+                break;
+
+            case COAP_OPTION_BLOCK2:
+                if ((option_len > 3) || dst_view_ptr->block2 != COAP_OPTION_BLOCK_NONE) {
+                    ret_status = -1;
+                    break;
+                }
+                dst_view_ptr->block2 = sn_coap_parser_options_parse_uint(packet_data_pptr, option_len);
+                break;
+
+            case COAP_OPTION_BLOCK1:
+                if ((option_len > 3) || dst_view_ptr->block1 != COAP_OPTION_BLOCK_NONE) {
+                    ret_status = -1;
+                    break;
+                }
+                dst_view_ptr->block1 = sn_coap_parser_options_parse_uint(packet_data_pptr, option_len);
+                break;
+
+            case COAP_OPTION_ACCEPT:
+                if ((option_len > 2) || (dst_view_ptr->accept != COAP_CT_NONE)) {
+                    ret_status = -1;
+                    break;
+                }
+                dst_view_ptr->accept = (sn_coap_content_format_e) sn_coap_parser_options_parse_uint(packet_data_pptr, option_len);
+                break;
+
+            case COAP_OPTION_SIZE1:
+                if ((option_len > 4) || dst_view_ptr->use_size1) {
+                    ret_status = -1;
+                    break;
+                }
+                dst_view_ptr->use_size1 = true;
+                dst_view_ptr->size1 = sn_coap_parser_options_parse_uint(packet_data_pptr, option_len);
+                break;
+
+            case COAP_OPTION_SIZE2:
+                if ((option_len > 4) || dst_view_ptr->use_size2) {
+                    ret_status = -1;
+                    break;
+                }
+                dst_view_ptr->use_size2 = true;
+                dst_view_ptr->size2 = sn_coap_parser_options_parse_uint(packet_data_pptr, option_len);
+                break;
+
+            default:
+                tr_error("sn_coap_parser_view - unknown option!");
+                return -1;
+        }
+
+        if (ret_status < 0) {
+            tr_error("sn_coap_parser_view - option %d not valid!", option_number);
+            return -1;
+        }
+
+        /* Check for overflow */
+        if ((*packet_data_pptr - packet_data_start_ptr) > packet_len) {
+            return -1;
+        }
+        message_left = sn_coap_parser_move_packet_ptr(packet_data_pptr, packet_data_start_ptr, packet_len, 0);
+    }
+    return 0;
+}
+
+int8_t sn_coap_parser_view(uint16_t packet_data_len, const uint8_t *packet_data_ptr, sn_coap_hdr_view_s *dst_view_ptr)
+{
+    /* The parser helpers take non-const pointers, but only read the packet */
+    uint8_t *packet_data_start_ptr = (uint8_t *)packet_data_ptr;
+    uint8_t *data_temp_ptr = packet_data_start_ptr;
+    uint8_t *payload_ptr = NULL;
+
+    /* * * * Check given pointer * * * */
+    if (packet_data_ptr == NULL || packet_data_len < 4 || dst_view_ptr == NULL) {
+        return -2;
+    }
+
+    memset(dst_view_ptr, 0, sizeof(sn_coap_hdr_view_s));
+    dst_view_ptr->content_format = COAP_CT_NONE;
+    dst_view_ptr->accept = COAP_CT_NONE;
+    dst_view_ptr->uri_port = COAP_OPTION_URI_PORT_NONE;
+    dst_view_ptr->observe = COAP_OBSERVE_NONE;
+    dst_view_ptr->block1 = COAP_OPTION_BLOCK_NONE;
+    dst_view_ptr->block2 = COAP_OPTION_BLOCK_NONE;
+
+    /* * * * Header parsing, same layout as in sn_coap_parser_header_parse() * * * */
+    dst_view_ptr->coap_version = (coap_version_e)(data_temp_ptr[0] & COAP_HEADER_VERSION_MASK);
+    dst_view_ptr->msg_type = (sn_coap_msg_type_e)(data_temp_ptr[0] & COAP_HEADER_MSG_TYPE_MASK);
+    dst_view_ptr->msg_code = (sn_coap_msg_code_e) data_temp_ptr[1];
+    dst_view_ptr->msg_id = (data_temp_ptr[2] << COAP_HEADER_MSG_ID_MSB_SHIFT) + data_temp_ptr[3];
+    data_temp_ptr += 4;
+
+    /* * * * Options parsing, move pointer over the options... * * * */
+    if (sn_coap_parser_view_options_parse(&data_temp_ptr, dst_view_ptr, packet_data_start_ptr, packet_data_len) != 0) {
+        return -1;
+    }
+
+    /* * * * Payload parsing * * * */
+    if (sn_coap_parser_payload_parse(packet_data_len, packet_data_start_ptr, &data_temp_ptr, &payload_ptr, &dst_view_ptr->payload_len) == -1) {
+        return -1;
+    }
+    dst_view_ptr->payload_ptr = payload_ptr;
+
+    return 0;
+}
+
+void sn_coap_option_iterator_init(sn_coap_option_iterator_s *iterator_ptr, const sn_coap_option_view_s *option_ptr)
+{
+    iterator_ptr->next_ptr = option_ptr->first_ptr;
+    iterator_ptr->next_len = option_ptr->first_len;
+    iterator_ptr->left = option_ptr->count;
+}
+
+bool sn_coap_option_iterator_next(sn_coap_option_iterator_s *iterator_ptr, const uint8_t **value_pptr, uint16_t *value_len_ptr)
+{
+    const uint8_t *option_ptr;
+    uint16_t option_len;
+
+    if (iterator_ptr->left == 0) {
+        return false;
+    }
+
+    *value_pptr = iterator_ptr->next_ptr;
+    *value_len_ptr = iterator_ptr->next_len;
+    iterator_ptr->left--;
+
+    if (iterator_ptr->left) {
+        /* sn_coap_parser_view() has validated the run, so the next option header is read without checks.
+         * The option delta is zero, only the length and its extension are decoded. */
+        option_ptr = iterator_ptr->next_ptr + iterator_ptr->next_len;
+        option_len = *option_ptr & 0x0F;
+        option_ptr++;
+
+        if (option_len == 13) {
+            option_len = 13 + option_ptr[0];
+            option_ptr += 1;
+        } else if (option_len == 14) {
+            option_len = 269 + ((option_ptr[0] << 8) | option_ptr[1]);
+            option_ptr += 2;
+        }
+
+        iterator_ptr->next_ptr = option_ptr;
+        iterator_ptr->next_len = option_len;
+    }
+
+    return true;
+}
@@ -47,11 +47,14 @@
 /* * * * LOCAL FUNCTION PROTOTYPES * * * */
 /* * * * * * * * * * * * * * * * * * * * */
 
+static uint32_t              sn_coap_protocol_system_time(struct coap_s *handle);
+
 #if SN_COAP_DUPLICATION_MAX_MSGS_COUNT/* If Message duplication detection is not used at all, this part of code will not be compiled */
 static void                  sn_coap_protocol_linked_list_duplication_info_store(struct coap_s *handle, sn_nsdl_addr_s *src_addr_ptr, uint16_t msg_id, void *param);
 static coap_duplication_info_s *sn_coap_protocol_linked_list_duplication_info_search(const struct coap_s *handle, const sn_nsdl_addr_s *scr_addr_ptr, const uint16_t msg_id);
 static void                  sn_coap_protocol_linked_list_duplication_info_remove_old_ones(struct coap_s *handle);
 static void                  sn_coap_protocol_duplication_info_free(struct coap_s *handle, coap_duplication_info_s *duplication_info_ptr);
+static void                  sn_coap_protocol_linked_list_duplication_info_unlink(struct coap_s *handle, coap_duplication_info_s *duplication_info_ptr);
 static bool                  sn_coap_protocol_update_duplicate_package_data(const struct coap_s *handle, const sn_nsdl_addr_s *dst_addr_ptr, const sn_coap_hdr_s *coap_msg_ptr, const int16_t data_size, const uint8_t *dst_packet_data_ptr);
 static bool                  sn_coap_protocol_update_duplicate_package_data_all(const struct coap_s *handle, const sn_nsdl_addr_s *dst_addr_ptr, const sn_coap_hdr_s *coap_msg_ptr, const int16_t data_size, const uint8_t *dst_packet_data_ptr);
 
@@ -74,19 +77,27 @@ static int16_t                  store_blockwise_copy(struct coap_s *handle, cons
 #endif
 
 #if ENABLE_RESENDINGS
-static uint8_t               sn_coap_protocol_linked_list_send_msg_store(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint16_t send_packet_data_len, uint8_t *send_packet_data_ptr, uint32_t sending_time, void *param);
+static uint8_t               sn_coap_protocol_linked_list_send_msg_store(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint16_t send_packet_data_len, uint8_t *send_packet_data_ptr, uint32_t sending_time, void *param, bool share_packet);
 static void                  sn_coap_protocol_linked_list_send_msg_remove(struct coap_s *handle, const sn_nsdl_addr_s *src_addr_ptr, uint16_t msg_id);
-static coap_send_msg_s      *sn_coap_protocol_allocate_mem_for_msg(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint16_t packet_data_len);
+static coap_send_msg_s      *sn_coap_protocol_allocate_mem_for_msg(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint16_t packet_data_len, bool allocate_packet);
 static void                  sn_coap_protocol_release_allocated_send_msg_mem(struct coap_s *handle, coap_send_msg_s *freed_send_msg_ptr);
-static uint16_t              sn_coap_count_linked_list_size(const coap_send_msg_list_t *linked_list_ptr);
+static void                  sn_coap_protocol_linked_list_send_msg_add(struct coap_s *handle, coap_send_msg_s *stored_msg_ptr);
+static void                  sn_coap_protocol_linked_list_send_msg_unlink(struct coap_s *handle, coap_send_msg_s *stored_msg_ptr);
+static void                  sn_coap_protocol_linked_list_send_msg_insert_sorted(struct coap_s *handle, coap_send_msg_s *stored_msg_ptr);
 static uint32_t              sn_coap_calculate_new_resend_time(const uint32_t current_time, const uint8_t interval, const uint8_t counter);
 #endif
 
+static int16_t               sn_coap_protocol_build_message(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint8_t *dst_packet_data_ptr, uint16_t dst_packet_data_size, sn_coap_hdr_s *src_coap_msg_ptr, void *param, bool share_packet);
 static uint16_t              read_packet_msg_id(const coap_send_msg_s *stored_msg);
 static uint16_t              get_new_message_id(void);
 
 static bool                  compare_port(const sn_nsdl_addr_s* left, const sn_nsdl_addr_s* right);
 
+#if SN_COAP_INDEXED_MESSAGE_LOOKUP
+static uint16_t              sn_coap_protocol_index_msg_id_bucket(uint16_t msg_id);
+static uint16_t              sn_coap_protocol_index_token_bucket(const uint8_t *token_ptr, uint8_t token_len);
+#endif
+
 /* * * * * * * * * * * * * * * * * */
 /* * * * GLOBAL DECLARATIONS * * * */
 /* * * * * * * * * * * * * * * * * */
@@ -315,9 +326,8 @@ void sn_coap_protocol_clear_retransmission_buffer(struct coap_s *handle)
         return;
     }
     ns_list_foreach_safe(coap_send_msg_s, tmp, &handle->linked_list_resent_msgs) {
-        ns_list_remove(&handle->linked_list_resent_msgs, tmp);
+        sn_coap_protocol_linked_list_send_msg_unlink(handle, tmp);
         sn_coap_protocol_release_allocated_send_msg_mem(handle, tmp);
-        --handle->count_resent_msgs;
     }
 #endif
 }
@@ -328,12 +338,15 @@ int8_t sn_coap_protocol_delete_retransmission(struct coap_s *handle, uint16_t ms
     if (handle == NULL) {
         return -1;
     }
+#if SN_COAP_INDEXED_MESSAGE_LOOKUP
+    for (coap_send_msg_s *tmp = handle->resent_msgs_by_msg_id[sn_coap_protocol_index_msg_id_bucket(msg_id)]; tmp; tmp = tmp->msg_id_next) {
+#else
     ns_list_foreach_safe(coap_send_msg_s, tmp, &handle->linked_list_resent_msgs) {
+#endif
         if (tmp->send_msg_ptr.packet_ptr) {
             uint16_t temp_msg_id = read_packet_msg_id(tmp);
             if (temp_msg_id == msg_id) {
-                ns_list_remove(&handle->linked_list_resent_msgs, tmp);
-                --handle->count_resent_msgs;
+                sn_coap_protocol_linked_list_send_msg_unlink(handle, tmp);
                 sn_coap_protocol_release_allocated_send_msg_mem(handle, tmp);
                 return 0;
             }
@@ -351,14 +364,17 @@ int8_t sn_coap_protocol_delete_retransmission_by_token(struct coap_s *handle, co
         return -1;
     }
 
+#if SN_COAP_INDEXED_MESSAGE_LOOKUP
+    for (coap_send_msg_s *stored_msg = handle->resent_msgs_by_token[sn_coap_protocol_index_token_bucket(token, token_len)]; stored_msg; stored_msg = stored_msg->token_next) {
+#else
     ns_list_foreach(coap_send_msg_s, stored_msg, &handle->linked_list_resent_msgs) {
+#endif
         uint8_t stored_token_len =  (stored_msg->send_msg_ptr.packet_ptr[0] & 0x0F);
         if (stored_token_len == token_len) {
             if (memcmp(&stored_msg->send_msg_ptr.packet_ptr[4], token, stored_token_len) == 0) {
 
                 tr_debug("sn_coap_protocol_delete_retransmission_by_token - removed msg_id: %" PRIu16, read_packet_msg_id(stored_msg));
-                ns_list_remove(&handle->linked_list_resent_msgs, stored_msg);
-                --handle->count_resent_msgs;
+                sn_coap_protocol_linked_list_send_msg_unlink(handle, stored_msg);
 
                 /* Free memory of stored message */
                 sn_coap_protocol_release_allocated_send_msg_mem(handle, stored_msg);
@@ -421,6 +437,103 @@ int8_t prepare_blockwise_message(struct coap_s *handle, sn_coap_hdr_s *src_coap_
 
 int16_t sn_coap_protocol_build(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr,
                                uint8_t *dst_packet_data_ptr, sn_coap_hdr_s *src_coap_msg_ptr, void *param)
+{
+    return sn_coap_protocol_build_message(handle, dst_addr_ptr, dst_packet_data_ptr, 0, src_coap_msg_ptr, param, false);
+}
+
+int16_t sn_coap_protocol_build_2(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint8_t *dst_packet_data_ptr,
+                                 uint16_t dst_packet_data_size, sn_coap_hdr_s *src_coap_msg_ptr, void *param)
+{
+    return sn_coap_protocol_build_message(handle, dst_addr_ptr, dst_packet_data_ptr, dst_packet_data_size, src_coap_msg_ptr, param, true);
+}
+
+uint8_t *sn_coap_protocol_packet_alloc(struct coap_s *handle, uint16_t packet_len)
+{
+    coap_packet_buffer_s *buffer_ptr;
+
+    if (handle == NULL) {
+        return NULL;
+    }
+
+    buffer_ptr = handle->sn_coap_protocol_malloc(sizeof(coap_packet_buffer_s) + packet_len);
+    if (buffer_ptr == NULL) {
+        return NULL;
+    }
+
+    buffer_ptr->free_fn = handle->sn_coap_protocol_free;
+    buffer_ptr->ref_count = 1;
+
+    return (uint8_t *)(buffer_ptr + 1);
+}
+
+static uint8_t *sn_coap_protocol_packet_ref(uint8_t *packet_ptr)
+{
+    coap_packet_buffer_s *buffer_ptr = (coap_packet_buffer_s *)packet_ptr - 1;
+
+    if (buffer_ptr->ref_count == UINT16_MAX) {
+        return NULL;
+    }
+
+    buffer_ptr->ref_count++;
+
+    return packet_ptr;
+}
+
+void sn_coap_protocol_packet_release(uint8_t *packet_ptr)
+{
+    coap_packet_buffer_s *buffer_ptr;
+
+    if (packet_ptr == NULL) {
+        return;
+    }
+
+    buffer_ptr = (coap_packet_buffer_s *)packet_ptr - 1;
+    if (--buffer_ptr->ref_count == 0) {
+        buffer_ptr->free_fn(buffer_ptr);
+    }
+}
+
+uint8_t *sn_coap_protocol_packet_ref_tx(struct coap_s *handle, const uint8_t *data_ptr)
+{
+    if (handle == NULL || data_ptr == NULL || data_ptr != handle->tx_packet_ptr) {
+        return NULL;
+    }
+
+    return sn_coap_protocol_packet_ref((uint8_t *)data_ptr);
+}
+
+uint8_t sn_coap_protocol_send_packet(struct coap_s *handle, uint8_t *packet_ptr, uint16_t packet_len, sn_nsdl_addr_s *dst_addr_ptr, void *param)
+{
+    const uint8_t *previous_tx_packet_ptr;
+    uint8_t ret_val;
+
+    if (handle == NULL || packet_ptr == NULL || handle->sn_coap_tx_callback == NULL) {
+        return 0;
+    }
+
+    /* Restored afterwards, TX callback may send another packet from inside the call */
+    previous_tx_packet_ptr = handle->tx_packet_ptr;
+    handle->tx_packet_ptr = packet_ptr;
+    ret_val = handle->sn_coap_tx_callback(packet_ptr, packet_len, dst_addr_ptr, param);
+    handle->tx_packet_ptr = previous_tx_packet_ptr;
+
+    return ret_val;
+}
+
+/**************************************************************************//**
+ * \fn static int16_t sn_coap_protocol_build_message(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint8_t *dst_packet_data_ptr, uint16_t dst_packet_data_size, sn_coap_hdr_s *src_coap_msg_ptr, void *param, bool share_packet)
+ *
+ * \brief Builds Packet data and stores it for resending purposes
+ *
+ * \param share_packet is false for building with sn_coap_builder_2() and storing
+ *        a copy of the Packet data. Otherwise the message is built with sn_coap_builder_3()
+ *        into dst_packet_data_size bytes of a reference counted buffer and the resending
+ *        list takes a reference to it.
+ *
+ * \return Return value is byte count of built Packet data, see sn_coap_protocol_build()
+ *****************************************************************************/
+static int16_t sn_coap_protocol_build_message(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint8_t *dst_packet_data_ptr,
+                                              uint16_t dst_packet_data_size, sn_coap_hdr_s *src_coap_msg_ptr, void *param, bool share_packet)
 {
     int16_t  byte_count_built     = 0;
 #if SN_COAP_BLOCKWISE_ENABLED || SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE /* If Message blockwising is not enabled, this part of code will not be compiled */
@@ -460,7 +573,11 @@ int16_t sn_coap_protocol_build(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_p
     /* * * * Build Packet data from CoAP message by using CoAP Header builder  * * * */
     /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
-    byte_count_built = sn_coap_builder_2(dst_packet_data_ptr, src_coap_msg_ptr, handle->sn_coap_block_data_size);
+    if (share_packet) {
+        byte_count_built = sn_coap_builder_3(dst_packet_data_ptr, dst_packet_data_size, src_coap_msg_ptr);
+    } else {
+        byte_count_built = sn_coap_builder_2(dst_packet_data_ptr, src_coap_msg_ptr, handle->sn_coap_block_data_size);
+    }
 
     if (byte_count_built < 0) {
         tr_error("sn_coap_protocol_build - failed to build message!");
@@ -472,10 +589,10 @@ int16_t sn_coap_protocol_build(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_p
     /* Check if built Message type was confirmable, only these messages are resent */
     if (src_coap_msg_ptr->msg_type == COAP_MSG_TYPE_CONFIRMABLE) {
         /* Store message to Linked list for resending purposes */
-        uint32_t resend_time = sn_coap_calculate_new_resend_time(handle->system_time, handle->sn_coap_resending_intervall, 0);
+        uint32_t resend_time = sn_coap_calculate_new_resend_time(sn_coap_protocol_system_time(handle), handle->sn_coap_resending_intervall, 0);
         if (sn_coap_protocol_linked_list_send_msg_store(handle, dst_addr_ptr, byte_count_built, dst_packet_data_ptr,
                 resend_time,
-                param) == 0) {
+                param, share_packet) == 0) {
             return -4;
         }
     }
@@ -533,7 +650,7 @@ static int16_t store_blockwise_copy(struct coap_s *handle, const sn_coap_hdr_s *
     }
 
     /* Fill struct */
-    stored_blockwise_msg_ptr->timestamp = handle->system_time;
+    stored_blockwise_msg_ptr->timestamp = sn_coap_protocol_system_time(handle);
 
     stored_blockwise_msg_ptr->coap_msg_ptr = sn_coap_protocol_copy_header(handle, src_coap_msg_ptr);
     if( stored_blockwise_msg_ptr->coap_msg_ptr == NULL ){
@@ -673,10 +790,8 @@ sn_coap_hdr_s *sn_coap_protocol_parse(struct coap_s *handle, sn_nsdl_addr_s *src
                 coap_duplication_info_s *stored_duplication_info_ptr = ns_list_get_first(&handle->linked_list_duplication_msgs);
 
                 // Remove oldest stored duplication message for getting room for new duplication message
-                sn_coap_protocol_linked_list_duplication_info_remove(handle,
-                                                                     stored_duplication_info_ptr->address->addr_ptr,
-                                                                     stored_duplication_info_ptr->address->port,
-                                                                     stored_duplication_info_ptr->msg_id);
+                sn_coap_protocol_linked_list_duplication_info_unlink(handle, stored_duplication_info_ptr);
+                sn_coap_protocol_duplication_info_free(handle, stored_duplication_info_ptr);
             }
 
             // Store Duplication info to Linked list
@@ -862,54 +977,50 @@ int8_t sn_coap_protocol_exec(struct coap_s *handle, uint32_t current_time)
 #endif
 
 #if ENABLE_RESENDINGS
-    /* Check if there is ongoing active message sendings */
-    /* foreach_safe isn't sufficient because callback routine could cancel messages. */
-rescan:
-    ns_list_foreach(coap_send_msg_s, stored_msg_ptr, &handle->linked_list_resent_msgs) {
-        // First check that msg belongs to handle
-        /* Check if it is time to send this message */
-        if (current_time >= stored_msg_ptr->resending_time) {
-            /* * * Increase Resending counter  * * */
-            stored_msg_ptr->resending_counter++;
+    /* Resending list is kept sorted by resending time, so only messages at the head can be due */
+    /* Callback routine could cancel messages, so the head is re-read on every round. */
+    coap_send_msg_s *stored_msg_ptr;
+    while ((stored_msg_ptr = ns_list_get_first(&handle->linked_list_resent_msgs)) != NULL &&
+           current_time >= stored_msg_ptr->resending_time) {
+        /* * * Increase Resending counter  * * */
+        stored_msg_ptr->resending_counter++;
 
-            /* Check if all re-sendings have been done */
-            if (stored_msg_ptr->resending_counter > handle->sn_coap_resending_count) {
-                coap_version_e coap_version = COAP_VERSION_UNKNOWN;
+        /* Check if all re-sendings have been done */
+        if (stored_msg_ptr->resending_counter > handle->sn_coap_resending_count) {
+            coap_version_e coap_version = COAP_VERSION_UNKNOWN;
 
 
-                /* Remove message from Linked list */
-                ns_list_remove(&handle->linked_list_resent_msgs, stored_msg_ptr);
-                --handle->count_resent_msgs;
+            /* Remove message from Linked list */
+            sn_coap_protocol_linked_list_send_msg_unlink(handle, stored_msg_ptr);
 
-                /* If RX callback have been defined.. */
-                if (handle->sn_coap_rx_callback != 0) {
-                    sn_coap_hdr_s *tmp_coap_hdr_ptr;
-                    /* Parse CoAP message, set status and call RX callback */
-                    tmp_coap_hdr_ptr = sn_coap_parser(handle, stored_msg_ptr->send_msg_ptr.packet_len, stored_msg_ptr->send_msg_ptr.packet_ptr, &coap_version);
+            /* If RX callback have been defined.. */
+            if (handle->sn_coap_rx_callback != 0) {
+                sn_coap_hdr_s *tmp_coap_hdr_ptr;
+                /* Parse CoAP message, set status and call RX callback */
+                tmp_coap_hdr_ptr = sn_coap_parser(handle, stored_msg_ptr->send_msg_ptr.packet_len, stored_msg_ptr->send_msg_ptr.packet_ptr, &coap_version);
 
-                    if (tmp_coap_hdr_ptr != 0) {
-                        tmp_coap_hdr_ptr->coap_status = COAP_STATUS_BUILDER_MESSAGE_SENDING_FAILED;
-                        handle->sn_coap_rx_callback(tmp_coap_hdr_ptr, &stored_msg_ptr->send_msg_ptr.dst_addr_ptr, stored_msg_ptr->param);
+                if (tmp_coap_hdr_ptr != 0) {
+                    tmp_coap_hdr_ptr->coap_status = COAP_STATUS_BUILDER_MESSAGE_SENDING_FAILED;
+                    handle->sn_coap_rx_callback(tmp_coap_hdr_ptr, &stored_msg_ptr->send_msg_ptr.dst_addr_ptr, stored_msg_ptr->param);
 
-                        sn_coap_parser_release_allocated_coap_msg_mem(handle, tmp_coap_hdr_ptr);
-                    }
+                    sn_coap_parser_release_allocated_coap_msg_mem(handle, tmp_coap_hdr_ptr);
                 }
-
-                /* Free memory of stored message */
-                sn_coap_protocol_release_allocated_send_msg_mem(handle, stored_msg_ptr);
-            } else {
-                /* Send message  */
-                handle->sn_coap_tx_callback(stored_msg_ptr->send_msg_ptr.packet_ptr,
-                        stored_msg_ptr->send_msg_ptr.packet_len, &stored_msg_ptr->send_msg_ptr.dst_addr_ptr, stored_msg_ptr->param);
-
-                /* * * Count new Resending time  * * */
-                stored_msg_ptr->resending_time = sn_coap_calculate_new_resend_time(current_time,
-                                                                                   handle->sn_coap_resending_intervall,
-                                                                                   stored_msg_ptr->resending_counter);
             }
-            /* Callback routine could have wiped the list (eg as a response to sending failed) */
-            /* Be super cautious and rescan from the start */
-            goto rescan;
+
+            /* Free memory of stored message */
+            sn_coap_protocol_release_allocated_send_msg_mem(handle, stored_msg_ptr);
+        } else {
+            /* * * Count new Resending time and move message to its new place in the list  * * */
+            /* This is done before sending, as TX callback routine could remove the message */
+            stored_msg_ptr->resending_time = sn_coap_calculate_new_resend_time(current_time,
+                                                                               handle->sn_coap_resending_intervall,
+                                                                               stored_msg_ptr->resending_counter);
+            ns_list_remove(&handle->linked_list_resent_msgs, stored_msg_ptr);
+            sn_coap_protocol_linked_list_send_msg_insert_sorted(handle, stored_msg_ptr);
+
+            /* Send message  */
+            sn_coap_protocol_send_packet(handle, stored_msg_ptr->send_msg_ptr.packet_ptr,
+                    stored_msg_ptr->send_msg_ptr.packet_len, &stored_msg_ptr->send_msg_ptr.dst_addr_ptr, stored_msg_ptr->param);
         }
     }
 
@@ -918,10 +1029,86 @@ rescan:
     return 0;
 }
 
+int8_t sn_coap_protocol_get_next_exec_time(struct coap_s *handle, uint32_t *next_time)
+{
+    bool found = false;
+    uint32_t earliest_time = 0;
+
+    if (!handle || !next_time) {
+        return -1;
+    }
+
+    /* All lists are kept in deadline order, so only the first entry of each needs to be checked */
+#if ENABLE_RESENDINGS
+    const coap_send_msg_s *stored_msg_ptr = ns_list_get_first(&handle->linked_list_resent_msgs);
+    if (stored_msg_ptr) {
+        earliest_time = stored_msg_ptr->resending_time;
+        found = true;
+    }
+#endif
+
+#if SN_COAP_DUPLICATION_MAX_MSGS_COUNT
+    const coap_duplication_info_s *duplication_info_ptr = ns_list_get_first(&handle->linked_list_duplication_msgs);
+    if (duplication_info_ptr) {
+        uint32_t expiry_time = duplication_info_ptr->timestamp + SN_COAP_DUPLICATION_MAX_TIME_MSGS_STORED + 1;
+        if (!found || expiry_time < earliest_time) {
+            earliest_time = expiry_time;
+            found = true;
+        }
+    }
+#endif
+
+#if SN_COAP_BLOCKWISE_ENABLED || SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE
+    const coap_blockwise_msg_s *blockwise_msg_ptr = ns_list_get_first(&handle->linked_list_blockwise_sent_msgs);
+    if (blockwise_msg_ptr) {
+        uint32_t expiry_time = blockwise_msg_ptr->timestamp + SN_COAP_BLOCKWISE_MAX_TIME_DATA_STORED + 1;
+        if (!found || expiry_time < earliest_time) {
+            earliest_time = expiry_time;
+            found = true;
+        }
+    }
+
+    const coap_blockwise_payload_s *blockwise_payload_ptr = ns_list_get_first(&handle->linked_list_blockwise_received_payloads);
+    if (blockwise_payload_ptr) {
+        uint32_t expiry_time = blockwise_payload_ptr->timestamp + SN_COAP_BLOCKWISE_MAX_TIME_DATA_STORED + 1;
+        if (!found || expiry_time < earliest_time) {
+            earliest_time = expiry_time;
+            found = true;
+        }
+    }
+#endif
+
+    if (!found) {
+        return -1;
+    }
+
+    *next_time = earliest_time;
+    return 0;
+}
+
+int8_t sn_coap_protocol_set_system_time_callback(struct coap_s *handle, uint32_t (*system_time_callback)(void))
+{
+    if (!handle) {
+        return -1;
+    }
+
+    handle->sn_coap_system_time_callback = system_time_callback;
+    return 0;
+}
+
+/* Time for new entries of the resend, duplication and blockwise lists */
+static uint32_t sn_coap_protocol_system_time(struct coap_s *handle)
+{
+    if (handle->sn_coap_system_time_callback) {
+        handle->system_time = handle->sn_coap_system_time_callback();
+    }
+    return handle->system_time;
+}
+
 #if ENABLE_RESENDINGS  /* If Message resending is not used at all, this part of code will not be compiled */
 
 /**************************************************************************//**
- * \fn static uint8_t sn_coap_protocol_linked_list_send_msg_store(sn_nsdl_addr_s *dst_addr_ptr, uint16_t send_packet_data_len, uint8_t *send_packet_data_ptr, uint32_t sending_time)
+ * \fn static uint8_t sn_coap_protocol_linked_list_send_msg_store(sn_nsdl_addr_s *dst_addr_ptr, uint16_t send_packet_data_len, uint8_t *send_packet_data_ptr, uint32_t sending_time, bool share_packet)
  *
  * \brief Stores message to Linked list for sending purposes.
 
@@ -933,13 +1120,16 @@ rescan:
  *
  * \param sending_time is stored sending time
  *
+ * \param share_packet is false if Packet data is copied. Otherwise send_packet_data_ptr is a
+ *        buffer from sn_coap_protocol_packet_alloc() and the stored message takes a reference to it.
+ *
  * \return 0 Allocation or buffer limit reached
  *
  * \return 1 Msg stored properly
  *****************************************************************************/
 
 static uint8_t sn_coap_protocol_linked_list_send_msg_store(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint16_t send_packet_data_len,
-        uint8_t *send_packet_data_ptr, uint32_t sending_time, void *param)
+        uint8_t *send_packet_data_ptr, uint32_t sending_time, void *param, bool share_packet)
 {
 
     coap_send_msg_s *stored_msg_ptr;
@@ -958,14 +1148,14 @@ static uint8_t sn_coap_protocol_linked_list_send_msg_store(struct coap_s *handle
 
     /* Count resending queue size, if buffer size is defined */
     if (handle->sn_coap_resending_queue_bytes > 0) {
-        if ((sn_coap_count_linked_list_size(&handle->linked_list_resent_msgs) + send_packet_data_len) > handle->sn_coap_resending_queue_bytes) {
+        if ((handle->size_resent_msgs + send_packet_data_len) > handle->sn_coap_resending_queue_bytes) {
             tr_error("sn_coap_protocol_linked_list_send_msg_store - resend buffer size reached!");
             return 0;
         }
     }
 
     /* Allocating memory for stored message */
-    stored_msg_ptr = sn_coap_protocol_allocate_mem_for_msg(handle, dst_addr_ptr, send_packet_data_len);
+    stored_msg_ptr = sn_coap_protocol_allocate_mem_for_msg(handle, dst_addr_ptr, send_packet_data_len, !share_packet);
 
     if (stored_msg_ptr == 0) {
         tr_error("sn_coap_protocol_linked_list_send_msg_store - failed to allocate message!");
@@ -979,7 +1169,15 @@ static uint8_t sn_coap_protocol_linked_list_send_msg_store(struct coap_s *handle
     /* Filling of sn_nsdl_transmit_s */
     stored_msg_ptr->send_msg_ptr.protocol = SN_NSDL_PROTOCOL_COAP;
     stored_msg_ptr->send_msg_ptr.packet_len = send_packet_data_len;
-    memcpy(stored_msg_ptr->send_msg_ptr.packet_ptr, send_packet_data_ptr, send_packet_data_len);
+    if (share_packet) {
+        stored_msg_ptr->send_msg_ptr.packet_ptr = sn_coap_protocol_packet_ref(send_packet_data_ptr);
+        if (stored_msg_ptr->send_msg_ptr.packet_ptr == NULL) {
+            sn_coap_protocol_release_allocated_send_msg_mem(handle, stored_msg_ptr);
+            return 0;
+        }
+    } else {
+        memcpy(stored_msg_ptr->send_msg_ptr.packet_ptr, send_packet_data_ptr, send_packet_data_len);
+    }
 
     /* Filling of sn_nsdl_addr_s */
     stored_msg_ptr->send_msg_ptr.dst_addr_ptr.type = dst_addr_ptr->type;
@@ -990,8 +1188,7 @@ static uint8_t sn_coap_protocol_linked_list_send_msg_store(struct coap_s *handle
     stored_msg_ptr->param = param;
 
     /* Storing Resending message to Linked list */
-    ns_list_add_to_end(&handle->linked_list_resent_msgs, stored_msg_ptr);
-    ++handle->count_resent_msgs;
+    sn_coap_protocol_linked_list_send_msg_add(handle, stored_msg_ptr);
     return 1;
 }
 
@@ -1007,8 +1204,13 @@ static uint8_t sn_coap_protocol_linked_list_send_msg_store(struct coap_s *handle
 
 static void sn_coap_protocol_linked_list_send_msg_remove(struct coap_s *handle, const sn_nsdl_addr_s *src_addr_ptr, uint16_t msg_id)
 {
+#if SN_COAP_INDEXED_MESSAGE_LOOKUP
+    /* Loop stored resending messages with the same Message ID hash */
+    for (coap_send_msg_s *stored_msg_ptr = handle->resent_msgs_by_msg_id[sn_coap_protocol_index_msg_id_bucket(msg_id)]; stored_msg_ptr; stored_msg_ptr = stored_msg_ptr->msg_id_next) {
+#else
     /* Loop all stored resending messages in Linked list */
     ns_list_foreach(coap_send_msg_s, stored_msg_ptr, &handle->linked_list_resent_msgs) {
+#endif
         /* Get message ID from stored resending message */
         uint16_t temp_msg_id = read_packet_msg_id(stored_msg_ptr);
         /* If message's Message ID is same than is searched */
@@ -1018,8 +1220,7 @@ static void sn_coap_protocol_linked_list_send_msg_remove(struct coap_s *handle,
             if (compare_port(src_addr_ptr, &stored_msg_ptr->send_msg_ptr.dst_addr_ptr)) {
                 /* * * Message found * * */
                 /* Remove message from Linked list */
-                ns_list_remove(&handle->linked_list_resent_msgs, stored_msg_ptr);
-                --handle->count_resent_msgs;
+                sn_coap_protocol_linked_list_send_msg_unlink(handle, stored_msg_ptr);
 
                 /* Free memory of stored message */
                 sn_coap_protocol_release_allocated_send_msg_mem(handle, stored_msg_ptr);
@@ -1030,6 +1231,91 @@ static void sn_coap_protocol_linked_list_send_msg_remove(struct coap_s *handle,
     }
 }
 
+/**************************************************************************//**
+ * \fn static void sn_coap_protocol_linked_list_send_msg_add(struct coap_s *handle, coap_send_msg_s *stored_msg_ptr)
+ *
+ * \brief Adds message to resending Linked list and updates message count, size and indexes
+ *
+ * \param *stored_msg_ptr is message to be added, packet and resending time must be filled in already
+ *****************************************************************************/
+
+static void sn_coap_protocol_linked_list_send_msg_add(struct coap_s *handle, coap_send_msg_s *stored_msg_ptr)
+{
+    sn_coap_protocol_linked_list_send_msg_insert_sorted(handle, stored_msg_ptr);
+    ++handle->count_resent_msgs;
+    handle->size_resent_msgs += stored_msg_ptr->send_msg_ptr.packet_len;
+
+#if SN_COAP_INDEXED_MESSAGE_LOOKUP
+    /* Append to the end of bucket chains so that searches find messages in the order they were stored */
+    coap_send_msg_s **link_ptr = &handle->resent_msgs_by_msg_id[sn_coap_protocol_index_msg_id_bucket(read_packet_msg_id(stored_msg_ptr))];
+    while (*link_ptr) {
+        link_ptr = &(*link_ptr)->msg_id_next;
+    }
+    stored_msg_ptr->msg_id_next = NULL;
+    *link_ptr = stored_msg_ptr;
+
+    link_ptr = &handle->resent_msgs_by_token[sn_coap_protocol_index_token_bucket(&stored_msg_ptr->send_msg_ptr.packet_ptr[4],
+                                                                                 stored_msg_ptr->send_msg_ptr.packet_ptr[0] & 0x0F)];
+    while (*link_ptr) {
+        link_ptr = &(*link_ptr)->token_next;
+    }
+    stored_msg_ptr->token_next = NULL;
+    *link_ptr = stored_msg_ptr;
+#endif
+}
+
+/**************************************************************************//**
+ * \fn static void sn_coap_protocol_linked_list_send_msg_unlink(struct coap_s *handle, coap_send_msg_s *stored_msg_ptr)
+ *
+ * \brief Removes message from resending Linked list and indexes, memory is not released
+ *
+ * \param *stored_msg_ptr is message to be removed, must be in the list
+ *****************************************************************************/
+
+static void sn_coap_protocol_linked_list_send_msg_unlink(struct coap_s *handle, coap_send_msg_s *stored_msg_ptr)
+{
+    ns_list_remove(&handle->linked_list_resent_msgs, stored_msg_ptr);
+    --handle->count_resent_msgs;
+    handle->size_resent_msgs -= stored_msg_ptr->send_msg_ptr.packet_len;
+
+#if SN_COAP_INDEXED_MESSAGE_LOOKUP
+    coap_send_msg_s **link_ptr = &handle->resent_msgs_by_msg_id[sn_coap_protocol_index_msg_id_bucket(read_packet_msg_id(stored_msg_ptr))];
+    while (*link_ptr != stored_msg_ptr) {
+        link_ptr = &(*link_ptr)->msg_id_next;
+    }
+    *link_ptr = stored_msg_ptr->msg_id_next;
+
+    link_ptr = &handle->resent_msgs_by_token[sn_coap_protocol_index_token_bucket(&stored_msg_ptr->send_msg_ptr.packet_ptr[4],
+                                                                                 stored_msg_ptr->send_msg_ptr.packet_ptr[0] & 0x0F)];
+    while (*link_ptr != stored_msg_ptr) {
+        link_ptr = &(*link_ptr)->token_next;
+    }
+    *link_ptr = stored_msg_ptr->token_next;
+#endif
+}
+
+/**************************************************************************//**
+ * \fn static void sn_coap_protocol_linked_list_send_msg_insert_sorted(struct coap_s *handle, coap_send_msg_s *stored_msg_ptr)
+ *
+ * \brief Inserts message to resending Linked list so that the list stays sorted by resending time
+ *
+ * Messages with equal resending time keep their insertion order. The list is scanned from the end,
+ * as a new resending time is normally the latest one.
+ *
+ * \param *stored_msg_ptr is message to be inserted, must not be in the list
+ *****************************************************************************/
+
+static void sn_coap_protocol_linked_list_send_msg_insert_sorted(struct coap_s *handle, coap_send_msg_s *stored_msg_ptr)
+{
+    ns_list_foreach_reverse(coap_send_msg_s, previous_msg_ptr, &handle->linked_list_resent_msgs) {
+        if (previous_msg_ptr->resending_time <= stored_msg_ptr->resending_time) {
+            ns_list_add_after(&handle->linked_list_resent_msgs, previous_msg_ptr, stored_msg_ptr);
+            return;
+        }
+    }
+    ns_list_add_to_start(&handle->linked_list_resent_msgs, stored_msg_ptr);
+}
+
 uint32_t sn_coap_calculate_new_resend_time(const uint32_t current_time, const uint8_t interval, const uint8_t counter)
 {
     uint32_t resend_time = interval << counter;
@@ -1107,7 +1393,7 @@ static void sn_coap_protocol_linked_list_duplication_info_store(struct coap_s *h
     }
 
     /* * * * Filling fields of stored Duplication info * * * */
-    stored_duplication_info_ptr->timestamp = handle->system_time;
+    stored_duplication_info_ptr->timestamp = sn_coap_protocol_system_time(handle);
     stored_duplication_info_ptr->address->addr_len = addr_ptr->addr_len;
     memcpy(stored_duplication_info_ptr->address->addr_ptr, addr_ptr->addr_ptr, addr_ptr->addr_len);
     stored_duplication_info_ptr->address->port = addr_ptr->port;
@@ -1118,6 +1404,14 @@ static void sn_coap_protocol_linked_list_duplication_info_store(struct coap_s *h
 
     ns_list_add_to_end(&handle->linked_list_duplication_msgs, stored_duplication_info_ptr);
     ++handle->count_duplication_msgs;
+
+#if SN_COAP_INDEXED_MESSAGE_LOOKUP
+    coap_duplication_info_s **link_ptr = &handle->duplication_msgs_index[sn_coap_protocol_index_msg_id_bucket(msg_id ^ addr_ptr->port)];
+    while (*link_ptr) {
+        link_ptr = &(*link_ptr)->index_next;
+    }
+    *link_ptr = stored_duplication_info_ptr;
+#endif
 }
 
 /**************************************************************************//**
@@ -1134,8 +1428,14 @@ static void sn_coap_protocol_linked_list_duplication_info_store(struct coap_s *h
 static coap_duplication_info_s* sn_coap_protocol_linked_list_duplication_info_search(const struct coap_s *handle,
         const sn_nsdl_addr_s *addr_ptr, const uint16_t msg_id)
 {
+#if SN_COAP_INDEXED_MESSAGE_LOOKUP
+    /* Loop nodes with the same Message ID and port hash */
+    for (coap_duplication_info_s *stored_duplication_info_ptr = handle->duplication_msgs_index[sn_coap_protocol_index_msg_id_bucket(msg_id ^ addr_ptr->port)];
+            stored_duplication_info_ptr; stored_duplication_info_ptr = stored_duplication_info_ptr->index_next) {
+#else
     /* Loop all nodes in Linked list for searching Message ID */
     ns_list_foreach(coap_duplication_info_s, stored_duplication_info_ptr, &handle->linked_list_duplication_msgs) {
+#endif
         /* If message's Message ID is same than is searched */
         if (stored_duplication_info_ptr->msg_id == msg_id) {
             /* If message's Source address & port is same than is searched */
@@ -1158,17 +1458,37 @@ static coap_duplication_info_s* sn_coap_protocol_linked_list_duplication_info_se
 
 static void sn_coap_protocol_linked_list_duplication_info_remove_old_ones(struct coap_s *handle)
 {
+    /* Duplication infos are stored to the end of the list, so the list is in timestamp order and the oldest ones are first */
+    coap_duplication_info_s *removed_duplication_info_ptr;
+    while ((removed_duplication_info_ptr = ns_list_get_first(&handle->linked_list_duplication_msgs)) != NULL &&
+           (handle->system_time - removed_duplication_info_ptr->timestamp)  > SN_COAP_DUPLICATION_MAX_TIME_MSGS_STORED) {
+        /* * * * Old Duplication info found, remove it from Linked list * * * */
+        sn_coap_protocol_linked_list_duplication_info_unlink(handle, removed_duplication_info_ptr);
 
-    ns_list_foreach_safe(coap_duplication_info_s, removed_duplication_info_ptr, &handle->linked_list_duplication_msgs) {
-        if ((handle->system_time - removed_duplication_info_ptr->timestamp)  > SN_COAP_DUPLICATION_MAX_TIME_MSGS_STORED) {
-            /* * * * Old Duplication info found, remove it from Linked list * * * */
-            ns_list_remove(&handle->linked_list_duplication_msgs, removed_duplication_info_ptr);
-            --handle->count_duplication_msgs;
+        /* Free memory of stored Duplication info */
+        sn_coap_protocol_duplication_info_free(handle, removed_duplication_info_ptr);
+    }
+}
 
-            /* Free memory of stored Duplication info */
-            sn_coap_protocol_duplication_info_free(handle, removed_duplication_info_ptr);
-        }
+/**************************************************************************//**
+ * \fn static void sn_coap_protocol_linked_list_duplication_info_unlink(struct coap_s *handle, coap_duplication_info_s *duplication_info_ptr)
+ *
+ * \brief Removes Duplication info from Linked list and index, memory is not released
+ *****************************************************************************/
+
+static void sn_coap_protocol_linked_list_duplication_info_unlink(struct coap_s *handle, coap_duplication_info_s *duplication_info_ptr)
+{
+    ns_list_remove(&handle->linked_list_duplication_msgs, duplication_info_ptr);
+    --handle->count_duplication_msgs;
+
+#if SN_COAP_INDEXED_MESSAGE_LOOKUP
+    coap_duplication_info_s **link_ptr = &handle->duplication_msgs_index[sn_coap_protocol_index_msg_id_bucket(duplication_info_ptr->msg_id ^
+                                                                                                             duplication_info_ptr->address->port)];
+    while (*link_ptr != duplication_info_ptr) {
+        link_ptr = &(*link_ptr)->index_next;
     }
+    *link_ptr = duplication_info_ptr->index_next;
+#endif
 }
 
 #endif /* SN_COAP_DUPLICATION_MAX_MSGS_COUNT */
@@ -1176,8 +1496,14 @@ static void sn_coap_protocol_linked_list_duplication_info_remove_old_ones(struct
 void sn_coap_protocol_linked_list_duplication_info_remove(struct coap_s *handle, const uint8_t *scr_addr_ptr, const uint16_t port, const uint16_t msg_id)
 {
 #if SN_COAP_DUPLICATION_MAX_MSGS_COUNT
+#if SN_COAP_INDEXED_MESSAGE_LOOKUP
+    /* Loop stored duplication messages with the same Message ID and port hash */
+    for (coap_duplication_info_s *removed_duplication_info_ptr = handle->duplication_msgs_index[sn_coap_protocol_index_msg_id_bucket(msg_id ^ port)];
+            removed_duplication_info_ptr; removed_duplication_info_ptr = removed_duplication_info_ptr->index_next) {
+#else
     /* Loop all stored duplication messages in Linked list */
     ns_list_foreach(coap_duplication_info_s, removed_duplication_info_ptr, &handle->linked_list_duplication_msgs) {
+#endif
         /* If message's Address is same than is searched */
         if (0 == memcmp(scr_addr_ptr,
                         removed_duplication_info_ptr->address->addr_ptr,
@@ -1188,8 +1514,7 @@ void sn_coap_protocol_linked_list_duplication_info_remove(struct coap_s *handle,
                 if (removed_duplication_info_ptr->msg_id == msg_id) {
                     /* * * * Correct Duplication info found, remove it from Linked list * * * */
                     tr_info("sn_coap_protocol_linked_list_duplication_info_remove - message id %d removed", msg_id);
-                    ns_list_remove(&handle->linked_list_duplication_msgs, removed_duplication_info_ptr);
-                    --handle->count_duplication_msgs;
+                    sn_coap_protocol_linked_list_duplication_info_unlink(handle, removed_duplication_info_ptr);
 
                     /* Free memory of stored Duplication info */
                     sn_coap_protocol_duplication_info_free(handle, removed_duplication_info_ptr);
@@ -1377,7 +1702,13 @@ static void sn_coap_protocol_linked_list_blockwise_payload_store(struct coap_s *
     }
 
     stored_blockwise_payload_ptr->block_number = block_number;
-    stored_blockwise_payload_ptr->timestamp = handle->system_time;
+    stored_blockwise_payload_ptr->timestamp = sn_coap_protocol_system_time(handle);
+
+    /* Refreshed payload is moved to the end, the list must stay in timestamp order for the timeout handling */
+    if (ns_list_get_last(&handle->linked_list_blockwise_received_payloads) != stored_blockwise_payload_ptr) {
+        ns_list_remove(&handle->linked_list_blockwise_received_payloads, stored_blockwise_payload_ptr);
+        ns_list_add_to_end(&handle->linked_list_blockwise_received_payloads, stored_blockwise_payload_ptr);
+    }
 }
 
 /**************************************************************************//**
@@ -1539,47 +1870,39 @@ static uint32_t sn_coap_protocol_linked_list_blockwise_payloads_get_len(struct c
 
 static void sn_coap_protocol_handle_blockwise_timout(struct coap_s *handle)
 {
-    /* Loop all outgoing blockwise messages */
-    /* foreach_safe isn't sufficient because callback routine could remove messages. */
-rescan:
-    ns_list_foreach_safe(coap_blockwise_msg_s, removed_blocwise_msg_ptr, &handle->linked_list_blockwise_sent_msgs) {
-        if ((handle->system_time - removed_blocwise_msg_ptr->timestamp)  > SN_COAP_BLOCKWISE_MAX_TIME_DATA_STORED) {
-            bool callback_called = false;
-            // Item must be removed from the list before calling the rx_callback function.
-            // Callback could actually clear the list and free the item and cause a use after free when callback returns.
-            ns_list_remove(&handle->linked_list_blockwise_sent_msgs, removed_blocwise_msg_ptr);
-
-            /* * * * This messages has timed out, remove it from Linked list * * * */
-            if( removed_blocwise_msg_ptr->coap_msg_ptr ){
-                if (handle->sn_coap_rx_callback) {
-                    /* Notify the application about the time out */
-                    removed_blocwise_msg_ptr->coap_msg_ptr->coap_status = COAP_STATUS_BUILDER_BLOCK_SENDING_FAILED;
-                    removed_blocwise_msg_ptr->coap_msg_ptr->msg_id = removed_blocwise_msg_ptr->msg_id;
-                    sn_coap_protocol_delete_retransmission(handle, removed_blocwise_msg_ptr->msg_id);
-                    handle->sn_coap_rx_callback(removed_blocwise_msg_ptr->coap_msg_ptr, NULL, removed_blocwise_msg_ptr->param);
-                    callback_called = true;
-                }
-                handle->sn_coap_protocol_free(removed_blocwise_msg_ptr->coap_msg_ptr->payload_ptr);
-                sn_coap_parser_release_allocated_coap_msg_mem(handle, removed_blocwise_msg_ptr->coap_msg_ptr);
-            }
-
-            handle->sn_coap_protocol_free(removed_blocwise_msg_ptr);
-
-            if (callback_called) {
-                /* Callback routine could have wiped the list already */
-                /* Be super cautious and rescan from the start */
-                goto rescan;
+    /* Both blockwise lists are in timestamp order, so only the oldest entries at the head need to be checked */
+    /* Loop outgoing blockwise messages */
+    /* Callback routine could remove messages, so the head is re-read on every round. */
+    coap_blockwise_msg_s *removed_blocwise_msg_ptr;
+    while ((removed_blocwise_msg_ptr = ns_list_get_first(&handle->linked_list_blockwise_sent_msgs)) != NULL &&
+           (handle->system_time - removed_blocwise_msg_ptr->timestamp)  > SN_COAP_BLOCKWISE_MAX_TIME_DATA_STORED) {
+        // Item must be removed from the list before calling the rx_callback function.
+        // Callback could actually clear the list and free the item and cause a use after free when callback returns.
+        ns_list_remove(&handle->linked_list_blockwise_sent_msgs, removed_blocwise_msg_ptr);
+
+        /* * * * This messages has timed out, remove it from Linked list * * * */
+        if( removed_blocwise_msg_ptr->coap_msg_ptr ){
+            if (handle->sn_coap_rx_callback) {
+                /* Notify the application about the time out */
+                removed_blocwise_msg_ptr->coap_msg_ptr->coap_status = COAP_STATUS_BUILDER_BLOCK_SENDING_FAILED;
+                removed_blocwise_msg_ptr->coap_msg_ptr->msg_id = removed_blocwise_msg_ptr->msg_id;
+                sn_coap_protocol_delete_retransmission(handle, removed_blocwise_msg_ptr->msg_id);
+                handle->sn_coap_rx_callback(removed_blocwise_msg_ptr->coap_msg_ptr, NULL, removed_blocwise_msg_ptr->param);
             }
+            handle->sn_coap_protocol_free(removed_blocwise_msg_ptr->coap_msg_ptr->payload_ptr);
+            sn_coap_parser_release_allocated_coap_msg_mem(handle, removed_blocwise_msg_ptr->coap_msg_ptr);
         }
+
+        handle->sn_coap_protocol_free(removed_blocwise_msg_ptr);
     }
 
 
-    /* Loop all incoming Blockwise messages */
-    ns_list_foreach_safe(coap_blockwise_payload_s, removed_blocwise_payload_ptr, &handle->linked_list_blockwise_received_payloads) {
-        if ((handle->system_time - removed_blocwise_payload_ptr->timestamp)  > SN_COAP_BLOCKWISE_MAX_TIME_DATA_STORED) {
-            /* * * * This messages has timed out, remove it from Linked list * * * */
-            sn_coap_protocol_linked_list_blockwise_payload_remove(handle, removed_blocwise_payload_ptr);
-        }
+    /* Loop incoming Blockwise messages */
+    coap_blockwise_payload_s *removed_blocwise_payload_ptr;
+    while ((removed_blocwise_payload_ptr = ns_list_get_first(&handle->linked_list_blockwise_received_payloads)) != NULL &&
+           (handle->system_time - removed_blocwise_payload_ptr->timestamp)  > SN_COAP_BLOCKWISE_MAX_TIME_DATA_STORED) {
+        /* * * * This messages has timed out, remove it from Linked list * * * */
+        sn_coap_protocol_linked_list_blockwise_payload_remove(handle, removed_blocwise_payload_ptr);
     }
 }
 
@@ -1594,12 +1917,12 @@ rescan:
  *
  * \param *dst_addr_ptr is pointer to destination address where message will be sent
  * \param packet_data_len is length of allocated Packet data
- * \param uri_path_len is length of messages path url
+ * \param allocate_packet is false if the caller shares an already built Packet data buffer
  *
  * \return pointer to allocated struct
  *****************************************************************************/
 
-coap_send_msg_s *sn_coap_protocol_allocate_mem_for_msg(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint16_t packet_data_len)
+coap_send_msg_s *sn_coap_protocol_allocate_mem_for_msg(struct coap_s *handle, sn_nsdl_addr_s *dst_addr_ptr, uint16_t packet_data_len, bool allocate_packet)
 {
 
     coap_send_msg_s *msg_ptr = sn_coap_protocol_calloc(handle, sizeof(coap_send_msg_s));
@@ -1608,12 +1931,14 @@ coap_send_msg_s *sn_coap_protocol_allocate_mem_for_msg(struct coap_s *handle, sn
         return 0;
     }
 
-    msg_ptr->send_msg_ptr.packet_ptr = handle->sn_coap_protocol_malloc(packet_data_len);
+    if (allocate_packet) {
+        msg_ptr->send_msg_ptr.packet_ptr = sn_coap_protocol_packet_alloc(handle, packet_data_len);
+    }
 
     msg_ptr->send_msg_ptr.dst_addr_ptr.addr_ptr = sn_coap_protocol_calloc(handle, dst_addr_ptr->addr_len);
 
     if ((msg_ptr->send_msg_ptr.dst_addr_ptr.addr_ptr == NULL) ||
-        (msg_ptr->send_msg_ptr.packet_ptr == NULL)) {
+        (allocate_packet && msg_ptr->send_msg_ptr.packet_ptr == NULL)) {
 
         sn_coap_protocol_release_allocated_send_msg_mem(handle, msg_ptr);
         return 0;
@@ -1637,30 +1962,12 @@ static void sn_coap_protocol_release_allocated_send_msg_mem(struct coap_s *handl
 
         handle->sn_coap_protocol_free(freed_send_msg_ptr->send_msg_ptr.dst_addr_ptr.addr_ptr);
 
-        handle->sn_coap_protocol_free(freed_send_msg_ptr->send_msg_ptr.packet_ptr);
+        sn_coap_protocol_packet_release(freed_send_msg_ptr->send_msg_ptr.packet_ptr);
 
         handle->sn_coap_protocol_free(freed_send_msg_ptr);
     }
 }
 
-/**************************************************************************//**
- * \fn static uint16_t sn_coap_count_linked_list_size(const coap_send_msg_list_t *linked_list_ptr)
- *
- * \brief Counts total message size of all messages in linked list
- *
- * \param const coap_send_msg_list_t *linked_list_ptr pointer to linked list
- *****************************************************************************/
-static uint16_t sn_coap_count_linked_list_size(const coap_send_msg_list_t *linked_list_ptr)
-{
-    uint16_t total_size = 0;
-
-    ns_list_foreach(coap_send_msg_s, stored_msg_ptr, linked_list_ptr) {
-        total_size += stored_msg_ptr->send_msg_ptr.packet_len;
-    }
-
-    return total_size;
-}
-
 #endif
 
 #if SN_COAP_BLOCKWISE_ENABLED || SN_COAP_MAX_BLOCKWISE_PAYLOAD_SIZE
@@ -1821,7 +2128,7 @@ static sn_coap_hdr_s *sn_coap_handle_blockwise_message(struct coap_s *handle, sn
                     /* Build and send block message */
                     dst_packed_data_needed_mem = sn_coap_builder_calc_needed_packet_data_size_2(src_coap_blockwise_ack_msg_ptr, handle->sn_coap_block_data_size);
 
-                    dst_ack_packet_data_ptr = handle->sn_coap_protocol_malloc(dst_packed_data_needed_mem);
+                    dst_ack_packet_data_ptr = sn_coap_protocol_packet_alloc(handle, dst_packed_data_needed_mem);
                     if (!dst_ack_packet_data_ptr) {
                         tr_error("sn_coap_handle_blockwise_message - (send block1) failed to allocate ack message!");
                         handle->sn_coap_protocol_free(src_coap_blockwise_ack_msg_ptr->options_list_ptr);
@@ -1834,19 +2141,19 @@ static sn_coap_hdr_s *sn_coap_handle_blockwise_message(struct coap_s *handle, sn
 
                     sn_coap_builder_2(dst_ack_packet_data_ptr, src_coap_blockwise_ack_msg_ptr, handle->sn_coap_block_data_size);
 
-                    handle->sn_coap_tx_callback(dst_ack_packet_data_ptr, dst_packed_data_needed_mem, src_addr_ptr, param);
+                    sn_coap_protocol_send_packet(handle, dst_ack_packet_data_ptr, dst_packed_data_needed_mem, src_addr_ptr, param);
 
 #if ENABLE_RESENDINGS
-                    uint32_t resend_time = sn_coap_calculate_new_resend_time(handle->system_time, handle->sn_coap_resending_intervall, 0);
+                    uint32_t resend_time = sn_coap_calculate_new_resend_time(sn_coap_protocol_system_time(handle), handle->sn_coap_resending_intervall, 0);
                     if (src_coap_blockwise_ack_msg_ptr->msg_type == COAP_MSG_TYPE_CONFIRMABLE) {
                         sn_coap_protocol_linked_list_send_msg_store(handle, src_addr_ptr,
                                 dst_packed_data_needed_mem,
                                 dst_ack_packet_data_ptr,
-                                resend_time, param);
+                                resend_time, param, true);
                     }
 #endif
 
-                    handle->sn_coap_protocol_free(dst_ack_packet_data_ptr);
+                    sn_coap_protocol_packet_release(dst_ack_packet_data_ptr);
                     dst_ack_packet_data_ptr = 0;
 
                     stored_blockwise_msg_temp_ptr->coap_msg_ptr->payload_len = original_payload_len;
@@ -1944,7 +2251,7 @@ static sn_coap_hdr_s *sn_coap_handle_blockwise_message(struct coap_s *handle, sn
 
                 dst_packed_data_needed_mem = sn_coap_builder_calc_needed_packet_data_size_2(src_coap_blockwise_ack_msg_ptr, handle->sn_coap_block_data_size);
 
-                dst_ack_packet_data_ptr = handle->sn_coap_protocol_malloc(dst_packed_data_needed_mem);
+                dst_ack_packet_data_ptr = sn_coap_protocol_packet_alloc(handle, dst_packed_data_needed_mem);
                 if (!dst_ack_packet_data_ptr) {
                     tr_error("sn_coap_handle_blockwise_message - (recv block1) message allocation failed!");
                     handle->sn_coap_protocol_free(src_coap_blockwise_ack_msg_ptr->options_list_ptr);
@@ -1962,7 +2269,7 @@ static sn_coap_hdr_s *sn_coap_handle_blockwise_message(struct coap_s *handle, sn
                                                                     dst_packed_data_needed_mem,
                                                                     dst_ack_packet_data_ptr)) {
                     sn_coap_parser_release_allocated_coap_msg_mem(handle, src_coap_blockwise_ack_msg_ptr);
-                    handle->sn_coap_protocol_free(dst_ack_packet_data_ptr);
+                    sn_coap_protocol_packet_release(dst_ack_packet_data_ptr);
                     return NULL;
                 }
 #endif
@@ -1981,10 +2288,10 @@ static sn_coap_hdr_s *sn_coap_handle_blockwise_message(struct coap_s *handle, sn
                                                                          received_coap_msg_ptr->options_list_ptr->size1);
                 }
 
-                handle->sn_coap_tx_callback(dst_ack_packet_data_ptr, dst_packed_data_needed_mem, src_addr_ptr, param);
+                sn_coap_protocol_send_packet(handle, dst_ack_packet_data_ptr, dst_packed_data_needed_mem, src_addr_ptr, param);
 
                 sn_coap_parser_release_allocated_coap_msg_mem(handle, src_coap_blockwise_ack_msg_ptr);
-                handle->sn_coap_protocol_free(dst_ack_packet_data_ptr);
+                sn_coap_protocol_packet_release(dst_ack_packet_data_ptr);
                 dst_ack_packet_data_ptr = 0;
 
                 received_coap_msg_ptr->coap_status = COAP_STATUS_PARSER_BLOCKWISE_MSG_RECEIVING;
@@ -2095,7 +2402,7 @@ static sn_coap_hdr_s *sn_coap_handle_blockwise_message(struct coap_s *handle, sn
                     dst_packed_data_needed_mem = sn_coap_builder_calc_needed_packet_data_size_2(src_coap_blockwise_ack_msg_ptr, handle->sn_coap_block_data_size);
 
                     /* Then allocate memory for Packet data */
-                    dst_ack_packet_data_ptr = sn_coap_protocol_calloc(handle, dst_packed_data_needed_mem);
+                    dst_ack_packet_data_ptr = sn_coap_protocol_packet_alloc(handle, dst_packed_data_needed_mem);
 
                     if (dst_ack_packet_data_ptr == NULL) {
                         tr_error("sn_coap_handle_blockwise_message - (send block2) failed to allocate packet!");
@@ -2106,7 +2413,7 @@ static sn_coap_hdr_s *sn_coap_handle_blockwise_message(struct coap_s *handle, sn
                     /* * * Then build Acknowledgement message to Packed data * * */
                     if ((sn_coap_builder_2(dst_ack_packet_data_ptr, src_coap_blockwise_ack_msg_ptr, handle->sn_coap_block_data_size)) < 0) {
                         tr_error("sn_coap_handle_blockwise_message - (send block2) builder failed!");
-                        handle->sn_coap_protocol_free(dst_ack_packet_data_ptr);
+                        sn_coap_protocol_packet_release(dst_ack_packet_data_ptr);
                         sn_coap_parser_release_allocated_coap_msg_mem(handle, src_coap_blockwise_ack_msg_ptr);
                         return NULL;
                     }
@@ -2117,12 +2424,12 @@ static sn_coap_hdr_s *sn_coap_handle_blockwise_message(struct coap_s *handle, sn
                     stored_blockwise_msg_ptr = sn_coap_protocol_calloc(handle, sizeof(coap_blockwise_msg_s));
                     if (!stored_blockwise_msg_ptr) {
                         tr_error("sn_coap_handle_blockwise_message - (send block2) failed to allocate blockwise message!");
-                        handle->sn_coap_protocol_free(dst_ack_packet_data_ptr);
+                        sn_coap_protocol_packet_release(dst_ack_packet_data_ptr);
                         sn_coap_parser_release_allocated_coap_msg_mem(handle, src_coap_blockwise_ack_msg_ptr);
                         return 0;
                     }
 
-                    stored_blockwise_msg_ptr->timestamp = handle->system_time;
+                    stored_blockwise_msg_ptr->timestamp = sn_coap_protocol_system_time(handle);
 
                     stored_blockwise_msg_ptr->coap_msg_ptr = src_coap_blockwise_ack_msg_ptr;
                     stored_blockwise_msg_ptr->param = param;
@@ -2130,17 +2437,17 @@ static sn_coap_hdr_s *sn_coap_handle_blockwise_message(struct coap_s *handle, sn
                     ns_list_add_to_end(&handle->linked_list_blockwise_sent_msgs, stored_blockwise_msg_ptr);
 
                     /* * * Then release memory of CoAP Acknowledgement message * * */
-                    handle->sn_coap_tx_callback(dst_ack_packet_data_ptr,
-                                                dst_packed_data_needed_mem, src_addr_ptr, param);
+                    sn_coap_protocol_send_packet(handle, dst_ack_packet_data_ptr,
+                                                 dst_packed_data_needed_mem, src_addr_ptr, param);
 
 #if ENABLE_RESENDINGS
-                    uint32_t resend_time = sn_coap_calculate_new_resend_time(handle->system_time, handle->sn_coap_resending_intervall, 0);
+                    uint32_t resend_time = sn_coap_calculate_new_resend_time(sn_coap_protocol_system_time(handle), handle->sn_coap_resending_intervall, 0);
                     sn_coap_protocol_linked_list_send_msg_store(handle, src_addr_ptr,
                             dst_packed_data_needed_mem,
                             dst_ack_packet_data_ptr,
-                            resend_time, param);
+                            resend_time, param, true);
 #endif
-                    handle->sn_coap_protocol_free(dst_ack_packet_data_ptr);
+                    sn_coap_protocol_packet_release(dst_ack_packet_data_ptr);
                     dst_ack_packet_data_ptr = 0;
                 }
 
@@ -2239,7 +2546,7 @@ static sn_coap_hdr_s *sn_coap_handle_blockwise_message(struct coap_s *handle, sn
                 /* Build and send block message */
                 dst_packed_data_needed_mem = sn_coap_builder_calc_needed_packet_data_size_2(src_coap_blockwise_ack_msg_ptr, handle->sn_coap_block_data_size);
 
-                dst_ack_packet_data_ptr = handle->sn_coap_protocol_malloc(dst_packed_data_needed_mem);
+                dst_ack_packet_data_ptr = sn_coap_protocol_packet_alloc(handle, dst_packed_data_needed_mem);
                 if (!dst_ack_packet_data_ptr) {
                     tr_error("sn_coap_handle_blockwise_message - (recv block2) failed to allocate packet!");
                     handle->sn_coap_protocol_free(original_payload_ptr);
@@ -2258,14 +2565,14 @@ static sn_coap_hdr_s *sn_coap_handle_blockwise_message(struct coap_s *handle, sn
                                                                         dst_packed_data_needed_mem,
                                                                         dst_ack_packet_data_ptr)) {
                     sn_coap_parser_release_allocated_coap_msg_mem(handle, src_coap_blockwise_ack_msg_ptr);
-                    handle->sn_coap_protocol_free(dst_ack_packet_data_ptr);
+                    sn_coap_protocol_packet_release(dst_ack_packet_data_ptr);
                     return NULL;
                 }
 #endif
 
-                handle->sn_coap_tx_callback(dst_ack_packet_data_ptr, dst_packed_data_needed_mem, src_addr_ptr, param);
+                sn_coap_protocol_send_packet(handle, dst_ack_packet_data_ptr, dst_packed_data_needed_mem, src_addr_ptr, param);
 
-                handle->sn_coap_protocol_free(dst_ack_packet_data_ptr);
+                sn_coap_protocol_packet_release(dst_ack_packet_data_ptr);
                 dst_ack_packet_data_ptr = 0;
 
                 stored_blockwise_msg_temp_ptr->coap_msg_ptr->payload_len = original_payload_len;
@@ -2535,6 +2842,25 @@ static bool compare_port(const sn_nsdl_addr_s* left, const sn_nsdl_addr_s* right
     return match;
 }
 
+#if SN_COAP_INDEXED_MESSAGE_LOOKUP
+static uint16_t sn_coap_protocol_index_msg_id_bucket(uint16_t msg_id)
+{
+    /* Message IDs are mostly sequential, so low bits spread evenly */
+    return msg_id & (SN_COAP_INDEXED_MESSAGE_LOOKUP - 1);
+}
+
+static uint16_t sn_coap_protocol_index_token_bucket(const uint8_t *token_ptr, uint8_t token_len)
+{
+    uint16_t hash = 0;
+
+    for (uint8_t i = 0; i < token_len; i++) {
+        hash = (hash * 31) + token_ptr[i];
+    }
+
+    return hash & (SN_COAP_INDEXED_MESSAGE_LOOKUP - 1);
+}
+#endif
+
 static uint16_t get_new_message_id(void)
 {
     if (message_id == 0) {
@@ -27,6 +27,8 @@
 #undef NS_EVENTLOOP_USE_TICK_TIMER
 /* Exclude high resolution timer from build (removes need for "platform_timer" API) */
 #undef NS_EXCLUDE_HIGHRES_TIMER
+/* Size of lock-free inbound queue for eventOS_event_send() (power of two, 0 = disabled; requires GCC atomic builtins) */
+#undef NS_EVENTLOOP_INBOUND_QUEUE_SIZE
 
 /*
  * mbedOS 5 specific configuration flag mapping to internal flags
@@ -39,6 +41,10 @@
 #define NS_EXCLUDE_HIGHRES_TIMER        1
 #endif
 
+#ifdef MBED_CONF_NANOSTACK_EVENTLOOP_INBOUND_QUEUE_SIZE
+#define NS_EVENTLOOP_INBOUND_QUEUE_SIZE MBED_CONF_NANOSTACK_EVENTLOOP_INBOUND_QUEUE_SIZE
+#endif
+
 /*
  * Include the user config file if defined
  */
@@ -46,4 +52,8 @@
 #include NS_EVENTLOOP_USER_CONFIG_FILE
 #endif
 
+#ifndef NS_EVENTLOOP_INBOUND_QUEUE_SIZE
+#define NS_EVENTLOOP_INBOUND_QUEUE_SIZE 0
+#endif
+
 #endif /* EVENTLOOP_CONFIG_H_ */
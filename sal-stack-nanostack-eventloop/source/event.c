@@ -23,6 +23,7 @@
 #include "ns_timer.h"
 #include "event.h"
 #include "platform/arm_hal_interrupt.h"
+#include "platform/eventloop_config.h"
 
 
 typedef struct arm_core_tasklet {
@@ -32,9 +33,51 @@ typedef struct arm_core_tasklet {
 } arm_core_tasklet_t;
 
 static NS_LIST_DEFINE(arm_core_tasklet_list, arm_core_tasklet_t, link);
-static NS_LIST_DEFINE(event_queue_active, arm_event_storage_t, link);
 static NS_LIST_DEFINE(free_event_entry, arm_event_storage_t, link);
 
+// Active events are kept in one FIFO per priority level, so that queueing an
+// event does not have to walk past the events already queued. Bit n of
+// event_queue_active_mask is set when event_queue_active[n] is non-empty.
+#define EVENT_QUEUE_LEVELS (ARM_LIB_LOW_PRIORITY_EVENT + 1)
+typedef NS_LIST_HEAD(arm_event_storage_t, link) event_queue_t;
+static event_queue_t event_queue_active[EVENT_QUEUE_LEVELS];
+static uint8_t event_queue_active_mask;
+
+// Highest priority (lowest numbered) non-empty level for each mask value
+static const uint8_t event_queue_first_level[1 << EVENT_QUEUE_LEVELS] = {
+    0, 0, 1, 0, 2, 0, 1, 0
+};
+
+#if NS_EVENTLOOP_INBOUND_QUEUE_SIZE
+#if !defined(__GNUC__)
+#error "NS_EVENTLOOP_INBOUND_QUEUE_SIZE requires GCC atomic builtins"
+#endif
+#if (NS_EVENTLOOP_INBOUND_QUEUE_SIZE & (NS_EVENTLOOP_INBOUND_QUEUE_SIZE - 1))
+#error "NS_EVENTLOOP_INBOUND_QUEUE_SIZE must be a power of two"
+#endif
+
+// Bounded multi-producer queue that eventOS_event_send() copies events into
+// without taking the critical section. Each slot's sequence number tells
+// whose turn it is: sequence == position means free for the producer claiming
+// that position, position + 1 means published. The queue is drained into
+// event_queue_active by whoever holds the critical section, so there is only
+// ever one consumer.
+typedef struct {
+    uint32_t sequence;
+    arm_event_t data;
+} event_inbound_slot_t;
+
+static event_inbound_slot_t event_inbound_queue[NS_EVENTLOOP_INBOUND_QUEUE_SIZE];
+static uint32_t event_inbound_head; // Next position to claim (producers)
+static uint32_t event_inbound_tail; // Next position to drain (critical section)
+
+static bool event_inbound_push(const arm_event_t *event);
+static bool event_inbound_drain_critical(void);
+#define EVENT_INBOUND_DRAIN_CRITICAL() ((void) event_inbound_drain_critical())
+#else
+#define EVENT_INBOUND_DRAIN_CRITICAL() ((void) 0)
+#endif
+
 // Statically allocate initial pool of events.
 #define STARTUP_EVENT_POOL_SIZE 10
 static arm_event_storage_t startup_event_pool[STARTUP_EVENT_POOL_SIZE];
@@ -47,6 +90,16 @@ static arm_core_tasklet_t *tasklet_dynamically_allocate(void);
 static arm_event_storage_t *event_dynamically_allocate(void);
 static arm_event_storage_t *event_core_get(void);
 static void event_core_write(arm_event_storage_t *event);
+static void event_core_write_critical(arm_event_storage_t *event);
+
+static uint8_t event_queue_level(const arm_event_storage_t *event)
+{
+    // Anything below the lowest defined priority is queued as lowest priority
+    if ((unsigned) event->data.priority >= EVENT_QUEUE_LEVELS) {
+        return ARM_LIB_LOW_PRIORITY_EVENT;
+    }
+    return event->data.priority;
+}
 
 static arm_core_tasklet_t *event_tasklet_handler_get(uint8_t tasklet_id)
 {
@@ -118,12 +171,28 @@ int8_t eventOS_event_handler_create(void (*handler_func_ptr)(arm_event_s *), uin
 int8_t eventOS_event_send(const arm_event_t *event)
 {
     if (event_tasklet_handler_get(event->receiver)) {
+#if NS_EVENTLOOP_INBOUND_QUEUE_SIZE
+        // If the inbound queue is full, make room by draining it here rather
+        // than bypassing it, so events from one sender stay in order.
+        while (!event_inbound_push(event)) {
+            platform_enter_critical();
+            bool drained = event_inbound_drain_critical();
+            platform_exit_critical();
+            if (!drained) {
+                return -1;
+            }
+        }
+        /* Wake From Idle */
+        eventOS_scheduler_signal();
+        return 0;
+#else
         arm_event_storage_t *event_tmp = event_core_get();
         if (event_tmp) {
             event_tmp->data = *event;
             event_core_write(event_tmp);
             return 0;
         }
+#endif
     }
     return -1;
 }
@@ -142,7 +211,11 @@ void eventOS_event_send_timer_allocated(arm_event_storage_t *event)
 
 void eventOS_event_cancel_critical(arm_event_storage_t *event)
 {
-    ns_list_remove(&event_queue_active, event);
+    uint8_t level = event_queue_level(event);
+    ns_list_remove(&event_queue_active[level], event);
+    if (ns_list_is_empty(&event_queue_active[level])) {
+        event_queue_active_mask &= ~(1 << level);
+    }
 }
 
 static arm_event_storage_t *event_dynamically_allocate(void)
@@ -206,44 +279,105 @@ void event_core_free_push(arm_event_storage_t *free)
 
 static arm_event_storage_t *event_core_read(void)
 {
+    arm_event_storage_t *event = NULL;
     platform_enter_critical();
-    arm_event_storage_t *event = ns_list_get_first(&event_queue_active);
-    if (event) {
+    EVENT_INBOUND_DRAIN_CRITICAL();
+    if (event_queue_active_mask) {
+        uint8_t level = event_queue_first_level[event_queue_active_mask];
+        event = ns_list_get_first(&event_queue_active[level]);
         event->state = ARM_LIB_EVENT_RUNNING;
-        ns_list_remove(&event_queue_active, event);
+        ns_list_remove(&event_queue_active[level], event);
+        if (ns_list_is_empty(&event_queue_active[level])) {
+            event_queue_active_mask &= ~(1 << level);
+        }
     }
     platform_exit_critical();
     return event;
 }
 
+// Requires lock to be held
+static void event_core_write_critical(arm_event_storage_t *event)
+{
+    uint8_t level = event_queue_level(event);
+    ns_list_add_to_end(&event_queue_active[level], event);
+    event_queue_active_mask |= 1 << level;
+    event->state = ARM_LIB_EVENT_QUEUED;
+}
+
 void event_core_write(arm_event_storage_t *event)
 {
     platform_enter_critical();
-    bool added = false;
-    ns_list_foreach(arm_event_storage_t, event_tmp, &event_queue_active) {
-        // note enum ordering means we're checking if event_tmp is LOWER priority than event
-        if (event_tmp->data.priority > event->data.priority) {
-            ns_list_add_before(&event_queue_active, event_tmp, event);
-            added = true;
-            break;
-        }
-    }
-    if (!added) {
-        ns_list_add_to_end(&event_queue_active, event);
-    }
-    event->state = ARM_LIB_EVENT_QUEUED;
+    // Keep ordering with events already sent through the inbound queue
+    EVENT_INBOUND_DRAIN_CRITICAL();
+    event_core_write_critical(event);
 
     /* Wake From Idle */
     platform_exit_critical();
     eventOS_scheduler_signal();
 }
 
+#if NS_EVENTLOOP_INBOUND_QUEUE_SIZE
+static bool event_inbound_push(const arm_event_t *event)
+{
+    uint32_t pos = __atomic_load_n(&event_inbound_head, __ATOMIC_RELAXED);
+    event_inbound_slot_t *slot;
+
+    for (;;) {
+        slot = &event_inbound_queue[pos & (NS_EVENTLOOP_INBOUND_QUEUE_SIZE - 1)];
+        int32_t diff = (int32_t)(__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0) {
+            // Slot is free for this position - try to claim it
+            if (__atomic_compare_exchange_n(&event_inbound_head, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Not yet drained from the previous lap - full
+            return false;
+        } else {
+            // Another producer claimed it first
+            pos = __atomic_load_n(&event_inbound_head, __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->data = *event;
+    __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Requires lock to be held. Returns false if out of memory.
+static bool event_inbound_drain_critical(void)
+{
+    for (;;) {
+        event_inbound_slot_t *slot = &event_inbound_queue[event_inbound_tail & (NS_EVENTLOOP_INBOUND_QUEUE_SIZE - 1)];
+        if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != event_inbound_tail + 1) {
+            // Empty, or the producer of the next slot has not finished yet
+            break;
+        }
+        // Lock is recursive, so event_core_get() is fine here. If out of
+        // memory, leave the rest queued for a later drain.
+        arm_event_storage_t *event = event_core_get();
+        if (!event) {
+            return false;
+        }
+        event->data = slot->data;
+        __atomic_store_n(&slot->sequence, event_inbound_tail + NS_EVENTLOOP_INBOUND_QUEUE_SIZE, __ATOMIC_RELEASE);
+        event_inbound_tail++;
+        event_core_write_critical(event);
+    }
+    return true;
+}
+#endif
+
 // Requires lock to be held
 arm_event_storage_t *eventOS_event_find_by_id_critical(uint8_t tasklet_id, uint8_t event_id)
 {
-    ns_list_foreach(arm_event_storage_t, cur, &event_queue_active) {
-        if (cur->data.receiver == tasklet_id && cur->data.event_id == event_id) {
-            return cur;
+    EVENT_INBOUND_DRAIN_CRITICAL();
+    for (uint8_t level = 0; level < EVENT_QUEUE_LEVELS; level++) {
+        ns_list_foreach(arm_event_storage_t, cur, &event_queue_active[level]) {
+            if (cur->data.receiver == tasklet_id && cur->data.event_id == event_id) {
+                return cur;
+            }
         }
     }
 
@@ -261,7 +395,17 @@ void eventOS_scheduler_init(void)
 {
     /* Reset Event List variables */
     ns_list_init(&free_event_entry);
-    ns_list_init(&event_queue_active);
+    for (uint8_t level = 0; level < EVENT_QUEUE_LEVELS; level++) {
+        ns_list_init(&event_queue_active[level]);
+    }
+    event_queue_active_mask = 0;
+#if NS_EVENTLOOP_INBOUND_QUEUE_SIZE
+    for (uint32_t i = 0; i < NS_EVENTLOOP_INBOUND_QUEUE_SIZE; i++) {
+        event_inbound_queue[i].sequence = i;
+    }
+    event_inbound_head = 0;
+    event_inbound_tail = 0;
+#endif
     ns_list_init(&arm_core_tasklet_list);
 
     //Add first 10 entries to "free" list